@@ -7,7 +7,22 @@
 #include "lr1121_tx.h"
 #include "can_handler.h"
 #include "ft550_decoder.h"
-#include "src/mcp2515/MCP2515/MCP2515.h"
+#include "scheduler.h"
+#include "dash_output.h"
+#include "telemetry_packet.h"
+#include "sample_queue.h"
+#include "alarm_engine.h"
+#include "telemetry_auth.h"
+#include "radio_stats.h"
+#include "lap_timer.h"
+#include "can_health.h"
+#include "can_profiler.h"
+#include "decode_kernel.h"
+#include "hot_path_bench.h"
+#include "boot_trace.h"
+#include "config_store.h"
+#include "tdma.h"
+#include "hardware/sync.h"
 
 // Global mutex for printf
 mutex_t printf_mutex;
@@ -19,208 +34,554 @@ mutex_t printf_mutex;
     mutex_exit(&printf_mutex); \
 } while(0)
 
-// Shared data between cores (protected by spin lock in GPS module)
-static volatile bool core1_running = false;
-
-// GPS telemetry packet structure with integrated CAN data
-typedef struct __attribute__((packed)) {
-    uint32_t magic;         // 4 bytes - 0x46533236 ("FS26")
-    
-    // GPS Data
-    float    latitude;      // 4 bytes
-    float    longitude;     // 4 bytes
-    float    gps_speed_kph; // 4 bytes
-    float    altitude;      // 4 bytes
-    uint8_t  satellites;    // 1 byte
-    uint8_t  fix_valid;     // 1 byte
-    
-    // CAN Data - Engine Parameters
-    uint16_t rpm;           // 2 bytes - RPM
-    float    engine_temp;   // 4 bytes - °C
-    float    tps;           // 4 bytes - Throttle Position %
-    
-    // CAN Data - Pressures & Fluids
-    float    oil_pressure;  // 4 bytes - Bar
-    float    fuel_pressure; // 4 bytes - Bar
-    float    brake_pressure;// 4 bytes - Bar
-    float    battery_voltage; // 4 bytes - V
-    
-    // CAN Data - Wheel Speeds
-    uint16_t wheel_speed_fr;// 2 bytes - km/h
-    uint16_t wheel_speed_fl;// 2 bytes - km/h
-    uint16_t wheel_speed_rr;// 2 bytes - km/h
-    uint16_t wheel_speed_rl;// 2 bytes - km/h
-    
-    // CAN Data - Dynamics
-    float    g_force_lateral;// 4 bytes
-    float    heading;       // 4 bytes
-    
-    // Packet Metadata
-    uint16_t tx_count;      // 2 bytes - LoRa TX count
-    uint16_t can_frame_count;// 2 bytes - CAN frames received
-} combined_telemetry_packet_t;
-
-// Core 1 entry point - LoRa broadcast with GPS + CAN telemetry
+// Core 1 side of the sample stream: sees every update and detects gaps
+static uint32_t samples_received = 0;
+static uint32_t samples_lost = 0;
+static uint16_t next_sample_seq = 0;
+static bool sample_seq_synced = false;
+
+static void drain_samples(void) {
+    sample_t batch[32];
+    uint32_t count;
+    while ((count = sample_queue_pop(batch, 32)) > 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (sample_seq_synced && batch[i].seq != next_sample_seq) {
+                samples_lost += (uint16_t)(batch[i].seq - next_sample_seq);
+            }
+            next_sample_seq = batch[i].seq + 1;
+            sample_seq_synced = true;
+            samples_received++;
+        }
+    }
+}
+
+// Encode a typed telemetry packet and send it over LoRa (blocking)
+static bool send_packet(const telemetry_header_t* header) {
+    uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t length = telemetry_encode(header, frame);
+    return length > 0 && telemetry_auth_send(frame, length);
+}
+
+// Same for alerts and laps, which also go out on sub-GHz when div_mode asks for it
+static bool send_critical_packet(const telemetry_header_t* header) {
+    uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t length = telemetry_encode(header, frame);
+    return length > 0 && telemetry_auth_send_critical(frame, length);
+}
+
+// Send a pending alarm alert out of cycle, ahead of the next telemetry slot
+static void send_pending_alert(void) {
+    alarm_alert_t alert;
+    if (!alarm_take_alert(&alert)) {
+        return;
+    }
+    telemetry_alarm_t packet;
+    telemetry_build_alarm(&packet, &alert);
+    if (send_critical_packet(&packet.header)) {
+        safe_printf("[ALERT] active:0x%04x changed:0x%04x\n", alert.active_mask, alert.changed_mask);
+    } else {
+        safe_printf("[ALERT] FAILED active:0x%04x\n", alert.active_mask);
+    }
+}
+
+// Send the summary of a lap completed on core 0
+static void send_pending_lap(void) {
+    lap_summary_t lap;
+    if (!lap_timer_take_summary(&lap)) {
+        return;
+    }
+    telemetry_lap_t packet;
+    telemetry_build_lap(&packet, &lap);
+    bool sent = send_critical_packet(&packet.header);
+    safe_printf("[LAP] %s #%u %lu.%03lus best %lu.%03lus\n", sent ? "sent" : "FAILED", lap.lap_number,
+                (unsigned long)(lap.lap_time_ms / 1000), (unsigned long)(lap.lap_time_ms % 1000),
+                (unsigned long)(lap.best_lap_ms / 1000), (unsigned long)(lap.best_lap_ms % 1000));
+}
+
+// --- Core 1 scheduler tasks ---
+
+static scheduler_t core1_sched;
+
+// Task ids: CORE1_TASKS is registered in this order
+enum { CORE1_BELL = 0, CORE1_FAST, CORE1_GPS, CORE1_THERM, CORE1_DIAG, CORE1_FHSS };
+
+// --- TDMA: several cars on one LoRa channel (tdma.h) ---
+// While the node is slotted, the periodic tasks only mark their packet due
+// and fast_tx_task() sends everything inside this node's window.
+
+#define TDMA_TX_GPS         (1u << 0)
+#define TDMA_TX_THERMAL     (1u << 1)
+#define TDMA_TX_DIAG        (1u << 2)
+#define TDMA_TX_HEALTH      (1u << 3)
+
+static tdma_node_t tdma;
+static uint32_t tdma_packet_us = 0;     // Longest LoRa frame with the active profile, plus set-up
+static uint32_t tdma_ref_seq = 0;
+static uint8_t tdma_tx_due = 0;         // TDMA_TX_* waiting for the slot
+static uint8_t tdma_tx_deferred = 0;    // Due, but did not fit in the last slot
+
+// Feed a new GPS time reference into the TDMA clock
+static void tdma_poll_time_ref(void) {
+    gps_time_ref_t ref;
+    if (gps_get_time_ref(&ref) && ref.seq != tdma_ref_seq) {
+        tdma_ref_seq = ref.seq;
+        tdma_clock_update(&tdma.clock, ref.utc_ms_of_day, ref.local_us,
+                          ref.pps ? TDMA_SYNC_PPS : TDMA_SYNC_NMEA);
+    }
+}
+
+static bool tdma_active(void) {
+    return tdma_node_active(&tdma, time_us_64());
+}
+
+// A periodic packet is due: true if it has to wait for the slot
+static bool tdma_hold(uint8_t packet) {
+    if (!tdma_active()) {
+        return false;
+    }
+    tdma_tx_due |= packet;
+    return true;
+}
+
+static bool tdma_slot_fits(void) {
+    return tdma_fits(&tdma.plan, &tdma.clock, time_us_64(), tdma_packet_us);
+}
+
+// --- Flash writes with core 1 parked ---
+// multicore_lockout would take over the SIO FIFO that carries the
+// doorbells, so core 0 asks core 1 to park with a doorbell of its own.
+
+#define FLASH_PARK_DOORBELL     0x464C5348  // "FLSH"
+#define FLASH_PARK_TIMEOUT_US   2000000     // Longest core 1 task: an LR-FHSS frame (~1 s)
+
+static volatile bool core1_parked = false;
+static volatile bool core1_release = false;
+
+// Core 1: spin in SRAM with interrupts off until core 0 is done with flash
+static void __not_in_flash_func(core1_park)(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    core1_parked = true;
+    while (!core1_release) {
+        tight_loop_contents();
+    }
+    core1_parked = false;
+    restore_interrupts(irq);
+}
+
+// Core 0: config store flash runner. Blocks core 0 until core 1 reaches
+// its next task boundary, so saving belongs in the pits.
+static bool run_with_core1_parked(void (*fn)(void*), void* param) {
+    core1_release = false;
+    uint64_t deadline = time_us_64() + FLASH_PARK_TIMEOUT_US;
+    if (!multicore_fifo_push_timeout_us(FLASH_PARK_DOORBELL, FLASH_PARK_TIMEOUT_US)) {
+        core1_release = true;
+        return false;
+    }
+    while (!core1_parked) {
+        if (time_us_64() > deadline) {
+            core1_release = true;       // Lets core 1 straight through if it parks late
+            return false;
+        }
+    }
+
+    uint32_t irq = save_and_disable_interrupts();
+    fn(param);
+    restore_interrupts(irq);
+    core1_release = true;
+    return true;
+}
+
+// Telemetry periods from the config store, re-read between task runs
+static void core1_apply_config(void) {
+    static uint32_t generation = 0;
+    if (generation == config_generation()) {
+        return;
+    }
+    generation = config_generation();
+
+    const daq_config_t* cfg = config_get();
+    sched_set_period(&core1_sched, CORE1_FAST, cfg->fast_period_ms * 1000u);
+    sched_set_period(&core1_sched, CORE1_GPS, cfg->gps_period_ms * 1000u);
+    sched_set_period(&core1_sched, CORE1_THERM, cfg->thermal_period_ms * 1000u);
+    sched_set_period(&core1_sched, CORE1_DIAG, cfg->diag_period_ms * 1000u);
+    sched_set_period(&core1_sched, CORE1_FHSS, cfg->essentials_period_ms * 1000u);
+
+    // One frame per fast packet period; the slot must fit the longest frame
+    tdma_packet_us = LORA_TX_SETUP_US +
+                     lora_time_on_air_ms(TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD) * 1000u;
+    uint32_t sync_error_us = GPS_PPS_PIN >= 0 ? TDMA_PPS_SYNC_ERROR_US : TDMA_NMEA_SYNC_ERROR_US;
+    if (tdma_node_configure(&tdma, cfg->tdma_node_id, cfg->tdma_nodes, cfg->fast_period_ms * 1000u,
+                            sync_error_us, tdma_packet_us)) {
+        safe_printf("[TDMA] node %u of %u: slot %lu us, guard %lu us, packet %lu us\n",
+                    cfg->tdma_node_id, cfg->tdma_nodes, (unsigned long)tdma.plan.slot_us,
+                    (unsigned long)tdma.plan.guard_us, (unsigned long)tdma_packet_us);
+    } else if (cfg->tdma_nodes > 1) {
+        safe_printf("[TDMA] OFF: %lu us packet and 2 x %lu us guard do not fit a %lu us slot\n",
+                    (unsigned long)tdma_packet_us, (unsigned long)tdma.plan.guard_us,
+                    (unsigned long)tdma.plan.slot_us);
+    }
+}
+
+static bool core1_doorbell_pending(void) {
+    return multicore_fifo_rvalid();
+}
+
+// Sample stream, alarm alerts and lap summaries: released by the SIO FIFO
+// doorbell (core 0's FIFO push issues __sev(), waking core 1 from __wfe())
+static void doorbell_task(void) {
+    while (multicore_fifo_rvalid()) {
+        if (multicore_fifo_pop_blocking() == FLASH_PARK_DOORBELL) {
+            core1_park();
+        }
+    }
+    core1_apply_config();
+    drain_samples();
+    tdma_poll_time_ref();
+    if (!tdma_active()) {
+        send_pending_alert();   // Otherwise sent in the next slot
+        send_pending_lap();
+    }
+}
+
+// Fast dynamics: engine + chassis (5 Hz)
+static void send_fast(void) {
+    ft550_sensor_data_t can_data;
+    can_get_sensor_data_safe(&can_data);
+
+    telemetry_fast_t packet;
+    telemetry_build_fast(&packet, &can_data);
+    if (!send_packet(&packet.header)) {
+        safe_printf("[TX] FAILED #%lu\n", lora_get_tx_count());
+    }
+}
+
+// Position and speed (2 Hz)
+static void send_gps(void) {
+    gps_data_t gps;
+    gps_get_data_safe(&gps);
+
+    telemetry_gps_t packet;
+    telemetry_build_gps(&packet, &gps);
+    if (!send_packet(&packet.header)) {
+        safe_printf("[TX] GPS FAILED #%lu\n", lora_get_tx_count());
+    }
+}
+
+// Slow thermals + counters (1 Hz), with the once-a-second console summary
+static void send_thermal(void) {
+    ft550_sensor_data_t can_data;
+    can_get_sensor_data_safe(&can_data);
+
+    telemetry_thermal_t packet;
+    telemetry_build_thermal(&packet, &can_data);
+    if (send_packet(&packet.header)) {
+        safe_printf("[TX] RPM:%u | Batt:%.2f | TPS:%.3f | EngineTemp:%.1f | TX#%u CAN#%u | SMP:%lu lost:%lu\n",
+               (unsigned)ft550_raw(&can_data, FT550_CH_RPM), ft550_value(&can_data, FT550_CH_BATTERY_VOLTAGE),
+               ft550_value(&can_data, FT550_CH_TPS), ft550_value(&can_data, FT550_CH_ENGINE_TEMP),
+               packet.tx_count, packet.can_frame_count,
+               samples_received, samples_lost);
+    } else {
+        safe_printf("[TX] FAILED #%lu\n", lora_get_tx_count());
+    }
+}
+
+// LR-FHSS essentials on the sub-GHz link, for when 2.4 GHz LoRa drops out.
+// Blocks core 1 for the frame's time on air (~1 s), so it runs last.
+static void essentials_task(void) {
+    gps_data_t gps;
+    gps_get_data_safe(&gps);
+    
+    ft550_sensor_data_t can_data;
+    can_get_sensor_data_safe(&can_data);
+    
+    telemetry_essentials_t packet;
+    telemetry_build_essentials(&packet, &gps, &can_data, alarm_get_active_mask());
+    
+    uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t length = telemetry_encode(&packet.header, frame);
+    bool sent = telemetry_auth_send_lr_fhss(frame, length);
+    
+    radio_airtime_t airtime;
+    lora_get_airtime(&airtime);
+    safe_printf("[FHSS] %s #%u RPM:%u alarms:0x%04x | airtime LoRa:%lums/%lu LR-FHSS:%lums/%lu deferred:%lu "
+                "div:%lums/%lu deferred:%lu\n",
+                sent ? "sent" : "NOT SENT", packet.header.seq, packet.rpm, packet.alarm_mask,
+                (unsigned long)airtime.lora_airtime_ms, (unsigned long)airtime.lora_packets,
+                (unsigned long)airtime.lr_fhss_airtime_ms, (unsigned long)airtime.lr_fhss_packets,
+                (unsigned long)airtime.lr_fhss_deferred, (unsigned long)airtime.div_airtime_ms,
+                (unsigned long)airtime.div_packets, (unsigned long)airtime.div_deferred);
+}
+
+// Link diagnostics for the pits: TX outcomes, time on air, chip and SPI errors
+static void send_radio_diag(void) {
+    telemetry_diag_t packet;
+    radio_stats_build_packet(&packet);
+    bool sent = send_packet(&packet.header);
+
+    safe_printf("[RADIO] %s | LoRa ok:%u tmo:%u spi:%u toa:%u/%ums | LR-FHSS ok:%u tmo:%u toa:%u/%ums | "
+                "syserr:0x%04x x%u | spi:%lu busy_tmo:%u busy:%lums max:%uus\n",
+                sent ? "sent" : "NOT SENT",
+                packet.lora_ok, packet.lora_timeout, packet.lora_spi_error,
+                packet.lora_toa_measured_ms, packet.lora_toa_computed_ms,
+                packet.fhss_ok, packet.fhss_timeout,
+                packet.fhss_toa_measured_ms, packet.fhss_toa_computed_ms,
+                packet.sys_errors, packet.sys_error_events,
+                (unsigned long)packet.spi_commands, packet.busy_timeouts,
+                (unsigned long)packet.busy_wait_ms, packet.busy_wait_max_us);
+}
+
+static void send_can_health(void) {
+    telemetry_can_health_t health;
+    can_health_build_packet(&health);
+    send_packet(&health.header);
+}
+
+static const struct {
+    uint8_t packet;
+    void (*send)(void);
+} TDMA_PACKETS[] = {
+    { TDMA_TX_GPS,     send_gps },
+    { TDMA_TX_THERMAL, send_thermal },
+    { TDMA_TX_DIAG,    send_radio_diag },
+    { TDMA_TX_HEALTH,  send_can_health },
+};
+
+// Send the packets in mask that are due, while they fit in the window
+static void tdma_send_due(uint8_t mask) {
+    for (size_t i = 0; i < sizeof(TDMA_PACKETS) / sizeof(TDMA_PACKETS[0]); i++) {
+        uint8_t packet = TDMA_PACKETS[i].packet;
+        if ((mask & tdma_tx_due & packet) && tdma_slot_fits()) {
+            tdma_tx_due &= ~packet;
+            TDMA_PACKETS[i].send();
+        }
+    }
+}
+
+// This node's window: alerts and laps, then packets left over from the
+// last slot ahead of the fast packet so a window that fits only one frame
+// does not starve them, then whatever else is due
+static void tdma_slot(void) {
+    if (tdma_slot_fits()) send_pending_alert();
+    if (tdma_slot_fits()) send_pending_lap();
+    tdma_send_due(tdma_tx_deferred);
+    if (tdma_slot_fits()) send_fast();
+    tdma_send_due(tdma_tx_due);
+    tdma_tx_deferred = tdma_tx_due;
+}
+
+static void fast_tx_task(void) {
+    tdma_poll_time_ref();
+    if (!tdma_active()) {
+        // Unsynced or TDMA off: send when due, as without TDMA
+        tdma_tx_due = 0;
+        tdma_tx_deferred = 0;
+        send_fast();
+        return;
+    }
+
+    tdma_slot();
+    sched_set_next_release(&core1_sched, CORE1_FAST,
+                           tdma_next_window(&tdma.plan, &tdma.clock, time_us_64()));
+}
+
+static void gps_tx_task(void) {
+    if (!tdma_hold(TDMA_TX_GPS)) send_gps();
+}
+
+static void thermal_tx_task(void) {
+    if (!tdma_hold(TDMA_TX_THERMAL)) send_thermal();
+}
+
+static void radio_diag_task(void) {
+    if (!tdma_hold(TDMA_TX_DIAG | TDMA_TX_HEALTH)) {
+        send_radio_diag();
+        send_can_health();
+    }
+}
+
+// Periods are the defaults; core1_apply_config() sets the configured ones
+static const sched_task_config_t CORE1_TASKS[] = {
+    //              name     run              ready                   period                              deadline priority
+    [CORE1_BELL]  = { "bell",  doorbell_task,   core1_doorbell_pending, 100000,                             20000,   0 },
+    [CORE1_FAST]  = { "fast",  fast_tx_task,    NULL,                   TELEMETRY_FAST_PERIOD_MS * 1000,    50000,   1 },
+    [CORE1_GPS]   = { "gps",   gps_tx_task,     NULL,                   TELEMETRY_GPS_PERIOD_MS * 1000,     100000,  2 },
+    [CORE1_THERM] = { "therm", thermal_tx_task, NULL,                   TELEMETRY_THERMAL_PERIOD_MS * 1000, 200000,  3 },
+    [CORE1_DIAG]  = { "diag",  radio_diag_task, NULL,                   RADIO_DIAG_PERIOD_MS * 1000,        500000,  4 },
+    [CORE1_FHSS]  = { "fhss",  essentials_task, NULL,                   ESSENTIALS_PERIOD_MS * 1000,        5000000, 5 },
+};
+
+// Core 1 entry point - LoRa/LR-FHSS broadcast with GPS + CAN telemetry
 void core1_main() {
     safe_printf("Core 1: Initializing LoRa TX...\n");
     lora_tx_init();
+    boot_trace_mark("radio ready");
     
-    core1_running = true;
+    // Load the LR1121 keys and check its crypto against the software AES
+    if (TELEMETRY_AUTH_MODE != TELEMETRY_AUTH_OFF) {
+        telemetry_auth_init();
+        telemetry_auth_benchmark(32);
+        boot_trace_mark("telemetry auth ready");
+    }
     
     safe_printf("Core 1: Starting combined telemetry broadcast (GPS + CAN + LoRa)...\n");
     
-    while (true) {        
-        // Get thread-safe copy of GPS data
-        gps_data_t gps;
-        gps_get_data_safe(&gps);
-        
-        // Get thread-safe copy of CAN sensor data
-        ft550_sensor_data_t can_data;
-        can_get_sensor_data_safe(&can_data);
-        
-        // Build combined telemetry packet
-        combined_telemetry_packet_t packet;
-        packet.magic = 0x46533236;  // "FS26" magic number
-        
-        // GPS Data
-        packet.latitude = gps.raw_latitude;
-        packet.longitude = gps.raw_longitude;
-        packet.gps_speed_kph = gps.speed_kph;
-        packet.altitude = gps.altitude;
-        packet.satellites = (uint8_t)gps.satellites;
-        packet.fix_valid = gps.fix_valid ? 1 : 0;
-        
-        // CAN Data - Engine Parameters
-        packet.rpm = can_data.rpm;
-        packet.engine_temp = can_data.engine_temp;
-        packet.tps = can_data.tps;
-        
-        // CAN Data - Pressures & Fluids
-        packet.oil_pressure = can_data.oil_pressure;
-        packet.fuel_pressure = can_data.fuel_pressure;
-        packet.brake_pressure = can_data.brake_pressure;
-        packet.battery_voltage = can_data.battery_voltage;
-        
-        // CAN Data - Wheel Speeds
-        packet.wheel_speed_fr = can_data.wheel_speed_fr;
-        packet.wheel_speed_fl = can_data.wheel_speed_fl;
-        packet.wheel_speed_rr = can_data.wheel_speed_rr;
-        packet.wheel_speed_rl = can_data.wheel_speed_rl;
-        
-        // CAN Data - Dynamics
-        packet.g_force_lateral = can_data.g_force_lateral;
-        packet.heading = can_data.heading;
-        
-        // Packet Metadata
-        packet.tx_count = (uint16_t)lora_get_tx_count();
-        packet.can_frame_count = (uint16_t)(can_get_frame_count() & 0xFFFF);
-        
-        // Send it (blocking)
-        if (lora_send((uint8_t*)&packet, sizeof(packet))) {
-            safe_printf("[TX] RPM:%u | Batt:%.2f | TPS:%.3f | EngineTemp:%.1f | TX#%u CAN#%u\n",
-                   packet.rpm, packet.battery_voltage, packet.tps, packet.engine_temp,
-                   packet.tx_count, packet.can_frame_count);
-        } else {
-            safe_printf("[TX] FAILED #%lu\n", lora_get_tx_count());
-        }
-        
-        sleep_ms(500);  // TX rate: 2Hz
+    sched_init(&core1_sched);
+    for (size_t i = 0; i < sizeof(CORE1_TASKS) / sizeof(CORE1_TASKS[0]); i++) {
+        sched_add_task(&core1_sched, &CORE1_TASKS[i]);
+    }
+    core1_apply_config();
+    sched_run(&core1_sched);
+}
+
+// --- Core 0 scheduler tasks ---
+
+static scheduler_t core0_sched;
+
+// Lap completed on core 0: wake core 1 to send the lap packet
+static void lap_doorbell(void) {
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(LAP_DOORBELL);
     }
 }
 
+// Alarm state changed (sent from dash_tx_task): wake core 1 to send the LoRa alert.
+// A full FIFO already holds a doorbell, and core 1 checks for alerts on every wake.
+static void alarm_alert_doorbell(void) {
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(ALARM_DOORBELL);
+    }
+}
+
+// CAN ingest: released by the MCP2515 INT line, 1 ms backstop poll
+static void can_ingest_task(void) {
+    static bool first_frame = false;
+    // DRAIN LOOP: Vacuum the ECU stream - may only be necessary if M84...test it with the FT550 though, since was added after the switch.
+    while (can_process_frame()) {
+        boot_trace_once(&first_frame, true, "first CAN frame");
+    }
+}
+
+// GPS ingest: released by the UART RX interrupt, 5 ms backstop poll
+static void gps_ingest_task(void) {
+    static bool configured = false;
+    gps_config_poll();
+    boot_trace_once(&configured, gps_config_done(), "GPS configured");
+    gps_process();
+
+    ft550_sensor_data_t can_data;
+    can_get_sensor_data_safe(&can_data);
+    lap_timer_update(gps_get_data(), (uint16_t)ft550_raw(&can_data, FT550_CH_RPM), to_ms_since_boot(get_absolute_time()));
+}
+
+// DASHBOARD BROADCAST - Publish the latest GPS + CAN telemetry to the dash via CAN.
+// Runs at the fastest frame rate; dash_publish() decides which frames are due.
+static void dash_tx_task(void) {
+    // Get thread-safe copies of the latest telemetry
+    ft550_sensor_data_t can_data;
+    can_get_sensor_data_safe(&can_data);
+    
+    gps_data_t gps;
+    gps_get_data_safe(&gps);
+
+    static bool first_frame = false;
+    boot_trace_once(&first_frame, dash_publish(&can_data, &gps, time_us_64()) > 0, "first dash frame");
+    alarm_publish(time_us_32());
+}
+
+// 1Hz scheduler health report (deadline misses, worst latency/exec per task)
+static void stats_task(void) {
+    sched_report(&core0_sched);
+
+    sample_queue_stats_t q;
+    sample_queue_get_stats(&q);
+    safe_printf("[SQ] pushed:%lu dropped:%lu popped:%lu high:%lu/%u\n",
+                (unsigned long)q.pushed, (unsigned long)q.dropped,
+                (unsigned long)q.popped, (unsigned long)q.high_water,
+                SAMPLE_QUEUE_CAPACITY);
+
+    dash_stats_t dash;
+    dash_get_stats(&dash);
+    safe_printf("[DASH] sent:%lu suppressed:%lu\n",
+                (unsigned long)dash.sent, (unsigned long)dash.suppressed);
+
+    can_profiler_report();
+    boot_trace_report();
+}
+
+static const sched_task_config_t CORE0_TASKS[] = {
+    // name     run              ready            period                deadline priority
+    { "can",   can_ingest_task, can_rx_pending,   1000,                 250,     0 },
+    { "gps",   gps_ingest_task, gps_is_readable,  5000,                 2000,    1 },
+    { "dash",  dash_tx_task,    NULL,             DASH_PUBLISH_TICK_US, 5000,    2 },
+    { "canhl", can_health_poll, NULL,             CAN_HEALTH_PERIOD_MS * 1000, 2000, 3 },
+    { "stats", stats_task,      NULL,             1000000,              100000,  4 },
+    { "cfg",   config_store_poll_usb, NULL,       20000,                10000,   5 },
+};
+
 int main() {
     stdio_init_all();
     mutex_init(&printf_mutex);  // Initialize mutex before anything else
-    sleep_ms(2000); 
+    boot_trace_init();
+#if BOOT_USB_WAIT_MS
+    // Bench only: give a terminal time to attach before the boot messages
+    absolute_time_t usb_deadline = make_timeout_time_ms(BOOT_USB_WAIT_MS);
+    while (!stdio_usb_connected() && !time_reached(usb_deadline)) {
+        sleep_ms(10);
+    }
+#endif
     
     safe_printf("Core 0: Initializing dual-core GPS + LoRa DAQ system...\n");
     
-    // Initialize GPS module on core 0
-    gps_init();
-    // Initialize CAN bus for ECU data
+    // Runtime configuration, read by everything below
+    config_store_init();
+    
+    // Core 0 -> core 1 sample stream and alarm rules (must exist before GPS/CAN start pushing)
+    sample_queue_init();
+    alarm_init();
+    alarm_set_alert_callback(alarm_alert_doorbell);
+    lap_timer_init();
+    lap_timer_set_callback(lap_doorbell);
+    
+    // CAN and the dash first: they are what the driver sees after a brown-out.
+    // can_init() may write the autobaud cache to flash, so it runs before core 1.
     can_init();
+    can_health_init();
+    can_profiler_init();
+    boot_trace_mark("can_init");
+    dash_publisher_init();
+    
+    // Only opens the UART; baud detection and configuration run in gps_ingest_task
+    gps_init();
+    boot_trace_mark("gps_init");
+
+#if DECODE_KERNEL_BENCHMARK
+    decode_kernel_bench_t bench;
+    decode_kernel_benchmark(10000, time_us_64, &bench);
+    safe_printf("Core 0: decode kernel %s: %llu us vs portable %llu us for %lu bursts, %s\n",
+                bench.dsp ? "DSP" : "C", (unsigned long long)bench.kernel_us,
+                (unsigned long long)bench.portable_us, (unsigned long)bench.iterations,
+                bench.match ? "outputs match" : "OUTPUT MISMATCH");
+#endif
+#if HOT_PATH_BENCHMARK
+    hot_path_benchmark();
+#endif
     
-    // Launch core 1 for LR1121
+    // Launch core 1 for LR1121. The radio comes up in parallel; core 0 does
+    // not wait for it.
     safe_printf("Core 0: Launching Core 1 for LR1121...\n");
     multicore_launch_core1(core1_main);
-    
-    // Wait for core 1 to be ready
-    while (!core1_running) {
-        sleep_ms(10);
-    }
+    config_store_set_flash_runner(run_with_core1_parked);
+    boot_trace_mark("core 1 launched");
 
-    safe_printf("Core 0: Both cores running. Starting GPS processing...\n");
+    safe_printf("Core 0: Starting CAN, dash and GPS processing...\n");
     
-    uint32_t last_dash_tx = 0; // Track when we last updated the screen
-
-    // Core 0 main loop - dedicated GPS & CAN processing
-    while (true) {
-        // 1. Poll GPS UART
-        gps_process();
-        
-        // 2. DRAIN LOOP: Vacuum the ECU stream - may only be necessary if M84...test it with the FT550 though, since was added after the switch.
-        while (can_process_frame()) {
-        }
-        
-        // 3. DASHBOARD BROADCAST (10Hz) - Send the latest GPS + CAN telemetry to the dash via CAN. 
-        uint32_t current_time = to_ms_since_boot(get_absolute_time());
-        if (current_time - last_dash_tx >= 50) { 
-            
-            // Get thread-safe copies of the latest telemetry
-            ft550_sensor_data_t can_data;
-            can_get_sensor_data_safe(&can_data);
-            
-            gps_data_t gps;
-            gps_get_data_safe(&gps);
-
-            // --- FRAME 0x600 (Primary Engine) ---
-            uint8_t dash_tx_buf[8];
-            uint16_t rpm_out = can_data.rpm;
-            uint16_t map_out = (uint16_t)(can_data.map * 10.0f);
-            int16_t  et_out  = (int16_t)(can_data.engine_temp * 10.0f);
-            uint16_t tps_out = (uint16_t)(can_data.tps * 10.0f);
-            
-            dash_tx_buf[0] = rpm_out & 0xFF; dash_tx_buf[1] = (rpm_out >> 8);
-            dash_tx_buf[2] = map_out & 0xFF; dash_tx_buf[3] = (map_out >> 8);
-            dash_tx_buf[4] = et_out & 0xFF;  dash_tx_buf[5] = (et_out >> 8);
-            dash_tx_buf[6] = tps_out & 0xFF; dash_tx_buf[7] = (tps_out >> 8);
-            MCP2515_Send(0x600, dash_tx_buf, 8);
-
-            // --- FRAME 0x601 (Battery & Air Temp) ---
-            uint8_t aux_tx_buf[8] = {0};
-            uint16_t batt_out = (uint16_t)(can_data.battery_voltage * 100.0f);
-            int16_t  at_out   = (int16_t)(can_data.air_temp * 10.0f);
-            
-            aux_tx_buf[0] = batt_out & 0xFF; aux_tx_buf[1] = (batt_out >> 8);
-            aux_tx_buf[2] = at_out & 0xFF;   aux_tx_buf[3] = (at_out >> 8);
-            MCP2515_Send(0x601, aux_tx_buf, 8);
-
-            // --- FRAME 0x602 (GPS Pos) ---
-            uint8_t gps_tx_buf[8];
-            int32_t lat_out = (int32_t)(gps.raw_latitude * 10000000.0f);
-            int32_t lon_out = (int32_t)(gps.raw_longitude * 10000000.0f);
-            
-            gps_tx_buf[0] = lat_out & 0xFF;         gps_tx_buf[1] = (lat_out >> 8) & 0xFF;
-            gps_tx_buf[2] = (lat_out >> 16) & 0xFF; gps_tx_buf[3] = (lat_out >> 24) & 0xFF;
-            gps_tx_buf[4] = lon_out & 0xFF;         gps_tx_buf[5] = (lon_out >> 8) & 0xFF;
-            gps_tx_buf[6] = (lon_out >> 16) & 0xFF; gps_tx_buf[7] = (lon_out >> 24) & 0xFF;
-            MCP2515_Send(0x602, gps_tx_buf, 8);
-
-            // --- FRAME 0x603 (Meta) ---
-            uint8_t meta_tx_buf[8] = {0};
-            uint16_t speed_out = (uint16_t)(gps.speed_kph * 10.0f);
-            
-            meta_tx_buf[0] = speed_out & 0xFF; meta_tx_buf[1] = (speed_out >> 8);
-            meta_tx_buf[2] = gps.satellites;
-            meta_tx_buf[3] = gps.fix_valid ? 1 : 0;
-            meta_tx_buf[4] = lora_get_tx_count() & 0xFF; meta_tx_buf[5] = (lora_get_tx_count() >> 8);
-            meta_tx_buf[6] = can_get_frame_count() & 0xFF; meta_tx_buf[7] = (can_get_frame_count() >> 8);
-            MCP2515_Send(0x603, meta_tx_buf, 8);
-
-            last_dash_tx = current_time;
-        }
-        
-        // Small delay to prevent locking the bus completely
-        sleep_us(100);
+    // Core 0 scheduler - dedicated GPS & CAN processing, idles in __wfe()
+    sched_init(&core0_sched);
+    for (size_t i = 0; i < sizeof(CORE0_TASKS) / sizeof(CORE0_TASKS[0]); i++) {
+        sched_add_task(&core0_sched, &CORE0_TASKS[i]);
     }
-}
\ No newline at end of file
+    gps_enable_rx_irq();
+    boot_trace_mark("core 0 scheduler");
+    
+    sched_run(&core0_sched);
+}
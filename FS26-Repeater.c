@@ -0,0 +1,273 @@
+/**
+ * @file      FS26-Repeater.c
+ * @brief     Trackside repeater (FS26-Repeater target): hears the cars, forwards to the pits
+ *
+ * Runs on the same Pico 2 + LR1121 + GPS board as the car, without CAN. The
+ * radio listens on the car channel. Each new DAQ frame is queued by relay.c
+ * and sent again unchanged, so authenticated frames keep a valid MIC.
+ *
+ * Two ways to forward, picked by relay_freq_khz:
+ *   0          the car channel, in this repeater's own TDMA slot. The
+ *              repeater takes a tdma_node_id like a car, and needs GPS time.
+ *   otherwise  that channel, as soon as a frame is queued. The base station
+ *              listens there. The repeater is half duplex: it cannot hear
+ *              the cars while it transmits.
+ *
+ * A frame that waits longer than relay_max_age_ms is dropped, so the
+ * repeater never adds more than that plus one transmission of latency.
+ *
+ * With channel hopping on (hop_channels > 1) the repeater follows the hops
+ * of the frames it hears (channel_hop.h), which works for one car. It
+ * forwards each frame on that frame's own hop channel, and reports the loss
+ * per channel with a suggested hop_blacklist.
+ *
+ * Single core, cooperative scheduler (scheduler.h):
+ *
+ *   Task   Released by
+ *   rx     LR1121 DIO (1 ms backstop): queue received frames, follow hops
+ *   fwd    every 1 ms: send queued frames when the channel allows it
+ *   gps    UART RX (5 ms backstop): GPS time references for TDMA
+ *   stats  every second
+ *   cfg    USB "cfg" console
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "gps.h"
+#include "lr1121_tx.h"
+#include "lr1121_rx.h"
+#include "relay.h"
+#include "telemetry_packet.h"
+#include "telemetry_auth.h"
+#include "scheduler.h"
+#include "config_store.h"
+#include "tdma.h"
+#include "channel_hop.h"
+#include "safe_print.h"
+
+// Global mutex for printf (safe_print.h)
+mutex_t printf_mutex;
+
+static scheduler_t sched;
+static relay_t relay;
+
+static tdma_node_t tdma;
+static uint32_t tdma_ref_seq = 0;
+static bool tdma_planned = false;       // Plan valid for the same-channel mode
+
+static hop_plan_t hop;
+static hop_rx_t hop_rx;
+static uint32_t rx_tuned_khz = 0;       // Channel RX was last started or retuned on
+
+static uint8_t rx_frame[PAYLOAD_LENGTH];
+_Static_assert(RELAY_MAX_FRAME >= PAYLOAD_LENGTH, "relay slots must hold any received frame");
+static uint32_t tx_failures = 0;
+
+// Channel to listen on: the car channel, or the next hop
+static uint32_t rx_freq_khz(void) {
+    if (!hop_enabled(&hop)) {
+        return config_get()->lora_freq_khz;
+    }
+    return hop_channel_khz(&hop, hop_rx_channel(&hop_rx, &hop));
+}
+
+// Channel a frame is forwarded on: the relay channel, or where the car sent it
+static uint32_t tx_freq_khz(const relay_frame_t* frame) {
+    const daq_config_t* cfg = config_get();
+    uint32_t counter, mask;
+    if (cfg->relay_freq_khz) {
+        return cfg->relay_freq_khz;
+    }
+    if (hop_enabled(&hop) && hop_frame_counter(frame->data, frame->length, &counter, &mask)) {
+        return hop_channel_khz(&hop, hop_channel(&hop, counter));
+    }
+    return cfg->lora_freq_khz;
+}
+
+static void rx_start(void) {
+    rx_tuned_khz = rx_freq_khz();
+    lora_rx_start(rx_tuned_khz);
+}
+
+// Follow a hop without restarting the oscillator
+static void rx_follow(void) {
+    uint32_t freq_khz = rx_freq_khz();
+    if (freq_khz != rx_tuned_khz) {
+        rx_tuned_khz = freq_khz;
+        lora_rx_retune(freq_khz);
+    }
+}
+
+// Re-plan TDMA and restart RX after a config commit
+static void apply_config(void) {
+    static uint32_t generation = 0;
+    if (generation == config_generation()) {
+        return;
+    }
+    generation = config_generation();
+
+    const daq_config_t* cfg = config_get();
+    relay.max_age_us = cfg->relay_max_age_ms * 1000u;
+
+    // Same slot layout as the cars, sized for the longest DAQ frame
+    uint32_t packet_us = LORA_TX_SETUP_US +
+                         lora_time_on_air_ms(TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD) * 1000u;
+    uint32_t sync_error_us = GPS_PPS_PIN >= 0 ? TDMA_PPS_SYNC_ERROR_US : TDMA_NMEA_SYNC_ERROR_US;
+    tdma_planned = tdma_node_configure(&tdma, cfg->tdma_node_id, cfg->tdma_nodes, cfg->fast_period_ms * 1000u,
+                                       sync_error_us, packet_us);
+    if (cfg->relay_freq_khz) {
+        safe_printf("[RELAY] %lu kHz -> %lu kHz, max age %u ms\n", (unsigned long)cfg->lora_freq_khz,
+                    (unsigned long)cfg->relay_freq_khz, cfg->relay_max_age_ms);
+    } else if (tdma_planned) {
+        safe_printf("[RELAY] %lu kHz, TDMA slot %u of %u (%lu us), max age %u ms\n",
+                    (unsigned long)cfg->lora_freq_khz, cfg->tdma_node_id, cfg->tdma_nodes,
+                    (unsigned long)tdma.plan.slot_us, cfg->relay_max_age_ms);
+    } else {
+        safe_printf("[RELAY] NOT FORWARDING: set relay_freq_khz, or tdma_nodes/tdma_node_id with "
+                    "a slot for a %lu us packet\n", (unsigned long)packet_us);
+    }
+
+    hop_plan_init(&hop, cfg->hop_base_khz, cfg->hop_spacing_khz, cfg->hop_channels, cfg->hop_blacklist,
+                  HOP_SEED);
+    hop_rx_init(&hop_rx, &hop, cfg->fast_period_ms * 1000u, time_us_64());
+    if (hop_enabled(&hop)) {
+        safe_printf("[HOP] following %u of %u channels from %lu kHz, %u kHz apart\n", hop.num_allowed,
+                    hop.count, (unsigned long)hop.base_khz, hop.spacing_khz);
+    }
+
+    rx_start();
+}
+
+// Whether a frame of length bytes may be sent now
+static bool may_send(uint8_t length, uint64_t now_us) {
+    if (config_get()->relay_freq_khz) {
+        return true;
+    }
+    // On the car channel only inside this repeater's slot
+    uint32_t tx_us = LORA_TX_SETUP_US + lora_time_on_air_ms(length) * 1000u;
+    return tdma_planned && tdma_node_active(&tdma, now_us) && tdma_fits(&tdma.plan, &tdma.clock, now_us, tx_us);
+}
+
+// --- Scheduler tasks ---
+
+// Received frames: released by the LR1121 DIO line, 1 ms backstop poll
+static void rx_task(void) {
+    uint8_t length;
+    int8_t rssi_dbm;
+    int8_t snr_db;
+    uint32_t counter, mask;
+    if (lora_rx_poll(rx_frame, &length, &rssi_dbm, &snr_db)) {
+        relay_receive(&relay, rx_frame, length, rssi_dbm, time_us_64());
+        if (hop_enabled(&hop) && hop_frame_counter(rx_frame, length, &counter, &mask)) {
+            hop_rx_received(&hop_rx, &hop, counter, mask, time_us_64());
+            rx_follow();
+        }
+    } else if (hop_rx_poll(&hop_rx, &hop, time_us_64())) {
+        rx_follow();
+    }
+}
+
+// Send queued frames, oldest first, while the channel allows it
+static void fwd_task(void) {
+    apply_config();
+
+    bool sent_any = false;
+    const relay_frame_t* frame;
+    while ((frame = relay_next(&relay, time_us_64())) != NULL && may_send(frame->length, time_us_64())) {
+        lora_rx_stop();
+        sent_any = true;
+        if (!lora_send_on(tx_freq_khz(frame), frame->data, frame->length)) {
+            tx_failures++;      // Retried until it expires
+            break;
+        }
+        relay_sent(&relay, time_us_64());
+    }
+
+    // The radio falls back to standby after TX
+    if (sent_any) {
+        rx_start();
+    }
+}
+
+// GPS: time references for the TDMA clock
+static void gps_task(void) {
+    gps_config_poll();
+    gps_process();
+
+    gps_time_ref_t ref;
+    if (gps_get_time_ref(&ref) && ref.seq != tdma_ref_seq) {
+        tdma_ref_seq = ref.seq;
+        tdma_clock_update(&tdma.clock, ref.utc_ms_of_day, ref.local_us,
+                          ref.pps ? TDMA_SYNC_PPS : TDMA_SYNC_NMEA);
+    }
+}
+
+// 1 Hz forwarding report and scheduler health
+static void stats_task(void) {
+    relay_stats_t r = relay.stats;
+    lora_rx_stats_t rx;
+    lora_rx_get_stats(&rx);
+
+    safe_printf("[RELAY] heard:%lu fwd:%lu dup:%lu bad:%lu over:%lu expired:%lu txfail:%lu "
+                "q:%u/%u high:%u max:%lu ms\n",
+                (unsigned long)r.received, (unsigned long)r.forwarded, (unsigned long)r.duplicates,
+                (unsigned long)r.invalid, (unsigned long)r.overflows, (unsigned long)r.expired,
+                (unsigned long)tx_failures, relay.count, RELAY_QUEUE_DEPTH, r.queue_high,
+                (unsigned long)(r.max_latency_us / 1000));
+    safe_printf("[RX] ok:%lu crc:%lu hdr:%lu spi:%lu | TDMA %s\n",
+                (unsigned long)rx.packets, (unsigned long)rx.crc_errors, (unsigned long)rx.header_errors,
+                (unsigned long)rx.spi_errors,
+                config_get()->relay_freq_khz ? "not used" :
+                tdma_node_active(&tdma, time_us_64()) ? "synced" : "NOT SYNCED");
+    if (hop_enabled(&hop)) {
+        safe_printf("[HOP] %s, loss %%:", hop_rx.synced ? "following" : "searching");
+        for (uint8_t i = 0; i < hop.count; i++) {
+            int loss = hop_loss_pct(&hop_rx.stats, i);
+            if (hop.blacklist & (1u << i)) {
+                safe_printf(" x");
+            } else if (loss < 0) {
+                safe_printf(" -");
+            } else {
+                safe_printf(" %d", loss);
+            }
+        }
+        uint16_t suggest = hop_suggest_blacklist(&hop_rx.stats, &hop);
+        if (suggest != hop.blacklist) {
+            safe_printf(" | cfg set hop_blacklist 0x%04x on every node", suggest);
+        }
+        safe_printf("\n");
+    }
+    sched_report(&sched);
+}
+
+static const sched_task_config_t TASKS[] = {
+    // name     run                    ready             period   deadline priority
+    { "rx",    rx_task,                lora_rx_pending,  1000,    500,     0 },
+    { "fwd",   fwd_task,               NULL,             1000,    50000,   1 },
+    { "gps",   gps_task,               gps_is_readable,  5000,    2000,    2 },
+    { "stats", stats_task,             NULL,             1000000, 100000,  3 },
+    { "cfg",   config_store_poll_usb,  NULL,             20000,   10000,   4 },
+};
+
+int main() {
+    stdio_init_all();
+    mutex_init(&printf_mutex);
+
+    safe_printf("FS26 repeater: initializing...\n");
+    config_store_init();
+    gps_init();
+
+    lora_tx_init();
+    relay_init(&relay, config_get()->relay_max_age_ms * 1000u);
+
+    sched_init(&sched);
+    for (size_t i = 0; i < sizeof(TASKS) / sizeof(TASKS[0]); i++) {
+        sched_add_task(&sched, &TASKS[i]);
+    }
+    apply_config();
+    gps_enable_rx_irq();
+
+    safe_printf("FS26 repeater: listening\n");
+    sched_run(&sched);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file      aes_soft.h
+ * @brief     Portable software AES-128 (encrypt only) with CMAC and CTR helpers
+ * 
+ * Reference implementation for telemetry authentication. It runs on core 1
+ * as a benchmark and fallback for the LR1121 crypto engine, and has no Pico
+ * SDK dependencies so receivers and host tools can build it unchanged.
+ */
+
+#ifndef AES_SOFT_H
+#define AES_SOFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AES_BLOCK_SIZE 16
+
+/**
+ * Expanded AES-128 key (11 round keys)
+ */
+typedef struct {
+    uint8_t round_key[176];
+} aes128_ctx_t;
+
+/**
+ * @brief Expand a 128-bit key
+ * 
+ * @param ctx Context to fill
+ * @param key 16-byte key
+ */
+void aes128_init(aes128_ctx_t* ctx, const uint8_t key[16]);
+
+/**
+ * @brief Encrypt one 16-byte block (ECB)
+ * 
+ * @param ctx Expanded key
+ * @param in Plaintext block
+ * @param out Ciphertext block (may alias in)
+ */
+void aes128_encrypt_block(const aes128_ctx_t* ctx, const uint8_t in[16], uint8_t out[16]);
+
+/**
+ * @brief Compute a full 16-byte AES-CMAC (RFC 4493)
+ * 
+ * @param ctx Expanded key
+ * @param data Message
+ * @param length Message length in bytes
+ * @param mac Output tag
+ */
+void aes128_cmac(const aes128_ctx_t* ctx, const uint8_t* data, size_t length, uint8_t mac[16]);
+
+/**
+ * @brief Encrypt a run of counter blocks to produce a CTR keystream
+ * 
+ * @param ctx Expanded key
+ * @param blocks Counter blocks, a multiple of 16 bytes
+ * @param length Length of blocks in bytes
+ * @param keystream Output (may alias blocks)
+ */
+void aes128_ecb_encrypt(const aes128_ctx_t* ctx, const uint8_t* blocks, size_t length, uint8_t* keystream);
+
+#endif // AES_SOFT_H
@@ -0,0 +1,229 @@
+/**
+ * @file      alarm_engine.c
+ * @brief     On-device driver alarms and shift light implementation
+ */
+
+#include "alarm_engine.h"
+#include "hot_path.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+
+_Static_assert(ALARM_NUM_RULES <= 16, "alarm masks are 16 bits wide");
+
+#if ALARM_RULES_EXTERNAL
+extern const alarm_rule_t ALARM_RULES[ALARM_NUM_RULES];
+#else
+static const alarm_rule_t ALARM_RULES[ALARM_NUM_RULES] HOT_PATH_DATA = {
+    [ALARM_ENGINE_OVERTEMP] = {
+        .name = "overtemp", .channel = SAMPLE_CH_ENGINE_TEMP, .compare = ALARM_ABOVE,
+        .flags = ALARM_F_LORA, .threshold = 1050, .hysteresis = 30,     // 105.0 °C, clear at 102.0
+        .debounce_us = 500000,
+    },
+    [ALARM_LOW_BATTERY] = {
+        .name = "low_batt", .channel = SAMPLE_CH_BATTERY_VOLTAGE, .compare = ALARM_BELOW,
+        .flags = ALARM_F_LORA, .threshold = 1200, .hysteresis = 30,     // 12.00 V, clear at 12.30
+        .debounce_us = 2000000,
+    },
+    [ALARM_SHIFT_LIGHT] = {
+        .name = "shift", .channel = SAMPLE_CH_RPM, .compare = ALARM_ABOVE,
+        .flags = 0, .threshold = 11500, .hysteresis = 300,              // CAN only, no debounce
+        .debounce_us = 0,
+    },
+};
+#endif
+
+/**
+ * Runtime state per rule (core 0 only)
+ */
+typedef struct {
+    bool     active;
+    bool     pending;               // Condition met, waiting out the debounce
+    uint32_t pending_since_us;
+} alarm_state_t;
+
+static alarm_state_t g_state[ALARM_NUM_RULES];
+static int32_t g_latest[SAMPLE_CH_COUNT];   // Latest value per channel for maps
+static uint32_t g_last_frame_us = 0;
+static void (*g_alert_callback)(void) = NULL;
+
+// Shared with core 1 and the core 0 publish task, guarded by g_spin_lock
+static spin_lock_t* g_spin_lock;
+static volatile uint16_t g_active_mask = 0;
+static uint16_t g_changed_mask = 0;
+static int32_t g_change_values[ALARM_NUM_RULES];
+static uint16_t g_frame_mask = 0;           // Rules with a CAN frame to send
+static int32_t g_frame_values[ALARM_NUM_RULES];
+static bool g_alert_pending = false;        // Alert callback still to run
+
+void alarm_init(void) {
+    memset(g_state, 0, sizeof(g_state));
+    memset(g_latest, 0, sizeof(g_latest));
+    memset(g_change_values, 0, sizeof(g_change_values));
+    memset(g_frame_values, 0, sizeof(g_frame_values));
+    g_active_mask = 0;
+    g_changed_mask = 0;
+    g_frame_mask = 0;
+    g_alert_pending = false;
+    g_last_frame_us = 0;
+    if (!g_spin_lock) {
+        g_spin_lock = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+}
+
+void alarm_set_alert_callback(void (*callback)(void)) {
+    g_alert_callback = callback;
+}
+
+// Piecewise-linear lookup, clamped at both ends
+static int32_t HOT_PATH_FUNC(map_threshold)(const alarm_rule_t* rule) {
+    int32_t x = g_latest[rule->map_channel];
+    const alarm_map_point_t* map = rule->map;
+
+    if (x <= map[0].x) {
+        return map[0].y;
+    }
+    for (uint8_t i = 1; i < rule->map_len; i++) {
+        if (x <= map[i].x) {
+            int32_t dx = map[i].x - map[i - 1].x;
+            int32_t dy = map[i].y - map[i - 1].y;
+            return map[i - 1].y + (int32_t)((int64_t)dy * (x - map[i - 1].x) / dx);
+        }
+    }
+    return map[rule->map_len - 1].y;
+}
+
+static void send_alarm_frame(uint16_t mask, uint8_t rule_id, bool active, int32_t value) {
+    uint8_t buf[8];
+    buf[0] = mask & 0xFF;
+    buf[1] = mask >> 8;
+    buf[2] = rule_id;
+    buf[3] = active ? 1 : 0;
+    buf[4] = value & 0xFF;
+    buf[5] = (value >> 8) & 0xFF;
+    buf[6] = (value >> 16) & 0xFF;
+    buf[7] = (value >> 24) & 0xFF;
+    MCP2515_Send(ALARM_CAN_ID, buf, 8);
+}
+
+// Latch the change; alarm_publish() sends the frame and runs the alert
+// callback, so the ingest path never waits on SPI or the TX buffer
+static void HOT_PATH_FUNC(set_rule_state)(uint8_t rule_id, bool active, int32_t value) {
+    const alarm_rule_t* rule = &ALARM_RULES[rule_id];
+    g_state[rule_id].active = active;
+    g_state[rule_id].pending = false;
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    {
+        if (active) {
+            g_active_mask |= (1u << rule_id);
+        } else {
+            g_active_mask &= ~(1u << rule_id);
+        }
+        g_frame_mask |= (1u << rule_id);
+        g_frame_values[rule_id] = value;
+        if (rule->flags & ALARM_F_LORA) {
+            g_changed_mask |= (1u << rule_id);
+            g_change_values[rule_id] = value;
+            g_alert_pending = true;
+        }
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void HOT_PATH_FUNC(alarm_on_sample)(uint8_t channel, int32_t value, uint32_t timestamp_us) {
+    if (channel >= SAMPLE_CH_COUNT) {
+        return;
+    }
+    g_latest[channel] = value;
+
+    for (uint8_t i = 0; i < ALARM_NUM_RULES; i++) {
+        const alarm_rule_t* rule = &ALARM_RULES[i];
+        if (rule->channel != channel) {
+            continue;
+        }
+
+        alarm_state_t* state = &g_state[i];
+        int32_t threshold = rule->map ? map_threshold(rule) : rule->threshold;
+
+        if (state->active) {
+            // Stay raised until the value is back past the hysteresis band
+            bool clear = (rule->compare == ALARM_ABOVE)
+                ? value < threshold - rule->hysteresis
+                : value > threshold + rule->hysteresis;
+            if (clear) {
+                set_rule_state(i, false, value);
+            }
+            continue;
+        }
+
+        bool tripped = (rule->compare == ALARM_ABOVE) ? value > threshold : value < threshold;
+        if (!tripped) {
+            state->pending = false;
+            continue;
+        }
+        if (!state->pending) {
+            state->pending = true;
+            state->pending_since_us = timestamp_us;
+        }
+        if (timestamp_us - state->pending_since_us >= rule->debounce_us) {
+            set_rule_state(i, true, value);
+        }
+    }
+}
+
+void alarm_publish(uint32_t now_us) {
+    uint16_t mask;
+    uint16_t frames;
+    int32_t values[ALARM_NUM_RULES];
+    bool alert;
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    {
+        mask = g_active_mask;
+        frames = g_frame_mask;
+        memcpy(values, g_frame_values, sizeof(values));
+        alert = g_alert_pending;
+        g_frame_mask = 0;
+        g_alert_pending = false;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+
+    if (alert && g_alert_callback) {
+        g_alert_callback();
+    }
+
+    if (frames) {
+        for (uint8_t i = 0; i < ALARM_NUM_RULES; i++) {
+            if (frames & (1u << i)) {
+                send_alarm_frame(mask, i, (mask >> i) & 1, values[i]);
+            }
+        }
+        g_last_frame_us = now_us;
+    } else if (mask && now_us - g_last_frame_us >= ALARM_FRAME_REFRESH_US) {
+        // Keep the dash in sync if it missed a change
+        send_alarm_frame(mask, 0xFF, true, 0);
+        g_last_frame_us = now_us;
+    }
+}
+
+uint16_t alarm_get_active_mask(void) {
+    return g_active_mask;
+}
+
+bool alarm_take_alert(alarm_alert_t* alert) {
+    bool taken = false;
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    if (g_changed_mask) {
+        alert->active_mask = g_active_mask;
+        alert->changed_mask = g_changed_mask;
+        memcpy(alert->values, g_change_values, sizeof(alert->values));
+        g_changed_mask = 0;
+        taken = true;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+
+    return taken;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file      alarm_engine.h
+ * @brief     On-device driver alarms and shift light (core 0)
+ * 
+ * Every decoded sample is checked against a flat, build-time rule table
+ * (threshold + hysteresis + debounce, optionally with an RPM-dependent
+ * threshold map). State changes are latched on the ingest path;
+ * alarm_publish(), run from the dash task, sends them as high-priority CAN
+ * alarm frames and flags an out-of-cycle LoRa alert packet.
+ * 
+ * Evaluation is integer-only on raw sample values and visits at most
+ * ALARM_NUM_RULES rules per sample, so its cost per sample is bounded.
+ */
+
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+// Alarm frame, lower id than the dash frames so it wins arbitration
+#define ALARM_CAN_ID            0x5F0
+
+// Resend the alarm frame this often while any alarm is active
+#define ALARM_FRAME_REFRESH_US  500000
+
+// SIO FIFO token used to wake core 1 for an alert
+#define ALARM_DOORBELL          0x414C5254  // "ALRT"
+
+// 1: ALARM_RULES is defined outside alarm_engine.c (host test, tools/alarm_sim.c)
+#ifndef ALARM_RULES_EXTERNAL
+#define ALARM_RULES_EXTERNAL 0
+#endif
+
+/**
+ * Rule ids (bit position in the active mask)
+ */
+typedef enum {
+    ALARM_ENGINE_OVERTEMP = 0,
+    ALARM_LOW_BATTERY,
+    ALARM_SHIFT_LIGHT,
+    ALARM_NUM_RULES
+} alarm_rule_id_t;
+
+typedef enum {
+    ALARM_ABOVE = 0,                // Raised when value > threshold
+    ALARM_BELOW                     // Raised when value < threshold
+} alarm_compare_t;
+
+#define ALARM_F_LORA            0x01    // Also send a LoRa alert on change
+
+/**
+ * One breakpoint of a threshold map (x = map channel, y = threshold)
+ */
+typedef struct {
+    int32_t x;
+    int32_t y;
+} alarm_map_point_t;
+
+/**
+ * Build-time rule description. Values are raw sample units
+ * (see sample_channel_scale[]).
+ */
+typedef struct {
+    const char*              name;
+    uint8_t                  channel;       // sample_channel_t to watch
+    uint8_t                  compare;       // alarm_compare_t
+    uint8_t                  flags;         // ALARM_F_*
+    uint8_t                  map_channel;   // x-axis channel when map is set
+    int32_t                  threshold;     // Fixed threshold (map == NULL)
+    int32_t                  hysteresis;    // Clear band beyond the threshold
+    uint32_t                 debounce_us;   // Condition must hold this long
+    const alarm_map_point_t* map;           // Optional threshold map, ascending x
+    uint8_t                  map_len;
+} alarm_rule_t;
+
+/**
+ * Out-of-cycle LoRa alert, sent as a telemetry_alarm_t packet
+ */
+typedef struct {
+    uint16_t active_mask;           // Rules currently raised
+    uint16_t changed_mask;          // Rules that changed since the last alert
+    int32_t  values[ALARM_NUM_RULES]; // Raw value at the last state change
+} alarm_alert_t;
+
+/**
+ * @brief Reset all alarm state. Call before CAN ingest starts.
+ */
+void alarm_init(void);
+
+/**
+ * @brief Register a callback run from alarm_publish() when a LoRa alert is pending
+ * 
+ * @param callback Function to call, or NULL to disable
+ */
+void alarm_set_alert_callback(void (*callback)(void));
+
+/**
+ * @brief Evaluate every rule watching this channel (core 0 only)
+ * 
+ * @param channel Sample channel (sample_channel_t)
+ * @param value Raw sample value
+ * @param timestamp_us Decode time from time_us_32()
+ */
+void alarm_on_sample(uint8_t channel, int32_t value, uint32_t timestamp_us);
+
+/**
+ * @brief Send latched alarm frames and run the alert callback (core 0)
+ * 
+ * Sends one frame per rule that changed since the last call, or a refresh
+ * frame every ALARM_FRAME_REFRESH_US while any alarm is active. Blocks on
+ * the MCP2515, so call it from the dash task, never from CAN ingest.
+ * 
+ * @param now_us Current time from time_us_32()
+ */
+void alarm_publish(uint32_t now_us);
+
+/**
+ * @brief Get the mask of currently raised alarms (any core)
+ */
+uint16_t alarm_get_active_mask(void);
+
+/**
+ * @brief Take the pending LoRa alert, if any (core 1)
+ * 
+ * @param alert Filled when an alert is pending
+ * @return true if an alert was taken
+ */
+bool alarm_take_alert(alarm_alert_t* alert);
+
+#endif // ALARM_ENGINE_H
@@ -0,0 +1,71 @@
+/**
+ * @file      boot_trace.c
+ * @brief     Power-on timeline implementation
+ */
+
+#include "boot_trace.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "safe_print.h"
+
+typedef struct {
+    const char* phase;
+    uint32_t    time_us;            // Since reset
+    uint8_t     core;
+} boot_mark_t;
+
+static spin_lock_t* g_spin_lock;
+static boot_mark_t g_marks[BOOT_TRACE_MAX_MARKS];
+static uint8_t g_num_marks = 0;
+static uint8_t g_dropped = 0;
+static bool g_reported = false;
+
+void boot_trace_init(void) {
+    g_spin_lock = spin_lock_instance(spin_lock_claim_unused(true));
+    boot_trace_mark("reset -> main");
+}
+
+void boot_trace_mark(const char* phase) {
+    // Timestamp under the lock so marks from both cores stay in time order
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    if (g_num_marks < BOOT_TRACE_MAX_MARKS) {
+        g_marks[g_num_marks].phase = phase;
+        g_marks[g_num_marks].time_us = time_us_32();
+        g_marks[g_num_marks].core = (uint8_t)get_core_num();
+        g_num_marks++;
+    } else {
+        g_dropped++;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void boot_trace_report(void) {
+    if (g_reported || to_ms_since_boot(get_absolute_time()) < BOOT_TRACE_REPORT_MS) {
+        return;
+    }
+    g_reported = true;
+
+    // Marks stop arriving long before the report, but copy under the lock anyway
+    boot_mark_t marks[BOOT_TRACE_MAX_MARKS];
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    uint8_t count = g_num_marks;
+    uint8_t dropped = g_dropped;
+    for (uint8_t i = 0; i < count; i++) {
+        marks[i] = g_marks[i];
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+
+    uint32_t prev_us = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t delta_us = marks[i].time_us - prev_us;
+        safe_printf("[BOOT] %4lu.%03lu ms (+%4lu.%03lu) c%u %s\n",
+                    (unsigned long)(marks[i].time_us / 1000), (unsigned long)(marks[i].time_us % 1000),
+                    (unsigned long)(delta_us / 1000), (unsigned long)(delta_us % 1000),
+                    marks[i].core, marks[i].phase);
+        prev_us = marks[i].time_us;
+    }
+    if (dropped) {
+        safe_printf("[BOOT] %u marks dropped\n", dropped);
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file      boot_trace.h
+ * @brief     Power-on timeline: when each bring-up phase finished, on which core
+ *
+ * boot_trace_mark() records the time since reset of a named phase. Both
+ * cores mark their bring-up steps and core 0 marks the first CAN frame and
+ * the first dash frame; boot_trace_report() prints the timeline once, after
+ * BOOT_TRACE_REPORT_MS, so the USB host has had time to enumerate.
+ *
+ * Example:
+ *   [BOOT]   12.408 ms (+   1.006) c0 can_init
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_TRACE_MAX_MARKS    24
+#define BOOT_TRACE_REPORT_MS    3000    // Earliest time the report is printed
+
+// Hold off the boot messages until a USB host has opened the port (ms,
+// 0 = never wait). Only useful at the bench: the car boots without USB.
+#ifndef BOOT_USB_WAIT_MS
+#define BOOT_USB_WAIT_MS        0
+#endif
+
+/**
+ * @brief Claim the trace lock and record "reset" -> now. Call first in main().
+ */
+void boot_trace_init(void);
+
+/**
+ * @brief Record the end of a boot phase (either core, not from an ISR)
+ *
+ * Marks past BOOT_TRACE_MAX_MARKS are dropped.
+ *
+ * @param phase Phase name, must be a string literal
+ */
+void boot_trace_mark(const char* phase);
+
+/**
+ * @brief Mark `phase` the first time `reached` is true
+ *
+ * For milestones seen from a periodic task (first CAN frame, first dash frame).
+ *
+ * @param done Per-milestone flag owned by the caller
+ * @param reached Milestone condition
+ * @param phase Phase name
+ */
+static inline void boot_trace_once(bool* done, bool reached, const char* phase) {
+    if (!*done && reached) {
+        *done = true;
+        boot_trace_mark(phase);
+    }
+}
+
+/**
+ * @brief Print the timeline once BOOT_TRACE_REPORT_MS have passed
+ *
+ * Call periodically (stats task); prints only once.
+ */
+void boot_trace_report(void);
+
+#endif // BOOT_TRACE_H
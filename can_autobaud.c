@@ -0,0 +1,101 @@
+/**
+ * @file      can_autobaud.c
+ * @brief     Boot-time CAN bit rate detection implementation
+ */
+
+#include "can_autobaud.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "config_store.h"
+
+typedef enum {
+    PROBE_SILENT = 0,                   // Nothing on the bus during the window
+    PROBE_MATCH,                        // Clean frames at this rate
+    PROBE_ERROR                         // Bus errors: wrong rate (or a sick bus)
+} probe_result_t;
+
+static const uint16_t RATE_KBPS[] = {
+    [KBPS5] = 5, [KBPS10] = 10, [KBPS20] = 20, [KBPS50] = 50, [KBPS100] = 100,
+    [KBPS125] = 125, [KBPS250] = 250, [KBPS500] = 500, [KBPS800] = 800, [KBPS1000] = 1000
+};
+
+// Rates scanned at boot, fastest first; the FS26 buses run at one of these.
+// Any other rate has to be set by hand (cfg set can_rate_ecu), after which
+// it is the cached rate and tried first
+static const enum RATEBPS SCAN_RATES[] = { KBPS1000, KBPS500 };
+
+uint16_t can_autobaud_rate_kbps(enum RATEBPS rate) {
+    return rate <= KBPS1000 ? RATE_KBPS[rate] : 0;
+}
+
+// Rate slot in the config store; only written when a bus moved to a new
+// rate, so the sector sees one erase per wiring change rather than one per boot
+static void cache_store(can_bus_t bus, enum RATEBPS rate) {
+    config_store_set(bus == CAN_BUS_ECU ? "can_rate_ecu" : "can_rate_chassis", rate);
+    config_store_commit(true);
+}
+
+static probe_result_t probe(const MCP2515_Dev* dev, enum RATEBPS rate, uint32_t listen_ms) {
+    if (MCP2515_Dev_Listen(dev, rate) != 0) {
+        return PROBE_ERROR;
+    }
+
+    uint32_t frames = 0;
+    uint32_t start_us = time_us_32();
+    while (time_us_32() - start_us < listen_ms * 1000) {
+        uint32_t frame_id;
+        uint8_t data[8];
+        if (MCP2515_Dev_Receive_Fast(dev, &frame_id, data) >= 0) {
+            frames++;
+        }
+        // A wrong rate almost never yields a frame with a valid CRC, but it
+        // does raise MERRF on the first stuff or form violation
+        if (MCP2515_Dev_Take_Error(dev)) {
+            return PROBE_ERROR;
+        }
+        if (frames >= CAN_AUTOBAUD_MIN_FRAMES) {
+            return PROBE_MATCH;
+        }
+    }
+    return PROBE_SILENT;
+}
+
+enum RATEBPS can_autobaud_detect(const MCP2515_Dev* dev, can_bus_t bus) {
+    uint8_t cached = config_can_rate(bus);
+    enum RATEBPS fallback = cached != CONFIG_CAN_RATE_AUTO ? (enum RATEBPS)cached : CAN_AUTOBAUD_DEFAULT_RATE;
+
+    if (!CAN_AUTOBAUD_ENABLED) {
+        return CAN_AUTOBAUD_DEFAULT_RATE;
+    }
+
+    // Cached rate first: a car that has not been rewired locks on here
+    if (cached != CONFIG_CAN_RATE_AUTO) {
+        probe_result_t result = probe(dev, (enum RATEBPS)cached, CAN_AUTOBAUD_CACHED_LISTEN_MS);
+        if (result != PROBE_ERROR) {
+            printf("CAN: bus %d %s at cached %u kbps\n", bus,
+                   result == PROBE_MATCH ? "locked on" : "silent, staying",
+                   can_autobaud_rate_kbps((enum RATEBPS)cached));
+            return (enum RATEBPS)cached;
+        }
+    }
+
+    bool heard = false;
+    for (size_t i = 0; i < sizeof(SCAN_RATES) / sizeof(SCAN_RATES[0]); i++) {
+        enum RATEBPS rate = SCAN_RATES[i];
+        if (rate == cached) {
+            continue;
+        }
+        probe_result_t result = probe(dev, rate, CAN_AUTOBAUD_LISTEN_MS);
+        if (result == PROBE_MATCH) {
+            printf("CAN: bus %d detected %u kbps\n", bus, can_autobaud_rate_kbps(rate));
+            cache_store(bus, rate);
+            return rate;
+        }
+        heard |= result == PROBE_ERROR;
+    }
+
+    printf("CAN: bus %d %s, using %u kbps\n", bus,
+           heard ? "traffic at no known rate" : "silent",
+           can_autobaud_rate_kbps(fallback));
+    return fallback;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file      can_autobaud.h
+ * @brief     Boot-time CAN bit rate detection for the MCP2515 buses
+ *
+ * can_autobaud_detect() restarts a controller in listen-only mode at
+ * 1000 kbps, then 500 kbps, and listens for up to CAN_AUTOBAUD_LISTEN_MS
+ * at each. Other rates are only used when set by hand in the config store. A rate is
+ * accepted once CAN_AUTOBAUD_MIN_FRAMES frames pass the controller's CRC and
+ * form checks without a single MERRF (message error). Listen-only mode never
+ * ACKs or sends error frames, so trying a wrong rate is invisible to the
+ * other nodes.
+ *
+ * The rate last detected on each bus is kept in the config store
+ * (can_rate_ecu, can_rate_chassis) and tried first, so a car that has not changed locks on with the first
+ * frames. The cached rate only gets CAN_AUTOBAUD_CACHED_LISTEN_MS, so a
+ * silent bus (ECU not powered yet) costs little boot time; it keeps the
+ * cached rate, or CAN_AUTOBAUD_DEFAULT_RATE without a cache.
+ *
+ * Call after config_store_init() and before core 1 is launched or the RTOS
+ * scheduler is started (can_init() does), so a new rate can be saved with
+ * the config store's boot-time flash write.
+ */
+
+#ifndef CAN_AUTOBAUD_H
+#define CAN_AUTOBAUD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "src/mcp2515/MCP2515/MCP2515.h"
+#include "can_handler.h"
+
+// Set to 0 to always run at CAN_AUTOBAUD_DEFAULT_RATE without probing
+#ifndef CAN_AUTOBAUD_ENABLED
+#define CAN_AUTOBAUD_ENABLED        1
+#endif
+
+#define CAN_AUTOBAUD_DEFAULT_RATE   KBPS1000
+#define CAN_AUTOBAUD_LISTEN_MS      100     // Per trial rate; a full scan is 200 ms
+#define CAN_AUTOBAUD_CACHED_LISTEN_MS 20    // Cached rate; bounds boot on a silent bus
+#define CAN_AUTOBAUD_MIN_FRAMES     2       // Clean frames needed to accept a rate
+
+/**
+ * @brief Find the bit rate of the bus behind one controller
+ *
+ * Leaves the controller in listen-only mode; bring it up with
+ * MCP2515_Dev_Reinit() at the returned rate. Saves the rate to the config
+ * store when it differs from the cached one.
+ *
+ * @param dev Controller, already through MCP2515_Dev_Init()
+ * @param bus Cache slot
+ * @return Rate to run the bus at (detected, cached or default)
+ */
+enum RATEBPS can_autobaud_detect(const MCP2515_Dev* dev, can_bus_t bus);
+
+/**
+ * @brief Bit rate of a CAN_RATE entry
+ *
+ * @param rate Rate index
+ * @return Bit rate in kbit/s
+ */
+uint16_t can_autobaud_rate_kbps(enum RATEBPS rate);
+
+#endif // CAN_AUTOBAUD_H
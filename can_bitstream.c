@@ -0,0 +1,280 @@
+/**
+ * @file      can_bitstream.c
+ * @brief     CAN 2.0B bit-level frame codec implementation
+ */
+
+#include "can_bitstream.h"
+#include "hot_path.h"
+#include <string.h>
+
+#define CRC15_POLY  0x4599
+#define STUFF_RUN   5
+
+enum {
+    S_WAIT_IDLE = 0,                // Counting recessive bits after power-up or an error
+    S_IDLE,                         // Bus idle, next dominant bit is a SOF
+    S_ID_A,                         // Base identifier (11)
+    S_SRR_RTR,                      // RTR (standard) or SRR (extended)
+    S_IDE,
+    S_R0,                           // Standard frames only
+    S_ID_B,                         // Identifier extension (18)
+    S_RTR_EXT,
+    S_R1R0,
+    S_DLC,
+    S_DATA,
+    S_CRC,
+    S_CRC_DELIM
+};
+
+static inline uint16_t crc15_update(uint16_t crc, uint8_t bit) {
+    uint8_t crc_next = bit ^ ((crc >> 14) & 1);
+    crc = (crc << 1) & 0x7FFF;
+    if (crc_next) {
+        crc ^= CRC15_POLY;
+    }
+    return crc;
+}
+
+uint16_t can_bitstream_crc15(const uint8_t* bits, int count) {
+    uint16_t crc = 0;
+    for (int i = 0; i < count; i++) {
+        crc = crc15_update(crc, bits[i] & 1);
+    }
+    return crc;
+}
+
+static void put_bits(uint8_t* bits, int* n, uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        bits[(*n)++] = (value >> i) & 1;
+    }
+}
+
+int can_bitstream_encode(const can_frame_t* frame, bool acked, uint8_t* bits, int max_bits) {
+    uint8_t raw[CAN_BITSTREAM_MAX_BITS];
+    int n = 0;
+    uint8_t dlc = frame->dlc > 8 ? 8 : frame->dlc;
+
+    // Destuffed SOF .. data
+    put_bits(raw, &n, 0, 1);
+    if (frame->extended) {
+        put_bits(raw, &n, (frame->id >> 18) & 0x7FF, 11);
+        put_bits(raw, &n, 1, 1);                    // SRR
+        put_bits(raw, &n, 1, 1);                    // IDE
+        put_bits(raw, &n, frame->id & 0x3FFFF, 18);
+        put_bits(raw, &n, frame->rtr, 1);
+        put_bits(raw, &n, 0, 2);                    // r1, r0
+    } else {
+        put_bits(raw, &n, frame->id & 0x7FF, 11);
+        put_bits(raw, &n, frame->rtr, 1);
+        put_bits(raw, &n, 0, 1);                    // IDE
+        put_bits(raw, &n, 0, 1);                    // r0
+    }
+    put_bits(raw, &n, dlc, 4);
+    if (!frame->rtr) {
+        for (int i = 0; i < dlc; i++) {
+            put_bits(raw, &n, frame->data[i], 8);
+        }
+    }
+    put_bits(raw, &n, can_bitstream_crc15(raw, n), 15);
+
+    // Stuff SOF .. CRC: after five equal bits insert one of the opposite level
+    int out = 0;
+    uint8_t run_bit = 2;
+    int run_len = 0;
+    for (int i = 0; i < n; i++) {
+        if (out + 2 > max_bits) {
+            return -1;
+        }
+        bits[out++] = raw[i];
+        if (raw[i] == run_bit) {
+            run_len++;
+        } else {
+            run_bit = raw[i];
+            run_len = 1;
+        }
+        if (run_len == STUFF_RUN) {
+            run_bit ^= 1;
+            bits[out++] = run_bit;
+            run_len = 1;
+        }
+    }
+
+    // CRC delimiter, ACK slot, ACK delimiter, EOF
+    if (out + 10 > max_bits) {
+        return -1;
+    }
+    bits[out++] = 1;
+    bits[out++] = acked ? 0 : 1;
+    bits[out++] = 1;
+    for (int i = 0; i < 7; i++) {
+        bits[out++] = 1;
+    }
+    return out;
+}
+
+void can_bitstream_decoder_init(can_bitstream_decoder_t* dec) {
+    memset(dec, 0, sizeof(*dec));
+    dec->state = S_WAIT_IDLE;
+}
+
+static inline void wait_idle(can_bitstream_decoder_t* dec) {
+    dec->state = S_WAIT_IDLE;
+    dec->idle_count = 0;
+}
+
+static inline void next_field(can_bitstream_decoder_t* dec, uint8_t state, uint8_t bits) {
+    dec->state = state;
+    dec->field_bits = bits;
+    dec->acc = 0;
+}
+
+bool HOT_PATH_FUNC(can_bitstream_push_bit)(can_bitstream_decoder_t* dec, uint8_t bit, can_frame_t* frame) {
+    bit &= 1;
+
+    switch (dec->state) {
+    case S_WAIT_IDLE:
+        if (!bit) {
+            dec->idle_count = 0;
+        } else if (++dec->idle_count >= CAN_BITSTREAM_IDLE_BITS) {
+            dec->state = S_IDLE;
+        }
+        return false;
+
+    case S_IDLE:
+        if (bit) {
+            return false;
+        }
+        // SOF
+        memset(&dec->frame, 0, sizeof(dec->frame));
+        dec->crc = crc15_update(0, 0);
+        dec->run_bit = 0;
+        dec->run_len = 1;
+        next_field(dec, S_ID_A, 11);
+        return false;
+
+    default:
+        break;
+    }
+
+    // Destuff SOF .. CRC, including a stuff bit after the last CRC bit
+    if (dec->state != S_CRC_DELIM || dec->run_len == STUFF_RUN) {
+        if (dec->run_len == STUFF_RUN) {
+            if (bit == dec->run_bit) {
+                dec->stats.stuff_errors++;
+                wait_idle(dec);
+                return false;
+            }
+            dec->run_bit = bit;
+            dec->run_len = 1;
+            return false;
+        }
+        if (bit == dec->run_bit) {
+            dec->run_len++;
+        } else {
+            dec->run_bit = bit;
+            dec->run_len = 1;
+        }
+    }
+
+    if (dec->state == S_CRC_DELIM) {
+        bool valid = false;
+        if (!bit) {
+            dec->stats.form_errors++;
+        } else if (dec->acc != dec->crc) {
+            dec->stats.crc_errors++;
+        } else {
+            dec->stats.frames++;
+            *frame = dec->frame;
+            valid = true;
+        }
+        wait_idle(dec);
+        return valid;
+    }
+
+    if (dec->state != S_CRC) {
+        dec->crc = crc15_update(dec->crc, bit);
+    }
+    dec->acc = (dec->acc << 1) | bit;
+    if (--dec->field_bits) {
+        return false;
+    }
+
+    can_frame_t* f = &dec->frame;
+    switch (dec->state) {
+    case S_ID_A:
+        f->id = dec->acc;
+        next_field(dec, S_SRR_RTR, 1);
+        break;
+    case S_SRR_RTR:
+        f->rtr = dec->acc;
+        next_field(dec, S_IDE, 1);
+        break;
+    case S_IDE:
+        f->extended = dec->acc;
+        if (f->extended) {
+            next_field(dec, S_ID_B, 18);
+        } else {
+            next_field(dec, S_R0, 1);
+        }
+        break;
+    case S_R0:
+    case S_R1R0:
+        next_field(dec, S_DLC, 4);
+        break;
+    case S_ID_B:
+        f->id = (f->id << 18) | dec->acc;
+        next_field(dec, S_RTR_EXT, 1);
+        break;
+    case S_RTR_EXT:
+        f->rtr = dec->acc;
+        next_field(dec, S_R1R0, 2);
+        break;
+    case S_DLC:
+        // DLC 9-15 is legal on the wire and means 8 bytes
+        f->dlc = dec->acc > 8 ? 8 : dec->acc;
+        dec->data_bytes = f->rtr ? 0 : f->dlc;
+        if (dec->data_bytes) {
+            next_field(dec, S_DATA, 8);
+        } else {
+            next_field(dec, S_CRC, 15);
+        }
+        break;
+    case S_DATA:
+        f->data[f->dlc - dec->data_bytes] = dec->acc;
+        if (--dec->data_bytes) {
+            next_field(dec, S_DATA, 8);
+        } else {
+            next_field(dec, S_CRC, 15);
+        }
+        break;
+    case S_CRC:
+        // Keep the received CRC in acc for the delimiter check
+        dec->state = S_CRC_DELIM;
+        break;
+    }
+    return false;
+}
+
+int HOT_PATH_FUNC(can_bitstream_push_word)(can_bitstream_decoder_t* dec, uint32_t word, can_frame_t* frame) {
+    // Fast path: an idle bus samples as all-recessive words
+    if (word == 0xFFFFFFFF) {
+        if (dec->state == S_IDLE) {
+            return -1;
+        }
+        if (dec->state == S_WAIT_IDLE) {
+            dec->idle_count += 32;
+            if (dec->idle_count >= CAN_BITSTREAM_IDLE_BITS) {
+                dec->state = S_IDLE;
+            }
+            return -1;
+        }
+    }
+
+    int done = -1;
+    for (int i = 0; i < 32; i++) {
+        if (can_bitstream_push_bit(dec, (word >> (31 - i)) & 1, frame)) {
+            done = i;
+        }
+    }
+    return done;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file      can_bitstream.h
+ * @brief     CAN 2.0B bit-level frame codec (bit stuffing, CRC-15, framing)
+ *
+ * Hardware-independent half of the PIO CAN receiver (can_pio.c). The PIO
+ * samples the bus once per bit and DMAs the raw bits into memory; this module
+ * turns that bit stream back into frames. The encoder produces the exact bit
+ * sequence a transmitter puts on the wire, so the decoder can be exercised on
+ * a host against generated bit streams.
+ *
+ * Bits are 1 = recessive, 0 = dominant. Words are MSB first (the PIO shifts
+ * left), so bit 31 of a word is the earliest bit on the wire.
+ */
+
+#ifndef CAN_BITSTREAM_H
+#define CAN_BITSTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest frame on the wire: 29-bit ID, 8 data bytes, worst-case stuffing,
+// CRC delimiter, ACK, EOF
+#define CAN_BITSTREAM_MAX_BITS  160
+
+// Recessive bits (ACK delimiter + EOF + intermission) before a SOF is accepted
+#define CAN_BITSTREAM_IDLE_BITS 11
+
+/**
+ * One CAN 2.0A/B data or remote frame
+ */
+typedef struct {
+    uint32_t id;                    // 11- or 29-bit identifier
+    bool     extended;              // 29-bit identifier (IDE)
+    bool     rtr;                   // Remote frame, no data
+    uint8_t  dlc;                   // 0-8
+    uint8_t  data[8];
+} can_frame_t;
+
+/**
+ * Decoder error and frame counters
+ */
+typedef struct {
+    uint32_t frames;                // Frames with a valid CRC and delimiter
+    uint32_t stuff_errors;          // Six equal bits inside the stuffed region
+    uint32_t crc_errors;            // CRC-15 mismatch
+    uint32_t form_errors;           // Bad fixed-form bit (SRR, CRC delimiter)
+} can_bitstream_stats_t;
+
+/**
+ * Streaming decoder state (one per bus)
+ */
+typedef struct {
+    uint8_t  state;                 // can_bitstream.c internal
+    uint8_t  field_bits;            // Bits left in the current field
+    uint8_t  run_bit;               // Level of the current stuffing run
+    uint8_t  run_len;               // Length of the current stuffing run
+    uint16_t crc;                   // Running CRC-15
+    uint16_t idle_count;            // Consecutive recessive bits while waiting for idle
+    uint32_t acc;                   // Current field accumulator
+    uint8_t  data_bytes;            // Data bytes still expected
+    can_frame_t frame;              // Frame being assembled
+    can_bitstream_stats_t stats;
+} can_bitstream_decoder_t;
+
+/**
+ * @brief Compute the CAN CRC-15 over a destuffed bit sequence
+ *
+ * @param bits One bit per byte
+ * @param count Number of bits
+ * @return 15-bit CRC
+ */
+uint16_t can_bitstream_crc15(const uint8_t* bits, int count);
+
+/**
+ * @brief Encode a frame into the bit sequence seen on the wire
+ *
+ * Produces SOF through EOF with stuff bits inserted. The ACK slot is driven
+ * dominant when acked is true, as a receiving node would.
+ *
+ * @param frame Frame to encode (dlc is clamped to 8)
+ * @param acked Level of the ACK slot
+ * @param bits Output, one bit per byte
+ * @param max_bits Capacity of bits (CAN_BITSTREAM_MAX_BITS is always enough)
+ * @return Number of bits written, or -1 if max_bits is too small
+ */
+int can_bitstream_encode(const can_frame_t* frame, bool acked, uint8_t* bits, int max_bits);
+
+/**
+ * @brief Reset a decoder; it waits for bus idle before accepting a SOF
+ *
+ * @param dec Decoder to reset (statistics are cleared)
+ */
+void can_bitstream_decoder_init(can_bitstream_decoder_t* dec);
+
+/**
+ * @brief Feed one bit
+ *
+ * @param dec Decoder
+ * @param bit Sampled bus level (1 = recessive)
+ * @param frame Filled when a frame completes
+ * @return true if this bit (the CRC delimiter) completed a valid frame
+ */
+bool can_bitstream_push_bit(can_bitstream_decoder_t* dec, uint8_t bit, can_frame_t* frame);
+
+/**
+ * @brief Feed 32 bits, MSB first
+ *
+ * Whole recessive words are skipped in one step while the bus is idle. A
+ * word can complete at most one frame (a frame is longer than 32 bits).
+ *
+ * @param dec Decoder
+ * @param word Sampled bits, bit 31 first
+ * @param frame Filled when a frame completes
+ * @return Index (0 = bit 31) of the bit that completed a frame, or -1
+ */
+int can_bitstream_push_word(can_bitstream_decoder_t* dec, uint32_t word, can_frame_t* frame);
+
+#endif // CAN_BITSTREAM_H
@@ -4,8 +4,15 @@
  */
 
 #include "can_handler.h"
+#include "hot_path.h"
 #include "src/mcp2515/MCP2515/MCP2515.h"
 #include "src/mcp2515/Config/DEV_Config.h"
+#include "can_pio.h"
+#include "can_autobaud.h"
+#include "can_profiler.h"
+#include "decode_kernel.h"
+#include "sample_queue.h"
+#include "alarm_engine.h"
 #include <stdio.h>
 
 // Global state
@@ -13,6 +20,10 @@ static ft550_sensor_data_t g_sensor_data;
 static spin_lock_t* g_spin_lock;
 static uint32_t g_frame_count = 0;
 
+_Static_assert(SAMPLE_CH_YAW_RATE_LATERAL - SAMPLE_CH_WHEEL_SPEED_FR ==
+               FT550_CH_YAW_RATE_LATERAL - FT550_CH_WHEEL_SPEED_FR,
+               "chassis sample channels follow the FT550 channel order");
+
 // FT550 frame IDs we want to receive
 static const uint32_t FT550_FRAME_IDS[] = {
     FT550_FRAME_TPS_MAP_TEMPS,
@@ -26,6 +37,75 @@ static const uint32_t FT550_FRAME_IDS[] = {
     FT550_FRAME_TRANS_TEMPS_FUEL
 };
 
+static bool decode_ecu_frame(uint32_t frame_id, const uint8_t* data, uint8_t len, uint32_t timestamp_us);
+static bool decode_chassis_frame(uint32_t frame_id, const uint8_t* data, uint8_t len, uint32_t timestamp_us);
+
+/**
+ * Per-bus ingest state
+ */
+typedef struct {
+    const MCP2515_Dev* dev;         // NULL = PIO receiver
+    // Returns false if the frame's ID is not one the decoder uses
+    bool (*decode)(uint32_t frame_id, const uint8_t* data, uint8_t len, uint32_t timestamp_us);
+    bool present;
+    uint8_t rate;                   // enum RATEBPS the controller runs at
+    volatile uint32_t edge_us;      // INT falling edge of the oldest unread frame
+    uint32_t frames;
+} can_bus_state_t;
+
+static can_bus_state_t g_bus[CAN_NUM_BUSES] = {
+#if CAN_ECU_BACKEND_PIO
+    [CAN_BUS_ECU]     = { NULL,          decode_ecu_frame },
+#else
+    [CAN_BUS_ECU]     = { &MCP2515_DEV0, decode_ecu_frame },
+#endif
+    [CAN_BUS_CHASSIS] = { &MCP2515_DEV1, decode_chassis_frame },
+};
+
+static void (*g_rx_callback)(void) = NULL;
+
+// M84 channels in the burst block: byte offset of the big-endian int16 from
+// the magic number, decoded raw (see sample_channel_scale)
+enum { M84_TPS, M84_RPM, M84_ENGINE_TEMP, M84_AIR_TEMP, M84_BATTERY, M84_MAP, M84_NUM_CHANNELS };
+static const uint16_t M84_OFFSETS[M84_NUM_CHANNELS] HOT_PATH_DATA = { 6, 4, 12, 14, 48, 78 };
+
+// INT falling edge: stamp the bus so the merge can order frames by arrival.
+// Taking the interrupt is also enough to wake the core from __wfe() (the
+// scheduler then polls can_rx_pending()); an RTOS build registers a callback
+// to notify its ingest task instead
+static void HOT_PATH_FUNC(can_int_isr)(uint gpio, uint32_t events) {
+    (void)events;
+    for (int bus = 0; bus < CAN_NUM_BUSES; bus++) {
+        if (g_bus[bus].dev && g_bus[bus].dev->int_pin == gpio) {
+            g_bus[bus].edge_us = time_us_32();
+        }
+    }
+    if (g_rx_callback) {
+        g_rx_callback();
+    }
+}
+
+static inline bool bus_pending(const can_bus_state_t* bus) {
+    if (!bus->present) {
+        return false;
+    }
+    if (!bus->dev) {
+        return can_pio_rx_pending();
+    }
+    return DEV_Digital_Read(bus->dev->int_pin) == 0;
+}
+
+// Arrival time of the bus's oldest unread frame (only valid while pending)
+static inline uint32_t bus_oldest_us(const can_bus_state_t* bus) {
+    return bus->dev ? bus->edge_us : can_pio_next_timestamp();
+}
+
+// Every decoded value goes to the core 1 sample stream and the alarm rules
+static inline void emit_sample(uint8_t channel, int32_t value, uint32_t now_us) {
+    sample_queue_push(channel, value, now_us);
+    alarm_on_sample(channel, value, now_us);
+}
+
 void can_init(void) {
     // Initialize sensor data
     ft550_init_sensor_data(&g_sensor_data);
@@ -36,10 +116,39 @@ void can_init(void) {
     // Initialize hardware (SPI, GPIO, etc.) - MUST be called before MCP2515_Init()
     DEV_Module_Init();
     
-    // Initialize MCP2515
-    MCP2515_Init();
+#if CAN_ECU_BACKEND_PIO
+    // The CS0 controller only sends dash frames in this configuration
+    MCP2515_Dev_Init(&MCP2515_DEV0, KBPS1000);
+#endif
+
+    // Initialize the receivers; INT lines for event-driven ingest
+    int num_buses = CAN_CHASSIS_BUS_ENABLED ? CAN_NUM_BUSES : 1;
+    for (int bus = 0; bus < num_buses; bus++) {
+        can_bus_state_t* b = &g_bus[bus];
+        b->rate = CAN_AUTOBAUD_DEFAULT_RATE;    // PIO receiver runs at CAN_PIO_BITRATE
+        if (!b->dev) {
+            // PIO receiver is polled from can_rx_pending() (1 ms backstop)
+            b->present = can_pio_init(CAN_PIO_RX_PIN, CAN_PIO_BITRATE);
+            printf("CAN: bus %d on PIO receiver (GPIO %d)%s\n", bus, CAN_PIO_RX_PIN,
+                   b->present ? "" : " failed, no free PIO state machine or DMA channel");
+            continue;
+        }
+        b->present = MCP2515_Dev_Init(b->dev, CAN_AUTOBAUD_DEFAULT_RATE) == 0;
+        if (!b->present) {
+            printf("CAN: bus %d controller not found, skipping\n", bus);
+            continue;
+        }
+        b->rate = can_autobaud_detect(b->dev, bus);
+        if (MCP2515_Dev_Reinit(b->dev, b->rate) != 0) {
+            printf("CAN: bus %d did not enter normal mode\n", bus);
+        }
+        DEV_GPIO_Mode(b->dev->int_pin, 0);
+        gpio_set_irq_enabled_with_callback(b->dev->int_pin, GPIO_IRQ_EDGE_FALL, true, can_int_isr);
+    }
     
-    printf("CAN: Initialized MCP2515 at 1 Mbps, extended 29-bit identifiers\n");
+    printf("CAN: Initialized (ECU %s, chassis %s), extended 29-bit identifiers\n",
+           g_bus[CAN_BUS_ECU].present ? "up" : "missing",
+           g_bus[CAN_BUS_CHASSIS].present ? "up" : "missing");
 }
 
 // -- REWORKED FOR MOTEC M84 DECODING -- SEE GIT HISTORY FOR FT550LITE IMPLEMENTATION. CODE STILL EXISTS IN ft550_decoder.c
@@ -50,24 +159,83 @@ handles the burst of frames and extracts the relevant data.
 If anyone is looking at this in years to come, get in touch with me (Louis) if you need any help.
 */
 
-bool can_process_frame(void) {
+bool HOT_PATH_FUNC(can_process_frame)(void) {
+    // Merge: serve the bus whose oldest frame raised INT first
+    can_bus_state_t* bus = NULL;
+    for (int i = 0; i < CAN_NUM_BUSES; i++) {
+        can_bus_state_t* b = &g_bus[i];
+        if (bus_pending(b) && (!bus || (int32_t)(bus_oldest_us(b) - bus_oldest_us(bus)) < 0)) {
+            bus = b;
+        }
+    }
+    if (!bus) {
+        return false;
+    }
+
     uint32_t received_id = 0;
     uint8_t rx_buffer[8] = {0}; 
-    
-    if (MCP2515_Receive_Fast(&received_id, rx_buffer) != 0) {
+    uint32_t timestamp_us = bus->edge_us;
+    int8_t len;
+
+    if (!bus->dev) {
+        len = can_pio_receive(&received_id, rx_buffer, &timestamp_us);
+    } else {
+        len = MCP2515_Dev_Receive_Fast(bus->dev, &received_id, rx_buffer);
+
+        // The second RX buffer keeps INT low without a new edge; it arrived
+        // no earlier than now as far as ordering is concerned
+        if (len >= 0 && bus_pending(bus)) {
+            bus->edge_us = time_us_32();
+        }
+    }
+    if (len < 0) {
         return false; 
     }
+    bus->frames++;
+
+    bool decoded = bus->decode(received_id, rx_buffer, (uint8_t)len, timestamp_us);
+    can_profiler_record((can_bus_t)(bus - g_bus), received_id, (uint8_t)len, timestamp_us, decoded);
+    return true;
+}
+
+// Chassis bus: FT550-format sensor frames (wheel speeds, traction/heading,
+// shocks, g-forces). Engine frames come from the ECU bus only.
+static bool HOT_PATH_FUNC(decode_chassis_frame)(uint32_t frame_id, const uint8_t* data, uint8_t len, uint32_t timestamp_us) {
+    if (len < 8 || frame_id < FT550_FRAME_WHEEL_SPEEDS || frame_id > FT550_FRAME_G_FORCE_YAW) {
+        return false;
+    }
 
-    if (received_id != 0x100) return true; 
+    // Four channels per frame, in the same order on both sides
+    uint32_t first = (frame_id - FT550_FRAME_WHEEL_SPEEDS) * 4;
+    const int16_t* words = &g_sensor_data.raw[FT550_CH_WHEEL_SPEED_FR + first];
+    int16_t raw[4];
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    ft550_decode_frame(frame_id, data, &g_sensor_data);
+    memcpy(raw, words, sizeof(raw));
+    spin_unlock(g_spin_lock, lock_owner);
+
+    // Stream every update, as for the ECU channels
+    for (uint32_t i = 0; i < 4; i++) {
+        bool is_unsigned = (FT550_UNSIGNED_CHANNELS >> (FT550_CH_WHEEL_SPEED_FR + first + i)) & 1;
+        emit_sample((uint8_t)(SAMPLE_CH_WHEEL_SPEED_FR + first + i),
+                    is_unsigned ? (uint16_t)raw[i] : raw[i], timestamp_us);
+    }
+    sample_queue_publish();
+    return true;
+}
+
+static bool HOT_PATH_FUNC(decode_ecu_frame)(uint32_t received_id, const uint8_t* rx_buffer, uint8_t len, uint32_t timestamp_us) {
+    (void)len;
+    if (received_id != 0x100) return false; 
 
     static uint8_t m84_block[256]; // Increased buffer slightly for safety
     static int frame_index = 0;
-    static uint32_t last_rx_time = 0;
-
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
+    static uint32_t frames_dropped = 0;
+    static uint32_t last_rx_us = 0;
 
     // If there is a gap of >5ms, the previous burst finished. Decode it!
-    if ((current_time - last_rx_time) > 5) {
+    if ((timestamp_us - last_rx_us) > 5000) {
         
         int anchor_idx = -1;
         
@@ -81,39 +249,75 @@ bool can_process_frame(void) {
         }
 
         if (anchor_idx != -1) {
-            #define MOTEC_I16(offset) ((int16_t)((m84_block[offset] << 8) | m84_block[offset + 1]))
+            // Dynamically map based on the anchor position
+            // (anchor_idx is normally 8, but will adapt if frames drop)
+            int32_t raw[M84_NUM_CHANNELS];
+            decode_kernel_gather(&m84_block[anchor_idx], M84_OFFSETS, raw, M84_NUM_CHANNELS);
+            int16_t tps_raw  = (int16_t)raw[M84_TPS];
+            int16_t rpm_raw  = (int16_t)raw[M84_RPM];
+            int16_t et_raw   = (int16_t)raw[M84_ENGINE_TEMP];
+            int16_t at_raw   = (int16_t)raw[M84_AIR_TEMP];
+            int16_t batt_raw = (int16_t)raw[M84_BATTERY];
+            int16_t map_raw  = (int16_t)raw[M84_MAP];
 
             uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
             {
-                // Dynamically map based on the anchor position
-                // (anchor_idx is normally 8, but will adapt if frames drop)
-                g_sensor_data.tps = MOTEC_I16(anchor_idx + 6) * 0.1f;           
-                g_sensor_data.rpm = MOTEC_I16(anchor_idx + 4);                
-                g_sensor_data.engine_temp = MOTEC_I16(anchor_idx + 12) * 0.1f;   
-                g_sensor_data.air_temp = MOTEC_I16(anchor_idx + 14) * 0.1f;      
-                g_sensor_data.battery_voltage = MOTEC_I16(anchor_idx + 48) * 0.01f;
-                g_sensor_data.map = MOTEC_I16(anchor_idx + 78) * 0.1f;           
-                
+                // Raw words; the M84 scales match ft550_channel_scale
+                g_sensor_data.raw[FT550_CH_TPS] = tps_raw;
+                g_sensor_data.raw[FT550_CH_RPM] = rpm_raw;
+                g_sensor_data.raw[FT550_CH_ENGINE_TEMP] = et_raw;
+                g_sensor_data.raw[FT550_CH_AIR_TEMP] = at_raw;
+                g_sensor_data.raw[FT550_CH_BATTERY_VOLTAGE] = batt_raw;
+                g_sensor_data.raw[FT550_CH_MAP] = map_raw;
+
                 g_frame_count++;
             }
             spin_unlock(g_spin_lock, lock_owner);
+
+            // Stream every update to core 1 and the alarm engine
+            // (raw values, see sample_channel_scale)
+            emit_sample(SAMPLE_CH_RPM, (uint16_t)rpm_raw, timestamp_us);
+            emit_sample(SAMPLE_CH_TPS, tps_raw, timestamp_us);
+            emit_sample(SAMPLE_CH_ENGINE_TEMP, et_raw, timestamp_us);
+            emit_sample(SAMPLE_CH_AIR_TEMP, at_raw, timestamp_us);
+            emit_sample(SAMPLE_CH_BATTERY_VOLTAGE, batt_raw, timestamp_us);
+            emit_sample(SAMPLE_CH_MAP, map_raw, timestamp_us);
+            sample_queue_publish();
         } else {
             // Optional: Print a warning if the block was too corrupt to find the anchor
             // printf("Warning: M84 Magic Number not found in block!\n");
         }
-        
+
+        if (frame_index > 0) {
+            can_profiler_record_block((uint32_t)frame_index, frames_dropped, anchor_idx != -1);
+        }
         frame_index = 0; 
+        frames_dropped = 0;
     }
     
-    last_rx_time = current_time;
+    last_rx_us = timestamp_us;
 
     // Assemble the frames
     if (frame_index < 32) { // 32 * 8 = 256 bytes max
         memcpy(&m84_block[frame_index * 8], rx_buffer, 8);
         frame_index++;
+    } else {
+        frames_dropped++;
+    }
+    return true;
+}
+
+bool HOT_PATH_FUNC(can_rx_pending)(void) {
+    for (int bus = 0; bus < CAN_NUM_BUSES; bus++) {
+        if (bus_pending(&g_bus[bus])) {
+            return true;
+        }
     }
+    return false;
+}
 
-    return true; 
+void can_set_rx_callback(void (*callback)(void)) {
+    g_rx_callback = callback;
 }
 
 void can_get_sensor_data_safe(ft550_sensor_data_t* sensor_data) {
@@ -131,3 +335,15 @@ void can_get_sensor_data_safe(ft550_sensor_data_t* sensor_data) {
 uint32_t can_get_frame_count(void) {
     return g_frame_count;
 }
+
+bool can_bus_present(can_bus_t bus) {
+    return bus < CAN_NUM_BUSES && g_bus[bus].present;
+}
+
+uint8_t can_get_bus_rate(can_bus_t bus) {
+    return bus < CAN_NUM_BUSES ? g_bus[bus].rate : CAN_AUTOBAUD_DEFAULT_RATE;
+}
+
+uint32_t can_get_bus_frame_count(can_bus_t bus) {
+    return bus < CAN_NUM_BUSES ? g_bus[bus].frames : 0;
+}
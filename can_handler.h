@@ -4,6 +4,12 @@
  * 
  * Provides high-level CAN bus initialization, frame reception, and thread-safe
  * access to decoded FT550 sensor data.
+ *
+ * Two MCP2515s share spi0: the ECU bus (CS0/INT0, MoTeC M84 burst) and the
+ * chassis bus (CS1/INT1, FT550-format wheel speed, shock and g-force frames).
+ * Both INT lines are edge-timestamped in the GPIO interrupt and
+ * can_process_frame() always reads the bus holding the oldest frame, so the
+ * two streams reach the decoders in arrival order.
  */
 
 #ifndef CAN_HANDLER_H
@@ -14,14 +20,35 @@
 #include "ft550_decoder.h"
 #include "pico/sync.h"
 
+// Build without the chassis controller (single-bus boards)
+#ifndef CAN_CHASSIS_BUS_ENABLED
+#define CAN_CHASSIS_BUS_ENABLED 1
+#endif
+
+// Receive the ECU bus with the listen-only PIO receiver (can_pio.h) instead
+// of the CS0 MCP2515, which is then only used to send dash frames
+#ifndef CAN_ECU_BACKEND_PIO
+#define CAN_ECU_BACKEND_PIO 0
+#endif
+
+/**
+ * CAN buses, one MCP2515 each
+ */
+typedef enum {
+    CAN_BUS_ECU = 0,                // MoTeC M84 (CS0 / INT0)
+    CAN_BUS_CHASSIS,                // Chassis sensors (CS1 / INT1)
+    CAN_NUM_BUSES
+} can_bus_t;
+
 /**
  * @brief Initialize CAN bus for FT550 communication
  * 
- * Configures MCP2515 for:
- * - 1 Mbps baud rate
+ * Configures each MCP2515 for:
+ * - the bus's bit rate, detected in listen-only mode (can_autobaud.h)
  * - Extended 29-bit CAN identifiers
  * - RX filters for all FT550 frame IDs (0x14080600-0x14080608)
  * 
+ * A controller that does not answer after reset is left out of ingest.
  * Must be called before any other CAN operations.
  */
 void can_init(void);
@@ -29,14 +56,59 @@ void can_init(void);
 /**
  * @brief Poll for incoming CAN frames and update sensor data
  * 
- * Non-blocking function that checks for new frames on the RX buffer
+ * Non-blocking function that reads the oldest pending frame from either bus
  * and updates the internal sensor data structure if frames are received.
- * Call this periodically (e.g., at 100Hz to match ECU broadcast rate).
+ * Call in a loop until it returns false to drain both controllers.
  * 
  * @return true if a frame was received and processed, false otherwise
  */
 bool can_process_frame(void);
 
+/**
+ * @brief Check whether either MCP2515 is holding frames for us
+ * 
+ * Reads the MCP2515 INT lines (active low while RX0IF/RX1IF is set). A falling
+ * edge on the line also raises a GPIO interrupt on the calling core, which is
+ * enough to wake the scheduler out of __wfe().
+ * 
+ * @return true if at least one RX buffer is full
+ */
+bool can_rx_pending(void);
+
+/**
+ * @brief Register a callback invoked from the MCP2515 INT interrupt
+ * 
+ * Lets an RTOS build defer ingest to a task (e.g. task notification).
+ * The callback runs in interrupt context and must be short.
+ * 
+ * @param callback Function to call on each INT falling edge (NULL to clear)
+ */
+void can_set_rx_callback(void (*callback)(void));
+
+/**
+ * @brief Check whether a bus controller answered during can_init()
+ *
+ * @param bus Bus to query
+ * @return true if the controller is fitted and ingesting
+ */
+bool can_bus_present(can_bus_t bus);
+
+/**
+ * @brief Get the bit rate a bus controller was configured for
+ *
+ * @param bus Bus to query
+ * @return MCP2515 rate index (enum RATEBPS in MCP2515.h)
+ */
+uint8_t can_get_bus_rate(can_bus_t bus);
+
+/**
+ * @brief Get the number of raw frames read from one bus
+ *
+ * @param bus Bus to query
+ * @return Frames read since can_init()
+ */
+uint32_t can_get_bus_frame_count(can_bus_t bus);
+
 /**
  * @brief Get a thread-safe copy of the latest sensor data
  * 
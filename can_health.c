@@ -0,0 +1,187 @@
+/**
+ * @file      can_health.c
+ * @brief     MCP2515 error-state monitoring and fast recovery implementation
+ */
+
+#include "can_health.h"
+#include <string.h>
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+#include "telemetry_packet.h"
+#include "safe_print.h"
+
+// Shared with core 1, written on core 0 only, guarded by g_spin_lock
+static spin_lock_t* g_spin_lock;
+static can_health_t g_health;
+
+// Core 0 state
+static uint8_t g_passive_polls[CAN_NUM_BUSES];
+static bool g_faulted[CAN_NUM_BUSES];
+static uint32_t g_fault_since_us[CAN_NUM_BUSES];
+
+static uint16_t sat16(uint32_t value) {
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+// MCP2515 behind a bus, or NULL if it is not fitted or not an MCP2515
+static const MCP2515_Dev* bus_device(can_bus_t bus) {
+    if (!can_bus_present(bus)) {
+        return NULL;
+    }
+    switch (bus) {
+        case CAN_BUS_ECU:
+            return CAN_ECU_BACKEND_PIO ? NULL : &MCP2515_DEV0;
+        case CAN_BUS_CHASSIS:
+            return &MCP2515_DEV1;
+        default:
+            return NULL;
+    }
+}
+
+static can_health_state_t classify(const MCP2515_Status* status) {
+    if ((status->canstat & 0xE0) != OPMODE_NORMAL) return CAN_HEALTH_STOPPED;
+    if (status->eflg & TXBO) return CAN_HEALTH_BUS_OFF;
+    if (status->eflg & (TXEP | RXEP)) return CAN_HEALTH_PASSIVE;
+    if (status->eflg & EWARN) return CAN_HEALTH_WARNING;
+    return CAN_HEALTH_ACTIVE;
+}
+
+void can_health_init(void) {
+    if (!g_spin_lock) {
+        g_spin_lock = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    memset(&g_health, 0, sizeof(g_health));
+    for (int bus = 0; bus < CAN_NUM_BUSES; bus++) {
+        g_health.bus[bus].state = bus_device(bus) ? CAN_HEALTH_ACTIVE : CAN_HEALTH_MISSING;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+
+    memset(g_passive_polls, 0, sizeof(g_passive_polls));
+    memset(g_faulted, 0, sizeof(g_faulted));
+}
+
+void can_health_poll(void) {
+    for (int bus = 0; bus < CAN_NUM_BUSES; bus++) {
+        const MCP2515_Dev* dev = bus_device(bus);
+        if (!dev) {
+            continue;
+        }
+
+        MCP2515_Status status;
+        bool answered = MCP2515_Dev_Read_Status(dev, &status) == 0;
+        can_health_state_t state = answered ? classify(&status) : CAN_HEALTH_STOPPED;
+
+        // Overflow only loses frames; clearing the latch is enough
+        bool overflow = answered && (status.eflg & (RX0OVR | RX1OVR));
+        if (overflow) {
+            MCP2515_Dev_Clear_Overflow(dev);
+        }
+
+        // Bus-off and stopped controllers never come back by themselves in
+        // useful time; error-passive gets a few polls to clear on its own
+        bool recover = state == CAN_HEALTH_BUS_OFF || state == CAN_HEALTH_STOPPED;
+        if (state == CAN_HEALTH_PASSIVE) {
+            recover = ++g_passive_polls[bus] >= CAN_HEALTH_PASSIVE_POLLS;
+        } else {
+            g_passive_polls[bus] = 0;
+        }
+        if (recover && !g_faulted[bus]) {
+            g_faulted[bus] = true;
+            g_fault_since_us[bus] = time_us_32();
+        }
+
+        bool recovered = false;
+        uint32_t recovery_us = 0;
+        if (recover) {
+            uint32_t start_us = time_us_32();
+            recovered = MCP2515_Dev_Reinit(dev, can_get_bus_rate(bus)) == 0;
+            recovery_us = time_us_32() - start_us;
+            g_passive_polls[bus] = 0;
+        }
+
+        uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+        can_bus_health_t* h = &g_health.bus[bus];
+        if (state != h->state) {
+            if (state == CAN_HEALTH_BUS_OFF) h->bus_off_events++;
+            if (state == CAN_HEALTH_PASSIVE) h->passive_events++;
+            if (state == CAN_HEALTH_STOPPED) h->stopped_events++;
+        }
+        h->state = state;
+        h->tec = status.tec;
+        h->rec = status.rec;
+        h->eflg = status.eflg;
+        if (overflow) {
+            h->overflows++;
+        }
+        if (recover) {
+            if (recovery_us > g_health.recovery_max_us) {
+                g_health.recovery_max_us = recovery_us;
+            }
+            if (recovered) {
+                // Reset clears TEC/REC/EFLG
+                h->recoveries++;
+                h->state = CAN_HEALTH_ACTIVE;
+                h->tec = 0;
+                h->rec = 0;
+                h->eflg = 0;
+                g_health.downtime_ms += (time_us_32() - g_fault_since_us[bus]) / 1000;
+            } else {
+                h->recovery_failures++;
+            }
+        }
+        spin_unlock(g_spin_lock, lock_owner);
+
+        if (recover) {
+            safe_printf("[CAN] bus %d state %d (TEC %u REC %u EFLG 0x%02x): re-init %s in %luus\n",
+                        bus, state, status.tec, status.rec, status.eflg,
+                        recovered ? "ok" : "FAILED", (unsigned long)recovery_us);
+            if (recovered) {
+                g_faulted[bus] = false;
+            }
+        }
+    }
+}
+
+void can_health_get(can_health_t* health) {
+    if (!health) {
+        return;
+    }
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    *health = g_health;
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void can_health_build_packet(telemetry_can_health_t* packet) {
+    can_health_t h;
+    can_health_get(&h);
+
+    const can_bus_health_t* ecu = &h.bus[CAN_BUS_ECU];
+    const can_bus_health_t* chassis = &h.bus[CAN_BUS_CHASSIS];
+
+    memset(packet, 0, sizeof(*packet));
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_CAN_HEALTH);
+    packet->downtime_ms = h.downtime_ms;
+    packet->recovery_max_us = h.recovery_max_us;
+
+    packet->ecu_overflows = sat16(ecu->overflows);
+    packet->ecu_bus_off = sat16(ecu->bus_off_events);
+    packet->ecu_passive = sat16(ecu->passive_events);
+    packet->ecu_recoveries = sat16(ecu->recoveries);
+    packet->ecu_tec = ecu->tec;
+    packet->ecu_rec = ecu->rec;
+    packet->ecu_eflg = ecu->eflg;
+    packet->ecu_state = ecu->state;
+
+    packet->chassis_overflows = sat16(chassis->overflows);
+    packet->chassis_bus_off = sat16(chassis->bus_off_events);
+    packet->chassis_passive = sat16(chassis->passive_events);
+    packet->chassis_recoveries = sat16(chassis->recoveries);
+    packet->chassis_tec = chassis->tec;
+    packet->chassis_rec = chassis->rec;
+    packet->chassis_eflg = chassis->eflg;
+    packet->chassis_state = chassis->state;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file      can_health.h
+ * @brief     MCP2515 error-state monitoring and fast recovery (core 0)
+ *
+ * can_health_poll() samples TEC, REC, EFLG and CANSTAT of every MCP2515 bus
+ * at CAN_HEALTH_PERIOD_MS. Latched RX0OVR/RX1OVR flags are counted and
+ * cleared. A controller that is bus-off, has left normal mode (e.g. reset by
+ * a supply glitch), stops answering, or stays error-passive for
+ * CAN_HEALTH_PASSIVE_POLLS samples is brought back with MCP2515_Dev_Reinit():
+ * an SPI reset and register reload that takes well under a millisecond,
+ * instead of a power cycle.
+ *
+ * Counters are shared with core 1 and sent as the telemetry_can_health_t
+ * packet alongside the radio diagnostics.
+ */
+
+#ifndef CAN_HEALTH_H
+#define CAN_HEALTH_H
+
+#include <stdint.h>
+#include "can_handler.h"
+#include "telemetry_schema.h"
+
+#define CAN_HEALTH_PERIOD_MS        100     // Sampling rate on core 0
+#define CAN_HEALTH_PASSIVE_POLLS    3       // Error-passive samples before a re-init
+
+/**
+ * Controller state, worst condition first
+ */
+typedef enum {
+    CAN_HEALTH_ACTIVE = 0,          // Error-active, counters < 96
+    CAN_HEALTH_WARNING,             // EWARN: a counter reached 96
+    CAN_HEALTH_PASSIVE,             // TEC or REC >= 128
+    CAN_HEALTH_BUS_OFF,             // TEC > 255, transmitter disconnected
+    CAN_HEALTH_STOPPED,             // Not in normal mode, or not answering SPI
+    CAN_HEALTH_MISSING              // Not fitted / not an MCP2515 bus
+} can_health_state_t;
+
+/**
+ * Per-bus counters
+ */
+typedef struct {
+    uint8_t  state;                 // can_health_state_t
+    uint8_t  tec;
+    uint8_t  rec;
+    uint8_t  eflg;
+    uint32_t overflows;             // Polls that found RX0OVR/RX1OVR latched
+    uint32_t bus_off_events;
+    uint32_t passive_events;
+    uint32_t stopped_events;
+    uint32_t recoveries;            // Successful re-inits
+    uint32_t recovery_failures;
+} can_bus_health_t;
+
+/**
+ * Snapshot of all buses
+ */
+typedef struct {
+    can_bus_health_t bus[CAN_NUM_BUSES];
+    uint32_t downtime_ms;           // First bad sample -> recovered, all buses
+    uint32_t recovery_max_us;       // Slowest MCP2515_Dev_Reinit()
+} can_health_t;
+
+/**
+ * @brief Reset the counters. Call after can_init().
+ */
+void can_health_init(void);
+
+/**
+ * @brief Sample every MCP2515 bus and recover faulted controllers (core 0)
+ *
+ * Call every CAN_HEALTH_PERIOD_MS from the task that owns CAN ingest.
+ */
+void can_health_poll(void);
+
+/**
+ * @brief Get a consistent copy of the counters (any core)
+ *
+ * @param health Structure to fill
+ */
+void can_health_get(can_health_t* health);
+
+/**
+ * @brief Build the CAN health telemetry packet (core 1)
+ *
+ * @param packet Packet to fill
+ */
+void can_health_build_packet(telemetry_can_health_t* packet);
+
+#endif // CAN_HEALTH_H
@@ -0,0 +1,161 @@
+/**
+ * @file      can_pio.c
+ * @brief     Listen-only PIO CAN receiver implementation
+ */
+
+#include "can_pio.h"
+#include "hot_path.h"
+#include <string.h>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "pico/time.h"
+#include "can_pio_rx.pio.h"
+
+#define RING_MASK       (CAN_PIO_RING_WORDS - 1)
+#define RING_BYTES      (CAN_PIO_RING_WORDS * sizeof(uint32_t))
+#define QUEUE_MASK      (CAN_PIO_QUEUE_DEPTH - 1)
+
+_Static_assert((CAN_PIO_RING_WORDS & RING_MASK) == 0,
+               "CAN_PIO_RING_WORDS must be a power of two");
+_Static_assert(RING_BYTES <= 32768, "DMA ring wrap is limited to 32 KB");
+_Static_assert((CAN_PIO_QUEUE_DEPTH & QUEUE_MASK) == 0,
+               "CAN_PIO_QUEUE_DEPTH must be a power of two");
+
+typedef struct {
+    can_frame_t frame;
+    uint32_t timestamp_us;
+} queued_frame_t;
+
+// The DMA write address wraps on RING_BYTES, so the ring must be aligned to it
+static uint32_t g_ring[CAN_PIO_RING_WORDS] __attribute__((aligned(RING_BYTES)));
+static int g_dma_chan = -1;
+static uint32_t g_read_idx = 0;
+static uint32_t g_ns_per_bit = 0;
+static uint32_t g_ring_us = 0;              // Time for the DMA to fill the ring once
+static uint32_t g_last_poll_us = 0;
+static can_bitstream_decoder_t g_decoder;
+
+static queued_frame_t g_queue[CAN_PIO_QUEUE_DEPTH];
+static uint32_t g_queue_head = 0;
+static uint32_t g_queue_tail = 0;
+
+static uint32_t g_ring_overruns = 0;
+static uint32_t g_queue_drops = 0;
+
+bool can_pio_init(uint32_t rx_pin, uint32_t bitrate) {
+    PIO pio;
+    uint sm;
+    uint offset;
+    if (!pio_claim_free_sm_and_add_program_for_gpio_range(&can_pio_rx_program, &pio, &sm, &offset,
+                                                          rx_pin, 1, true)) {
+        return false;
+    }
+    g_dma_chan = dma_claim_unused_channel(false);
+    if (g_dma_chan < 0) {
+        pio_remove_program_and_unclaim_sm(&can_pio_rx_program, pio, sm, offset);
+        return false;
+    }
+
+    can_bitstream_decoder_init(&g_decoder);
+    memset(g_ring, 0xFF, sizeof(g_ring));
+    g_read_idx = 0;
+    g_queue_head = 0;
+    g_queue_tail = 0;
+    g_ns_per_bit = 1000000000u / bitrate;
+    g_ring_us = (uint32_t)((uint64_t)CAN_PIO_RING_WORDS * 32 * 1000000 / bitrate);
+
+    // PIO RX FIFO -> ring, forever
+    dma_channel_config c = dma_channel_get_default_config(g_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, __builtin_ctz(RING_BYTES));
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(g_dma_chan, &c, g_ring, &pio->rxf[sm],
+                          dma_encode_endless_transfer_count(), true);
+
+    can_pio_rx_program_init(pio, sm, offset, rx_pin, bitrate);
+    g_last_poll_us = time_us_32();
+    return true;
+}
+
+static void HOT_PATH_FUNC(queue_frame)(const can_frame_t* frame, uint32_t timestamp_us) {
+    if (g_queue_head - g_queue_tail >= CAN_PIO_QUEUE_DEPTH) {
+        g_queue_drops++;
+        return;
+    }
+    queued_frame_t* q = &g_queue[g_queue_head & QUEUE_MASK];
+    q->frame = *frame;
+    q->timestamp_us = timestamp_us;
+    g_queue_head++;
+}
+
+// Decode every word the DMA has written since the last call
+static void HOT_PATH_FUNC(decode_new_words)(void) {
+    if (g_dma_chan < 0) {
+        return;
+    }
+
+    uint32_t now_us = time_us_32();
+    uint32_t write_addr = dma_channel_hw_addr(g_dma_chan)->write_addr;
+    uint32_t write_idx = ((write_addr - (uint32_t)(uintptr_t)g_ring) / sizeof(uint32_t)) & RING_MASK;
+
+    // Too long since the last poll: the DMA may have lapped us, so the
+    // samples between the indices are not contiguous. Drop them and let the
+    // decoder resynchronise on the next bus idle.
+    if (now_us - g_last_poll_us >= g_ring_us) {
+        g_ring_overruns++;
+        can_bitstream_stats_t stats = g_decoder.stats;
+        can_bitstream_decoder_init(&g_decoder);
+        g_decoder.stats = stats;
+        g_read_idx = write_idx;
+    }
+    g_last_poll_us = now_us;
+
+    uint32_t words_after = (write_idx - g_read_idx) & RING_MASK;
+    while (g_read_idx != write_idx) {
+        can_frame_t frame;
+        int bit = can_bitstream_push_word(&g_decoder, g_ring[g_read_idx], &frame);
+        words_after--;
+        if (bit >= 0) {
+            // Back-date by the samples that followed the CRC delimiter
+            uint32_t bits_ago = words_after * 32 + (31 - (uint32_t)bit);
+            queue_frame(&frame, now_us - bits_ago * g_ns_per_bit / 1000);
+        }
+        g_read_idx = (g_read_idx + 1) & RING_MASK;
+    }
+}
+
+bool HOT_PATH_FUNC(can_pio_rx_pending)(void) {
+    decode_new_words();
+    return g_queue_head != g_queue_tail;
+}
+
+uint32_t HOT_PATH_FUNC(can_pio_next_timestamp)(void) {
+    return g_queue[g_queue_tail & QUEUE_MASK].timestamp_us;
+}
+
+int8_t HOT_PATH_FUNC(can_pio_receive)(uint32_t* frame_id, uint8_t* data, uint32_t* timestamp_us) {
+    if (g_queue_head == g_queue_tail) {
+        return -1;
+    }
+
+    const queued_frame_t* q = &g_queue[g_queue_tail & QUEUE_MASK];
+    *frame_id = q->frame.id;
+    memcpy(data, q->frame.data, q->frame.dlc);
+    if (timestamp_us) {
+        *timestamp_us = q->timestamp_us;
+    }
+    int8_t len = (int8_t)q->frame.dlc;
+    g_queue_tail++;
+    return len;
+}
+
+void can_pio_get_stats(can_pio_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->decoder = g_decoder.stats;
+    stats->ring_overruns = g_ring_overruns;
+    stats->queue_drops = g_queue_drops;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file      can_pio.h
+ * @brief     Listen-only CAN receiver on a PIO state machine (no MCP2515)
+ *
+ * Alternative ECU bus backend for can_handler.c, selected with
+ * CAN_ECU_BACKEND_PIO=1. A PIO state machine samples the CAN transceiver's
+ * RX pin once per bit (can_pio_rx.pio) and a DMA channel streams the samples
+ * into a RAM ring, so reception costs no SPI traffic and no interrupts.
+ * can_pio_rx_pending() decodes whatever has arrived since the last call with
+ * can_bitstream.c and queues complete frames for can_pio_receive().
+ *
+ * The receiver never drives the bus, so it does not acknowledge frames or
+ * send error frames; another node on the bus (the dash) has to ACK. Frames
+ * are still sent through the MCP2515.
+ */
+
+#ifndef CAN_PIO_H
+#define CAN_PIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "can_bitstream.h"
+
+#ifndef CAN_PIO_RX_PIN
+#define CAN_PIO_RX_PIN          22          // CAN transceiver RXD
+#endif
+#define CAN_PIO_BITRATE         1000000     // Matches the MCP2515 KBPS1000 setting
+
+// DMA ring, 32 samples per word; must be a power of two. 1024 words hold
+// 32 ms of traffic at 1 Mbit/s, so can_pio_rx_pending() must run more often.
+#define CAN_PIO_RING_WORDS      1024
+#define CAN_PIO_QUEUE_DEPTH     16          // Decoded frames awaiting can_pio_receive()
+
+/**
+ * Receiver counters
+ */
+typedef struct {
+    can_bitstream_stats_t decoder;  // Frames and bit-level errors
+    uint32_t ring_overruns;         // Decode fell a full ring behind, samples lost
+    uint32_t queue_drops;           // Frames dropped because the queue was full
+} can_pio_stats_t;
+
+/**
+ * @brief Claim a PIO state machine and DMA channel and start sampling
+ *
+ * @param rx_pin GPIO connected to the transceiver RXD
+ * @param bitrate Bus bit rate in bit/s
+ * @return true on success, false if no PIO state machine or DMA channel is free
+ */
+bool can_pio_init(uint32_t rx_pin, uint32_t bitrate);
+
+/**
+ * @brief Decode newly sampled bits and check for a queued frame
+ *
+ * @return true if can_pio_receive() will return a frame
+ */
+bool can_pio_rx_pending(void);
+
+/**
+ * @brief Timestamp of the oldest queued frame
+ *
+ * @return time_us_32() at the frame's CRC delimiter (only valid while pending)
+ */
+uint32_t can_pio_next_timestamp(void);
+
+/**
+ * @brief Take the oldest decoded frame (same contract as MCP2515_Dev_Receive_Fast)
+ *
+ * @param frame_id Decoded 11/29-bit identifier
+ * @param data Up-to-8 byte payload
+ * @param timestamp_us time_us_32() at the frame's CRC delimiter
+ * @return Payload length (0-8), or -1 if no frame is queued
+ */
+int8_t can_pio_receive(uint32_t* frame_id, uint8_t* data, uint32_t* timestamp_us);
+
+/**
+ * @brief Get the receiver counters
+ *
+ * @param stats Structure to fill
+ */
+void can_pio_get_stats(can_pio_stats_t* stats);
+
+#endif // CAN_PIO_H
@@ -0,0 +1,192 @@
+/**
+ * @file      can_profiler.c
+ * @brief     Per-ID frame rate, inter-arrival jitter and bus load profiler implementation
+ */
+
+#include "can_profiler.h"
+
+#if CAN_PROFILER_ENABLED
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "can_autobaud.h"
+#include "safe_print.h"
+
+#define ID_MASK         (CAN_PROFILER_MAX_IDS - 1)
+
+_Static_assert((CAN_PROFILER_MAX_IDS & ID_MASK) == 0, "CAN_PROFILER_MAX_IDS must be a power of two");
+
+/**
+ * Counters for one (bus, ID) pair
+ */
+typedef struct {
+    bool     used;
+    uint8_t  bus;
+    uint32_t id;
+    uint32_t frames;
+    uint32_t ignored;               // Not consumed by the bus decoder
+    uint32_t last_us;
+    uint32_t gap_min_us;
+    uint32_t gap_max_us;
+    uint32_t gap_sum_us;            // Over frames - 1 gaps; a window is < 72 min
+    uint32_t gap_bins[CAN_PROFILER_GAP_BINS];
+} id_profile_t;
+
+/**
+ * One window of counters
+ */
+typedef struct {
+    id_profile_t ids[CAN_PROFILER_MAX_IDS];
+    uint32_t untracked;             // Frames of IDs beyond CAN_PROFILER_MAX_IDS
+    uint32_t bus_bits[CAN_NUM_BUSES];
+
+    uint32_t blocks;
+    uint32_t block_frames;
+    uint32_t block_min;
+    uint32_t block_max;
+    uint32_t block_dropped;
+    uint32_t block_no_anchor;
+} profile_t;
+
+static spin_lock_t* g_spin_lock;
+static profile_t g_profile;
+static profile_t g_snapshot;        // Report copy, so printing runs unlocked
+static uint32_t g_window_start_ms;
+
+// Nominal frame length without stuff bits (which add up to ~20 %):
+// SOF..EOF plus intermission. IDs above 0x7FF must be extended; the rare
+// extended frame with a small ID is counted as standard.
+static inline uint32_t frame_bits(uint32_t frame_id, uint8_t len) {
+    return (frame_id > 0x7FF ? 67u : 47u) + 8u * len;
+}
+
+static inline uint32_t gap_bin(uint32_t gap_us) {
+    uint32_t bin = 0;
+    gap_us >>= 6;
+    while (gap_us && bin < CAN_PROFILER_GAP_BINS - 1) {
+        gap_us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+static void reset_locked(void) {
+    memset(&g_profile, 0, sizeof(g_profile));
+    g_profile.block_min = UINT32_MAX;
+    g_window_start_ms = to_ms_since_boot(get_absolute_time());
+}
+
+void can_profiler_init(void) {
+    if (!g_spin_lock) {
+        g_spin_lock = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    reset_locked();
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void can_profiler_record(can_bus_t bus, uint32_t frame_id, uint8_t len,
+                         uint32_t timestamp_us, bool decoded) {
+    uint32_t slot = ((frame_id ^ ((uint32_t)bus << 29)) * 2654435761u) >> 27;
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    g_profile.bus_bits[bus] += frame_bits(frame_id, len);
+
+    // Open addressing, linear probe
+    id_profile_t* p = NULL;
+    for (uint32_t i = 0; i < CAN_PROFILER_MAX_IDS; i++) {
+        id_profile_t* candidate = &g_profile.ids[(slot + i) & ID_MASK];
+        if (!candidate->used || (candidate->id == frame_id && candidate->bus == bus)) {
+            p = candidate;
+            break;
+        }
+    }
+
+    if (!p) {
+        g_profile.untracked++;
+    } else if (!p->used) {
+        p->used = true;
+        p->bus = (uint8_t)bus;
+        p->id = frame_id;
+        p->frames = 1;
+        p->ignored = decoded ? 0 : 1;
+        p->last_us = timestamp_us;
+        p->gap_min_us = UINT32_MAX;
+    } else {
+        uint32_t gap_us = timestamp_us - p->last_us;
+        p->frames++;
+        p->ignored += decoded ? 0 : 1;
+        p->last_us = timestamp_us;
+        p->gap_sum_us += gap_us;
+        if (gap_us < p->gap_min_us) p->gap_min_us = gap_us;
+        if (gap_us > p->gap_max_us) p->gap_max_us = gap_us;
+        p->gap_bins[gap_bin(gap_us)]++;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void can_profiler_record_block(uint32_t frames, uint32_t dropped, bool anchor_found) {
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    g_profile.blocks++;
+    g_profile.block_frames += frames;
+    g_profile.block_dropped += dropped;
+    if (frames < g_profile.block_min) g_profile.block_min = frames;
+    if (frames > g_profile.block_max) g_profile.block_max = frames;
+    if (!anchor_found) g_profile.block_no_anchor++;
+    spin_unlock(g_spin_lock, lock_owner);
+}
+
+void can_profiler_report(void) {
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (!g_spin_lock || now_ms - g_window_start_ms < CAN_PROFILER_WINDOW_MS) {
+        return;
+    }
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    uint32_t window_ms = now_ms - g_window_start_ms;
+    g_snapshot = g_profile;
+    reset_locked();
+    spin_unlock(g_spin_lock, lock_owner);
+
+    const profile_t* s = &g_snapshot;
+    for (int bus = 0; bus < CAN_NUM_BUSES; bus++) {
+        if (!can_bus_present(bus)) {
+            continue;
+        }
+        uint32_t kbps = can_autobaud_rate_kbps(can_get_bus_rate(bus));
+        // bits / (kbit/s * ms) is a fraction; x1000 for 0.1 % resolution
+        uint32_t load_permille = (uint32_t)((uint64_t)s->bus_bits[bus] * 1000 / ((uint64_t)kbps * window_ms));
+        safe_printf("[CANPROF] bus %d: %lu kbps, load %lu.%lu %% (nominal, no stuff bits) over %lu ms\n",
+                    bus, (unsigned long)kbps, (unsigned long)(load_permille / 10),
+                    (unsigned long)(load_permille % 10), (unsigned long)window_ms);
+    }
+
+    safe_printf("[CANPROF] bus id        frames     Hz ignored  gap min/mean/max us   gaps <64us x2 ... >=65ms\n");
+    for (int i = 0; i < CAN_PROFILER_MAX_IDS; i++) {
+        const id_profile_t* p = &s->ids[i];
+        if (!p->used) {
+            continue;
+        }
+        uint32_t mean_us = p->frames > 1 ? p->gap_sum_us / (p->frames - 1) : 0;
+        safe_printf("[CANPROF] %d   %08lx %7lu %6lu %7lu  %6lu/%6lu/%6lu  ",
+                    p->bus, (unsigned long)p->id, (unsigned long)p->frames,
+                    (unsigned long)(p->frames * 1000 / window_ms), (unsigned long)p->ignored,
+                    (unsigned long)(p->frames > 1 ? p->gap_min_us : 0), (unsigned long)mean_us,
+                    (unsigned long)p->gap_max_us);
+        for (int bin = 0; bin < CAN_PROFILER_GAP_BINS; bin++) {
+            safe_printf(" %lu", (unsigned long)p->gap_bins[bin]);
+        }
+        safe_printf("\n");
+    }
+
+    safe_printf("[CANPROF] untracked IDs: %lu frames. M84 blocks: %lu, frames/block %lu..%lu mean %lu, "
+                "dropped past buffer %lu, no anchor %lu\n",
+                (unsigned long)s->untracked, (unsigned long)s->blocks,
+                (unsigned long)(s->blocks ? s->block_min : 0), (unsigned long)s->block_max,
+                (unsigned long)(s->blocks ? s->block_frames / s->blocks : 0),
+                (unsigned long)s->block_dropped, (unsigned long)s->block_no_anchor);
+}
+
+#endif // CAN_PROFILER_ENABLED
@@ -0,0 +1,82 @@
+/**
+ * @file      can_profiler.h
+ * @brief     Per-ID frame rate, inter-arrival jitter and bus load profiler
+ *
+ * Build with CAN_PROFILER_ENABLED=1 to record every frame can_process_frame()
+ * reads, before the decoders filter it: per-ID counts, min/mean/max
+ * inter-arrival time and a log2 histogram of the gaps, frames the decoder
+ * ignored, and the nominal bus utilisation. The ECU decoder also reports
+ * every M84 block it closes (frames per burst, frames dropped past the
+ * 32-frame buffer, missing anchor), which is what the 5 ms burst gap and the
+ * block size need tuning against.
+ *
+ * can_profiler_report() prints the summary over USB every
+ * CAN_PROFILER_WINDOW_MS and starts a new window. With the profiler
+ * disabled every call compiles to nothing.
+ */
+
+#ifndef CAN_PROFILER_H
+#define CAN_PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "can_handler.h"
+
+#ifndef CAN_PROFILER_ENABLED
+#define CAN_PROFILER_ENABLED    0
+#endif
+
+#define CAN_PROFILER_MAX_IDS    32          // Distinct IDs tracked per window
+#define CAN_PROFILER_GAP_BINS   12          // Bin k: gap < 64 << k us; last bin is >= 65.5 ms
+#define CAN_PROFILER_WINDOW_MS  10000       // Summary period
+
+#if CAN_PROFILER_ENABLED
+
+/**
+ * @brief Reset all counters. Call after can_init().
+ */
+void can_profiler_init(void);
+
+/**
+ * @brief Record one received frame (core 0, CAN ingest)
+ *
+ * @param bus Bus it arrived on
+ * @param frame_id 11/29-bit identifier
+ * @param len Payload length
+ * @param timestamp_us Arrival time
+ * @param decoded false if the bus decoder ignored the ID
+ */
+void can_profiler_record(can_bus_t bus, uint32_t frame_id, uint8_t len,
+                         uint32_t timestamp_us, bool decoded);
+
+/**
+ * @brief Record one closed M84 burst block
+ *
+ * @param frames Frames assembled into the block
+ * @param dropped Frames that arrived after the block buffer was full
+ * @param anchor_found false if the magic number was not in the block
+ */
+void can_profiler_record_block(uint32_t frames, uint32_t dropped, bool anchor_found);
+
+/**
+ * @brief Print the summary if the window has elapsed, then start a new one
+ *
+ * Safe to call from any task; call at least once a second.
+ */
+void can_profiler_report(void);
+
+#else
+
+static inline void can_profiler_init(void) {}
+static inline void can_profiler_record(can_bus_t bus, uint32_t frame_id, uint8_t len,
+                                       uint32_t timestamp_us, bool decoded) {
+    (void)bus; (void)frame_id; (void)len; (void)timestamp_us; (void)decoded;
+}
+static inline void can_profiler_record_block(uint32_t frames, uint32_t dropped, bool anchor_found) {
+    (void)frames; (void)dropped; (void)anchor_found;
+}
+static inline void can_profiler_report(void) {}
+
+#endif // CAN_PROFILER_ENABLED
+
+#endif // CAN_PROFILER_H
@@ -0,0 +1,225 @@
+/**
+ * @file      channel_hop.c
+ * @brief     Pseudo-random LoRa channel hopping implementation
+ */
+
+#include "channel_hop.h"
+#include <string.h>
+#include "telemetry_auth.h"
+#include "telemetry_schema.h"
+
+// 32-bit integer hash (lowbias32)
+static uint32_t mix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+bool hop_plan_init(hop_plan_t* plan, uint32_t base_khz, uint16_t spacing_khz, uint8_t count,
+                   uint16_t blacklist, uint32_t seed) {
+    if (count == 0 || count > HOP_MAX_CHANNELS) {
+        count = 1;
+    }
+    plan->base_khz = base_khz;
+    plan->spacing_khz = spacing_khz;
+    plan->count = count;
+    plan->blacklist = blacklist;
+    plan->seed = seed;
+    plan->num_allowed = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!(blacklist & (1u << i))) {
+            plan->allowed[plan->num_allowed++] = i;
+        }
+    }
+    if (plan->num_allowed == 0) {
+        plan->allowed[plan->num_allowed++] = 0;
+    }
+    if (count > 1 && plan->num_allowed < HOP_MIN_CHANNELS) {
+        plan->num_allowed = 1;
+        return false;
+    }
+    return true;
+}
+
+uint8_t hop_channel(const hop_plan_t* plan, uint32_t counter) {
+    uint8_t n = plan->num_allowed;
+    if (n <= 1) {
+        return plan->allowed[0];
+    }
+
+    // Fisher-Yates shuffle of the allowed list, one per cycle of n frames
+    uint8_t order[HOP_MAX_CHANNELS];
+    memcpy(order, plan->allowed, n);
+    uint32_t state = mix32(plan->seed ^ mix32(counter / n));
+    for (uint8_t i = n - 1; i > 0; i--) {
+        state = mix32(state);
+        uint8_t j = (uint8_t)(state % (i + 1u));
+        uint8_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    return order[counter % n];
+}
+
+bool hop_frame_counter(const uint8_t* frame, uint8_t length, uint32_t* counter, uint32_t* mask) {
+    // Authenticated frame: the counter is in the plaintext header
+    if (length > TELEMETRY_AUTH_OVERHEAD && frame[0] == TELEMETRY_AUTH_VERSION &&
+        (frame[1] & ~TELEMETRY_AUTH_F_ENCRYPTED) == 0) {
+        *counter = (uint32_t)frame[4] | (uint32_t)frame[5] << 8 |
+                   (uint32_t)frame[6] << 16 | (uint32_t)frame[7] << 24;
+        *mask = 0xFFFFFFFFu;
+        return true;
+    }
+
+    // Plain telemetry packet: one sequence number across all LoRa packet types
+    if (telemetry_peek_type(frame, length) != 0) {
+        *counter = frame[1];
+        *mask = 0xFFu;
+        return true;
+    }
+    return false;
+}
+
+// Listen on one channel for a whole cycle while searching
+static void park_deadline(hop_rx_t* rx, const hop_plan_t* plan, uint64_t now_us) {
+    rx->deadline_us = now_us + (uint64_t)rx->interval_us * plan->num_allowed;
+}
+
+// How long after its predecessor a frame is given to arrive
+static uint32_t overdue_us(const hop_rx_t* rx) {
+    return rx->max_gap_us + rx->max_gap_us / 4;
+}
+
+void hop_rx_init(hop_rx_t* rx, const hop_plan_t* plan, uint32_t interval_us, uint64_t now_us) {
+    memset(rx, 0, sizeof(*rx));
+    rx->counter_mask = 0xFFFFFFFFu;
+    rx->interval_us = interval_us ? interval_us : 1;
+    rx->max_gap_us = rx->interval_us;
+    park_deadline(rx, plan, now_us);
+}
+
+uint8_t hop_rx_channel(const hop_rx_t* rx, const hop_plan_t* plan) {
+    if (!rx->synced) {
+        return hop_channel(plan, rx->park);
+    }
+    return hop_channel(plan, rx->next);
+}
+
+// Every HOP_STATS_HALF_LIFE frames, halve the counts so old interference fades out
+static void count_frame(hop_stats_t* stats, uint8_t channel, bool lost) {
+    if (lost) {
+        stats->lost[channel]++;
+    } else {
+        stats->received[channel]++;
+    }
+    if (++stats->frames >= HOP_STATS_HALF_LIFE) {
+        for (int i = 0; i < HOP_MAX_CHANNELS; i++) {
+            stats->received[i] /= 2;
+            stats->lost[i] /= 2;
+        }
+        stats->frames = 0;
+    }
+}
+
+void hop_rx_received(hop_rx_t* rx, const hop_plan_t* plan, uint32_t counter, uint32_t mask,
+                     uint64_t now_us) {
+    // Frames missed while following were listened for on their channel
+    if (rx->synced && mask == rx->counter_mask) {
+        uint32_t gap = (counter - rx->after_last) & mask;
+        if (gap <= HOP_MAX_GAP) {
+            for (uint32_t i = 0; i < gap; i++) {
+                if (rx->listened & (1u << i)) {
+                    count_frame(&rx->stats, hop_channel(plan, (rx->after_last + i) & mask), true);
+                }
+            }
+            // Mean interval (1/8 weight per frame) and a slowly decaying
+            // longest one between consecutive frames
+            uint64_t dt = now_us - rx->last_us;
+            int32_t sample = (int32_t)(dt / (gap + 1));
+            rx->interval_us = (uint32_t)((int32_t)rx->interval_us + (sample - (int32_t)rx->interval_us) / 8);
+            if (rx->interval_us == 0) {
+                rx->interval_us = 1;
+            }
+            if (gap == 0 && dt > rx->max_gap_us) {
+                rx->max_gap_us = (uint32_t)dt;
+            } else if (gap == 0) {
+                rx->max_gap_us -= (rx->max_gap_us - (uint32_t)dt) / 32;
+            }
+        }
+    }
+    count_frame(&rx->stats, hop_channel(plan, counter), false);
+
+    rx->synced = true;
+    rx->counter_mask = mask;
+    rx->next = (counter + 1) & mask;
+    rx->after_last = rx->next;
+    rx->misses = 0;
+    rx->listened = 0;
+    rx->last_us = now_us;
+    rx->deadline_us = now_us + overdue_us(rx);
+}
+
+bool hop_rx_poll(hop_rx_t* rx, const hop_plan_t* plan, uint64_t now_us) {
+    if (!hop_enabled(plan) || now_us <= rx->deadline_us) {
+        return false;
+    }
+    if (!rx->synced) {
+        rx->park++;
+        park_deadline(rx, plan, now_us);
+        return true;
+    }
+    if (++rx->misses >= HOP_RX_MAX_MISSES) {
+        rx->synced = false;
+        rx->misses = 0;
+        park_deadline(rx, plan, now_us);
+        return true;
+    }
+
+    // Charged to its channel by hop_rx_received() if a later frame shows it was sent
+    uint32_t offset = (rx->next - rx->after_last) & rx->counter_mask;
+    if (offset < 32) {
+        rx->listened |= 1u << offset;
+    }
+
+    // Frames come in bursts, so the car may be further on than the mean
+    // interval says: wait ahead of it rather than behind
+    offset = (uint32_t)((now_us - rx->last_us) / rx->interval_us) + HOP_RX_LEAD;
+    rx->next = (rx->after_last + offset) & rx->counter_mask;
+    rx->deadline_us = rx->last_us + (uint64_t)rx->interval_us * offset + overdue_us(rx);
+    return true;
+}
+
+int hop_loss_pct(const hop_stats_t* stats, uint8_t channel) {
+    if (channel >= HOP_MAX_CHANNELS) {
+        return -1;
+    }
+    uint32_t total = (uint32_t)stats->received[channel] + stats->lost[channel];
+    if (total < HOP_MIN_SAMPLES) {
+        return -1;
+    }
+    return (int)(stats->lost[channel] * 100u / total);
+}
+
+uint16_t hop_suggest_blacklist(const hop_stats_t* stats, const hop_plan_t* plan) {
+    uint16_t mask = plan->blacklist;
+    uint8_t allowed = plan->num_allowed;
+    while (allowed > HOP_MIN_CHANNELS) {
+        int worst = -1, worst_loss = HOP_BLACKLIST_LOSS_PCT;
+        for (uint8_t i = 0; i < plan->count; i++) {
+            int loss = hop_loss_pct(stats, i);
+            if (!(mask & (1u << i)) && loss > worst_loss) {
+                worst = i;
+                worst_loss = loss;
+            }
+        }
+        if (worst < 0) {
+            break;
+        }
+        mask |= (uint16_t)(1u << worst);
+        allowed--;
+    }
+    return mask;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file      channel_hop.h
+ * @brief     Pseudo-random LoRa channel hopping across the 2.4 GHz band
+ *
+ * The channel list is base + i x spacing for i < count, minus a blacklist
+ * mask. Each frame goes out on the channel picked by its sequence number:
+ * the counter of a telemetry_auth frame, or the header sequence number of a
+ * plain telemetry packet. A receiver that decoded frame n therefore knows
+ * the channel of frame n + 1 without any other traffic.
+ *
+ * The sequence walks a fresh pseudo-random permutation of the allowed
+ * channels every count frames. Every channel is used equally often, and a
+ * channel swamped by Wi-Fi costs at most one frame per cycle.
+ *
+ * A receiver that misses a frame guesses how far the car has got from the
+ * mean time between frames, and waits on a channel slightly ahead. After
+ * HOP_RX_MAX_MISSES it parks on one channel for a cycle, where a frame is
+ * bound to come, and syncs again on the first one it decodes.
+ *
+ * The receiving side counts the frames lost on each channel: the sequence
+ * gap before a frame tells which of the frames it listened for were sent,
+ * and the plan tells where. hop_suggest_blacklist() turns the counts into a
+ * mask for the hop_blacklist key. Both ends must use the same mask, so the
+ * car takes it as a configuration change (config_store.h).
+ *
+ * No Pico SDK dependency: tools/hop_sim.c runs it with simulated interference.
+ */
+
+#ifndef CHANNEL_HOP_H
+#define CHANNEL_HOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOP_MAX_CHANNELS        16
+#define HOP_MIN_CHANNELS        2           // Never blacklist below this many
+#define HOP_SEED                0x46533236  // "FS26"
+
+// Receiver following and loss statistics
+#define HOP_RX_MAX_MISSES       4           // Expected frames missed in a row before re-acquiring
+#define HOP_RX_LEAD             1           // Frames waited ahead of the estimate after a miss
+#define HOP_MAX_GAP             32          // Longer sequence gaps are not charged to channels
+#define HOP_STATS_HALF_LIFE     512         // Frames after which the counts are halved
+#define HOP_MIN_SAMPLES         16          // Frames a channel needs before it is judged
+#define HOP_BLACKLIST_LOSS_PCT  30          // Loss that blacklists a channel
+
+/**
+ * Channel list shared by the sender and the receivers
+ */
+typedef struct {
+    uint32_t base_khz;
+    uint16_t spacing_khz;
+    uint8_t  count;                 // Channels in the list; 1 turns hopping off
+    uint16_t blacklist;             // Bit i excludes channel i
+    uint8_t  allowed[HOP_MAX_CHANNELS];
+    uint8_t  num_allowed;
+    uint32_t seed;
+} hop_plan_t;
+
+/**
+ * Per-channel reception counts (decayed every HOP_STATS_HALF_LIFE frames)
+ */
+typedef struct {
+    uint16_t received[HOP_MAX_CHANNELS];
+    uint16_t lost[HOP_MAX_CHANNELS];
+    uint16_t frames;                // Since the last halving
+} hop_stats_t;
+
+/**
+ * Receiver that follows a sender's hops
+ */
+typedef struct {
+    bool     synced;
+    uint32_t next;                  // Sequence number expected next
+    uint32_t after_last;            // One past the last frame received
+    uint32_t counter_mask;          // 0xFF for plain packets, 0xFFFFFFFF for auth frames
+    uint32_t listened;              // Bit i: listened in vain for after_last + i
+    uint8_t  misses;                // Expected frames missed in a row
+    uint8_t  park;                  // Listening on hop_channel(park) while not synced
+    uint64_t last_us;               // When the last frame was received
+    uint32_t interval_us;           // Mean time between sequence numbers
+    uint32_t max_gap_us;            // Longest recent time between consecutive frames
+    uint64_t deadline_us;           // The expected frame counts as missed after this
+    hop_stats_t stats;
+} hop_rx_t;
+
+/**
+ * @brief Build the channel list
+ *
+ * @return false if fewer than HOP_MIN_CHANNELS channels are left after the
+ *         blacklist; the plan then keeps only the first allowed channel
+ */
+bool hop_plan_init(hop_plan_t* plan, uint32_t base_khz, uint16_t spacing_khz, uint8_t count,
+                   uint16_t blacklist, uint32_t seed);
+
+/**
+ * @brief Whether frames hop (more than one allowed channel)
+ */
+static inline bool hop_enabled(const hop_plan_t* plan) {
+    return plan->num_allowed > 1;
+}
+
+/**
+ * @brief Channel index (0..count-1) of the frame with this sequence number
+ */
+uint8_t hop_channel(const hop_plan_t* plan, uint32_t counter);
+
+/**
+ * @brief Frequency of a channel index, in kHz
+ */
+static inline uint32_t hop_channel_khz(const hop_plan_t* plan, uint8_t channel) {
+    return plan->base_khz + (uint32_t)channel * plan->spacing_khz;
+}
+
+/**
+ * @brief Sequence number that picks the channel of a DAQ frame
+ *
+ * @param mask Filled in: the range the sequence number wraps in
+ * @return false if the frame is neither a telemetry_auth frame nor a telemetry packet
+ */
+bool hop_frame_counter(const uint8_t* frame, uint8_t length, uint32_t* counter, uint32_t* mask);
+
+/**
+ * @brief Start following from scratch (after a plan change)
+ *
+ * @param interval_us First guess of the time between frames, refined from the
+ *                    frames received
+ */
+void hop_rx_init(hop_rx_t* rx, const hop_plan_t* plan, uint32_t interval_us, uint64_t now_us);
+
+/**
+ * @brief Channel index to listen on for the next frame
+ */
+uint8_t hop_rx_channel(const hop_rx_t* rx, const hop_plan_t* plan);
+
+/**
+ * @brief A frame was received: follow it and charge the gap before it to its channels
+ */
+void hop_rx_received(hop_rx_t* rx, const hop_plan_t* plan, uint32_t counter, uint32_t mask,
+                     uint64_t now_us);
+
+/**
+ * @brief Move on when the expected frame is overdue
+ *
+ * A frame is overdue 1.5 mean intervals after the last one received, and the
+ * one after it a mean interval later. After HOP_RX_MAX_MISSES in a row the
+ * receiver parks on one allowed channel for a whole hop cycle at a time,
+ * until a frame arrives there.
+ *
+ * @return true if hop_rx_channel() changed
+ */
+bool hop_rx_poll(hop_rx_t* rx, const hop_plan_t* plan, uint64_t now_us);
+
+/**
+ * @brief Loss of a channel in percent, or -1 with fewer than HOP_MIN_SAMPLES frames
+ */
+int hop_loss_pct(const hop_stats_t* stats, uint8_t channel);
+
+/**
+ * @brief Blacklist mask for the measured loss
+ *
+ * Adds every channel lossier than HOP_BLACKLIST_LOSS_PCT to the plan's
+ * blacklist, worst first, while HOP_MIN_CHANNELS stay allowed.
+ */
+uint16_t hop_suggest_blacklist(const hop_stats_t* stats, const hop_plan_t* plan);
+
+#endif // CHANNEL_HOP_H
@@ -0,0 +1,464 @@
+/**
+ * @file      config_store.c
+ * @brief     Runtime configuration store implementation
+ */
+
+#include "config_store.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "gps.h"
+#include "lr1121_config.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+#include "radio_stats.h"
+#include "telemetry_auth.h"
+#include "tdma.h"
+#include "channel_hop.h"
+#include "telemetry_packet.h"
+#include "safe_print.h"
+
+// Every telemetry frame must still fit after authentication
+#define CONFIG_MIN_PAYLOAD  (TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD)
+
+#define BLOCK_MAGIC         0x46534346u     // "FSCF"
+#define LEGACY_CAN_MAGIC    0x43414E42u     // "CANB": can_autobaud.c rate cache, same sector
+#define BLOCK_OFFSET        (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define TALLY_OFFSET        (BLOCK_OFFSET + FLASH_PAGE_SIZE)    // Boot tally: rest of the sector
+#define TALLY_BYTES         (FLASH_SECTOR_SIZE - FLASH_PAGE_SIZE)
+#define LINE_MAX            80
+
+/**
+ * Flash block header; {key, length, value (little-endian)} records follow
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;                // Record bytes after the header
+    uint32_t crc;                   // CRC-32 of the records
+} block_header_t;
+
+/**
+ * One key, generated from CONFIG_FIELDS
+ */
+typedef struct {
+    uint8_t     key;
+    const char* name;
+    uint8_t     offset;
+    uint8_t     size;
+    bool        is_signed;
+    int32_t     min;
+    int32_t     max;
+} field_desc_t;
+
+static const field_desc_t FIELDS[] = {
+#define FIELD_DESC(key, name, type, def, min, max) \
+    { key, #name, offsetof(daq_config_t, name), sizeof(type), (type)-1 < 0, min, max },
+    CONFIG_FIELDS(FIELD_DESC)
+#undef FIELD_DESC
+};
+
+#define NUM_FIELDS          (sizeof(FIELDS) / sizeof(FIELDS[0]))
+#define MAX_BLOCK_BYTES     (sizeof(block_header_t) + NUM_FIELDS * (2 + sizeof(uint32_t)))
+
+_Static_assert(MAX_BLOCK_BYTES <= FLASH_PAGE_SIZE, "configuration block must fit one flash page");
+_Static_assert(CONFIG_MIN_PAYLOAD <= PAYLOAD_LENGTH, "PAYLOAD_LENGTH too small for authenticated telemetry");
+
+static const daq_config_t DEFAULTS = {
+#define FIELD_DEFAULT(key, name, type, def, min, max) .name = (type)(def),
+    CONFIG_FIELDS(FIELD_DEFAULT)
+#undef FIELD_DEFAULT
+};
+
+static daq_config_t g_banks[2];
+const daq_config_t* volatile g_config_active = &DEFAULTS;
+static volatile uint32_t g_generation = 0;
+
+// Edits in progress; only touched by the task that runs the commands
+static daq_config_t g_staged;
+
+static bool run_with_irqs_off(void (*fn)(void*), void* param) {
+    uint32_t irq = save_and_disable_interrupts();
+    fn(param);
+    restore_interrupts(irq);
+    return true;
+}
+
+static config_flash_runner_t g_flash_runner = run_with_irqs_off;
+
+static uint32_t crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static int32_t field_get(const daq_config_t* cfg, const field_desc_t* f) {
+    const uint8_t* p = (const uint8_t*)cfg + f->offset;
+    switch (f->size) {
+        case 1:  return f->is_signed ? (int32_t)*(const int8_t*)p : (int32_t)*p;
+        case 2:  { uint16_t v; memcpy(&v, p, 2); return f->is_signed ? (int32_t)(int16_t)v : (int32_t)v; }
+        default: { int32_t v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+static void field_put(daq_config_t* cfg, const field_desc_t* f, int32_t value) {
+    uint8_t* p = (uint8_t*)cfg + f->offset;
+    switch (f->size) {
+        case 1:  *p = (uint8_t)value; break;
+        case 2:  { uint16_t v = (uint16_t)value; memcpy(p, &v, 2); break; }
+        default: memcpy(p, &value, 4); break;
+    }
+}
+
+static const field_desc_t* field_by_name(const char* name) {
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        if (strcmp(FIELDS[i].name, name) == 0) {
+            return &FIELDS[i];
+        }
+    }
+    return NULL;
+}
+
+static const field_desc_t* field_by_key(uint8_t key) {
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        if (FIELDS[i].key == key) {
+            return &FIELDS[i];
+        }
+    }
+    return NULL;
+}
+
+static bool in_range(const field_desc_t* f, int32_t value) {
+    return value >= f->min && value <= f->max;
+}
+
+// Cross-field rules on top of the per-key ranges; prints the first failure
+static bool validate(const daq_config_t* cfg) {
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        if (!in_range(&FIELDS[i], field_get(cfg, &FIELDS[i]))) {
+            safe_printf("[CFG] %s out of range %ld..%ld\n", FIELDS[i].name,
+                        (long)FIELDS[i].min, (long)FIELDS[i].max);
+            return false;
+        }
+    }
+    if (cfg->lora_bw_khz != 200 && cfg->lora_bw_khz != 400 && cfg->lora_bw_khz != 800) {
+        safe_printf("[CFG] lora_bw_khz must be 200, 400 or 800 (2.4 GHz LoRa)\n");
+        return false;
+    }
+    if ((cfg->can_rate_ecu > KBPS1000 && cfg->can_rate_ecu != CONFIG_CAN_RATE_AUTO) ||
+        (cfg->can_rate_chassis > KBPS1000 && cfg->can_rate_chassis != CONFIG_CAN_RATE_AUTO)) {
+        safe_printf("[CFG] can_rate_* must be a CAN_RATE index (0..%d) or %d\n", KBPS1000, CONFIG_CAN_RATE_AUTO);
+        return false;
+    }
+    if (cfg->tdma_nodes > 1 &&
+        (cfg->tdma_node_id >= cfg->tdma_nodes || TDMA_DAY_US % (cfg->fast_period_ms * 1000u) != 0)) {
+        safe_printf("[CFG] TDMA needs tdma_node_id < tdma_nodes and a fast_period_ms that divides a day\n");
+        return false;
+    }
+    hop_plan_t hop;
+    if (cfg->hop_channels > 1 &&
+        (cfg->hop_spacing_khz < cfg->lora_bw_khz ||
+         cfg->hop_base_khz + (cfg->hop_channels - 1u) * cfg->hop_spacing_khz > 2500000 ||
+         !hop_plan_init(&hop, cfg->hop_base_khz, cfg->hop_spacing_khz, cfg->hop_channels,
+                        cfg->hop_blacklist, HOP_SEED))) {
+        safe_printf("[CFG] hopping needs hop_spacing_khz >= lora_bw_khz, every channel below 2500000 kHz "
+                    "and %d channels not in hop_blacklist\n", HOP_MIN_CHANNELS);
+        return false;
+    }
+    if (cfg->relay_freq_khz != 0 &&
+        (cfg->relay_freq_khz < 2400000 || cfg->relay_freq_khz == cfg->lora_freq_khz)) {
+        safe_printf("[CFG] relay_freq_khz must be 0 or another channel in 2400000..2500000\n");
+        return false;
+    }
+    return true;
+}
+
+// Serialise into one page; returns the bytes used
+static size_t encode_block(const daq_config_t* cfg, uint8_t* page) {
+    uint8_t* rec = page + sizeof(block_header_t);
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        int32_t value = field_get(cfg, &FIELDS[i]);
+        *rec++ = FIELDS[i].key;
+        *rec++ = FIELDS[i].size;
+        memcpy(rec, &value, FIELDS[i].size);   // Little-endian low bytes
+        rec += FIELDS[i].size;
+    }
+
+    block_header_t header = {
+        .magic = BLOCK_MAGIC,
+        .version = CONFIG_STORE_VERSION,
+        .length = (uint16_t)(rec - page - sizeof(block_header_t)),
+    };
+    header.crc = crc32(page + sizeof(block_header_t), header.length);
+    memcpy(page, &header, sizeof(header));
+    return (size_t)(rec - page);
+}
+
+// Apply every known, in-range record over cfg; returns the keys taken
+static int decode_block(const uint8_t* block, daq_config_t* cfg) {
+    block_header_t header;
+    memcpy(&header, block, sizeof(header));
+    if (header.magic != BLOCK_MAGIC || header.version != CONFIG_STORE_VERSION ||
+        header.length > FLASH_PAGE_SIZE - sizeof(header) ||
+        crc32(block + sizeof(header), header.length) != header.crc) {
+        return -1;
+    }
+
+    int taken = 0;
+    const uint8_t* rec = block + sizeof(header);
+    const uint8_t* end = rec + header.length;
+    while (rec + 2 <= end && rec + 2 + rec[1] <= end) {
+        const field_desc_t* f = field_by_key(rec[0]);
+        if (f && rec[1] == f->size) {
+            int32_t value = 0;
+            memcpy(&value, rec + 2, f->size);
+            if (f->is_signed && f->size == 1) value = (int8_t)value;
+            if (f->is_signed && f->size == 2) value = (int16_t)value;
+            if (in_range(f, value)) {
+                field_put(cfg, f, value);
+                taken++;
+            }
+        }
+        rec += 2 + rec[1];
+    }
+    return taken;
+}
+
+static void flash_write_page(void* param) {
+    flash_range_erase(BLOCK_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(BLOCK_OFFSET, (const uint8_t*)param, FLASH_PAGE_SIZE);
+}
+
+// Tally page to reprogram (bits only go from 1 to 0, so no erase)
+typedef struct {
+    uint32_t       offset;
+    const uint8_t* data;
+} tally_write_t;
+
+static void flash_program_tally(void* param) {
+    const tally_write_t* write = (const tally_write_t*)param;
+    flash_range_program(write->offset, write->data, FLASH_PAGE_SIZE);
+}
+
+static bool save(const daq_config_t* cfg) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    size_t used = encode_block(cfg, page);
+
+    // One erase per actual change, not per commit
+    if (memcmp(page, (const void*)(XIP_BASE + BLOCK_OFFSET), used) == 0) {
+        return true;
+    }
+    if (!g_flash_runner(flash_write_page, page)) {
+        safe_printf("[CFG] flash write failed, configuration active but not saved\n");
+        return false;
+    }
+    return true;
+}
+
+// Number this boot: boot_count of the block plus one per cleared tally bit,
+// plus one. The bit for this boot is cleared before any frame goes out.
+static void count_boot(daq_config_t* cfg) {
+    const uint8_t* tally = (const uint8_t*)(XIP_BASE + TALLY_OFFSET);
+    uint32_t full = 0;
+    while (full < TALLY_BYTES && tally[full] == 0x00) {
+        full++;
+    }
+    uint32_t recorded = full * 8;
+    if (full < TALLY_BYTES) {
+        recorded += 8 - (uint32_t)__builtin_popcount(tally[full]);
+    }
+    cfg->boot_count += recorded + 1;
+
+    // Tally full: fold it into the block; the erase empties it
+    if (full == TALLY_BYTES) {
+        save(cfg);
+        return;
+    }
+
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t page_start = full - full % FLASH_PAGE_SIZE;
+    memcpy(page, tally + page_start, FLASH_PAGE_SIZE);
+    page[full - page_start] &= (uint8_t)(page[full - page_start] - 1);     // Lowest set bit
+    tally_write_t write = { TALLY_OFFSET + page_start, page };
+    if (!g_flash_runner(flash_program_tally, &write)) {
+        safe_printf("[CFG] boot tally write failed\n");
+    }
+}
+
+static void publish(const daq_config_t* cfg) {
+    daq_config_t* bank = g_config_active == &g_banks[0] ? &g_banks[1] : &g_banks[0];
+    *bank = *cfg;
+    __dmb();
+    g_config_active = bank;
+    g_generation++;
+    // config_copy() must see the increment before the next commit rewrites a bank
+    __dmb();
+}
+
+void config_store_init(void) {
+    daq_config_t cfg = DEFAULTS;
+    const uint8_t* block = (const uint8_t*)(XIP_BASE + BLOCK_OFFSET);
+    int taken = decode_block(block, &cfg);
+
+    if (taken < 0) {
+        // Sector still holds the CAN rate cache from before this store
+        uint32_t magic;
+        memcpy(&magic, block, sizeof(magic));
+        if (magic == LEGACY_CAN_MAGIC) {
+            if (block[4] <= KBPS1000) cfg.can_rate_ecu = block[4];
+            if (block[5] <= KBPS1000) cfg.can_rate_chassis = block[5];
+            safe_printf("[CFG] imported CAN rate cache, defaults for the rest\n");
+        } else {
+            safe_printf("[CFG] no valid block in flash, using defaults\n");
+        }
+    } else {
+        safe_printf("[CFG] loaded %d of %u keys from flash (v%u)\n", taken, (unsigned)NUM_FIELDS, CONFIG_STORE_VERSION);
+    }
+
+    // The boot count survives a block that fails validation
+    if (!validate(&cfg)) {
+        uint32_t boot_count = cfg.boot_count;
+        cfg = DEFAULTS;
+        cfg.boot_count = boot_count;
+    }
+    count_boot(&cfg);
+    safe_printf("[CFG] boot %lu\n", (unsigned long)cfg.boot_count);
+    publish(&cfg);
+    g_staged = cfg;
+}
+
+uint32_t config_generation(void) {
+    return g_generation;
+}
+
+uint32_t config_copy(daq_config_t* out) {
+    uint32_t generation;
+    do {
+        generation = g_generation;
+        __dmb();
+        *out = *config_get();
+        __dmb();
+    } while (generation != g_generation);
+    return generation;
+}
+
+void config_store_set_flash_runner(config_flash_runner_t runner) {
+    g_flash_runner = runner ? runner : run_with_irqs_off;
+}
+
+bool config_store_set(const char* name, int32_t value) {
+    const field_desc_t* f = field_by_name(name);
+    if (!f || !in_range(f, value) || f->offset == offsetof(daq_config_t, boot_count)) {
+        return false;
+    }
+    field_put(&g_staged, f, value);
+    return true;
+}
+
+bool config_store_commit(bool persist) {
+    // Read-only, also over "cfg defaults"; saving it folds the boot tally
+    g_staged.boot_count = config_get()->boot_count;
+    if (!validate(&g_staged)) {
+        return false;
+    }
+    publish(&g_staged);
+    return !persist || save(config_get());
+}
+
+void config_store_revert(void) {
+    g_staged = *config_get();
+}
+
+static void print_fields(const char* only) {
+    const daq_config_t* active = config_get();
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        const field_desc_t* f = &FIELDS[i];
+        if (only && strcmp(only, f->name) != 0) {
+            continue;
+        }
+        int32_t value = field_get(active, f);
+        int32_t staged = field_get(&g_staged, f);
+        if (staged != value) {
+            safe_printf("[CFG] %-20s %ld (staged %ld)\n", f->name, (long)value, (long)staged);
+        } else {
+            safe_printf("[CFG] %-20s %ld\n", f->name, (long)value);
+        }
+    }
+}
+
+bool config_store_command(const char* line) {
+    char word[8], verb[12] = "", name[24] = "", arg[16] = "";
+    if (sscanf(line, "%7s %11s %23s %15s", word, verb, name, arg) < 1 || strcmp(word, "cfg") != 0) {
+        return false;
+    }
+
+    if (!verb[0] || strcmp(verb, "show") == 0) {
+        print_fields(NULL);
+    } else if (strcmp(verb, "get") == 0 && name[0]) {
+        if (!field_by_name(name)) {
+            safe_printf("[CFG] unknown key %s\n", name);
+        } else {
+            print_fields(name);
+        }
+    } else if (strcmp(verb, "set") == 0 && name[0] && arg[0]) {
+        char* end;
+        long value = strtol(arg, &end, 0);
+        const field_desc_t* f = field_by_name(name);
+        if (!f) {
+            safe_printf("[CFG] unknown key %s\n", name);
+        } else if (f->offset == offsetof(daq_config_t, boot_count)) {
+            safe_printf("[CFG] %s is read-only\n", name);
+        } else if (*end != '\0' || !config_store_set(name, (int32_t)value)) {
+            safe_printf("[CFG] %s: expected %ld..%ld\n", name, (long)f->min, (long)f->max);
+        } else {
+            safe_printf("[CFG] %s staged, 'cfg apply' or 'cfg commit' to activate\n", name);
+        }
+    } else if (strcmp(verb, "apply") == 0 || strcmp(verb, "commit") == 0) {
+        bool persist = verb[0] == 'c';
+        if (config_store_commit(persist)) {
+            safe_printf("[CFG] generation %lu active%s\n", (unsigned long)config_generation(),
+                        persist ? ", saved to flash" : " until reboot");
+        }
+    } else if (strcmp(verb, "revert") == 0) {
+        config_store_revert();
+        safe_printf("[CFG] staged edits dropped\n");
+    } else if (strcmp(verb, "defaults") == 0) {
+        g_staged = DEFAULTS;
+        safe_printf("[CFG] defaults staged\n");
+    } else {
+        safe_printf("[CFG] cfg [show] | get <key> | set <key> <value> | apply | commit | revert | defaults\n");
+    }
+    return true;
+}
+
+void config_store_poll_usb(void) {
+    static char line[LINE_MAX];
+    static uint8_t length = 0;
+
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c != '\r' && c != '\n') {
+            if (length < sizeof(line) - 1) {
+                line[length++] = (char)c;
+            }
+            continue;
+        }
+        if (length == 0) {
+            continue;
+        }
+        line[length] = '\0';
+        length = 0;
+        if (!config_store_command(line)) {
+            safe_printf("[CFG] unknown command '%s', try 'cfg help'\n", line);
+        }
+    }
+}
@@ -0,0 +1,203 @@
+/**
+ * @file      config_store.h
+ * @brief     Runtime configuration in flash: radio profile, telemetry and dash rates, GPS filter
+ *
+ * The tunables that used to need a rebuild live in one daq_config_t. It is
+ * loaded once at boot from the last flash sector, and the hot paths read it
+ * through config_get(): one pointer load, no key lookup.
+ *
+ * The flash block is versioned key-value: a header (magic, version, length,
+ * CRC-32) followed by {key, length, value} records. Unknown keys are
+ * skipped and missing keys keep their defaults, so firmware with more or
+ * fewer keys reads the other's block. CONFIG_STORE_VERSION only changes if
+ * an existing key changes meaning.
+ *
+ * Edits are staged and then published by config_store_commit(). The staged
+ * copy is validated as a whole, written to the inactive bank, and the active
+ * pointer is swapped. A task that takes config_get() once per cycle therefore
+ * sees the old or the new configuration, never a mix, as long as it is done
+ * with it before the next commit rewrites that bank. Code that can be held
+ * up longer (a radio send waits for TX done) takes config_copy() instead.
+ * State derived from the configuration (scheduler periods, dash frame
+ * rates, the PA setting) is rebuilt between cycles when config_generation()
+ * changes.
+ *
+ * Boots are counted without an erase per boot: config_store_init() clears
+ * one bit in a tally that fills the rest of the sector, and the tally is
+ * folded into boot_count whenever the block is rewritten.
+ *
+ * Edits arrive as text lines through config_store_command(): from USB
+ * (config_store_poll_usb()) or from any other link that can deliver a line.
+ * Type "cfg help" on the USB console.
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "can_handler.h"
+
+#define CONFIG_STORE_VERSION    1
+#define CONFIG_CAN_RATE_AUTO    0xFF        // can_rate_*: no rate detected yet
+
+/**
+ * Every key, largest type first so daq_config_t packs without padding.
+ * Defaults refer to the compile-time macros and are only expanded in
+ * config_store.c.
+ *
+ *   key  name                  type      default                      min    max
+ */
+#define CONFIG_FIELDS(X) \
+    X(1,  lora_freq_khz,        uint32_t, RF_FREQ_IN_HZ / 1000,        2400000, 2500000) \
+    X(21, relay_freq_khz,       uint32_t, 0,                           0,     2500000) \
+    X(23, hop_base_khz,         uint32_t, 2404000,                     2400000, 2500000) \
+    X(27, div_freq_khz,         uint32_t, DIV_RF_FREQ_IN_HZ / 1000,    DIV_FREQ_MIN_KHZ, DIV_FREQ_MAX_KHZ) \
+    X(30, boot_count,           uint32_t, 0,                           0,     0x7FFFFFFF) \
+    X(7,  fast_period_ms,       uint16_t, TELEMETRY_FAST_PERIOD_MS,    50,    10000) \
+    X(8,  gps_period_ms,        uint16_t, TELEMETRY_GPS_PERIOD_MS,     100,   10000) \
+    X(9,  thermal_period_ms,    uint16_t, TELEMETRY_THERMAL_PERIOD_MS, 200,   60000) \
+    X(10, diag_period_ms,       uint16_t, RADIO_DIAG_PERIOD_MS,        1000,  60000) \
+    X(11, essentials_period_ms, uint16_t, ESSENTIALS_PERIOD_MS,        5000,  60000) \
+    X(12, dash_engine_ms,       uint16_t, 10,                          10,    1000) \
+    X(13, dash_aux_ms,          uint16_t, 200,                         10,    1000) \
+    X(14, dash_gps_ms,          uint16_t, 100,                         10,    1000) \
+    X(15, dash_meta_ms,         uint16_t, 200,                         10,    1000) \
+    X(16, gps_max_hdop_x10,     uint16_t, (uint16_t)(MAX_HDOP_THRESHOLD * 10), 10, 255) \
+    X(22, relay_max_age_ms,     uint16_t, 500,                         50,    5000) \
+    X(24, hop_spacing_khz,      uint16_t, 5000,                        200,   20000) \
+    X(25, hop_blacklist,        uint16_t, 0,                           0,     0xFFFF) \
+    X(4,  lora_bw_khz,          uint16_t, 800,                         200,   800) \
+    X(2,  lora_power_dbm,       int8_t,   TX_OUTPUT_POWER_DBM,         -18,   13) \
+    X(3,  lora_sf,              uint8_t,  LORA_SPREADING_FACTOR,       5,     12) \
+    X(5,  lora_cr,              uint8_t,  LORA_CODING_RATE,            1,     4) \
+    X(6,  lora_max_payload,     uint8_t,  PAYLOAD_LENGTH,              CONFIG_MIN_PAYLOAD, PAYLOAD_LENGTH) \
+    X(17, can_rate_ecu,         uint8_t,  CONFIG_CAN_RATE_AUTO,        0,     CONFIG_CAN_RATE_AUTO) \
+    X(18, can_rate_chassis,     uint8_t,  CONFIG_CAN_RATE_AUTO,        0,     CONFIG_CAN_RATE_AUTO) \
+    X(19, tdma_node_id,         uint8_t,  0,                           0,     TDMA_MAX_NODES - 1) \
+    X(20, tdma_nodes,           uint8_t,  1,                           1,     TDMA_MAX_NODES) \
+    X(26, hop_channels,         uint8_t,  1,                           1,     HOP_MAX_CHANNELS) \
+    X(28, div_mode,             uint8_t,  DIV_OFF,                     DIV_OFF, DIV_DUPLICATE) \
+    X(29, div_sf,               uint8_t,  DIV_LORA_SPREADING_FACTOR,   7,     12)
+
+/**
+ * Active configuration
+ *
+ * lora_bw_khz is 200, 400 or 800; lora_cr 1..4 is 4/5..4/8; can_rate_* is
+ * an enum RATEBPS index (kept by can_autobaud.c). tdma_nodes 1 turns TDMA
+ * off; above that, each car on the channel needs its own tdma_node_id.
+ * relay_* only matter to FS26-Repeater: relay_freq_khz 0 forwards on the
+ * car channel in the repeater's TDMA slot, otherwise on that channel at once.
+ * hop_channels 1 keeps every frame on lora_freq_khz; above that, frames hop
+ * over hop_base_khz + i x hop_spacing_khz minus the hop_blacklist bits.
+ * div_mode also sends critical frames (alerts, laps) as sub-GHz LoRa on
+ * div_freq_khz at div_sf and 125 kHz: DIV_ALTERNATE every other one,
+ * DIV_DUPLICATE all of them. div_freq_khz is limited to the 869.4-869.65 MHz
+ * sub-band, since the 10 % duty cycle budget is only legal there.
+ * boot_count is read-only: the number of this boot, counted by
+ * config_store_init() and kept by every commit (telemetry_auth session).
+ */
+typedef struct {
+#define CONFIG_STRUCT_FIELD(key, name, type, def, min, max) type name;
+    CONFIG_FIELDS(CONFIG_STRUCT_FIELD)
+#undef CONFIG_STRUCT_FIELD
+} daq_config_t;
+
+/**
+ * Runs fn with flash safe to erase/program (no XIP access from either core).
+ * Returns false if that could not be arranged; fn was not called.
+ */
+typedef bool (*config_flash_runner_t)(void (*fn)(void*), void* param);
+
+// Active bank; read through config_get()
+extern const daq_config_t* volatile g_config_active;
+
+/**
+ * @brief Current configuration. Take it once per cycle and read fields from it.
+ */
+static inline const daq_config_t* config_get(void) {
+    return g_config_active;
+}
+
+/**
+ * @brief Load the flash block (defaults if blank or corrupt) and count this boot
+ *
+ * Call first in main(), before core 1 or the RTOS scheduler starts: the
+ * boot tally is programmed with interrupts disabled.
+ */
+void config_store_init(void);
+
+/**
+ * @brief Incremented by every commit; compare to rebuild derived state
+ */
+uint32_t config_generation(void);
+
+/**
+ * @brief Copy the configuration, retrying if a commit lands during the copy
+ *
+ * @param out Filled with one consistent configuration
+ * @return config_generation() the copy belongs to
+ */
+uint32_t config_copy(daq_config_t* out);
+
+/**
+ * @brief How flash writes are made safe once both cores run
+ *
+ * Until this is called, writes run with interrupts disabled on the calling
+ * core, which is only safe before core 1 or the RTOS scheduler starts.
+ *
+ * @param runner Firmware-specific runner (core 1 park / flash_safe_execute)
+ */
+void config_store_set_flash_runner(config_flash_runner_t runner);
+
+/**
+ * @brief Stage one value by name
+ *
+ * @param name Key name as in CONFIG_FIELDS
+ * @param value New value, range-checked
+ * @return false for an unknown name or a value out of range
+ */
+bool config_store_set(const char* name, int32_t value);
+
+/**
+ * @brief Validate the staged values and make them active
+ *
+ * @param persist Also write the block to flash
+ * @return false if validation or the flash write failed (the active
+ *         configuration is unchanged if validation failed)
+ */
+bool config_store_commit(bool persist);
+
+/**
+ * @brief Drop staged edits
+ */
+void config_store_revert(void);
+
+/**
+ * @brief Execute one text command ("cfg set lora_sf 9", "cfg commit", ...)
+ *
+ * Not reentrant: call from one task only.
+ *
+ * @param line Command without the line terminator
+ * @return false if the line is not a cfg command
+ */
+bool config_store_command(const char* line);
+
+/**
+ * @brief Read USB serial without blocking and execute complete lines
+ *
+ * Call periodically from the task that owns the console.
+ */
+void config_store_poll_usb(void);
+
+/**
+ * @brief Last rate detected on a bus
+ *
+ * @param bus Bus
+ * @return enum RATEBPS index, or CONFIG_CAN_RATE_AUTO
+ */
+static inline uint8_t config_can_rate(can_bus_t bus) {
+    return bus == CAN_BUS_ECU ? config_get()->can_rate_ecu : config_get()->can_rate_chassis;
+}
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,171 @@
+/**
+ * @file      dash_output.c
+ * @brief     Dashboard CAN frame publisher implementation
+ */
+
+#include "dash_output.h"
+#include <string.h>
+#include "lr1121_tx.h"
+#include "can_handler.h"
+#include "config_store.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+
+/**
+ * Everything the encoders need, gathered once per dash_publish() call
+ */
+typedef struct {
+    const ft550_sensor_data_t* can;
+    const gps_data_t* gps;
+    uint32_t lora_tx_count;
+    uint32_t can_frame_count;
+} dash_inputs_t;
+
+typedef void (*dash_encode_fn_t)(const dash_inputs_t* in, uint8_t* buf);
+
+typedef struct {
+    uint16_t          can_id;
+    dash_encode_fn_t  encode;
+    dash_frame_rate_t rate;
+    uint8_t           last_payload[8];
+    uint64_t          last_sent_us;
+    bool              sent_once;
+} dash_frame_t;
+
+static inline void put_u16(uint8_t* buf, uint16_t v) {
+    buf[0] = v & 0xFF;
+    buf[1] = v >> 8;
+}
+
+static inline void put_u32(uint8_t* buf, uint32_t v) {
+    buf[0] = v & 0xFF;
+    buf[1] = (v >> 8) & 0xFF;
+    buf[2] = (v >> 16) & 0xFF;
+    buf[3] = (v >> 24) & 0xFF;
+}
+
+// --- FRAME 0x600 (Primary Engine) ---
+static void encode_engine(const dash_inputs_t* in, uint8_t* buf) {
+    // The dash scales are the channels' raw scales
+    put_u16(&buf[0], (uint16_t)in->can->raw[FT550_CH_RPM]);
+    put_u16(&buf[2], (uint16_t)in->can->raw[FT550_CH_MAP]);
+    put_u16(&buf[4], (uint16_t)in->can->raw[FT550_CH_ENGINE_TEMP]);
+    put_u16(&buf[6], (uint16_t)in->can->raw[FT550_CH_TPS]);
+}
+
+// --- FRAME 0x601 (Battery & Air Temp) ---
+static void encode_aux(const dash_inputs_t* in, uint8_t* buf) {
+    put_u16(&buf[0], (uint16_t)in->can->raw[FT550_CH_BATTERY_VOLTAGE]);
+    put_u16(&buf[2], (uint16_t)in->can->raw[FT550_CH_AIR_TEMP]);
+}
+
+// --- FRAME 0x602 (GPS Pos) ---
+static void encode_gps_pos(const dash_inputs_t* in, uint8_t* buf) {
+    put_u32(&buf[0], (uint32_t)in->gps->latitude_e7);
+    put_u32(&buf[4], (uint32_t)in->gps->longitude_e7);
+}
+
+// --- FRAME 0x603 (Meta) ---
+static void encode_meta(const dash_inputs_t* in, uint8_t* buf) {
+    put_u16(&buf[0], in->gps->speed_x10);
+    buf[2] = in->gps->satellites;
+    buf[3] = in->gps->fix_valid ? 1 : 0;
+    put_u16(&buf[4], (uint16_t)in->lora_tx_count);
+    put_u16(&buf[6], (uint16_t)in->can_frame_count);
+}
+
+// Engine data drives the shift lights, so it gets the fast lane. Battery,
+// air temp and the GPS/meta frames change slowly and mostly ride the refresh.
+// The minimum periods are the dash_*_ms defaults in config_store.h.
+static const dash_frame_t DASH_FRAME_DEFAULTS[DASH_NUM_FRAMES] = {
+    // can_id             encoder         min_period  refresh
+    { DASH_FRAME_ENGINE,  encode_engine,  { 10000,    100000  } },  // 100 Hz on change
+    { DASH_FRAME_AUX,     encode_aux,     { 200000,   1000000 } },  // 5 Hz on change
+    { DASH_FRAME_GPS_POS, encode_gps_pos, { 100000,   1000000 } },  // GPS updates at 10 Hz max
+    { DASH_FRAME_META,    encode_meta,    { 200000,   1000000 } },  // Counters always change
+};
+
+static dash_frame_t g_frames[DASH_NUM_FRAMES];
+static dash_stats_t g_stats;
+static uint32_t g_config_generation;    // Configuration the frame rates were taken from
+
+// Minimum periods from the config store, in DASH_FRAME_DEFAULTS order;
+// refresh intervals keep their defaults unless a period exceeds them
+static void load_config_rates(void) {
+    const daq_config_t* cfg = config_get();
+    const uint16_t period_ms[DASH_NUM_FRAMES] = {
+        cfg->dash_engine_ms, cfg->dash_aux_ms, cfg->dash_gps_ms, cfg->dash_meta_ms
+    };
+    for (int i = 0; i < DASH_NUM_FRAMES; i++) {
+        uint32_t min_period_us = (uint32_t)period_ms[i] * 1000;
+        g_frames[i].rate.min_period_us = min_period_us;
+        g_frames[i].rate.refresh_us = DASH_FRAME_DEFAULTS[i].rate.refresh_us > min_period_us
+                                      ? DASH_FRAME_DEFAULTS[i].rate.refresh_us : min_period_us;
+    }
+}
+
+void dash_publisher_init(void) {
+    memcpy(g_frames, DASH_FRAME_DEFAULTS, sizeof(g_frames));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_config_generation = config_generation();
+    load_config_rates();
+}
+
+bool dash_set_frame_rate(uint16_t can_id, const dash_frame_rate_t* rate) {
+    for (int i = 0; i < DASH_NUM_FRAMES; i++) {
+        if (g_frames[i].can_id == can_id) {
+            g_frames[i].rate = *rate;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t dash_publish(const ft550_sensor_data_t* can_data, const gps_data_t* gps, uint64_t now_us) {
+    dash_inputs_t in = {
+        .can = can_data,
+        .gps = gps,
+        .lora_tx_count = lora_get_tx_count(),
+        .can_frame_count = can_get_frame_count(),
+    };
+    uint32_t sent = 0;
+
+    // Configuration edits take effect between publish cycles
+    if (g_config_generation != config_generation()) {
+        g_config_generation = config_generation();
+        load_config_rates();
+    }
+
+    for (int i = 0; i < DASH_NUM_FRAMES; i++) {
+        dash_frame_t* frame = &g_frames[i];
+        uint64_t since_last = now_us - frame->last_sent_us;
+
+        if (frame->sent_once && since_last < frame->rate.min_period_us) {
+            continue;
+        }
+
+        uint8_t payload[8] = {0};
+        frame->encode(&in, payload);
+
+        bool changed = !frame->sent_once || memcmp(payload, frame->last_payload, 8) != 0;
+        if (!changed && since_last < frame->rate.refresh_us) {
+            g_stats.suppressed++;
+            continue;
+        }
+
+        MCP2515_Send(frame->can_id, payload, 8);
+        memcpy(frame->last_payload, payload, 8);
+        frame->last_sent_us = now_us;
+        frame->sent_once = true;
+        sent++;
+    }
+
+    g_stats.sent += sent;
+    return sent;
+}
+
+void dash_get_stats(dash_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    *stats = g_stats;
+}
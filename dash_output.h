@@ -0,0 +1,81 @@
+/**
+ * @file      dash_output.h
+ * @brief     Dashboard CAN frame publisher (frames 0x600-0x603)
+ * 
+ * Encodes the latest GPS + CAN telemetry into the compact dashboard frames
+ * and sends them on the local CAN bus through the MCP2515. Each frame has
+ * its own rate: it is sent when its payload changed and its minimum period
+ * has elapsed, or unconditionally once its refresh interval runs out.
+ * The minimum periods come from the config store (dash_*_ms) and are
+ * reloaded between publish cycles when the configuration changes.
+ */
+
+#ifndef DASH_OUTPUT_H
+#define DASH_OUTPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ft550_decoder.h"
+#include "gps.h"
+
+/**
+ * Dashboard frame IDs (Standard 11-bit)
+ */
+#define DASH_FRAME_ENGINE   0x600   // RPM, MAP, Engine Temp, TPS
+#define DASH_FRAME_AUX      0x601   // Battery Voltage, Air Temp
+#define DASH_FRAME_GPS_POS  0x602   // Latitude, Longitude (1e-7 deg)
+#define DASH_FRAME_META     0x603   // GPS Speed, Sats, Fix, LoRa TX count, CAN frame count
+
+#define DASH_NUM_FRAMES     4
+
+// How often dash_publish() should be called (fastest frame period)
+#define DASH_PUBLISH_TICK_US 10000
+
+/**
+ * Per-frame publishing rates
+ */
+typedef struct {
+    uint32_t min_period_us;         // Fastest rate when the payload changes
+    uint32_t refresh_us;            // Resend even if unchanged after this long
+} dash_frame_rate_t;
+
+/**
+ * Publisher accounting
+ */
+typedef struct {
+    uint32_t sent;                  // Frames put on the bus
+    uint32_t suppressed;            // Due frames skipped because nothing changed
+} dash_stats_t;
+
+/**
+ * @brief Reset the publisher so every frame is sent on the next call
+ */
+void dash_publisher_init(void);
+
+/**
+ * @brief Override the rates of one frame until the next configuration change
+ * 
+ * @param can_id One of the DASH_FRAME_* ids
+ * @param rate New rates
+ * @return true if the id is a dashboard frame
+ */
+bool dash_set_frame_rate(uint16_t can_id, const dash_frame_rate_t* rate);
+
+/**
+ * @brief Encode and send every dashboard frame that is due
+ * 
+ * @param can_data Snapshot of the decoded ECU data
+ * @param gps Snapshot of the GPS data
+ * @param now_us Current time from time_us_64()
+ * @return Number of frames sent
+ */
+uint32_t dash_publish(const ft550_sensor_data_t* can_data, const gps_data_t* gps, uint64_t now_us);
+
+/**
+ * @brief Get a copy of the publisher counters
+ * 
+ * @param stats Structure to fill
+ */
+void dash_get_stats(dash_stats_t* stats);
+
+#endif // DASH_OUTPUT_H
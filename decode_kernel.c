@@ -0,0 +1,148 @@
+/**
+ * @file      decode_kernel.c
+ * @brief     Big-endian int16 extraction and scaling implementation
+ */
+
+#include "decode_kernel.h"
+#include "hot_path.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include <arm_acle.h>
+#define DECODE_KERNEL_DSP 1
+#else
+#define DECODE_KERNEL_DSP 0
+#endif
+
+#define BENCH_BLOCK_BYTES   256
+#define BENCH_FRAMES        (BENCH_BLOCK_BYTES / 8)
+#define BENCH_CHANNELS      32
+
+const int16_t DECODE_KERNEL_UNIT_SCALES[4] HOT_PATH_DATA = { 1, 1, 1, 1 };
+
+static inline int32_t be16(const uint8_t* p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static inline int32_t be16_scaled(const uint8_t* p, int16_t scale) {
+    return be16(p) * scale;
+}
+
+void HOT_PATH_FUNC(decode_kernel_frame_c)(const uint8_t* data, const int16_t* scales, int32_t* out) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = be16_scaled(&data[i * 2], scales[i]);
+    }
+}
+
+void HOT_PATH_FUNC(decode_kernel_gather_c)(const uint8_t* block, const uint16_t* offsets,
+                            int32_t* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = be16(&block[offsets[i]]);
+    }
+}
+
+#if DECODE_KERNEL_DSP
+
+// Two scales in one register, [i] in the bottom half
+static inline int32_t pack_scales(const int16_t* scales) {
+    return (int32_t)((uint16_t)scales[0] | ((uint32_t)(uint16_t)scales[1] << 16));
+}
+
+// REV16 turns a little-endian load of two big-endian words into two
+// host-order halfwords; SMULBB/SMULTT sign-extend and scale each half
+static inline void scale_pair(uint32_t word, int32_t scales, int32_t* out) {
+    word = __rev16(word);
+    out[0] = __smulbb((int32_t)word, scales);
+    out[1] = __smultt((int32_t)word, scales);
+}
+
+void HOT_PATH_FUNC(decode_kernel_frame)(const uint8_t* data, const int16_t* scales, int32_t* out) {
+    uint32_t lo, hi;
+    memcpy(&lo, data, 4);               // Unaligned LDR is fine on the M33
+    memcpy(&hi, data + 4, 4);
+    scale_pair(lo, pack_scales(&scales[0]), &out[0]);
+    scale_pair(hi, pack_scales(&scales[2]), &out[2]);
+}
+
+// REV16 as above; SXTH and ASR sign-extend each half
+static inline void extend_pair(uint32_t word, int32_t* out) {
+    word = __rev16(word);
+    out[0] = (int16_t)word;
+    out[1] = (int32_t)word >> 16;
+}
+
+void HOT_PATH_FUNC(decode_kernel_gather)(const uint8_t* block, const uint16_t* offsets,
+                          int32_t* out, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint16_t a, b;
+        memcpy(&a, &block[offsets[i]], 2);
+        memcpy(&b, &block[offsets[i + 1]], 2);
+        extend_pair((uint32_t)a | ((uint32_t)b << 16), &out[i]);
+    }
+    if (i < count) {
+        out[i] = be16(&block[offsets[i]]);
+    }
+}
+
+#else
+
+void HOT_PATH_FUNC(decode_kernel_frame)(const uint8_t* data, const int16_t* scales, int32_t* out) {
+    decode_kernel_frame_c(data, scales, out);
+}
+
+void HOT_PATH_FUNC(decode_kernel_gather)(const uint8_t* block, const uint16_t* offsets,
+                          int32_t* out, uint32_t count) {
+    decode_kernel_gather_c(block, offsets, out, count);
+}
+
+#endif // DECODE_KERNEL_DSP
+
+void decode_kernel_benchmark(uint32_t iterations, uint64_t (*now_us)(void),
+                             decode_kernel_bench_t* result) {
+    static uint8_t block[BENCH_BLOCK_BYTES + 1];
+    static int32_t out_c[BENCH_FRAMES * 4 + BENCH_CHANNELS];
+    static int32_t out_k[BENCH_FRAMES * 4 + BENCH_CHANNELS];
+    uint16_t offsets[BENCH_CHANNELS];
+    int16_t scales[BENCH_FRAMES * 4];
+
+    // Deterministic data with both signs, odd and even channel offsets,
+    // and scales up to the int16 limits
+    uint32_t seed = 0x2545F491u;
+    for (int i = 0; i < (int)sizeof(block); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        block[i] = (uint8_t)(seed >> 24);
+    }
+    for (int i = 0; i < BENCH_FRAMES * 4; i++) {
+        static const int16_t SCALE_SET[] = { 1, 10, 100, 1000, -1, 32767, -32768, 7 };
+        scales[i] = SCALE_SET[i % 8];
+    }
+    for (int i = 0; i < BENCH_CHANNELS; i++) {
+        offsets[i] = (uint16_t)((i * 37 + 3) % (BENCH_BLOCK_BYTES - 1));
+    }
+
+    result->iterations = iterations;
+    result->dsp = DECODE_KERNEL_DSP;
+
+    uint64_t start = now_us();
+    for (uint32_t n = 0; n < iterations; n++) {
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            decode_kernel_frame_c(&block[f * 8], &scales[f * 4], &out_c[f * 4]);
+        }
+        decode_kernel_gather_c(block, offsets, &out_c[BENCH_FRAMES * 4], BENCH_CHANNELS);
+        __asm volatile("" ::: "memory");
+    }
+    result->portable_us = now_us() - start;
+
+    start = now_us();
+    for (uint32_t n = 0; n < iterations; n++) {
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            decode_kernel_frame(&block[f * 8], &scales[f * 4], &out_k[f * 4]);
+        }
+        decode_kernel_gather(block, offsets, &out_k[BENCH_FRAMES * 4], BENCH_CHANNELS);
+        __asm volatile("" ::: "memory");
+    }
+    result->kernel_us = now_us() - start;
+
+    result->match = memcmp(out_c, out_k, sizeof(out_c)) == 0;
+}
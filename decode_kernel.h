@@ -0,0 +1,85 @@
+/**
+ * @file      decode_kernel.h
+ * @brief     Big-endian int16 extraction and scaling for CAN frames and burst blocks
+ *
+ * Every FT550 frame is four big-endian int16 words and the M84 burst block
+ * is a byte array with big-endian int16 channels at fixed offsets from the
+ * magic number. These kernels extract a whole frame or every wanted channel
+ * of a block in one pass. The frame kernel writes raw x scale as int32
+ * fixed point (a scale of 1 gives the sign-extended raw value). The gather
+ * kernel writes the sign-extended raw words, since the M84 channels are
+ * kept raw and scaled by sample_channel_scale() downstream.
+ *
+ * On the Cortex-M33 (__ARM_FEATURE_DSP) two channels are handled per 32-bit
+ * word: REV16 swaps both halfwords to host order, then SMULBB/SMULTT
+ * sign-extend and scale each half (a frame) or SXTH/ASR sign-extend them
+ * (a gather). Elsewhere the same functions are plain
+ * C, so the module builds unchanged on a host; the _c variants are always
+ * the portable reference.
+ *
+ * No Pico SDK dependency.
+ */
+
+#ifndef DECODE_KERNEL_H
+#define DECODE_KERNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Run decode_kernel_benchmark() once at boot and print the result
+#ifndef DECODE_KERNEL_BENCHMARK
+#define DECODE_KERNEL_BENCHMARK 0
+#endif
+
+// Scales that return the raw words
+extern const int16_t DECODE_KERNEL_UNIT_SCALES[4];
+
+/**
+ * @brief Decode one 8-byte frame of four big-endian int16 words
+ *
+ * @param data Frame payload
+ * @param scales Multiplier per word
+ * @param out raw[i] * scales[i]
+ */
+void decode_kernel_frame(const uint8_t* data, const int16_t* scales, int32_t* out);
+
+/**
+ * @brief Decode big-endian int16 channels at arbitrary byte offsets
+ *
+ * @param block Start of the block (offsets may be odd)
+ * @param offsets Byte offset of each channel's high byte
+ * @param out Sign-extended raw[i]
+ * @param count Number of channels
+ */
+void decode_kernel_gather(const uint8_t* block, const uint16_t* offsets,
+                          int32_t* out, uint32_t count);
+
+// Portable reference implementations (same contract)
+void decode_kernel_frame_c(const uint8_t* data, const int16_t* scales, int32_t* out);
+void decode_kernel_gather_c(const uint8_t* block, const uint16_t* offsets,
+                            int32_t* out, uint32_t count);
+
+/**
+ * Benchmark result
+ */
+typedef struct {
+    uint32_t iterations;
+    uint64_t portable_us;           // decode_kernel_*_c
+    uint64_t kernel_us;             // decode_kernel_* (DSP when available)
+    bool     dsp;                   // Kernel was built with the DSP path
+    bool     match;                 // Both produced identical output
+} decode_kernel_bench_t;
+
+/**
+ * @brief Time both implementations on a synthetic 256-byte burst block
+ *
+ * Each iteration decodes 32 frames and gathers 32 channels.
+ *
+ * @param iterations Passes over the block
+ * @param now_us Microsecond clock (time_us_64 on the Pico)
+ * @param result Timings and cross-check
+ */
+void decode_kernel_benchmark(uint32_t iterations, uint64_t (*now_us)(void),
+                             decode_kernel_bench_t* result);
+
+#endif // DECODE_KERNEL_H
@@ -0,0 +1,44 @@
+/**
+ * @file      duty_cycle.c
+ * @brief     Hourly airtime budget implementation
+ */
+
+#include "duty_cycle.h"
+#include <string.h>
+
+// Empty the buckets of the minutes passed since the last call
+static void advance(duty_cycle_t* duty, uint32_t now_ms) {
+    uint32_t minute = now_ms / DUTY_CYCLE_BUCKET_MS;
+    uint32_t passed = minute - duty->minute;
+    if (passed >= DUTY_CYCLE_BUCKETS) {
+        memset(duty->airtime_ms, 0, sizeof(duty->airtime_ms));
+    } else {
+        for (uint32_t i = 1; i <= passed; i++) {
+            duty->airtime_ms[(duty->minute + i) % DUTY_CYCLE_BUCKETS] = 0;
+        }
+    }
+    duty->minute = minute;
+}
+
+void duty_cycle_init(duty_cycle_t* duty, uint8_t percent) {
+    memset(duty, 0, sizeof(*duty));
+    duty->limit_ms = 3600000u / 100u * percent;
+}
+
+uint32_t duty_cycle_used_ms(duty_cycle_t* duty, uint32_t now_ms) {
+    advance(duty, now_ms);
+    uint32_t used = 0;
+    for (int i = 0; i < DUTY_CYCLE_BUCKETS; i++) {
+        used += duty->airtime_ms[i];
+    }
+    return used;
+}
+
+bool duty_cycle_allows(duty_cycle_t* duty, uint32_t now_ms, uint32_t toa_ms) {
+    return duty_cycle_used_ms(duty, now_ms) + toa_ms <= duty->limit_ms;
+}
+
+void duty_cycle_spend(duty_cycle_t* duty, uint32_t now_ms, uint32_t toa_ms) {
+    advance(duty, now_ms);
+    duty->airtime_ms[duty->minute % DUTY_CYCLE_BUCKETS] += toa_ms;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file      duty_cycle.h
+ * @brief     Hourly airtime budget for a duty-cycled sub-GHz sub-band
+ *
+ * EU868 sub-bands limit each transmitter to a share of every hour on air
+ * (10 % on 869.4-869.65 MHz). The LR-FHSS essentials and the sub-GHz copies
+ * of critical LoRa frames share one sub-band, so they share one budget.
+ *
+ * Airtime is summed in one-minute buckets. The current bucket and the 60
+ * before it always cover at least the last hour, so a frame is only
+ * allowed if the whole hour stays within the limit. Unlike a fixed off-time
+ * after every frame, a rare critical frame can still go out a few seconds
+ * after a long LR-FHSS frame.
+ *
+ * No Pico SDK dependency.
+ */
+
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DUTY_CYCLE_BUCKET_MS    60000
+#define DUTY_CYCLE_BUCKETS      61          // The current minute and the hour before it
+
+typedef struct {
+    uint32_t airtime_ms[DUTY_CYCLE_BUCKETS];
+    uint32_t minute;                // Minute since boot of the newest bucket
+    uint32_t limit_ms;              // Airtime allowed in any hour
+} duty_cycle_t;
+
+/**
+ * @brief Start with an empty hour
+ *
+ * @param percent Share of every hour allowed on air
+ */
+void duty_cycle_init(duty_cycle_t* duty, uint8_t percent);
+
+/**
+ * @brief Whether a frame of toa_ms fits the budget now
+ */
+bool duty_cycle_allows(duty_cycle_t* duty, uint32_t now_ms, uint32_t toa_ms);
+
+/**
+ * @brief Charge a frame that was sent
+ */
+void duty_cycle_spend(duty_cycle_t* duty, uint32_t now_ms, uint32_t toa_ms);
+
+/**
+ * @brief Airtime used in the last hour (up to a minute more)
+ */
+uint32_t duty_cycle_used_ms(duty_cycle_t* duty, uint32_t now_ms);
+
+#endif // DUTY_CYCLE_H
@@ -0,0 +1,522 @@
+/**
+ * @file      FS26-DAQ-rtos.c
+ * @brief     FreeRTOS SMP variant of the DAQ (optional FS26-DAQ-RTOS target)
+ *
+ * Same ingest/broadcast modules as FS26-DAQ.c, split into pinned, prioritised
+ * tasks. Interrupts only notify their task (deferred processing) and tasks
+ * exchange the latest GPS/CAN snapshots through single-slot mailbox queues.
+ *
+ *   Task     Core  Prio  Released by
+ *   can_rx   0     6     MCP2515 INT notification, either bus (1 ms backstop)
+ *   gps_rx   0     5     UART RX notification (5 ms backstop)
+ *   dash_tx  0     4     every 10 ms (per-frame rates in dash_output.c)
+ *   lora_tx  1     4     fast packet every 200 ms, GPS/thermal/diagnostics
+ *                         packets and LR-FHSS essentials at their own rates,
+ *                         alarm and lap packets on notification; with TDMA
+ *                         on, LoRa packets wait for this node's slot
+ *   log      any   1     log message buffer, CPU report every 5 s, USB
+ *                         "cfg" console
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "pico/flash.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "message_buffer.h"
+
+#include "gps.h"
+#include "lr1121_tx.h"
+#include "can_handler.h"
+#include "ft550_decoder.h"
+#include "dash_output.h"
+#include "telemetry_packet.h"
+#include "alarm_engine.h"
+#include "telemetry_auth.h"
+#include "radio_stats.h"
+#include "boot_trace.h"
+#include "lap_timer.h"
+#include "can_health.h"
+#include "can_profiler.h"
+#include "safe_print.h"
+#include "config_store.h"
+#include "tdma.h"
+
+// Global mutex for printf (used by the shared modules through safe_print.h)
+mutex_t printf_mutex;
+
+#define CORE0_AFFINITY  (1u << 0)
+#define CORE1_AFFINITY  (1u << 1)
+
+#define CAN_RX_PRIORITY   (tskIDLE_PRIORITY + 6)
+#define GPS_RX_PRIORITY   (tskIDLE_PRIORITY + 5)
+#define DASH_TX_PRIORITY  (tskIDLE_PRIORITY + 4)
+#define LORA_TX_PRIORITY  (tskIDLE_PRIORITY + 4)
+#define LOG_PRIORITY      (tskIDLE_PRIORITY + 1)
+
+#define LOG_BUFFER_SIZE     1024
+#define LOG_LINE_MAX        128
+#define CPU_REPORT_MS       5000
+#define FLASH_SAFE_MS       2000
+
+static TaskHandle_t can_rx_handle;
+static TaskHandle_t gps_rx_handle;
+static TaskHandle_t lora_tx_handle;
+
+// Latest-value mailboxes (length 1, written with xQueueOverwrite)
+static QueueHandle_t can_mailbox;
+static QueueHandle_t gps_mailbox;
+
+static MessageBufferHandle_t log_buffer;
+static SemaphoreHandle_t log_mutex;
+static volatile uint32_t log_dropped = 0;
+
+// Message buffers are single-writer, so senders serialise on log_mutex.
+// Lines are dropped (and counted) rather than blocking a real-time task.
+static void rtos_log(const char* fmt, ...) {
+    char line[LOG_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len <= 0) return;
+    if (len >= (int)sizeof(line)) len = sizeof(line) - 1;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    if (xMessageBufferSend(log_buffer, line, (size_t)len, 0) == 0) {
+        log_dropped++;
+    }
+    xSemaphoreGive(log_mutex);
+}
+
+// --- ISR deferral ---
+
+static void can_rx_isr_callback(void) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(can_rx_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void gps_rx_isr_callback(void) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(gps_rx_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Alarm state changed (dash_tx) or lap completed (gps_rx): wake lora_tx
+static void lora_event_notify(void) {
+    xTaskNotifyGive(lora_tx_handle);
+}
+
+// --- Tasks ---
+
+static void can_rx_task(void* param) {
+    (void)param;
+    bool first_frame = false;
+    TickType_t last_health = xTaskGetTickCount();
+
+    can_set_rx_callback(can_rx_isr_callback);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1));
+
+        // spi0 is arbitrated per driver call (DEV_SPI_Lock), so dash_tx
+        // frames can go out between reads
+        bool received = false;
+        while (can_process_frame()) {
+            received = true;
+        }
+
+        // Publish after any frame from either bus: chassis frames update
+        // the sensor data without an ECU block being decoded
+        boot_trace_once(&first_frame, received, "first CAN frame");
+        if (received) {
+            ft550_sensor_data_t can_data;
+            can_get_sensor_data_safe(&can_data);
+            xQueueOverwrite(can_mailbox, &can_data);
+        }
+
+        // Error counters and recovery share spi0 with reception, so they
+        // run here rather than in a task of their own
+        if (xTaskGetTickCount() - last_health >= pdMS_TO_TICKS(CAN_HEALTH_PERIOD_MS)) {
+            last_health = xTaskGetTickCount();
+            can_health_poll();
+        }
+    }
+}
+
+static void gps_rx_task(void* param) {
+    (void)param;
+
+    bool configured = false;
+
+    // Registers the UART IRQ on this task's core (core 0)
+    gps_set_rx_callback(gps_rx_isr_callback);
+    gps_enable_rx_irq();
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+        gps_config_poll();
+        boot_trace_once(&configured, gps_config_done(), "GPS configured");
+        if (!gps_is_readable()) continue;
+
+        gps_process();
+
+        gps_data_t gps;
+        gps_get_data_safe(&gps);
+        xQueueOverwrite(gps_mailbox, &gps);
+
+        ft550_sensor_data_t can_data = {0};
+        xQueuePeek(can_mailbox, &can_data, 0);
+        lap_timer_update(&gps, (uint16_t)ft550_raw(&can_data, FT550_CH_RPM), to_ms_since_boot(get_absolute_time()));
+    }
+}
+
+static void dash_tx_task(void* param) {
+    (void)param;
+    ft550_sensor_data_t can_data = {0};
+    gps_data_t gps = {0};
+    bool first_frame = false;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (true) {
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(DASH_PUBLISH_TICK_US / 1000));
+
+        xQueuePeek(can_mailbox, &can_data, 0);
+        xQueuePeek(gps_mailbox, &gps, 0);
+
+        boot_trace_once(&first_frame, dash_publish(&can_data, &gps, time_us_64()) > 0, "first dash frame");
+        alarm_publish(time_us_32());
+    }
+}
+
+// TDMA (tdma.h), owned by lora_tx_task
+static tdma_node_t tdma;
+static uint32_t tdma_packet_us = 0;     // Longest LoRa frame with the active profile, plus set-up
+static bool tdma_slotted = false;       // Clock synced this cycle: LoRa waits for the window
+static bool tdma_deferred = false;      // A due packet did not fit in the last window
+
+static void tdma_apply_config(const daq_config_t* cfg) {
+    tdma_packet_us = LORA_TX_SETUP_US +
+                     lora_time_on_air_ms(TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD) * 1000u;
+    uint32_t sync_error_us = GPS_PPS_PIN >= 0 ? TDMA_PPS_SYNC_ERROR_US : TDMA_NMEA_SYNC_ERROR_US;
+    if (tdma_node_configure(&tdma, cfg->tdma_node_id, cfg->tdma_nodes, cfg->fast_period_ms * 1000u,
+                            sync_error_us, tdma_packet_us)) {
+        rtos_log("[TDMA] node %u of %u: slot %lu us, guard %lu us, packet %lu us\n",
+                 cfg->tdma_node_id, cfg->tdma_nodes, (unsigned long)tdma.plan.slot_us,
+                 (unsigned long)tdma.plan.guard_us, (unsigned long)tdma_packet_us);
+    } else if (cfg->tdma_nodes > 1) {
+        rtos_log("[TDMA] OFF: %lu us packet and 2 x %lu us guard do not fit a %lu us slot\n",
+                 (unsigned long)tdma_packet_us, (unsigned long)tdma.plan.guard_us,
+                 (unsigned long)tdma.plan.slot_us);
+    }
+}
+
+// Feed a new GPS time reference into the TDMA clock
+static void tdma_poll_time_ref(void) {
+    static uint32_t seq = 0;
+    gps_time_ref_t ref;
+    if (gps_get_time_ref(&ref) && ref.seq != seq) {
+        seq = ref.seq;
+        tdma_clock_update(&tdma.clock, ref.utc_ms_of_day, ref.local_us,
+                          ref.pps ? TDMA_SYNC_PPS : TDMA_SYNC_NMEA);
+    }
+}
+
+// A LoRa frame started now stays inside this node's window (always true unslotted)
+static bool lora_fits(void) {
+    return !tdma_slotted || tdma_fits(&tdma.plan, &tdma.clock, time_us_64(), tdma_packet_us);
+}
+
+static bool send_packet(const telemetry_header_t* header) {
+    uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t length = telemetry_encode(header, frame);
+    return length > 0 && telemetry_auth_send(frame, length);
+}
+
+// Alerts and laps also go out on sub-GHz when div_mode asks for it
+static bool send_critical_packet(const telemetry_header_t* header) {
+    uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t length = telemetry_encode(header, frame);
+    return length > 0 && telemetry_auth_send_critical(frame, length);
+}
+
+// Alarm alerts and lap summaries are sent as soon as they are notified,
+// or in the next window when slotted
+static void send_pending_events(void) {
+    alarm_alert_t alert;
+    if (lora_fits() && alarm_take_alert(&alert)) {
+        telemetry_alarm_t packet;
+        telemetry_build_alarm(&packet, &alert);
+        if (send_critical_packet(&packet.header)) {
+            rtos_log("[ALERT] active:0x%04x changed:0x%04x\n", alert.active_mask, alert.changed_mask);
+        } else {
+            rtos_log("[ALERT] FAILED active:0x%04x\n", alert.active_mask);
+        }
+    }
+
+    lap_summary_t lap;
+    if (lora_fits() && lap_timer_take_summary(&lap)) {
+        telemetry_lap_t packet;
+        telemetry_build_lap(&packet, &lap);
+        bool sent = send_critical_packet(&packet.header);
+        rtos_log("[LAP] %s #%u %lums best %lums\n", sent ? "sent" : "FAILED", lap.lap_number,
+                 (unsigned long)lap.lap_time_ms, (unsigned long)lap.best_lap_ms);
+    }
+}
+
+// True (and restarts the interval) once period_ms has passed since *last
+static bool interval_due(TickType_t* last, uint32_t period_ms) {
+    TickType_t now = xTaskGetTickCount();
+    if (now - *last < pdMS_TO_TICKS(period_ms)) {
+        return false;
+    }
+    *last = now;
+    return true;
+}
+
+// interval_due() for a LoRa packet: one that is due but does not fit the
+// window stays due for the next one
+static bool lora_due(TickType_t* last, uint32_t period_ms) {
+    if (xTaskGetTickCount() - *last < pdMS_TO_TICKS(period_ms)) {
+        return false;
+    }
+    if (!lora_fits()) {
+        tdma_deferred = true;
+        return false;
+    }
+    return interval_due(last, period_ms);
+}
+
+static void send_fast(const ft550_sensor_data_t* can_data) {
+    telemetry_fast_t fast;
+    telemetry_build_fast(&fast, can_data);
+    if (!send_packet(&fast.header)) {
+        rtos_log("[TX] FAILED #%lu\n", (unsigned long)lora_get_tx_count());
+    }
+}
+
+static void lora_tx_task(void* param) {
+    (void)param;
+    ft550_sensor_data_t can_data = {0};
+    gps_data_t gps = {0};
+
+    // Radio IRQ is registered on this task's core (core 1)
+    lora_tx_init();
+    boot_trace_mark("radio ready");
+    if (TELEMETRY_AUTH_MODE != TELEMETRY_AUTH_OFF) {
+        telemetry_auth_init();
+    }
+    rtos_log("lora_tx: LR1121 ready\n");
+
+    TickType_t last_wake = xTaskGetTickCount();
+    TickType_t last_gps = last_wake;
+    TickType_t last_thermal = last_wake;
+    TickType_t last_diag = last_wake;
+    TickType_t last_essentials = last_wake;
+    uint32_t generation = 0;
+    while (true) {
+        // One configuration per cycle; a commit takes effect from the next one
+        if (generation != config_generation()) {
+            generation = config_generation();
+            tdma_apply_config(config_get());
+        }
+        const daq_config_t* cfg = config_get();
+        xQueuePeek(can_mailbox, &can_data, 0);
+        xQueuePeek(gps_mailbox, &gps, 0);
+
+        tdma_poll_time_ref();
+        tdma_slotted = tdma_node_active(&tdma, time_us_64());
+        send_pending_events();
+
+        // Each packet type at its own rate; the fast packet sets the slot.
+        // Packets left over from the last window go first so a window that
+        // fits one frame does not starve them.
+        bool fast_pending = true;
+        if (!tdma_slotted || !tdma_deferred) {
+            if (lora_fits()) send_fast(&can_data);
+            fast_pending = false;
+        }
+        tdma_deferred = false;
+
+        if (lora_due(&last_gps, cfg->gps_period_ms)) {
+            telemetry_gps_t packet;
+            telemetry_build_gps(&packet, &gps);
+            send_packet(&packet.header);
+        }
+
+        if (lora_due(&last_thermal, cfg->thermal_period_ms)) {
+            telemetry_thermal_t packet;
+            telemetry_build_thermal(&packet, &can_data);
+            if (send_packet(&packet.header)) {
+                rtos_log("[TX] RPM:%u | Batt:%.2f | TPS:%.3f | EngineTemp:%.1f | TX#%u CAN#%u\n",
+                         (unsigned)ft550_raw(&can_data, FT550_CH_RPM), ft550_value(&can_data, FT550_CH_BATTERY_VOLTAGE),
+                         ft550_value(&can_data, FT550_CH_TPS), ft550_value(&can_data, FT550_CH_ENGINE_TEMP),
+                         packet.tx_count, packet.can_frame_count);
+            }
+        }
+
+        // Link diagnostics for the pits
+        if (lora_due(&last_diag, cfg->diag_period_ms)) {
+            telemetry_diag_t diag;
+            radio_stats_build_packet(&diag);
+            bool sent = send_packet(&diag.header);
+            rtos_log("[RADIO] %s | LoRa ok:%u tmo:%u spi:%u | LR-FHSS ok:%u tmo:%u | syserr:0x%04x x%u | spi:%lu busy_tmo:%u\n",
+                     sent ? "sent" : "NOT SENT",
+                     diag.lora_ok, diag.lora_timeout, diag.lora_spi_error,
+                     diag.fhss_ok, diag.fhss_timeout, diag.sys_errors, diag.sys_error_events,
+                     (unsigned long)diag.spi_commands, diag.busy_timeouts);
+
+            telemetry_can_health_t health;
+            can_health_build_packet(&health);
+            if (lora_fits()) send_packet(&health.header);
+        }
+
+        if (fast_pending && lora_fits()) {
+            send_fast(&can_data);
+        }
+
+        // Sub-GHz LR-FHSS essentials (blocks for ~1 s of time on air), outside TDMA
+        if (interval_due(&last_essentials, cfg->essentials_period_ms)) {
+            telemetry_essentials_t essentials;
+            telemetry_build_essentials(&essentials, &gps, &can_data, alarm_get_active_mask());
+            uint8_t frame[TELEMETRY_MAX_PACKET_SIZE];
+            uint8_t length = telemetry_encode(&essentials.header, frame);
+            bool sent = telemetry_auth_send_lr_fhss(frame, length);
+
+            radio_airtime_t airtime;
+            lora_get_airtime(&airtime);
+            rtos_log("[FHSS] %s #%u | airtime LoRa:%lums LR-FHSS:%lums deferred:%lu div:%lums deferred:%lu\n",
+                     sent ? "sent" : "NOT SENT", essentials.header.seq,
+                     (unsigned long)airtime.lora_airtime_ms, (unsigned long)airtime.lr_fhss_airtime_ms,
+                     (unsigned long)airtime.lr_fhss_deferred, (unsigned long)airtime.div_airtime_ms,
+                     (unsigned long)airtime.div_deferred);
+        }
+
+        // Wait for the next fast slot (this node's next window when slotted,
+        // rounded up to a tick), sending events as they are notified
+        TickType_t max_wait = pdMS_TO_TICKS(cfg->fast_period_ms) + 1;
+        TickType_t next_wake = last_wake + pdMS_TO_TICKS(cfg->fast_period_ms);
+        if (tdma_slotted) {
+            uint64_t now_us = time_us_64();
+            uint64_t wait_us = tdma_next_window(&tdma.plan, &tdma.clock, now_us) - now_us;
+            next_wake = xTaskGetTickCount() + (TickType_t)((wait_us + portTICK_PERIOD_MS * 1000 - 1) /
+                                                           (portTICK_PERIOD_MS * 1000));
+        }
+        while (true) {
+            // Zero or wrapped past the period means the slot is due
+            TickType_t remaining = next_wake - xTaskGetTickCount();
+            if (remaining == 0 || remaining > max_wait) break;
+            ulTaskNotifyTake(pdTRUE, remaining);
+            send_pending_events();
+        }
+        last_wake = next_wake;
+    }
+}
+
+// Config store flash writes: flash_safe_execute() parks the other core
+// through a high-priority task, so the kernel must be running
+static bool run_flash_safe(void (*fn)(void*), void* param) {
+    return flash_safe_execute(fn, param, FLASH_SAFE_MS) == PICO_OK;
+}
+
+static void log_task(void* param) {
+    (void)param;
+    static char line[LOG_LINE_MAX + 1];
+    static char stats[768];
+    TickType_t last_report = xTaskGetTickCount();
+
+    config_store_set_flash_runner(run_flash_safe);
+
+    while (true) {
+        size_t len = xMessageBufferReceive(log_buffer, line, LOG_LINE_MAX, pdMS_TO_TICKS(100));
+        if (len > 0) {
+            line[len] = '\0';
+            safe_printf("%s", line);
+        }
+
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(CPU_REPORT_MS)) {
+            last_report = xTaskGetTickCount();
+            vTaskGetRunTimeStats(stats);
+            safe_printf("[RTOS] Task            Abs(us)         %%CPU  (log dropped: %lu)\n%s",
+                        (unsigned long)log_dropped, stats);
+        }
+
+        can_profiler_report();
+        boot_trace_report();
+        config_store_poll_usb();
+    }
+}
+
+// --- Kernel hooks ---
+
+void vApplicationStackOverflowHook(TaskHandle_t task, char* name) {
+    (void)task;
+    printf("[RTOS] Stack overflow in %s\n", name);
+    while (true) {
+    }
+}
+
+void vApplicationMallocFailedHook(void) {
+    printf("[RTOS] Heap exhausted\n");
+    while (true) {
+    }
+}
+
+int main() {
+    stdio_init_all();
+    mutex_init(&printf_mutex);
+    boot_trace_init();
+#if BOOT_USB_WAIT_MS
+    // Bench only: give a terminal time to attach before the boot messages
+    absolute_time_t usb_deadline = make_timeout_time_ms(BOOT_USB_WAIT_MS);
+    while (!stdio_usb_connected() && !time_reached(usb_deadline)) {
+        sleep_ms(10);
+    }
+#endif
+
+    printf("FS26-DAQ-RTOS: Initializing CAN + GPS before starting the kernel...\n");
+    config_store_init();
+    alarm_init();
+    alarm_set_alert_callback(lora_event_notify);
+    lap_timer_init();
+    lap_timer_set_callback(lora_event_notify);
+    // can_init() may write the autobaud cache to flash, so before the kernel
+    can_init();
+    can_health_init();
+    can_profiler_init();
+    boot_trace_mark("can_init");
+    dash_publisher_init();
+    // Only opens the UART; configuration runs in gps_rx_task
+    gps_init();
+    boot_trace_mark("gps_init");
+
+    can_mailbox = xQueueCreate(1, sizeof(ft550_sensor_data_t));
+    gps_mailbox = xQueueCreate(1, sizeof(gps_data_t));
+    log_buffer = xMessageBufferCreate(LOG_BUFFER_SIZE);
+    log_mutex = xSemaphoreCreateMutex();
+
+    xTaskCreateAffinitySet(can_rx_task, "can_rx", 1024, NULL, CAN_RX_PRIORITY,
+                           CORE0_AFFINITY, &can_rx_handle);
+    xTaskCreateAffinitySet(gps_rx_task, "gps_rx", 1024, NULL, GPS_RX_PRIORITY,
+                           CORE0_AFFINITY, &gps_rx_handle);
+    xTaskCreateAffinitySet(dash_tx_task, "dash_tx", 1024, NULL, DASH_TX_PRIORITY,
+                           CORE0_AFFINITY, NULL);
+    xTaskCreateAffinitySet(lora_tx_task, "lora_tx", 2048, NULL, LORA_TX_PRIORITY,
+                           CORE1_AFFINITY, &lora_tx_handle);
+    xTaskCreate(log_task, "log", 1536, NULL, LOG_PRIORITY, NULL);
+
+    boot_trace_mark("kernel start");
+    vTaskStartScheduler();
+
+    // Only reached if the kernel could not allocate the idle/timer tasks
+    printf("FS26-DAQ-RTOS: Scheduler failed to start\n");
+    while (true) {
+    }
+}
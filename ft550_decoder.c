@@ -4,139 +4,82 @@
  */
 
 #include "ft550_decoder.h"
+#include "hot_path.h"
+#include "decode_kernel.h"
 #include <string.h>
 #include <stdio.h>
 
+_Static_assert(FT550_FRAME_TRANS_TEMPS_FUEL - FT550_FRAME_TPS_MAP_TEMPS == FT550_NUM_FRAMES - 1,
+               "FT550 frame IDs must be contiguous");
+_Static_assert(FT550_CH_BATTERY_VOLTAGE == FT550_NUM_FRAMES * 4, "four channels per FT550 frame");
+
+// MAP is in M84 units: the ECU bus is the only source of that channel. The
+// FT550's own 0x14080600 frame (MAP in bar x 0.001) is not on either bus.
+const float ft550_channel_scale[FT550_CH_COUNT] = {
+    [FT550_CH_TPS]                  = 0.1f,
+    [FT550_CH_MAP]                  = 0.1f,
+    [FT550_CH_AIR_TEMP]             = 0.1f,
+    [FT550_CH_ENGINE_TEMP]          = 0.1f,
+    [FT550_CH_OIL_PRESSURE]         = 0.001f,
+    [FT550_CH_FUEL_PRESSURE]        = 0.001f,
+    [FT550_CH_WATER_PRESSURE]       = 0.001f,
+    [FT550_CH_GEAR]                 = 1.0f,
+    [FT550_CH_EXHAUST_O2]           = 0.001f,
+    [FT550_CH_RPM]                  = 1.0f,
+    [FT550_CH_OIL_TEMP]             = 0.1f,
+    [FT550_CH_PIT_LIMIT]            = 1.0f,
+    [FT550_CH_WHEEL_SPEED_FR]       = 1.0f,
+    [FT550_CH_WHEEL_SPEED_FL]       = 1.0f,
+    [FT550_CH_WHEEL_SPEED_RR]       = 1.0f,
+    [FT550_CH_WHEEL_SPEED_RL]       = 1.0f,
+    [FT550_CH_TRACTION_CTRL_SLIP]   = 1.0f,
+    [FT550_CH_TRACTION_CTRL_RETARD] = 1.0f,
+    [FT550_CH_TRACTION_CTRL_CUT]    = 1.0f,
+    [FT550_CH_HEADING]              = 1.0f,
+    [FT550_CH_SHOCK_FR]             = 0.001f,
+    [FT550_CH_SHOCK_FL]             = 0.001f,
+    [FT550_CH_SHOCK_RR]             = 0.001f,
+    [FT550_CH_SHOCK_RL]             = 0.001f,
+    [FT550_CH_G_FORCE_ACCEL]        = 1.0f,
+    [FT550_CH_G_FORCE_LATERAL]      = 1.0f,
+    [FT550_CH_YAW_RATE_FRONTAL]     = 1.0f,
+    [FT550_CH_YAW_RATE_LATERAL]     = 1.0f,
+    [FT550_CH_LAMBDA_CORRECTION]    = 1.0f,
+    [FT550_CH_FUEL_FLOW_TOTAL]      = 0.01f,
+    [FT550_CH_INJ_TIME_BANK_A]      = 0.01f,
+    [FT550_CH_INJ_TIME_BANK_B]      = 0.01f,
+    [FT550_CH_TRANS_OIL_TEMP]       = 0.1f,
+    [FT550_CH_TRANS_TEMP]           = 0.1f,
+    [FT550_CH_FUEL_CONSUMPTION]     = 1.0f,
+    [FT550_CH_BRAKE_PRESSURE]       = 0.001f,
+    [FT550_CH_BATTERY_VOLTAGE]      = 0.01f,
+};
+
 void ft550_init_sensor_data(ft550_sensor_data_t* sensor_data) {
     if (sensor_data) {
         memset(sensor_data, 0, sizeof(ft550_sensor_data_t));
     }
 }
 
-bool ft550_decode_frame(uint32_t frame_id, const uint8_t* data, 
+bool HOT_PATH_FUNC(ft550_decode_frame)(uint32_t frame_id, const uint8_t* data, 
                         ft550_sensor_data_t* sensor_data) {
     if (!data || !sensor_data) {
         return false;
     }
 
-    int16_t raw_m1, raw_m2, raw_m3, raw_m4;
-
-    switch (frame_id) {
-        // Frame 0x14080600: TPS, MAP, Air Temp, Engine Temp
-        case FT550_FRAME_TPS_MAP_TEMPS:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->tps = raw_m1 * 0.1f;
-            sensor_data->map = raw_m2 * 0.001f;
-            sensor_data->air_temp = raw_m3 * 0.1f;
-            sensor_data->engine_temp = raw_m4 * 0.1f;
-            return true;
-
-        // Frame 0x14080601: Oil Pressure, Fuel Pressure, Water Pressure, Gear
-        case FT550_FRAME_PRESSURES_GEAR:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->oil_pressure = raw_m1 * 0.001f;
-            sensor_data->fuel_pressure = raw_m2 * 0.001f;
-            sensor_data->water_pressure = raw_m3 * 0.001f;
-            sensor_data->gear = raw_m4;
-            return true;
-
-        // Frame 0x14080602: Exhaust O2, RPM, Oil Temp, Pit Limit
-        case FT550_FRAME_O2_RPM_TEMPS:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->exhaust_o2 = raw_m1 * 0.001f;
-            sensor_data->rpm = (uint16_t)raw_m2;  // RPM: raw × 1
-            sensor_data->oil_temp = raw_m3 * 0.1f;
-            sensor_data->pit_limit = raw_m4;
-            return true;
-
-        // Frame 0x14080603: Wheel Speeds (FR, FL, RR, RL)
-        case FT550_FRAME_WHEEL_SPEEDS:
-            sensor_data->wheel_speed_fr = ft550_extract_uint16_be(data, 0);
-            sensor_data->wheel_speed_fl = ft550_extract_uint16_be(data, 2);
-            sensor_data->wheel_speed_rr = ft550_extract_uint16_be(data, 4);
-            sensor_data->wheel_speed_rl = ft550_extract_uint16_be(data, 6);
-            return true;
-
-        // Frame 0x14080604: Traction Control & Heading
-        case FT550_FRAME_TRACTION_HEADING:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->traction_ctrl_slip = (float)raw_m1;
-            sensor_data->traction_ctrl_retard = (float)raw_m2;
-            sensor_data->traction_ctrl_cut = (float)raw_m3;
-            sensor_data->heading = (float)raw_m4;
-            return true;
-
-        // Frame 0x14080605: Shock Sensors (FR, FL, RR, RL)
-        case FT550_FRAME_SHOCK_SENSORS:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->shock_fr = raw_m1 * 0.001f;
-            sensor_data->shock_fl = raw_m2 * 0.001f;
-            sensor_data->shock_rr = raw_m3 * 0.001f;
-            sensor_data->shock_rl = raw_m4 * 0.001f;
-            return true;
-
-        // Frame 0x14080606: G-Force & Yaw Rate
-        case FT550_FRAME_G_FORCE_YAW:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->g_force_accel = (float)raw_m1;
-            sensor_data->g_force_lateral = (float)raw_m2;
-            sensor_data->yaw_rate_frontal = (float)raw_m3;
-            sensor_data->yaw_rate_lateral = (float)raw_m4;
-            return true;
-
-        // Frame 0x14080607: Lambda Correction, Fuel Flow, Injection Time
-        case FT550_FRAME_FUEL_LAMBDA:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->lambda_correction = (float)raw_m1;
-            sensor_data->fuel_flow_total = raw_m2 * 0.01f;
-            sensor_data->inj_time_bank_a = raw_m3 * 0.01f;
-            sensor_data->inj_time_bank_b = raw_m4 * 0.01f;
-            return true;
-
-        // Frame 0x14080608: Transmission & Brake
-        case FT550_FRAME_TRANS_TEMPS_FUEL:
-            raw_m1 = ft550_extract_int16_be(data, 0);
-            raw_m2 = ft550_extract_int16_be(data, 2);
-            raw_m3 = ft550_extract_int16_be(data, 4);
-            raw_m4 = ft550_extract_int16_be(data, 6);
-            
-            sensor_data->trans_oil_temp = raw_m1 * 0.1f;
-            sensor_data->trans_temp = raw_m2 * 0.1f;
-            sensor_data->fuel_consumption = (float)raw_m3;
-            sensor_data->brake_pressure = raw_m4 * 0.001f;
-            return true;
+    uint32_t frame = frame_id - FT550_FRAME_TPS_MAP_TEMPS;
+    if (frame >= FT550_NUM_FRAMES) {
+        // Unrecognized frame ID
+        return false;
+    }
 
-        default:
-            // Unrecognized frame ID
-            // printf("Warning: Unrecognized FT550 frame ID: 0x%08X\n", frame_id);
-            return false;
+    // Every frame is four big-endian int16 words; extract them in one pass
+    // straight into the frame's four channels
+    int32_t raw[4];
+    decode_kernel_frame(data, DECODE_KERNEL_UNIT_SCALES, raw);
+    int16_t* words = &sensor_data->raw[frame * 4];
+    for (int i = 0; i < 4; i++) {
+        words[i] = (int16_t)raw[i];
     }
+    return true;
 }
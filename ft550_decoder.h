@@ -28,74 +28,114 @@ typedef enum {
     FT550_FRAME_TRANS_TEMPS_FUEL    = 0x14080608   // Trans Oil Temp, Trans Temp, Fuel Consumption, Brake Press
 } ft550_frame_id_t;
 
+#define FT550_NUM_FRAMES    9
+
 /**
- * Combined sensor data from all FT550 frames
- * Stores decoded values with multipliers already applied
+ * Sensor channels, four per FT550 frame in frame and word order, so frame
+ * n fills channels 4n..4n+3. Battery voltage only comes from the M84 block.
  */
-typedef struct {
+typedef enum {
     // Frame 0x14080600 - TPS, MAP, Temps
-    float tps;                          // % (Raw × 0.1)
-    float map;                          // Bar (Raw × 0.001)
-    float air_temp;                     // °C (Raw × 0.1)
-    float engine_temp;                  // °C (Raw × 0.1)
-    
+    FT550_CH_TPS = 0,                   // % (Raw × 0.1)
+    FT550_CH_MAP,                       // kPa (Raw × 0.1, M84 units, see ft550_channel_scale)
+    FT550_CH_AIR_TEMP,                  // °C (Raw × 0.1)
+    FT550_CH_ENGINE_TEMP,               // °C (Raw × 0.1)
+
     // Frame 0x14080601 - Pressures, Gear
-    float oil_pressure;                 // Bar (Raw × 0.001)
-    float fuel_pressure;                // Bar (Raw × 0.001)
-    float water_pressure;               // Bar (Raw × 0.001)
-    int16_t gear;                       // Raw (No multiplier)
-    
+    FT550_CH_OIL_PRESSURE,              // Bar (Raw × 0.001)
+    FT550_CH_FUEL_PRESSURE,             // Bar (Raw × 0.001)
+    FT550_CH_WATER_PRESSURE,            // Bar (Raw × 0.001)
+    FT550_CH_GEAR,                      // Raw (No multiplier)
+
     // Frame 0x14080602 - O2, RPM, Temps
-    float exhaust_o2;                   // λ (Raw × 0.001)
-    uint16_t rpm;                       // RPM (Raw × 1)
-    float oil_temp;                     // °C (Raw × 0.1)
-    int16_t pit_limit;                  // Raw (No multiplier)
-    
+    FT550_CH_EXHAUST_O2,                // λ (Raw × 0.001)
+    FT550_CH_RPM,                       // RPM (Raw × 1, unsigned)
+    FT550_CH_OIL_TEMP,                  // °C (Raw × 0.1)
+    FT550_CH_PIT_LIMIT,                 // Raw (No multiplier)
+
     // Frame 0x14080603 - Wheel Speeds
-    uint16_t wheel_speed_fr;            // km/h (Raw × 1)
-    uint16_t wheel_speed_fl;            // km/h (Raw × 1)
-    uint16_t wheel_speed_rr;            // km/h (Raw × 1)
-    uint16_t wheel_speed_rl;            // km/h (Raw × 1)
-    
+    FT550_CH_WHEEL_SPEED_FR,            // km/h (Raw × 1, unsigned)
+    FT550_CH_WHEEL_SPEED_FL,            // km/h (Raw × 1, unsigned)
+    FT550_CH_WHEEL_SPEED_RR,            // km/h (Raw × 1, unsigned)
+    FT550_CH_WHEEL_SPEED_RL,            // km/h (Raw × 1, unsigned)
+
     // Frame 0x14080604 - Traction Control & Heading
-    float traction_ctrl_slip;           // Raw (No multiplier)
-    float traction_ctrl_retard;         // Raw (No multiplier)
-    float traction_ctrl_cut;            // Raw (No multiplier)
-    float heading;                      // Raw (No multiplier)
-    
+    FT550_CH_TRACTION_CTRL_SLIP,        // Raw (No multiplier)
+    FT550_CH_TRACTION_CTRL_RETARD,      // Raw (No multiplier)
+    FT550_CH_TRACTION_CTRL_CUT,         // Raw (No multiplier)
+    FT550_CH_HEADING,                   // Raw (No multiplier)
+
     // Frame 0x14080605 - Shock Sensors
-    float shock_fr;                     // Raw × 0.001
-    float shock_fl;                     // Raw × 0.001
-    float shock_rr;                     // Raw × 0.001
-    float shock_rl;                     // Raw × 0.001
-    
+    FT550_CH_SHOCK_FR,                  // Raw × 0.001
+    FT550_CH_SHOCK_FL,                  // Raw × 0.001
+    FT550_CH_SHOCK_RR,                  // Raw × 0.001
+    FT550_CH_SHOCK_RL,                  // Raw × 0.001
+
     // Frame 0x14080606 - G-Forces & Yaw Rate
-    float g_force_accel;                // Raw (No multiplier, already in g)
-    float g_force_lateral;              // Raw (No multiplier, already in g)
-    float yaw_rate_frontal;             // Raw (No multiplier)
-    float yaw_rate_lateral;             // Raw (No multiplier)
-    
+    FT550_CH_G_FORCE_ACCEL,             // g (No multiplier)
+    FT550_CH_G_FORCE_LATERAL,           // g (No multiplier)
+    FT550_CH_YAW_RATE_FRONTAL,          // Raw (No multiplier)
+    FT550_CH_YAW_RATE_LATERAL,          // Raw (No multiplier)
+
     // Frame 0x14080607 - Lambda, Fuel Flow, Injection
-    float lambda_correction;            // Raw (No multiplier)
-    float fuel_flow_total;              // L/min (Raw × 0.01)
-    float battery_voltage;              // V (Raw × 0.01)
-    float inj_time_bank_a;              // ms (Raw × 0.01)
-    float inj_time_bank_b;              // ms (Raw × 0.01)
-    
+    FT550_CH_LAMBDA_CORRECTION,         // Raw (No multiplier)
+    FT550_CH_FUEL_FLOW_TOTAL,           // L/min (Raw × 0.01)
+    FT550_CH_INJ_TIME_BANK_A,           // ms (Raw × 0.01)
+    FT550_CH_INJ_TIME_BANK_B,           // ms (Raw × 0.01)
+
     // Frame 0x14080608 - Transmission & Brake
-    float trans_oil_temp;               // °C (Raw × 0.1)
-    float trans_temp;                   // °C (Raw × 0.1)
-    float fuel_consumption;             // L (Raw × 1)
-    float brake_pressure;               // Bar (Raw × 0.001)
+    FT550_CH_TRANS_OIL_TEMP,            // °C (Raw × 0.1)
+    FT550_CH_TRANS_TEMP,                // °C (Raw × 0.1)
+    FT550_CH_FUEL_CONSUMPTION,          // L (Raw × 1)
+    FT550_CH_BRAKE_PRESSURE,            // Bar (Raw × 0.001)
+
+    // M84 burst block only
+    FT550_CH_BATTERY_VOLTAGE,           // V (Raw × 0.01)
+
+    FT550_CH_COUNT
+} ft550_channel_t;
+
+// Channels whose 16-bit raw word is unsigned
+#define FT550_UNSIGNED_CHANNELS ((1ull << FT550_CH_RPM) | (1ull << FT550_CH_WHEEL_SPEED_FR) | \
+                                 (1ull << FT550_CH_WHEEL_SPEED_FL) | (1ull << FT550_CH_WHEEL_SPEED_RR) | \
+                                 (1ull << FT550_CH_WHEEL_SPEED_RL))
+
+/**
+ * Combined sensor data from all FT550 frames
+ *
+ * Stores the raw 16-bit words as received; ft550_channel_scale[] converts
+ * them to engineering units. Most consumers send fixed point (x10, x100)
+ * and use the raw word directly instead of going through float.
+ */
+typedef struct {
+    int16_t raw[FT550_CH_COUNT];        // Indexed by ft550_channel_t
 } ft550_sensor_data_t;
 
+// Multiplier converting a raw channel word into the units above
+extern const float ft550_channel_scale[FT550_CH_COUNT];
+
+/**
+ * @brief Raw word of a channel, sign- or zero-extended as the channel requires
+ */
+static inline int32_t ft550_raw(const ft550_sensor_data_t* sensor_data, ft550_channel_t channel) {
+    return (FT550_UNSIGNED_CHANNELS >> channel) & 1 ? (int32_t)(uint16_t)sensor_data->raw[channel]
+                                                    : (int32_t)sensor_data->raw[channel];
+}
+
+/**
+ * @brief Channel value in engineering units
+ */
+static inline float ft550_value(const ft550_sensor_data_t* sensor_data, ft550_channel_t channel) {
+    return ft550_raw(sensor_data, channel) * ft550_channel_scale[channel];
+}
+
 /**
  * @brief Decode FT550 CAN frame and update sensor data
  * 
  * Parses an 8-byte CAN frame according to FT550 format:
  * - Big-endian signed 16-bit integers (INT16)
- * - Applies protocol-defined multipliers
- * - Updates corresponding fields in sensor_data
+ * - Stores the four raw words in the frame's channels; the protocol-defined
+ *   multipliers are in ft550_channel_scale[]
  * 
  * @param frame_id CAN extended ID (0x14080600-0x14080608)
  * @param data Pointer to 8-byte CAN data payload
@@ -3,19 +3,37 @@
 #include <stdlib.h>
 #include "gps.h"
 #include "safe_print.h"
+#include "sample_queue.h"
+#include "config_store.h"
+#include "hot_path.h"
 
 static char nmea_buffer[NMEA_BUFFER_SIZE];
 static int buffer_index = 0;
 static int total_readings = 0;
 static gps_data_t gps_data = {0};
 
+// Position held while stationary (anti-drift), only for the debug print
+static int32_t display_latitude_e7 = 0;
+static int32_t display_longitude_e7 = 0;
+
 // Spin lock for thread-safe access to gps_data
 static spin_lock_t* gps_spin_lock = NULL;
 
+// RX interrupt is only used as a wakeup source, see gps_enable_rx_irq()
+static bool rx_irq_enabled = false;
+static void (*rx_callback)(void) = NULL;
+
+// Time references: the RX interrupt fires a few characters into a burst,
+// which is the closest stamp of the sentence start that gps_process() sees
+static volatile uint64_t rx_irq_us = 0;
+static uint64_t sentence_us = 0;            // Local time of the last '$'
+static volatile uint64_t pps_us = 0;        // Last PPS rising edge
+static gps_time_ref_t time_ref = {0};
+
 // --- Helper Functions ---
 
 // Custom tokenizer that handles empty fields (e.g. ",,") correctly
-static char* nmea_token(char** stringp) {
+static char* HOT_PATH_FUNC(nmea_token)(char** stringp) {
     char* start = *stringp;
     if (!start) return NULL;
     char* end = strchr(start, ',');
@@ -28,7 +46,7 @@ static char* nmea_token(char** stringp) {
     return start;
 }
 
-static float nmea_to_decimal(const char* nmea_coord, char direction) {
+static float HOT_PATH_FUNC(nmea_to_decimal)(const char* nmea_coord, char direction) {
     if (!nmea_coord || strlen(nmea_coord) == 0) return 0.0;
     float coord = atof(nmea_coord);
     int degrees = (int)(coord / 100);
@@ -38,7 +56,13 @@ static float nmea_to_decimal(const char* nmea_coord, char direction) {
     return decimal;
 }
 
-static bool verify_nmea_checksum(char* sentence) {
+static int32_t HOT_PATH_FUNC(clamp_i32)(float value, int32_t min, int32_t max) {
+    if (value <= (float)min) return min;
+    if (value >= (float)max) return max;
+    return (int32_t)value;
+}
+
+static bool HOT_PATH_FUNC(verify_nmea_checksum)(char* sentence) {
     if (sentence[0] != '$') return false;
     char* asterisk = strrchr(sentence, '*');
     if (asterisk == NULL) return false;
@@ -50,13 +74,14 @@ static bool verify_nmea_checksum(char* sentence) {
 
 // NMEA Parsers
 
-static void parse_gpgga(char* sentence) {
+static void HOT_PATH_FUNC(parse_gpgga)(char* sentence) {
     char* cursor = sentence;
     nmea_token(&cursor); // Skip tag
     
     int field = 1;
     char* token;
     char lat_str[16]={0}, lat_dir=0, lon_str[16]={0}, lon_dir=0, alt_str[16]={0}, sat_str[8]={0};
+    float hdop = 0.0f;
     
     while ((token = nmea_token(&cursor)) != NULL && field < 15) {
         switch (field) {
@@ -65,7 +90,7 @@ static void parse_gpgga(char* sentence) {
             case 4: strncpy(lon_str, token, 15); break;
             case 5: lon_dir = token[0]; break;
             case 7: strncpy(sat_str, token, 7); break;
-            case 8: gps_data.hdop = atof(token); break;
+            case 8: hdop = atof(token); break;
             case 9: strncpy(alt_str, token, 15); break;
         }
         field++;
@@ -76,34 +101,75 @@ static void parse_gpgga(char* sentence) {
     float lat = nmea_to_decimal(lat_str, lat_dir);
     float lon = nmea_to_decimal(lon_str, lon_dir);
     float alt = atof(alt_str);
-    float hdop_val = atof(alt_str); // Already parsed above into gps_data.hdop
     bool valid = (strlen(lat_str) > 0 && sats > 0);
 
+    // Fixed point once, here; snapshots and the sample stream share it
+    int32_t lat_e7 = (int32_t)(lat * 10000000.0f);
+    int32_t lon_e7 = (int32_t)(lon * 10000000.0f);
+    int16_t alt_x10 = (int16_t)clamp_i32(alt * 10.0f, INT16_MIN, INT16_MAX);
+
     // Update gps_data with spin lock protection
     uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
-    gps_data.satellites = sats;
+    gps_data.satellites = sats > 63 ? 63 : sats;
+    gps_data.hdop_x10 = (uint8_t)clamp_i32(hdop * 10.0f, 0, UINT8_MAX);
     if (valid) {
         gps_data.fix_valid = true;
-        gps_data.raw_latitude = lat;
-        gps_data.raw_longitude = lon;
-        gps_data.altitude = alt;
+        gps_data.latitude_e7 = lat_e7;
+        gps_data.longitude_e7 = lon_e7;
+        gps_data.altitude_x10 = alt_x10;
     } else {
         gps_data.fix_valid = false;
     }
     spin_unlock(gps_spin_lock, irq_state);
+
+    // Stream the fix to core 1
+    uint32_t now_us = time_us_32();
+    sample_queue_push(SAMPLE_CH_GPS_SATELLITES, sats, now_us);
+    if (valid) {
+        sample_queue_push(SAMPLE_CH_GPS_LATITUDE, lat_e7, now_us);
+        sample_queue_push(SAMPLE_CH_GPS_LONGITUDE, lon_e7, now_us);
+        sample_queue_push(SAMPLE_CH_GPS_ALTITUDE, alt_x10, now_us);
+    }
+    sample_queue_publish();
+}
+
+static void HOT_PATH_FUNC(update_time_ref)(const char* time_str) {
+    int hhmmss = atoi(time_str);
+    const char* dot = strchr(time_str, '.');
+    uint32_t frac_ms = dot ? (uint32_t)(atof(dot) * 1000.0f + 0.5f) : 0;
+    uint32_t utc_ms = (uint32_t)((hhmmss / 10000) * 3600 + (hhmmss / 100 % 100) * 60 + hhmmss % 100) * 1000u
+                      + frac_ms;
+
+    // The PPS edge marks the whole second; use it if it belongs to this sentence
+    uint64_t edge = pps_us;
+    bool use_pps = GPS_PPS_PIN >= 0 && edge != 0 && sentence_us > edge + frac_ms * 1000u &&
+                   sentence_us - edge < 1000000u;
+    if (GPS_PPS_PIN >= 0 && edge != 0 && !use_pps) {
+        return;     // Do not flip to NMEA over one sentence that straddles an edge
+    }
+    uint64_t local_us = use_pps ? edge + frac_ms * 1000u
+                                : sentence_us - (uint64_t)GPS_NMEA_LATENCY_MS * 1000u;
+
+    uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
+    time_ref.seq++;
+    time_ref.utc_ms_of_day = utc_ms;
+    time_ref.local_us = local_us;
+    time_ref.pps = use_pps;
+    spin_unlock(gps_spin_lock, irq_state);
 }
 
-static void parse_gprmc(char* sentence) {
+static void HOT_PATH_FUNC(parse_gprmc)(char* sentence) {
     char* cursor = sentence;
     nmea_token(&cursor); // Skip tag
     
     int field = 1;
     char* token;
     char status = 'V';  // V = void (invalid), A = active (valid)
-    char speed_str[16]={0}, course_str[16]={0};
+    char time_str[16]={0}, speed_str[16]={0}, course_str[16]={0};
     
     while ((token = nmea_token(&cursor)) != NULL && field < 12) {
         switch (field) {
+            case 1: strncpy(time_str, token, 15); break;  // hhmmss.sss
             case 2: status = token[0]; break;  // A=valid, V=invalid
             case 7: strncpy(speed_str, token, 15); break;
             case 8: strncpy(course_str, token, 15); break;
@@ -119,16 +185,25 @@ static void parse_gprmc(char* sentence) {
         crs = (strlen(course_str) > 0) ? atof(course_str) : 0.0f;
     }
 
+    uint16_t speed_x10 = (uint16_t)clamp_i32(speed * 10.0f, 0, UINT16_MAX);
+
     // Update with spin lock protection
     uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
-    gps_data.speed_kph = speed;
-    gps_data.course = crs;
+    gps_data.speed_x10 = speed_x10;
+    gps_data.course_x10 = (uint16_t)clamp_i32(crs * 10.0f, 0, UINT16_MAX);
     spin_unlock(gps_spin_lock, irq_state);
+
+    sample_queue_push(SAMPLE_CH_GPS_SPEED, speed_x10, time_us_32());
+    sample_queue_publish();
+
+    if (status == 'A' && strlen(time_str) >= 6) {
+        update_time_ref(time_str);
+    }
 }
 
 // Logic Functions
 
-static void apply_filtering_and_print() {
+static void HOT_PATH_FUNC(apply_filtering_and_print)() {
     total_readings++;
 
     // Print raw status even if no fix, so we know it's alive
@@ -137,31 +212,31 @@ static void apply_filtering_and_print() {
         return;
     }
 
-    // Filter 1: Accuracy Check
-    if (gps_data.hdop > MAX_HDOP_THRESHOLD) {
+    // Filter 1: Accuracy Check (limit from the config store, default MAX_HDOP_THRESHOLD)
+    if (gps_data.hdop_x10 > config_get()->gps_max_hdop_x10) {
         // Signal is too weak/noisy
         return;
     }
 
     // Filter 2: Stationary Anti-Drift (with spin lock)
     uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
-    if (gps_data.speed_kph >= MIN_SPEED_THRESHOLD) {
+    if (gps_data.speed_x10 >= (uint16_t)(MIN_SPEED_THRESHOLD * 10)) {
         gps_data.is_moving = true;
-        gps_data.display_latitude = gps_data.raw_latitude;
-        gps_data.display_longitude = gps_data.raw_longitude;
+        display_latitude_e7 = gps_data.latitude_e7;
+        display_longitude_e7 = gps_data.longitude_e7;
     } else {
         gps_data.is_moving = false;
         // Keep previous display coordinates (locking them)
         // Unless this is the very first reading
-        if (gps_data.display_latitude == 0.0) {
-            gps_data.display_latitude = gps_data.raw_latitude;
-            gps_data.display_longitude = gps_data.raw_longitude;
+        if (display_latitude_e7 == 0) {
+            display_latitude_e7 = gps_data.latitude_e7;
+            display_longitude_e7 = gps_data.longitude_e7;
         }
     }
     // Copy for printing outside lock
-    float disp_lat = gps_data.display_latitude;
-    float disp_lon = gps_data.display_longitude;
-    float spd = gps_data.speed_kph;
+    float disp_lat = display_latitude_e7 * 1e-7f;
+    float disp_lon = display_longitude_e7 * 1e-7f;
+    float spd = gps_data.speed_x10 * 0.1f;
     bool moving = gps_data.is_moving;
     spin_unlock(gps_spin_lock, irq_state);
 
@@ -173,7 +248,7 @@ static void apply_filtering_and_print() {
     //        spd);
 }
 
-static void process_gps_data() {
+static void HOT_PATH_FUNC(process_gps_data)() {
     for (int i = 0; i < buffer_index; i++) {
         if (nmea_buffer[i] == '\n' || nmea_buffer[i] == '\r') {
             if (i > 0) {
@@ -198,6 +273,72 @@ static void process_gps_data() {
 
 // Public Interface Implementation
 
+/**
+ * Bring-up steps run by gps_config_poll(). Same sequence the blocking init
+ * used to run: find the receiver at 9600 (or 57600 from a previous boot),
+ * select RMC+GGA, switch to 57600 and set 5 Hz.
+ */
+typedef enum {
+    GPS_CFG_PROBE_9600 = 0,         // Wait for a '$' at 9600
+    GPS_CFG_PROBE_57600,            // Already switched on a previous boot?
+    GPS_CFG_SET_OUTPUT,             // GPS_CMD_SET_OUTPUT x3, 100 ms apart
+    GPS_CFG_SWITCH_BAUD,            // PMTK251, 500 ms for the receiver to switch
+    GPS_CFG_SETTLE_57600,           // 200 ms after our UART follows
+    GPS_CFG_VERIFY_57600,           // Wait for a '$' at 57600
+    GPS_CFG_SET_RATE,               // GPS_CMD_RATE x3, 100 ms apart
+    GPS_CFG_DONE,
+    GPS_CFG_ABSENT
+} gps_cfg_state_t;
+
+#define GPS_CFG_STARTUP_MS      1000    // Receiver power-up before the first probe window
+#define GPS_CFG_PROBE_MS        2000
+#define GPS_CFG_REPEATS         3
+
+static gps_cfg_state_t cfg_state = GPS_CFG_DONE;
+static absolute_time_t cfg_deadline;
+static uint8_t cfg_repeats = 0;
+static bool cfg_seen_sentence = false;  // Set by gps_process() on every '$'
+static const char* cfg_tx = NULL;       // Command still being written
+
+// Write as much of the pending command as the FIFO takes, never blocking
+static bool cfg_tx_pump(void) {
+    while (cfg_tx && *cfg_tx && uart_is_writable(GPS_UART_ID)) {
+        uart_putc_raw(GPS_UART_ID, *cfg_tx++);
+    }
+    if (cfg_tx && !*cfg_tx) cfg_tx = NULL;
+    return cfg_tx == NULL;
+}
+
+static void cfg_enter(gps_cfg_state_t state, uint32_t wait_ms) {
+    cfg_state = state;
+    cfg_deadline = make_timeout_time_ms(wait_ms);
+    cfg_seen_sentence = false;
+}
+
+// Send `command` GPS_CFG_REPEATS times, 100 ms apart; true once all are out
+static bool cfg_repeat(const char* command) {
+    if (!cfg_tx_pump() || !time_reached(cfg_deadline)) return false;
+    if (cfg_repeats == GPS_CFG_REPEATS) {
+        cfg_repeats = 0;
+        return true;
+    }
+    cfg_repeats++;
+    cfg_tx = command;
+    cfg_tx_pump();
+    cfg_deadline = make_timeout_time_ms(100);
+    return false;
+}
+
+#if GPS_PPS_PIN >= 0
+// Timestamp the receiver's PPS edge
+static void HOT_PATH_FUNC(gps_pps_irq_handler)(void) {
+    if (gpio_get_irq_event_mask(GPS_PPS_PIN) & GPIO_IRQ_EDGE_RISE) {
+        gpio_acknowledge_irq(GPS_PPS_PIN, GPIO_IRQ_EDGE_RISE);
+        pps_us = time_us_64();
+    }
+}
+#endif
+
 void gps_init(void) {
     gps_spin_lock = spin_lock_init(spin_lock_claim_unused(true));
     
@@ -205,107 +346,138 @@ void gps_init(void) {
     uart_init(GPS_UART_ID, 9600);
     gpio_set_function(GPS_TX_PIN, GPIO_FUNC_UART);
     gpio_set_function(GPS_RX_PIN, GPIO_FUNC_UART);
-    
-    sleep_ms(1000);  // Longer stabilization time
-    
-    // Flush any garbage
-    while (uart_is_readable(GPS_UART_ID)) uart_getc(GPS_UART_ID);
-
-    // Test if GPS is responding at 9600
-    safe_printf("   Checking for GPS at 9600...\n");
-    bool found_at_9600 = false;
-    absolute_time_t timeout = make_timeout_time_ms(2000);
-    while (!time_reached(timeout)) {
-        if (uart_is_readable(GPS_UART_ID)) {
-            char c = uart_getc(GPS_UART_ID);
-            if (c == '$') {
-                found_at_9600 = true;
-                break;
+
+#if GPS_PPS_PIN >= 0
+    // Raw handler: the shared GPIO callback belongs to the CAN interrupts
+    gpio_init(GPS_PPS_PIN);
+    gpio_set_dir(GPS_PPS_PIN, GPIO_IN);
+    gpio_pull_down(GPS_PPS_PIN);
+    gpio_add_raw_irq_handler(GPS_PPS_PIN, gps_pps_irq_handler);
+    gpio_set_irq_enabled(GPS_PPS_PIN, GPIO_IRQ_EDGE_RISE, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+#endif
+
+    // The rest of the bring-up runs from gps_config_poll() so CAN and the
+    // dash do not wait seconds for the receiver
+    cfg_enter(GPS_CFG_PROBE_9600, GPS_CFG_STARTUP_MS + GPS_CFG_PROBE_MS);
+}
+
+void gps_config_poll(void) {
+    switch (cfg_state) {
+        case GPS_CFG_PROBE_9600:
+            if (cfg_seen_sentence) {
+                safe_printf("   Found GPS at 9600.\n");
+                safe_printf("2. Configuring GPS output...\n");
+                cfg_enter(GPS_CFG_SET_OUTPUT, 0);
+            } else if (time_reached(cfg_deadline)) {
+                // Maybe GPS is already at 57600 from previous run
+                safe_printf("   Not found at 9600, trying 57600...\n");
+                uart_set_baudrate(GPS_UART_ID, 57600);
+                cfg_enter(GPS_CFG_PROBE_57600, 100 + GPS_CFG_PROBE_MS);
             }
-        }
-    }
-    
-    if (!found_at_9600) {
-        // Maybe GPS is already at 57600 from previous run
-        safe_printf("   Not found at 9600, trying 57600...\n");
-        uart_set_baudrate(GPS_UART_ID, 57600);
-        sleep_ms(100);
-        while (uart_is_readable(GPS_UART_ID)) uart_getc(GPS_UART_ID);
-        
-        timeout = make_timeout_time_ms(2000);
-        while (!time_reached(timeout)) {
-            if (uart_is_readable(GPS_UART_ID)) {
-                char c = uart_getc(GPS_UART_ID);
-                if (c == '$') {
-                    safe_printf("   Found GPS at 57600!\n");
-                    goto configure_rate;
-                }
+            break;
+
+        case GPS_CFG_PROBE_57600:
+            if (cfg_seen_sentence) {
+                safe_printf("   Found GPS at 57600!\n");
+                safe_printf("4. Setting 5Hz update rate...\n");
+                cfg_enter(GPS_CFG_SET_RATE, 0);
+            } else if (time_reached(cfg_deadline)) {
+                safe_printf("   WARNING: No GPS detected!\n");
+                cfg_enter(GPS_CFG_ABSENT, 0);
             }
-        }
-        safe_printf("   WARNING: No GPS detected!\n");
-        return;
-    }
-    
-    safe_printf("   Found GPS at 9600.\n");
-    
-    // Configure output sentences first (at 9600)
-    safe_printf("2. Configuring GPS output...\n");
-    for(int i=0; i<3; i++) { 
-        uart_puts(GPS_UART_ID, GPS_CMD_SET_OUTPUT); 
-        sleep_ms(100); 
-    }
-    
-    // Switch GPS to 57600 baud
-    safe_printf("3. Switching GPS to 57600 baud...\n");
-    uart_puts(GPS_UART_ID, "$PMTK251,57600*00\r\n");
-    sleep_ms(500);  // Give GPS time to switch
-    
-    // Switch Pico UART to match
-    uart_set_baudrate(GPS_UART_ID, 57600);
-    sleep_ms(200);
-    
-    // Flush and verify
-    while (uart_is_readable(GPS_UART_ID)) uart_getc(GPS_UART_ID);
-    
-    // Verify we can still communicate
-    safe_printf("   Verifying communication at 57600...\n");
-    timeout = make_timeout_time_ms(2000);
-    bool verified = false;
-    while (!time_reached(timeout)) {
-        if (uart_is_readable(GPS_UART_ID)) {
-            char c = uart_getc(GPS_UART_ID);
-            if (c == '$') {
-                verified = true;
-                break;
+            break;
+
+        case GPS_CFG_SET_OUTPUT:
+            if (cfg_repeat(GPS_CMD_SET_OUTPUT)) {
+                // Switch GPS to 57600 baud
+                safe_printf("3. Switching GPS to 57600 baud...\n");
+                cfg_tx = "$PMTK251,57600*00\r\n";
+                cfg_tx_pump();
+                cfg_enter(GPS_CFG_SWITCH_BAUD, 500);  // Give GPS time to switch
             }
-        }
-    }
-    
-    if (!verified) {
-        safe_printf("   WARNING: Lost GPS after baud switch! Reverting to 9600.\n");
-        uart_set_baudrate(GPS_UART_ID, 9600);
-        safe_printf(">> GPS running at 9600 baud, 1Hz.\n");
-        return;
-    }
-    
-configure_rate:
-    // Set 5Hz update rate
-    safe_printf("4. Setting 5Hz update rate...\n");
-    for(int i=0; i<3; i++) { 
-        uart_puts(GPS_UART_ID, GPS_CMD_RATE);
-        sleep_ms(100); 
+            break;
+
+        case GPS_CFG_SWITCH_BAUD:
+            if (cfg_tx_pump() && time_reached(cfg_deadline)) {
+                // Switch Pico UART to match
+                uart_set_baudrate(GPS_UART_ID, 57600);
+                cfg_enter(GPS_CFG_SETTLE_57600, 200);
+            }
+            break;
+
+        case GPS_CFG_SETTLE_57600:
+            if (time_reached(cfg_deadline)) {
+                safe_printf("   Verifying communication at 57600...\n");
+                cfg_enter(GPS_CFG_VERIFY_57600, GPS_CFG_PROBE_MS);
+            }
+            break;
+
+        case GPS_CFG_VERIFY_57600:
+            if (cfg_seen_sentence) {
+                safe_printf("4. Setting 5Hz update rate...\n");
+                cfg_enter(GPS_CFG_SET_RATE, 0);
+            } else if (time_reached(cfg_deadline)) {
+                safe_printf("   WARNING: Lost GPS after baud switch! Reverting to 9600.\n");
+                uart_set_baudrate(GPS_UART_ID, 9600);
+                safe_printf(">> GPS running at 9600 baud, 1Hz.\n");
+                cfg_enter(GPS_CFG_DONE, 0);
+            }
+            break;
+
+        case GPS_CFG_SET_RATE:
+            if (cfg_repeat(GPS_CMD_RATE)) {
+                safe_printf(">> GPS Configured: 57600 baud, 5Hz. Waiting for Fix...\n");
+                cfg_enter(GPS_CFG_DONE, 0);
+            }
+            break;
+
+        case GPS_CFG_DONE:
+        case GPS_CFG_ABSENT:
+            break;
     }
-    
-    safe_printf(">> GPS Configured: 57600 baud, 5Hz. Waiting for Fix...\n");
 }
 
-void gps_process(void) {
+bool gps_config_done(void) {
+    return cfg_state == GPS_CFG_DONE || cfg_state == GPS_CFG_ABSENT;
+}
+
+void HOT_PATH_FUNC(gps_process)(void) {
+    uint64_t burst_us = rx_irq_us;
+    rx_irq_us = 0;
     while (uart_is_readable(GPS_UART_ID)) {
         char c = uart_getc(GPS_UART_ID);
+        if (c == '$') {
+            cfg_seen_sentence = true;
+            sentence_us = burst_us ? burst_us : time_us_64();
+        }
+        burst_us = 0;
         if (buffer_index < NMEA_BUFFER_SIZE - 1) nmea_buffer[buffer_index++] = c;
         else buffer_index = 0; 
         if (c == '\n') process_gps_data();
     }
+    
+    // FIFO drained - re-arm the wakeup interrupt
+    if (rx_irq_enabled) uart_set_irq_enables(GPS_UART_ID, true, false);
+}
+
+// Mask the RX interrupt until gps_process() has drained the FIFO, otherwise
+// it would keep firing while the data sits there
+static void HOT_PATH_FUNC(gps_uart_irq_handler)(void) {
+    rx_irq_us = time_us_64();
+    uart_set_irq_enables(GPS_UART_ID, false, false);
+    if (rx_callback) rx_callback();
+}
+
+void gps_set_rx_callback(void (*callback)(void)) {
+    rx_callback = callback;
+}
+
+void gps_enable_rx_irq(void) {
+    irq_set_exclusive_handler(UART0_IRQ, gps_uart_irq_handler);
+    irq_set_enabled(UART0_IRQ, true);
+    rx_irq_enabled = true;
+    uart_set_irq_enables(GPS_UART_ID, true, false);
 }
 
 bool gps_is_readable(void) {
@@ -320,4 +492,11 @@ void gps_get_data_safe(gps_data_t* out) {
     uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
     *out = gps_data;  // Copy entire struct atomically
     spin_unlock(gps_spin_lock, irq_state);
+}
+
+bool gps_get_time_ref(gps_time_ref_t* out) {
+    uint32_t irq_state = spin_lock_blocking(gps_spin_lock);
+    *out = time_ref;
+    spin_unlock(gps_spin_lock, irq_state);
+    return out->seq != 0;
 }
\ No newline at end of file
@@ -2,15 +2,28 @@
 #define GPS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "pico/stdlib.h"
 #include "pico/sync.h"
 #include "hardware/uart.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
 
 #define GPS_UART_ID uart0
 #define GPS_TX_PIN 0
 #define GPS_RX_PIN 1
 
+// Receiver PPS output for TDMA time references; -1 if not wired
+#ifndef GPS_PPS_PIN
+#define GPS_PPS_PIN -1
+#endif
+
+// Epoch to RMC sentence start, subtracted from NMEA time references.
+// Calibrate against a PPS node before mixing PPS and NMEA nodes on one channel.
+#ifndef GPS_NMEA_LATENCY_MS
+#define GPS_NMEA_LATENCY_MS 0
+#endif
+
 // Baud Rate: 57600 required for 5Hz
 #define GPS_TARGET_BAUD 57600
 
@@ -19,41 +32,77 @@
 #define GPS_CMD_SET_OUTPUT  "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n"
 
 // Filtering Settings
-#define MAX_HDOP_THRESHOLD  3.0f   // Ignore data if accuracy is worse than this
+#define MAX_HDOP_THRESHOLD  3.0f   // Default for gps_max_hdop_x10 (config_store.h): ignore worse fixes
 #define MIN_SPEED_THRESHOLD 8.0f   // km/h - Must exceed GPS noise floor (~7 kph)
 
 // Buffer
 #define NMEA_BUFFER_SIZE 256
 
+/**
+ * Latest fix (16 bytes), fixed point in the sample stream's units
+ */
 typedef struct {
-    bool fix_valid;
-    float raw_latitude;
-    float raw_longitude;
-    float altitude;
-    float speed_kph;
-    float course;
-    float hdop;
-    int satellites;
-    
-    // Display (Filtered)
-    float display_latitude;
-    float display_longitude;
-    bool is_moving;
+    int32_t  latitude_e7;               // deg (Raw × 1e-7)
+    int32_t  longitude_e7;              // deg (Raw × 1e-7)
+    int16_t  altitude_x10;              // m (Raw × 0.1)
+    uint16_t speed_x10;                 // km/h (Raw × 0.1)
+    uint16_t course_x10;                // deg (Raw × 0.1)
+    uint8_t  hdop_x10;                  // Raw × 0.1, saturates at 25.5
+    uint8_t  satellites : 6;            // In use (GGA), saturates at 63
+    uint8_t  fix_valid  : 1;
+    uint8_t  is_moving  : 1;            // Above MIN_SPEED_THRESHOLD
 } gps_data_t;
 
+/**
+ * GPS time of one fix epoch against the local timer (for tdma.c)
+ */
+typedef struct {
+    uint32_t seq;                       // Incremented for every new reference
+    uint32_t utc_ms_of_day;             // RMC time of the epoch
+    uint64_t local_us;                  // time_us_64() at the epoch
+    bool     pps;                       // From the PPS edge, else the RMC sentence start
+} gps_time_ref_t;
+
 // --- Public Interface ---
 
 /**
- * Initialize GPS module with smart baud rate detection and configuration
+ * Set up the UART at 9600 baud and start the receiver bring-up
+ *
+ * Returns at once; baud detection and configuration are driven by
+ * gps_config_poll().
  */
 void gps_init(void);
 
+/**
+ * Advance the GPS bring-up (baud detection, sentence selection, 57600 baud,
+ * 5 Hz) without blocking. Call with gps_process() from the GPS task; a few
+ * seconds after gps_init() gps_config_done() becomes true.
+ */
+void gps_config_poll(void);
+
+/**
+ * @return true once the bring-up has finished (configured or no receiver)
+ */
+bool gps_config_done(void);
+
 /**
  * Process any available GPS data from UART
  * Call this regularly in your main loop
  */
 void gps_process(void);
 
+/**
+ * Enable the UART RX interrupt so an idle core wakes when NMEA data arrives.
+ * The interrupt masks itself; gps_process() re-arms it after draining the FIFO.
+ */
+void gps_enable_rx_irq(void);
+
+/**
+ * Register a callback invoked from the UART RX interrupt (e.g. to notify an
+ * RTOS task). Runs in interrupt context; pass NULL to clear.
+ */
+void gps_set_rx_callback(void (*callback)(void));
+
 /**
  * Check if GPS UART has readable data
  * @return true if data is available
@@ -73,4 +122,11 @@ const gps_data_t* gps_get_data(void);
  */
 void gps_get_data_safe(gps_data_t* out);
 
+/**
+ * Get the latest time reference (thread-safe)
+ * @param out Filled in; compare out->seq to detect a new reference
+ * @return false until a valid RMC sentence has been seen
+ */
+bool gps_get_time_ref(gps_time_ref_t* out);
+
 #endif // GPS_H
\ No newline at end of file
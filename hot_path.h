@@ -0,0 +1,35 @@
+/**
+ * @file      hot_path.h
+ * @brief     SRAM placement for latency-critical code and tables
+ *
+ * Code normally executes from QSPI flash through the XIP cache. A cache
+ * miss costs hundreds of cycles and a flash erase/program stalls both
+ * cores, so the CAN/GPS ingest path, the shared SPI and GPIO helpers and
+ * the LR1121 HAL are copied to SRAM at boot instead.
+ *
+ * HOT_PATH_FUNC(name) is the SDK's __not_in_flash_func(name) (the
+ * ".time_critical.<name>" section the Pico linker scripts copy to RAM),
+ * written out so SDK-free modules can use it and host builds ignore it.
+ * HOT_PATH_DATA does the same for const lookup tables.
+ *
+ * Build with HOT_PATH_IN_RAM=0 (FS26_HOT_PATH_IN_RAM=OFF) to leave
+ * everything in flash, e.g. for the before/after hot_path_bench.c run.
+ * tools/hot_path_report.py lists where each hot symbol ended up.
+ */
+
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+#ifndef HOT_PATH_IN_RAM
+#define HOT_PATH_IN_RAM 1
+#endif
+
+#if HOT_PATH_IN_RAM && defined(__arm__)
+#define HOT_PATH_FUNC(name) __attribute__((section(".time_critical." #name))) name
+#define HOT_PATH_DATA       __attribute__((section(".time_critical.hot_path_data")))
+#else
+#define HOT_PATH_FUNC(name) name
+#define HOT_PATH_DATA
+#endif
+
+#endif // HOT_PATH_H
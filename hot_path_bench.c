@@ -0,0 +1,149 @@
+/**
+ * @file      hot_path_bench.c
+ * @brief     Boot-time execution jitter benchmark implementation
+ */
+
+#include "hot_path_bench.h"
+#include "hot_path.h"
+#include <stdint.h>
+#include <string.h>
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "hardware/xip_cache.h"
+#include "can_handler.h"
+#include "can_bitstream.h"
+#include "decode_kernel.h"
+#include "ft550_decoder.h"
+#include "gps.h"
+#include "safe_print.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+
+#define SYSTICK_MASK    0x00FFFFFFu
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} bench_case_t;
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} bench_stats_t;
+
+static const uint8_t SHOCK_FRAME[8] = { 0x01, 0x2C, 0xFF, 0x38, 0x00, 0x64, 0x80, 0x01 };
+static const uint16_t M84_OFFSETS[] = { 6, 4, 12, 14, 48, 78 };
+
+static ft550_sensor_data_t g_scratch;
+static gps_data_t g_gps_scratch;
+static uint8_t g_block[128];
+static int32_t g_out[6];
+static can_bitstream_decoder_t g_decoder;
+static can_frame_t g_frame;
+
+static void run_noop(void) {
+}
+
+static void run_can_process_frame(void) {
+    (void)can_process_frame();
+}
+
+static void run_mcp2515_receive(void) {
+    uint32_t id;
+    uint8_t data[8];
+    (void)MCP2515_Dev_Receive_Fast(&MCP2515_DEV1, &id, data);
+}
+
+static void run_ft550_decode(void) {
+    (void)ft550_decode_frame(FT550_FRAME_SHOCK_SENSORS, SHOCK_FRAME, &g_scratch);
+}
+
+// The per-cycle snapshot copies (dash and LoRa each take both)
+static void run_can_snapshot(void) {
+    can_get_sensor_data_safe(&g_scratch);
+}
+
+static void run_gps_snapshot(void) {
+    gps_get_data_safe(&g_gps_scratch);
+}
+
+static void run_m84_gather(void) {
+    decode_kernel_gather(&g_block[8], M84_OFFSETS, g_out, 6);
+}
+
+static void run_bitstream_word(void) {
+    (void)can_bitstream_push_word(&g_decoder, 0x5A5A5A5Au, &g_frame);
+}
+
+static const bench_case_t CASES[] = {
+    { "call overhead",            run_noop },
+    { "can_process_frame (idle)", run_can_process_frame },
+    { "MCP2515 receive (empty)",  run_mcp2515_receive },
+    { "ft550_decode_frame",       run_ft550_decode },
+    { "M84 channel gather",       run_m84_gather },
+    { "CAN snapshot copy",        run_can_snapshot },
+    { "GPS snapshot copy",        run_gps_snapshot },
+    { "bitstream push_word",      run_bitstream_word },
+};
+
+static uint32_t time_once(void (*run)(void), bool cold) {
+    uint32_t irq = save_and_disable_interrupts();
+    if (cold) {
+        xip_cache_invalidate_all();
+    }
+    uint32_t start = systick_hw->cvr;
+    run();
+    uint32_t end = systick_hw->cvr;
+    restore_interrupts(irq);
+    return (start - end) & SYSTICK_MASK;    // Down-counter
+}
+
+static void measure(void (*run)(void), bool cold, bench_stats_t* stats) {
+    stats->min = UINT32_MAX;
+    stats->max = 0;
+    stats->sum = 0;
+    run();                                  // Warm the cache / first-call paths
+    for (int i = 0; i < HOT_PATH_BENCH_RUNS; i++) {
+        uint32_t cycles = time_once(run, cold);
+        if (cycles < stats->min) stats->min = cycles;
+        if (cycles > stats->max) stats->max = cycles;
+        stats->sum += cycles;
+    }
+}
+
+void hot_path_benchmark(void) {
+    for (size_t i = 0; i < sizeof(g_block); i++) {
+        g_block[i] = (uint8_t)(i * 29 + 7);
+    }
+    can_bitstream_decoder_init(&g_decoder);
+
+    // SysTick on the processor clock as a 24-bit cycle counter
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;                  // CLKSOURCE | ENABLE
+
+    safe_printf("[HOT] hot path %s, cycles over %d runs (min/mean/max)\n",
+#if HOT_PATH_IN_RAM
+                "in SRAM",
+#else
+                "in flash",
+#endif
+                HOT_PATH_BENCH_RUNS);
+    safe_printf("[HOT] %-26s %-20s %-20s\n", "case", "cold XIP cache", "warm");
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        if (CASES[i].run == run_mcp2515_receive && !can_bus_present(CAN_BUS_CHASSIS)) {
+            continue;
+        }
+        bench_stats_t cold, warm;
+        measure(CASES[i].run, true, &cold);
+        measure(CASES[i].run, false, &warm);
+        safe_printf("[HOT] %-26s %5lu/%5lu/%5lu    %5lu/%5lu/%5lu\n", CASES[i].name,
+                    (unsigned long)cold.min, (unsigned long)(cold.sum / HOT_PATH_BENCH_RUNS),
+                    (unsigned long)cold.max,
+                    (unsigned long)warm.min, (unsigned long)(warm.sum / HOT_PATH_BENCH_RUNS),
+                    (unsigned long)warm.max);
+    }
+
+    systick_hw->csr = 0;
+}
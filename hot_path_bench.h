@@ -0,0 +1,30 @@
+/**
+ * @file      hot_path_bench.h
+ * @brief     Boot-time execution jitter benchmark for the hot path
+ *
+ * Times representative ingest calls with the XIP cache invalidated before
+ * each run (cold: every flash-resident instruction misses) and with it warm.
+ * Code in SRAM shows the same figure in both columns; code left in flash
+ * pays the miss penalty on every cold run. Build once with
+ * FS26_HOT_PATH_IN_RAM=ON and once with OFF for the before/after numbers.
+ */
+
+#ifndef HOT_PATH_BENCH_H
+#define HOT_PATH_BENCH_H
+
+// Run hot_path_benchmark() at boot and print the result
+#ifndef HOT_PATH_BENCHMARK
+#define HOT_PATH_BENCHMARK 0
+#endif
+
+#define HOT_PATH_BENCH_RUNS 200     // Samples per case and cache state
+
+/**
+ * @brief Measure min/mean/max cycles of each case, cold and warm, and print them
+ *
+ * Uses SysTick as a cycle counter, so run it before the RTOS scheduler
+ * starts. Call after can_init(); may consume pending CAN frames.
+ */
+void hot_path_benchmark(void);
+
+#endif // HOT_PATH_BENCH_H
@@ -0,0 +1,140 @@
+/**
+ * @file      lap_timer.c
+ * @brief     GPS start/finish gate lap timing implementation
+ */
+
+#include "lap_timer.h"
+#include <math.h>
+#include <string.h>
+#include "hardware/sync.h"
+
+#define DEG_TO_RAD          0.017453293f
+#define METERS_PER_DEG_LAT  110540.0f
+#define METERS_PER_DEG_LON  111320.0f   // At the equator, scaled by cos(latitude)
+
+// Larger jumps between fixes are GPS glitches, not a crossing
+#define MAX_STEP_M          100.0f
+
+// Gate in the fix's fixed point; offsets are taken in integers so the
+// projection keeps the 1e-7 deg resolution
+#define GATE_LATITUDE_E7    ((int32_t)((double)LAP_GATE_LATITUDE * 1e7))
+#define GATE_LONGITUDE_E7   ((int32_t)((double)LAP_GATE_LONGITUDE * 1e7))
+
+// Core 0 state
+static bool g_have_prev = false;
+static int32_t g_prev_lat_e7 = 0;
+static int32_t g_prev_lon_e7 = 0;
+static float g_prev_along_m = 0.0f;
+static uint32_t g_prev_ms = 0;
+
+static bool g_lap_started = false;
+static uint32_t g_lap_start_ms = 0;
+static uint16_t g_lap_count = 0;
+static uint32_t g_best_lap_ms = 0;
+static uint16_t g_lap_max_rpm = 0;
+static float g_lap_max_speed = 0.0f;
+static void (*g_callback)(void) = NULL;
+
+// Shared with core 1, guarded by g_spin_lock
+static spin_lock_t* g_spin_lock;
+static lap_summary_t g_pending;
+static bool g_pending_valid = false;
+
+void lap_timer_init(void) {
+    g_have_prev = false;
+    g_lap_started = false;
+    g_lap_count = 0;
+    g_best_lap_ms = 0;
+    g_lap_max_rpm = 0;
+    g_lap_max_speed = 0.0f;
+    g_pending_valid = false;
+    if (!g_spin_lock) {
+        g_spin_lock = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+}
+
+void lap_timer_set_callback(void (*callback)(void)) {
+    g_callback = callback;
+}
+
+static void complete_lap(uint32_t crossing_ms) {
+    uint32_t lap_ms = crossing_ms - g_lap_start_ms;
+    g_lap_count++;
+    if (g_best_lap_ms == 0 || lap_ms < g_best_lap_ms) {
+        g_best_lap_ms = lap_ms;
+    }
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    g_pending.lap_number = g_lap_count;
+    g_pending.lap_time_ms = lap_ms;
+    g_pending.best_lap_ms = g_best_lap_ms;
+    g_pending.max_rpm = g_lap_max_rpm;
+    g_pending.max_speed_kph = g_lap_max_speed;
+    g_pending_valid = true;
+    spin_unlock(g_spin_lock, lock_owner);
+
+    if (g_callback) {
+        g_callback();
+    }
+}
+
+void lap_timer_update(const gps_data_t* gps, uint16_t rpm, uint32_t now_ms) {
+    if (LAP_GATE_LATITUDE == 0.0f || !gps->fix_valid) {
+        g_have_prev = false;
+        return;
+    }
+    if (g_have_prev && gps->latitude_e7 == g_prev_lat_e7 && gps->longitude_e7 == g_prev_lon_e7) {
+        return;
+    }
+
+    float speed_kph = gps->speed_x10 * 0.1f;
+    if (rpm > g_lap_max_rpm) g_lap_max_rpm = rpm;
+    if (speed_kph > g_lap_max_speed) g_lap_max_speed = speed_kph;
+
+    // Local flat projection around the gate, then rotate into the gate frame:
+    // along = distance past the line in the direction of travel, cross = offset along it
+    const float heading = LAP_GATE_HEADING_DEG * DEG_TO_RAD;
+    float east_m = (float)(gps->longitude_e7 - GATE_LONGITUDE_E7) * 1e-7f *
+                   METERS_PER_DEG_LON * cosf(LAP_GATE_LATITUDE * DEG_TO_RAD);
+    float north_m = (float)(gps->latitude_e7 - GATE_LATITUDE_E7) * 1e-7f * METERS_PER_DEG_LAT;
+    float along_m = east_m * sinf(heading) + north_m * cosf(heading);
+    float cross_m = east_m * cosf(heading) - north_m * sinf(heading);
+
+    if (g_have_prev && g_prev_along_m < 0.0f && along_m >= 0.0f &&
+        along_m - g_prev_along_m < MAX_STEP_M && fabsf(cross_m) <= LAP_GATE_HALF_WIDTH_M) {
+        // Interpolate the crossing between the two fixes
+        float fraction = -g_prev_along_m / (along_m - g_prev_along_m);
+        uint32_t crossing_ms = g_prev_ms + (uint32_t)((float)(now_ms - g_prev_ms) * fraction);
+
+        bool new_lap = !g_lap_started || crossing_ms - g_lap_start_ms >= LAP_MIN_LAP_MS;
+        if (new_lap) {
+            if (g_lap_started) {
+                complete_lap(crossing_ms);
+            }
+            g_lap_started = true;
+            g_lap_start_ms = crossing_ms;
+            g_lap_max_rpm = rpm;
+            g_lap_max_speed = speed_kph;
+        }
+    }
+
+    g_have_prev = true;
+    g_prev_lat_e7 = gps->latitude_e7;
+    g_prev_lon_e7 = gps->longitude_e7;
+    g_prev_along_m = along_m;
+    g_prev_ms = now_ms;
+}
+
+bool lap_timer_take_summary(lap_summary_t* summary) {
+    bool taken = false;
+
+    uint32_t lock_owner = spin_lock_blocking(g_spin_lock);
+    if (g_pending_valid) {
+        *summary = g_pending;
+        g_pending_valid = false;
+        taken = true;
+    }
+    spin_unlock(g_spin_lock, lock_owner);
+
+    return taken;
+}
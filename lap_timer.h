@@ -0,0 +1,79 @@
+/**
+ * @file      lap_timer.h
+ * @brief     GPS start/finish gate lap timing (core 0)
+ *
+ * The gate is a line through LAP_GATE_LATITUDE/LONGITUDE, perpendicular to
+ * the direction of travel LAP_GATE_HEADING_DEG, LAP_GATE_HALF_WIDTH_M wide on
+ * each side. A lap is completed when consecutive GPS fixes cross the line in
+ * the direction of travel; the crossing time is interpolated between the two
+ * fixes, so lap times are not quantised to the 5 Hz fix rate.
+ *
+ * Completed laps are handed to core 1 as a lap summary for the LoRa lap packet.
+ * Leave LAP_GATE_LATITUDE at 0 to disable lap timing.
+ */
+
+#ifndef LAP_TIMER_H
+#define LAP_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gps.h"
+
+#ifndef LAP_GATE_LATITUDE
+#define LAP_GATE_LATITUDE       0.0f    // deg, 0 = lap timing disabled
+#endif
+#ifndef LAP_GATE_LONGITUDE
+#define LAP_GATE_LONGITUDE      0.0f    // deg
+#endif
+#ifndef LAP_GATE_HEADING_DEG
+#define LAP_GATE_HEADING_DEG    0.0f    // Direction of travel across the line
+#endif
+#define LAP_GATE_HALF_WIDTH_M   15.0f   // Track half-width at the gate
+#define LAP_MIN_LAP_MS          20000   // Ignore re-crossings closer than this
+
+// SIO FIFO token used to wake core 1 for a lap packet
+#define LAP_DOORBELL            0x4C415031  // "LAP1"
+
+/**
+ * Summary of the last completed lap
+ */
+typedef struct {
+    uint16_t lap_number;            // 1 = first completed lap
+    uint32_t lap_time_ms;
+    uint32_t best_lap_ms;
+    uint16_t max_rpm;
+    float    max_speed_kph;
+} lap_summary_t;
+
+/**
+ * @brief Reset the lap counter and best lap. Call before GPS ingest starts.
+ */
+void lap_timer_init(void);
+
+/**
+ * @brief Register a callback run (on core 0) when a lap summary is pending
+ *
+ * @param callback Function to call, or NULL to disable
+ */
+void lap_timer_set_callback(void (*callback)(void));
+
+/**
+ * @brief Feed the latest GPS fix (core 0, after gps_process())
+ *
+ * Repeated calls with an unchanged position are ignored.
+ *
+ * @param gps Current GPS data
+ * @param rpm Current engine RPM (for the lap maximum)
+ * @param now_ms Board uptime in ms
+ */
+void lap_timer_update(const gps_data_t* gps, uint16_t rpm, uint32_t now_ms);
+
+/**
+ * @brief Take the pending lap summary, if any (core 1)
+ *
+ * @param summary Filled when a lap was completed since the last call
+ * @return true if a summary was taken
+ */
+bool lap_timer_take_summary(lap_summary_t* summary);
+
+#endif // LAP_TIMER_H
@@ -34,6 +34,7 @@
  */
 
 #include "lr1121_config.h"
+#include "radio_stats.h"
 
 lr1121_t lr1121;
 
@@ -90,8 +91,45 @@ void print_lora_configuration( void );
 void print_gfsk_configuration( void );
 
 // Initialize the LR1121 system
+// The LR1121 keeps its configuration and calibration while powered, and
+// its reset status reads CLEARED until it restarts. Reuse both when only
+// the MCU was reset (watchdog, brown-out of the Pico rail, reflash).
+static bool lora_system_is_warm( const void* context )
+{
+    lr11xx_system_stat1_t stat1;
+    lr11xx_system_stat2_t stat2;
+    lr11xx_system_irq_mask_t irq;
+    uint16_t errors;
+
+    if( lr11xx_system_get_status( context, &stat1, &stat2, &irq ) != LR11XX_STATUS_OK ||
+        lr11xx_system_get_errors( context, &errors ) != LR11XX_STATUS_OK )
+    {
+        return false;
+    }
+    const uint16_t calib_errors = LR11XX_SYSTEM_ERRORS_LF_RC_CALIB_MASK | LR11XX_SYSTEM_ERRORS_HF_RC_CALIB_MASK |
+                                  LR11XX_SYSTEM_ERRORS_ADC_CALIB_MASK | LR11XX_SYSTEM_ERRORS_PLL_CALIB_MASK |
+                                  LR11XX_SYSTEM_ERRORS_IMG_CALIB_MASK;
+    return stat2.reset_status == LR11XX_SYSTEM_RESET_STATUS_CLEARED &&
+           stat2.is_running_from_flash &&
+           ( errors & calib_errors ) == 0;
+}
+
 void lora_system_init( const void* context )
 {
+    lr11xx_hal_wakeup( ( void* ) context );   // Wake up the device
+
+    if( lora_system_is_warm( context ) )
+    {
+        // Stop whatever the radio was doing when the MCU went down; the
+        // calibration, TCXO, regulator, RF switch and LF clock settings are
+        // still in place, and lora_radio_init() reapplies the modem setup
+        lr11xx_system_set_standby( ( void* ) context, LR11XX_SYSTEM_STANDBY_CFG_XOSC );
+        lr11xx_system_clear_errors( context );
+        lr11xx_system_clear_irq_status( context, LR11XX_SYSTEM_IRQ_ALL_MASK );
+        printf( "LR1121 warm start, calibration kept\r\n" );
+        return;
+    }
+
     lr11xx_system_reset( ( void* ) context ); // Reset the LR1121 system
     lr11xx_hal_wakeup( ( void* ) context );   // Wake up the device
 
@@ -104,10 +142,6 @@ void lora_system_init( const void* context )
     
     // Set the LR1121 to standby mode using the external oscillator
     lr11xx_system_set_standby(( void* ) context, LR11XX_SYSTEM_STANDBY_CFG_XOSC);
-    // Calibrate the image for 2.4GHz band
-    lr11xx_system_calibrate_image_in_mhz(( void* ) context, 2400, 2500); // Calibrate for 2.4GHz band
-    // lr11xx_system_calibrate_image(( void* ) context,0x6B,0x6E); // Calibrate for 430~440MHz
-    // lr11xx_system_calibrate_image(( void* ) context,0xD7,0xDB); // Calibrate for 863~870MHz
     
     // Configure the regulator mode
     const lr11xx_system_reg_mode_t regulator = smtc_shield_lr11xx_common_get_reg_mode();
@@ -127,10 +161,16 @@ void lora_system_init( const void* context )
     lr11xx_system_clear_errors( context );
     // Calibrate the system
     lr11xx_system_calibrate( context, 0x3F );
+    // Then the image for the sub-GHz band used by LR-FHSS and diversity, with
+    // the TCXO running. Only the sub-GHz path has an image to calibrate (and
+    // 2400-2500 MHz does not fit the 4 MHz-step arguments).
+    lr11xx_system_calibrate_image_in_mhz(( void* ) context, SUB_GHZ_IMAGE_MIN_MHZ, SUB_GHZ_IMAGE_MAX_MHZ);
+    // lr11xx_system_calibrate_image(( void* ) context,0x6B,0x6E); // Calibrate for 430~440MHz
 
     uint16_t errors;
     // Retrieve system errors
     lr11xx_system_get_errors( context, &errors );
+    radio_stats_record_sys_errors( errors );
     if(errors & LR11XX_SYSTEM_ERRORS_IMG_CALIB_MASK)
     {
       printf("Image calibration error\r\n");
@@ -140,6 +180,9 @@ void lora_system_init( const void* context )
     
     // Clear all pending IRQ status bits
     lr11xx_system_clear_irq_status( context, LR11XX_SYSTEM_IRQ_ALL_MASK );
+
+    // Reads CLEARED from now until the radio itself restarts
+    lr11xx_system_clear_reset_status_info( context );
 }
 
 // Initialize the LR1121 radio module
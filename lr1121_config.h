@@ -49,7 +49,7 @@
 #define PA_RAMP_TIME LR11XX_RADIO_RAMP_48_US
 #define FALLBACK_MODE LR11XX_RADIO_FALLBACK_STDBY_RC
 #define ENABLE_RX_BOOST_MODE false
-#define PAYLOAD_LENGTH 68  // Increased from 32 to accommodate combined telemetry packet (~68 bytes)
+#define PAYLOAD_LENGTH 64  // Largest frame: TELEMETRY_MAX_PACKET_SIZE (48) + auth overhead (12); frames are sent at their own length
 
 /*! 
  * @brief Modulation parameters for LoRa packets
@@ -149,6 +149,39 @@ static const uint8_t gfsk_sync_word[8] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0
 #define FSK_BROADCAST_ADDRESS 0xAB
 #endif
 
+/*!
+ * @brief LR-FHSS "essentials" link (sub-GHz, sent by lr_fhss_send())
+ */
+#define LR_FHSS_RF_FREQ_IN_HZ 869525000UL  // EU868 869.4-869.65 MHz sub-band, 10% duty cycle
+#define LR_FHSS_TX_OUTPUT_POWER_DBM 14
+#define LR_FHSS_CODING_RATE LR_FHSS_V1_CR_2_3
+#define LR_FHSS_BANDWIDTH LR_FHSS_V1_BW_136719_HZ
+#define LR_FHSS_GRID LR_FHSS_V1_GRID_3906_HZ
+#define LR_FHSS_HEADER_COUNT 2
+#define LR_FHSS_MAX_PAYLOAD_LENGTH 48
+
+/*!
+ * @brief Dual-band diversity: sub-GHz LoRa copies of critical frames (div_mode in config_store.h)
+ */
+#define DIV_OFF 0
+#define DIV_ALTERNATE 1  // Critical frames take turns between 2.4 GHz and sub-GHz
+#define DIV_DUPLICATE 2  // Critical frames go out on both bands
+#define DIV_RF_FREQ_IN_HZ 869525000UL  // Same sub-band as LR-FHSS
+#define DIV_TX_OUTPUT_POWER_DBM 14
+#define DIV_LORA_SPREADING_FACTOR LR11XX_RADIO_LORA_SF9
+#define DIV_LORA_BANDWIDTH LR11XX_RADIO_LORA_BW_125
+
+/*!
+ * @brief Sub-GHz band shared by LR-FHSS and diversity (duty_cycle.h)
+ */
+#define SUB_GHZ_DUTY_CYCLE_PERCENT 10  // Share of every hour on air, all sub-GHz frames together
+#define SUB_GHZ_BAND_MIN_KHZ 869400    // EU868 sub-band g3, the only one that allows that share
+#define SUB_GHZ_BAND_MAX_KHZ 869650
+#define DIV_FREQ_MIN_KHZ (SUB_GHZ_BAND_MIN_KHZ + 63)  // div_freq_khz: the whole 125 kHz channel inside g3
+#define DIV_FREQ_MAX_KHZ (SUB_GHZ_BAND_MAX_KHZ - 63)
+#define SUB_GHZ_IMAGE_MIN_MHZ 863      // Image calibration range (lora_system_init)
+#define SUB_GHZ_IMAGE_MAX_MHZ 870
+
 /*!
  * @brief Sigfox radio configuration
  */
@@ -0,0 +1,141 @@
+/*!
+ * @file      lr1121_rx.c
+ *
+ * @brief     LoRa continuous receive for the trackside repeater
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2022. All rights reserved.
+ * Modified for the FS26 repeater.
+ */
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+#include <stdio.h>
+#include "lr1121_rx.h"
+#include "lr1121_tx.h"
+#include "gpio.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE CONSTANTS -------------------------------------------------------
+ */
+#define RX_IRQ_MASK (LR11XX_SYSTEM_IRQ_TX_DONE | LR11XX_SYSTEM_IRQ_TIMEOUT | LR11XX_SYSTEM_IRQ_RX_DONE | \
+                     LR11XX_SYSTEM_IRQ_CRC_ERROR | LR11XX_SYSTEM_IRQ_HEADER_ERROR)
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE VARIABLES -------------------------------------------------------
+ */
+static lora_rx_stats_t rx_stats = {0};
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS --------------------------------------------------------
+ */
+
+/**
+ * @brief Enter continuous RX on a channel with the live radio profile
+ */
+void lora_rx_start(uint32_t freq_khz)
+{
+    // Straight from a forwarded frame's standby XOSC fallback, or a full TCXO start
+    if (!lora_xosc_running()) {
+        lr11xx_system_set_standby(&lr1121, LR11XX_SYSTEM_STANDBY_CFG_RC);
+
+        // TCXO may have stopped in standby, as in lora_send()
+        lr11xx_system_set_tcxo_mode(&lr1121, LR11XX_SYSTEM_TCXO_CTRL_3_0V, 500);
+        sleep_ms(5);
+        lr11xx_system_clear_errors(&lr1121);
+    }
+
+    lr11xx_system_set_dio_irq_params(&lr1121, RX_IRQ_MASK, 0);
+    lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK);
+
+    // Explicit header: the length is the largest frame accepted
+    lora_apply_profile(freq_khz, PAYLOAD_LENGTH);
+
+    if (lr11xx_radio_set_rx_with_timeout_in_rtc_step(&lr1121, RX_CONTINUOUS) != LR11XX_STATUS_OK) {
+        printf("[DBG] RX: set_rx failed\n");
+        rx_stats.spi_errors++;
+    }
+}
+
+/**
+ * @brief Move continuous RX to another channel
+ */
+void lora_rx_retune(uint32_t freq_khz)
+{
+    lr11xx_system_set_standby(&lr1121, LR11XX_SYSTEM_STANDBY_CFG_XOSC);
+    lora_set_freq(freq_khz);
+    if (lr11xx_radio_set_rx_with_timeout_in_rtc_step(&lr1121, RX_CONTINUOUS) != LR11XX_STATUS_OK) {
+        printf("[DBG] RX: set_rx failed\n");
+        rx_stats.spi_errors++;
+    }
+}
+
+/**
+ * @brief Leave RX for standby, keeping the TCXO running for the next TX
+ */
+void lora_rx_stop(void)
+{
+    lr11xx_system_set_standby(&lr1121, LR11XX_SYSTEM_STANDBY_CFG_XOSC);
+    lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK);
+}
+
+/**
+ * @brief Whether the radio has raised an interrupt (DIO high)
+ */
+bool lora_rx_pending(void)
+{
+    return DEV_Digital_Read(lr1121.irq) != 0;
+}
+
+/**
+ * @brief Fetch a received frame, if any (non-blocking)
+ */
+bool lora_rx_poll(uint8_t* data, uint8_t* length, int8_t* rssi_dbm, int8_t* snr_db)
+{
+    lr11xx_system_irq_mask_t irq = 0;
+    if (lr11xx_system_get_and_clear_irq_status(&lr1121, &irq) != LR11XX_STATUS_OK) {
+        rx_stats.spi_errors++;
+        return false;
+    }
+    if (irq & LR11XX_SYSTEM_IRQ_HEADER_ERROR) {
+        rx_stats.header_errors++;
+        return false;
+    }
+    if (irq & LR11XX_SYSTEM_IRQ_CRC_ERROR) {
+        rx_stats.crc_errors++;
+        return false;
+    }
+    if (!(irq & LR11XX_SYSTEM_IRQ_RX_DONE)) {
+        return false;
+    }
+
+    lr11xx_radio_rx_buffer_status_t buffer;
+    lr11xx_radio_pkt_status_lora_t pkt;
+    if (lr11xx_radio_get_rx_buffer_status(&lr1121, &buffer) != LR11XX_STATUS_OK ||
+        buffer.pld_len_in_bytes == 0 || buffer.pld_len_in_bytes > PAYLOAD_LENGTH ||
+        lr11xx_regmem_read_buffer8(&lr1121, data, buffer.buffer_start_pointer,
+                                   buffer.pld_len_in_bytes) != LR11XX_STATUS_OK ||
+        lr11xx_radio_get_lora_pkt_status(&lr1121, &pkt) != LR11XX_STATUS_OK) {
+        rx_stats.spi_errors++;
+        return false;
+    }
+
+    *length = buffer.pld_len_in_bytes;
+    *rssi_dbm = pkt.rssi_pkt_in_dbm;
+    *snr_db = pkt.snr_pkt_in_db;
+    rx_stats.packets++;
+    return true;
+}
+
+/**
+ * @brief Get a copy of the receive counters
+ */
+void lora_rx_get_stats(lora_rx_stats_t* out)
+{
+    *out = rx_stats;
+}
@@ -0,0 +1,95 @@
+/*!
+ * @file      lr1121_rx.h
+ *
+ * @brief     LoRa continuous receive for the trackside repeater
+ *
+ * The Clear BSD License
+ * Copyright Semtech Corporation 2022. All rights reserved.
+ * Modified for the FS26 repeater.
+ */
+
+#ifndef LR1121_RX_H
+#define LR1121_RX_H
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- DEPENDENCIES ------------------------------------------------------------
+ */
+#include "lr1121_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC TYPES ------------------------------------------------------------
+ */
+
+/**
+ * Receive counters
+ */
+typedef struct {
+    uint32_t packets;               // RX_DONE with a valid length
+    uint32_t crc_errors;
+    uint32_t header_errors;
+    uint32_t spi_errors;            // IRQ, buffer status or buffer read failed
+} lora_rx_stats_t;
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
+ */
+
+/**
+ * @brief Enter continuous RX on a channel with the live radio profile
+ * 
+ * Call after lora_tx_init(), after every lora_send() (the radio falls back
+ * to standby XOSC, so no TCXO start-up wait) and when the configuration
+ * changes. Enables the RX_DONE, CRC_ERROR and HEADER_ERROR interrupts on DIO
+ * next to TX_DONE and TIMEOUT.
+ * 
+ * @param freq_khz RF frequency in kHz
+ */
+void lora_rx_start(uint32_t freq_khz);
+
+/**
+ * @brief Move continuous RX to another channel, e.g. to follow a hop
+ * 
+ * Keeps the oscillator running, so it is much quicker than lora_rx_start().
+ * 
+ * @param freq_khz RF frequency in kHz
+ */
+void lora_rx_retune(uint32_t freq_khz);
+
+/**
+ * @brief Leave RX for standby XOSC, e.g. before lora_send()
+ */
+void lora_rx_stop(void);
+
+/**
+ * @brief Whether the radio has raised an interrupt (DIO high)
+ */
+bool lora_rx_pending(void);
+
+/**
+ * @brief Fetch a received frame, if any (non-blocking)
+ * 
+ * Reads and clears the IRQ status. The radio stays in RX.
+ * 
+ * @param data Buffer of at least PAYLOAD_LENGTH bytes
+ * @param length Frame length, filled in
+ * @param rssi_dbm Packet RSSI, filled in
+ * @param snr_db Packet SNR, filled in
+ * @return true if a frame with a valid CRC was read
+ */
+bool lora_rx_poll(uint8_t* data, uint8_t* length, int8_t* rssi_dbm, int8_t* snr_db);
+
+/**
+ * @brief Get a copy of the receive counters
+ * 
+ * @param stats Structure to fill
+ */
+void lora_rx_get_stats(lora_rx_stats_t* stats);
+
+#endif // LR1121_RX_H
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -16,15 +16,54 @@
 #include <string.h>
 #include <stdlib.h>
 #include "lr1121_tx.h"
+#include "radio_stats.h"
 #include "safe_print.h"
+#include "config_store.h"
+#include "channel_hop.h"
+#include "duty_cycle.h"
 #include "gpio.h"
+#include "pico/rand.h"
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PRIVATE CONSTANTS -------------------------------------------------------
+ */
+
+// Beyond the radio's own TX timeout before the MCU gives up on the DIO line
+#define TX_BACKSTOP_MS      100
 
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE VARIABLES -------------------------------------------------------
  */
-static volatile bool tx_done_flag = false;
+static volatile bool tx_done_flag = false;   // DIO raised: TX_DONE or TIMEOUT
+static volatile uint32_t tx_done_us = 0;
+static uint32_t tx_start_us = 0;
 static uint32_t tx_count = 0;
+static radio_airtime_t airtime = {0};
+static duty_cycle_t sub_ghz_duty;          // LR-FHSS and diversity frames share the sub-band
+static uint32_t critical_count = 0;        // lora_send_critical() calls, for DIV_ALTERNATE
+static uint32_t pa_config_generation = 0;  // config_generation() the PA was last set for
+static uint32_t pa_freq_in_hz = 0;         // ...and a frequency in the band it was set for
+static uint32_t rf_freq_in_hz = 0;         // Last lr11xx_radio_set_rf_freq()
+
+static hop_plan_t hop_plan;
+static uint32_t hop_generation = 0;        // config_generation() hop_plan was built for
+
+static const uint8_t lr_fhss_sync_word[LR_FHSS_SYNC_WORD_BYTES] = { 0x2C, 0x0F, 0x79, 0x95 };
+
+static const lr11xx_lr_fhss_params_t lr_fhss_params = {
+    .lr_fhss_params = {
+        .sync_word       = lr_fhss_sync_word,
+        .modulation_type = LR_FHSS_V1_MODULATION_TYPE_GMSK_488,
+        .cr              = LR_FHSS_CODING_RATE,
+        .grid            = LR_FHSS_GRID,
+        .bw              = LR_FHSS_BANDWIDTH,
+        .enable_hopping  = true,
+        .header_count    = LR_FHSS_HEADER_COUNT,
+    },
+    .device_offset = 0,
+};
 
 /*
  * -----------------------------------------------------------------------------
@@ -32,51 +71,207 @@ static uint32_t tx_count = 0;
  */
 
 static void isr(uint gpio, uint32_t events) {
+    tx_done_us = time_us_32();
     tx_done_flag = true;
 }
 
-/*
- * -----------------------------------------------------------------------------
- * --- PUBLIC FUNCTIONS --------------------------------------------------------
+/**
+ * @brief Read the chip error flags into radio_stats, then clear them
  */
+static void collect_sys_errors(void)
+{
+    uint16_t sys_errors = 0;
+    if (lr11xx_system_get_errors(&lr1121, &sys_errors) == LR11XX_STATUS_OK) {
+        radio_stats_record_sys_errors(sys_errors);
+    }
+    lr11xx_system_clear_errors(&lr1121);
+}
 
 /**
- * @brief Initialize the LR1121 radio for TX-only operation
+ * @brief Start the transmission and note the start time for the ToA measurement
+ * 
+ * The radio's own timer aborts the frame after timeout_ms and raises TIMEOUT.
  */
-void lora_tx_init(void)
+static bool start_tx(uint32_t timeout_ms)
 {
-    safe_printf("[LORA] Initializing LR1121 for TX...\n");
-    
-    lora_init_io_context(&lr1121);
-    lora_init_io(&lr1121);
-    lora_spi_init(&lr1121);
+    tx_start_us = time_us_32();
+    return lr11xx_radio_set_tx_with_timeout_in_rtc_step(&lr1121,
+               lr11xx_radio_convert_time_in_ms_to_rtc_step(timeout_ms)) == LR11XX_STATUS_OK;
+}
 
-    safe_printf("[LORA] LR11XX driver version: %s\n", lr11xx_driver_version_get_version_string());
+/**
+ * @brief Measured time from start_tx() to TX_DONE of the last frame
+ */
+static uint32_t measured_toa_ms(void)
+{
+    return (tx_done_us - tx_start_us) / 1000;
+}
 
-    lora_system_init(&lr1121);
-    lora_print_version(&lr1121);
-    lora_radio_init(&lr1121);
-    
-    lora_init_irq(&lr1121, &isr);
+/**
+ * @brief Wait for the TX_DONE or TIMEOUT interrupt, then read and clear the IRQs
+ * 
+ * The radio ends a stuck frame itself (start_tx()), so the MCU does not poll
+ * it. The backstop only covers a radio that never raises DIO (reset, SPI lost).
+ * 
+ * @param toa_ms Expected time on air
+ */
+static radio_tx_result_t wait_tx_irq(uint32_t toa_ms)
+{
+    absolute_time_t backstop = make_timeout_time_ms(toa_ms + LORA_TX_TIMEOUT_MARGIN_MS + TX_BACKSTOP_MS);
+#if LORA_TX_WAIT_WFE
+    // The DIO interrupt wakes the core
+    while (!tx_done_flag && !time_reached(backstop)) {
+        best_effort_wfe_or_timeout(backstop);
+    }
+#else
+    // The FreeRTOS time interop makes these task delays, which the DIO
+    // interrupt does not end early: sleep through the frame, then by ticks
+    sleep_ms(toa_ms);
+    while (!tx_done_flag && !time_reached(backstop)) {
+        sleep_ms(1);
+    }
+#endif
 
-    // Only enable TX_DONE interrupt
-    ASSERT_LR11XX_RC(lr11xx_system_set_dio_irq_params(&lr1121, LR11XX_SYSTEM_IRQ_TX_DONE, 0));
-    ASSERT_LR11XX_RC(lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK));
+    lr11xx_system_irq_mask_t irq = 0;
+    if (lr11xx_system_get_and_clear_irq_status(&lr1121, &irq) != LR11XX_STATUS_OK) {
+        return RADIO_TX_SPI_ERROR;
+    }
+    if (irq & LR11XX_SYSTEM_IRQ_TX_DONE) {
+        if (!tx_done_flag) {
+            tx_done_us = time_us_32();      // Edge missed: only the backstop ended the wait
+        }
+        return RADIO_TX_OK;
+    }
 
-    safe_printf("[LORA] TX initialization complete\n");
+    printf("[DBG] TX %s after %lums: irq=0x%08lX\n", (irq & LR11XX_SYSTEM_IRQ_TIMEOUT) ? "timeout" : "no IRQ",
+           (unsigned long)((time_us_32() - tx_start_us) / 1000), (unsigned long)irq);
+    collect_sys_errors();
+    if (!(irq & LR11XX_SYSTEM_IRQ_TIMEOUT)) {
+        lr11xx_system_set_standby(&lr1121, LR11XX_SYSTEM_STANDBY_CFG_RC);
+    }
+    return RADIO_TX_TIMEOUT;
 }
 
 /**
- * @brief Send data over LoRa (blocking until TX complete)
+ * @brief Retune only if the frequency changed since the last call
+ */
+static void set_rf_freq(uint32_t freq_in_hz)
+{
+    if (freq_in_hz != rf_freq_in_hz &&
+        lr11xx_radio_set_rf_freq(&lr1121, freq_in_hz) == LR11XX_STATUS_OK) {
+        rf_freq_in_hz = freq_in_hz;
+    }
+}
+
+/**
+ * @brief Whether two frequencies share a PA setting (2.4 GHz or sub-GHz)
+ */
+static bool same_band(uint32_t a_in_hz, uint32_t b_in_hz)
+{
+    return (a_in_hz >= 1500000000u) == (b_in_hz >= 1500000000u);
+}
+
+/**
+ * @brief Channel of a LoRa frame: its hop when hopping, else lora_freq_khz
+ */
+static uint32_t frame_freq_khz(const uint8_t* data, uint8_t length)
+{
+    const daq_config_t* cfg = config_get();
+    if (hop_generation != config_generation()) {
+        hop_generation = config_generation();
+        hop_plan_init(&hop_plan, cfg->hop_base_khz, cfg->hop_spacing_khz, cfg->hop_channels,
+                      cfg->hop_blacklist, HOP_SEED);
+    }
+
+    uint32_t counter, mask;
+    if (!hop_enabled(&hop_plan) || !hop_frame_counter(data, length, &counter, &mask)) {
+        return cfg->lora_freq_khz;
+    }
+    return hop_channel_khz(&hop_plan, hop_channel(&hop_plan, counter));
+}
+
+/**
+ * @brief Point the PA at the given band and output power
+ */
+static bool apply_pa_config(uint32_t freq_in_hz, int8_t power_dbm)
+{
+    const smtc_shield_lr11xx_pa_pwr_cfg_t* pa_pwr_cfg =
+        smtc_shield_lr1121mb1gis_get_pa_pwr_cfg(freq_in_hz, power_dbm);
+    if (pa_pwr_cfg == NULL) {
+        return false;
+    }
+    lr11xx_radio_set_pa_cfg(&lr1121, &(pa_pwr_cfg->pa_config));
+    lr11xx_radio_set_tx_params(&lr1121, pa_pwr_cfg->power, PA_RAMP_TIME);
+    return true;
+}
+
+/**
+ * @brief LoRa bandwidth for the configured lora_bw_khz (200, 400 or 800)
+ */
+static lr11xx_radio_lora_bw_t lora_bandwidth(uint16_t bw_khz)
+{
+    return bw_khz == 200 ? LR11XX_RADIO_LORA_BW_200 :
+           bw_khz == 400 ? LR11XX_RADIO_LORA_BW_400 : LR11XX_RADIO_LORA_BW_800;
+}
+
+/**
+ * @brief LoRa modulation with the low data rate optimisation it needs
+ */
+static lr11xx_radio_mod_params_lora_t lora_mod_params_for(uint8_t sf, lr11xx_radio_lora_bw_t bw, uint8_t cr)
+{
+    lr11xx_radio_mod_params_lora_t mod_params = {
+        .sf   = (lr11xx_radio_lora_sf_t)sf,
+        .bw   = bw,
+        .cr   = (lr11xx_radio_lora_cr_t)cr,
+        .ldro = 0
+    };
+    mod_params.ldro = smtc_shield_lr11xx_common_compute_lora_ldro(mod_params.sf, mod_params.bw);
+    return mod_params;
+}
+
+/**
+ * @brief LoRa modulation for the configured SF, bandwidth and coding rate
+ */
+static lr11xx_radio_mod_params_lora_t lora_mod_params(const daq_config_t* cfg)
+{
+    return lora_mod_params_for(cfg->lora_sf, lora_bandwidth(cfg->lora_bw_khz), cfg->lora_cr);
+}
+
+/**
+ * @brief Sub-GHz LoRa modulation of the diversity copies (div_sf, 125 kHz)
+ */
+static lr11xx_radio_mod_params_lora_t div_mod_params(const daq_config_t* cfg)
+{
+    return lora_mod_params_for(cfg->div_sf, DIV_LORA_BANDWIDTH, cfg->lora_cr);
+}
+
+/**
+ * @brief LoRa packet parameters (explicit header) for a frame of length bytes
+ */
+static lr11xx_radio_pkt_params_lora_t lora_pkt_params(uint8_t length)
+{
+    lr11xx_radio_pkt_params_lora_t pkt_params = {
+        .preamble_len_in_symb = LORA_PREAMBLE_LENGTH,
+        .header_type          = LORA_PKT_LEN_MODE,
+        .pld_len_in_bytes     = length,
+        .crc                  = LORA_CRC,
+        .iq                   = LORA_IQ,
+    };
+    return pkt_params;
+}
+
+/**
+ * @brief Send one LoRa frame with the given channel, power and modulation
  * 
- * @param data Pointer to data buffer to send
- * @param length Length of data in bytes (max PAYLOAD_LENGTH)
- * @return true if TX completed successfully, false on error
+ * @param generation Generation of the caller's config_copy()
  */
-bool lora_send(const uint8_t* data, uint8_t length)
+static bool send_lora(uint32_t freq_khz, int8_t power_dbm, const lr11xx_radio_mod_params_lora_t* mod_params,
+                      uint32_t toa_ms, radio_link_t link, uint32_t generation,
+                      const uint8_t* data, uint8_t length)
 {
-    if (length > PAYLOAD_LENGTH) {
-        printf("[DBG] TX: payload too large (%u > %u)\n", length, PAYLOAD_LENGTH);
+    if (length > config_get()->lora_max_payload) {
+        printf("[DBG] TX: payload too large (%u > %u)\n", length, config_get()->lora_max_payload);
+        radio_stats_record_tx(link, RADIO_TX_BAD_LENGTH, 0, 0);
         return false;
     }
 
@@ -88,48 +283,47 @@ bool lora_send(const uint8_t* data, uint8_t length)
     lr11xx_system_clear_errors(&lr1121);
     lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK);
     
-    // Re-enable TCXO with longer timeout (500 * 30.52µs = ~15ms)
-    // This is needed because TCXO may have stopped in standby
-    lr11xx_system_set_tcxo_mode(&lr1121, LR11XX_SYSTEM_TCXO_CTRL_3_0V, 500);
-    
-    // Wait for TCXO to stabilize
-    sleep_ms(5);
-    
-    // Clear errors that may have been set during TCXO startup
-    lr11xx_system_clear_errors(&lr1121);
+    // After a frame the radio falls back to standby XOSC with the TCXO running
+    if (!lora_xosc_running()) {
+        // Re-enable TCXO with longer timeout (500 * 30.52µs = ~15ms)
+        // This is needed because TCXO may have stopped in standby
+        lr11xx_system_set_tcxo_mode(&lr1121, LR11XX_SYSTEM_TCXO_CTRL_3_0V, 500);
+        
+        // Wait for TCXO to stabilize
+        sleep_ms(5);
+        
+        // Record and clear errors set during TCXO startup (HF_XOSC_START etc.)
+        collect_sys_errors();
+    }
     
     // Set packet type (required before TX after fallback to standby)
     lr11xx_radio_set_pkt_type(&lr1121, PACKET_TYPE);
     
-    // Set RF frequency
-    lr11xx_radio_set_rf_freq(&lr1121, RF_FREQ_IN_HZ);
+    // Set RF frequency (hops within the band keep the PA setting)
+    uint32_t freq_in_hz = freq_khz * 1000u;
+    set_rf_freq(freq_in_hz);
+
+    // Output power or band changed since the last packet
+    if (generation != pa_config_generation || !same_band(freq_in_hz, pa_freq_in_hz)) {
+        if (!apply_pa_config(freq_in_hz, power_dbm)) {
+            printf("[DBG] TX: no PA setting for %d dBm at %lu Hz\n", power_dbm, (unsigned long)freq_in_hz);
+        }
+        pa_config_generation = generation;
+        pa_freq_in_hz = freq_in_hz;
+    }
     
     // Re-apply LoRa modulation params
-    lr11xx_radio_mod_params_lora_t mod_params = {
-        .sf   = LORA_SPREADING_FACTOR,
-        .bw   = LORA_BANDWIDTH,
-        .cr   = LORA_CODING_RATE,
-        .ldro = 0
-    };
-    lr11xx_radio_set_lora_mod_params(&lr1121, &mod_params);
+    lr11xx_radio_set_lora_mod_params(&lr1121, mod_params);
     
-    // Re-apply LoRa packet params
-    lr11xx_radio_pkt_params_lora_t pkt_params = {
-        .preamble_len_in_symb = LORA_PREAMBLE_LENGTH,
-        .header_type          = LORA_PKT_LEN_MODE,
-        .pld_len_in_bytes     = PAYLOAD_LENGTH,
-        .crc                  = LORA_CRC,
-        .iq                   = LORA_IQ,
-    };
+    // Re-apply LoRa packet params (explicit header, sized to this frame)
+    lr11xx_radio_pkt_params_lora_t pkt_params = lora_pkt_params(length);
     lr11xx_radio_set_lora_pkt_params(&lr1121, &pkt_params);
 
-    // Write data to radio buffer (pad to PAYLOAD_LENGTH)
-    uint8_t tx_buffer[PAYLOAD_LENGTH] = {0};
-    memcpy(tx_buffer, data, length);
-    
-    lr11xx_status_t rc = lr11xx_regmem_write_buffer8(&lr1121, tx_buffer, PAYLOAD_LENGTH);
+    // Write data to radio buffer
+    lr11xx_status_t rc = lr11xx_regmem_write_buffer8(&lr1121, data, length);
     if (rc != LR11XX_STATUS_OK) {
         printf("[DBG] write_buffer failed: %d\n", rc);
+        radio_stats_record_tx(link, RADIO_TX_SPI_ERROR, 0, 0);
         return false;
     }
     
@@ -138,63 +332,265 @@ bool lora_send(const uint8_t* data, uint8_t length)
     lr11xx_system_get_errors(&lr1121, &sys_errors);
     if (sys_errors != 0) {
         printf("[DBG] Pre-TX SysErr: 0x%04X\n", sys_errors);
+        radio_stats_record_sys_errors(sys_errors);
         lr11xx_system_clear_errors(&lr1121);
     }
     
-    // Get radio status before TX
-    lr11xx_system_irq_mask_t irq_status_before;
-    lr11xx_system_get_status(&lr1121, NULL, NULL, &irq_status_before);
-    printf("[DBG] Radio status before TX: irq=0x%08lX\n", (unsigned long)irq_status_before);
-    
     // Start transmission
-    rc = lr11xx_radio_set_tx(&lr1121, 0);
-    if (rc != LR11XX_STATUS_OK) {
-        printf("[DBG] set_tx failed: %d\n", rc);
+    if (!start_tx(toa_ms + LORA_TX_TIMEOUT_MARGIN_MS)) {
+        printf("[DBG] set_tx failed\n");
+        radio_stats_record_tx(link, RADIO_TX_SPI_ERROR, 0, 0);
         return false;
     }
-    printf("[DBG] TX: Radio set to TX mode\n");
+
+    // Sleep until the radio reports TX_DONE or its own timeout
+    radio_tx_result_t result = wait_tx_irq(toa_ms);
+    if (result != RADIO_TX_OK) {
+        radio_stats_record_tx(link, result, 0, 0);
+        return false;
+    }
+    printf("[DBG] TX #%lu: TX complete!\n", tx_count);
     
-    // Check radio status immediately after set_tx
-    sleep_ms(10);
-    lr11xx_system_irq_mask_t irq_status_after;
-    lr11xx_system_get_status(&lr1121, NULL, NULL, &irq_status_after);
-    printf("[DBG] Radio status after set_tx: irq=0x%08lX\n", (unsigned long)irq_status_after);
-
-    // Wait for TX to complete (polling with timeout)
-    uint32_t timeout_ms = 2000;
-    uint32_t start = to_ms_since_boot(get_absolute_time());
-    uint32_t poll_count = 0;
+    radio_stats_record_tx(link, RADIO_TX_OK, measured_toa_ms(), toa_ms);
+    return true;
+}
+
+/**
+ * @brief Send a sub-GHz LoRa copy of a critical frame, within the hourly budget
+ */
+static bool send_div(const uint8_t* data, uint8_t length)
+{
+    // A copy: a commit during the TX wait may rewrite the bank config_get() returns
+    daq_config_t cfg;
+    uint32_t generation = config_copy(&cfg);
+    lr11xx_radio_mod_params_lora_t mod_params = div_mod_params(&cfg);
+    lr11xx_radio_pkt_params_lora_t pkt_params = lora_pkt_params(length);
+    uint32_t toa_ms = lr11xx_radio_get_lora_time_on_air_in_ms(&pkt_params, &mod_params);
+
+    // Charged even if the frame then fails: the budget must never be exceeded
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (!duty_cycle_allows(&sub_ghz_duty, now_ms, toa_ms)) {
+        airtime.div_deferred++;
+        radio_stats_record_tx(RADIO_LINK_LORA_SUB_GHZ, RADIO_TX_DEFERRED, 0, 0);
+        return false;
+    }
+    duty_cycle_spend(&sub_ghz_duty, now_ms, toa_ms);
+
+    if (!send_lora(cfg.div_freq_khz, DIV_TX_OUTPUT_POWER_DBM, &mod_params, toa_ms, RADIO_LINK_LORA_SUB_GHZ,
+                   generation, data, length)) {
+        return false;
+    }
+    airtime.div_packets++;
+    airtime.div_airtime_ms += toa_ms;
+    return true;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC FUNCTIONS --------------------------------------------------------
+ */
+
+/**
+ * @brief Initialize the LR1121 radio for TX-only operation
+ */
+void lora_tx_init(void)
+{
+    safe_printf("[LORA] Initializing LR1121 for TX...\n");
     
-    while (!tx_done_flag) {
-        lr11xx_system_irq_mask_t irq_status;
-        lr11xx_system_get_irq_status(&lr1121, &irq_status);
-        poll_count++;
-        
-        if (irq_status & LR11XX_SYSTEM_IRQ_TX_DONE) {
-            printf("[DBG] TX: TX_DONE IRQ detected after %lu polls\n", poll_count);
-            tx_done_flag = true;
-            break;
-        }
-        
-        uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - start;
-        if (elapsed > timeout_ms) {
-            printf("[DBG] TX timeout after %lums (%lu polls): irq_status=0x%08lX\n", 
-                   elapsed, poll_count, (unsigned long)irq_status);
-            lr11xx_system_clear_errors(&lr1121);
-            lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK);
-            return false;
+    lora_init_io_context(&lr1121);
+    lora_init_io(&lr1121);
+    lora_spi_init(&lr1121);
+
+    safe_printf("[LORA] LR11XX driver version: %s\n", lr11xx_driver_version_get_version_string());
+
+    lora_system_init(&lr1121);
+    lora_print_version(&lr1121);
+    lora_radio_init(&lr1121);
+    
+    lora_init_irq(&lr1121, &isr);
+    duty_cycle_init(&sub_ghz_duty, SUB_GHZ_DUTY_CYCLE_PERCENT);
+
+    // DIO only for the end of a frame: sent, or stopped by the radio's TX timeout
+    ASSERT_LR11XX_RC(lr11xx_system_set_dio_irq_params(&lr1121, LR11XX_SYSTEM_IRQ_TX_DONE | LR11XX_SYSTEM_IRQ_TIMEOUT, 0));
+    ASSERT_LR11XX_RC(lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK));
+
+    // Keep the TCXO running between frames instead of falling back to standby RC
+    ASSERT_LR11XX_RC(lr11xx_radio_set_rx_tx_fallback_mode(&lr1121, LR11XX_RADIO_FALLBACK_STDBY_XOSC));
+
+    safe_printf("[LORA] TX initialization complete\n");
+}
+
+/**
+ * @brief Send data over LoRa (blocking until TX complete)
+ * 
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max lora_max_payload, at most PAYLOAD_LENGTH)
+ * @return true if TX completed successfully, false on error
+ */
+bool lora_send(const uint8_t* data, uint8_t length)
+{
+    return lora_send_on(frame_freq_khz(data, length), data, length);
+}
+
+/**
+ * @brief Send data over LoRa on another 2.4 GHz channel (blocking until TX complete)
+ * 
+ * @param freq_khz RF frequency in kHz
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max lora_max_payload)
+ * @return true if TX completed successfully, false on error
+ */
+bool lora_send_on(uint32_t freq_khz, const uint8_t* data, uint8_t length)
+{
+    daq_config_t cfg;
+    uint32_t generation = config_copy(&cfg);
+    lr11xx_radio_mod_params_lora_t mod_params = lora_mod_params(&cfg);
+    lr11xx_radio_pkt_params_lora_t pkt_params = lora_pkt_params(length);
+    uint32_t toa_ms = lr11xx_radio_get_lora_time_on_air_in_ms(&pkt_params, &mod_params);
+
+    if (!send_lora(freq_khz, cfg.lora_power_dbm, &mod_params, toa_ms, RADIO_LINK_LORA, generation, data, length)) {
+        return false;
+    }
+    airtime.lora_packets++;
+    airtime.lora_airtime_ms += toa_ms;
+    return true;
+}
+
+/**
+ * @brief Send a critical frame on the band(s) div_mode picks (blocking)
+ */
+bool lora_send_critical(const uint8_t* data, uint8_t length)
+{
+    switch (config_get()->div_mode) {
+        case DIV_ALTERNATE:
+            // Every other frame on sub-GHz; on 2.4 GHz if that one fails or is deferred
+            if ((critical_count++ & 1) && send_div(data, length)) {
+                return true;
+            }
+            return lora_send(data, length);
+        case DIV_DUPLICATE: {
+            // 2.4 GHz first, so the fast link is not held up by the slow copy
+            bool sent = lora_send(data, length);
+            bool sent_div = send_div(data, length);
+            return sent || sent_div;
         }
-        
-        sleep_ms(1);
+        default:
+            return lora_send(data, length);
+    }
+}
+
+/**
+ * @brief Send data with LR-FHSS on the sub-GHz essentials channel (blocking)
+ * 
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max LR_FHSS_MAX_PAYLOAD_LENGTH)
+ * @return true if TX completed successfully, false on error or deferral
+ */
+bool lr_fhss_send(const uint8_t* data, uint8_t length)
+{
+    if (length > LR_FHSS_MAX_PAYLOAD_LENGTH) {
+        printf("[DBG] LR-FHSS: payload too large (%u > %u)\n", length, LR_FHSS_MAX_PAYLOAD_LENGTH);
+        radio_stats_record_tx(RADIO_LINK_LR_FHSS, RADIO_TX_BAD_LENGTH, 0, 0);
+        return false;
     }
 
-    // Clear ALL IRQs after TX complete
+    // Respect the sub-band duty cycle, charged even if the frame then fails
+    uint32_t toa_ms = lr11xx_lr_fhss_get_time_on_air_in_ms(&lr_fhss_params, length);
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (!duty_cycle_allows(&sub_ghz_duty, now_ms, toa_ms)) {
+        airtime.lr_fhss_deferred++;
+        radio_stats_record_tx(RADIO_LINK_LR_FHSS, RADIO_TX_DEFERRED, 0, 0);
+        return false;
+    }
+    duty_cycle_spend(&sub_ghz_duty, now_ms, toa_ms);
+
+    tx_done_flag = false;
+    lr11xx_system_clear_errors(&lr1121);
     lr11xx_system_clear_irq_status(&lr1121, LR11XX_SYSTEM_IRQ_ALL_MASK);
-    printf("[DBG] TX #%lu: TX complete!\n", tx_count);
-    
+
+    // Packet type + LR-FHSS modulation, sub-GHz frequency and PA
+    lr11xx_lr_fhss_init(&lr1121);
+    set_rf_freq(LR_FHSS_RF_FREQ_IN_HZ);
+    bool ok = apply_pa_config(LR_FHSS_RF_FREQ_IN_HZ, LR_FHSS_TX_OUTPUT_POWER_DBM);
+
+    radio_tx_result_t result = RADIO_TX_SPI_ERROR;
+    if (ok) {
+        // Random hop sequence per frame spreads collisions with other LR-FHSS users
+        uint16_t hop_sequence_id = get_rand_32() % lr11xx_lr_fhss_get_hop_sequence_count(&lr_fhss_params);
+        if (lr11xx_lr_fhss_build_frame(&lr1121, &lr_fhss_params, hop_sequence_id, data, length) == LR11XX_STATUS_OK &&
+            start_tx(toa_ms + LORA_TX_TIMEOUT_MARGIN_MS)) {
+            result = wait_tx_irq(toa_ms);
+        }
+    }
+
+    // Back to the 2.4 GHz PA for lora_send()
+    const daq_config_t* cfg = config_get();
+    apply_pa_config(cfg->lora_freq_khz * 1000u, cfg->lora_power_dbm);
+    pa_freq_in_hz = cfg->lora_freq_khz * 1000u;
+
+    if (result != RADIO_TX_OK) {
+        printf("[DBG] LR-FHSS TX failed\n");
+        radio_stats_record_tx(RADIO_LINK_LR_FHSS, result, 0, 0);
+        return false;
+    }
+
+    radio_stats_record_tx(RADIO_LINK_LR_FHSS, RADIO_TX_OK, measured_toa_ms(), toa_ms);
+    airtime.lr_fhss_packets++;
+    airtime.lr_fhss_airtime_ms += toa_ms;
     return true;
 }
 
+/**
+ * @brief Load the live LoRa profile (packet type, frequency, modulation, packet params)
+ */
+void lora_apply_profile(uint32_t freq_khz, uint8_t length)
+{
+    lr11xx_radio_set_pkt_type(&lr1121, PACKET_TYPE);
+    set_rf_freq(freq_khz * 1000u);
+
+    lr11xx_radio_mod_params_lora_t mod_params = lora_mod_params(config_get());
+    lr11xx_radio_set_lora_mod_params(&lr1121, &mod_params);
+
+    lr11xx_radio_pkt_params_lora_t pkt_params = lora_pkt_params(length);
+    lr11xx_radio_set_lora_pkt_params(&lr1121, &pkt_params);
+}
+
+/**
+ * @brief Time on air of a LoRa frame with the active radio profile
+ */
+uint32_t lora_time_on_air_ms(uint8_t length)
+{
+    lr11xx_radio_mod_params_lora_t mod_params = lora_mod_params(config_get());
+    lr11xx_radio_pkt_params_lora_t pkt_params = lora_pkt_params(length);
+    return lr11xx_radio_get_lora_time_on_air_in_ms(&pkt_params, &mod_params);
+}
+
+/**
+ * @brief Set the RF frequency unless the radio is already on it
+ */
+void lora_set_freq(uint32_t freq_khz)
+{
+    set_rf_freq(freq_khz * 1000u);
+}
+
+/**
+ * @brief Whether the radio is in standby XOSC, with the TCXO already running
+ */
+bool lora_xosc_running(void)
+{
+    lr11xx_system_stat2_t stat2;
+    return lr11xx_system_get_status(&lr1121, NULL, &stat2, NULL) == LR11XX_STATUS_OK &&
+           stat2.chip_mode == LR11XX_SYSTEM_CHIP_MODE_STBY_XOSC;
+}
+
+/**
+ * @brief Get a copy of the airtime counters
+ */
+void lora_get_airtime(radio_airtime_t* out)
+{
+    *out = airtime;
+}
+
 /**
  * @brief Get the current TX packet count
  */
@@ -19,6 +19,23 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC CONSTANTS --------------------------------------------------------
+ */
+
+// lora_send() call to the frame going on air: TCXO start (5 ms, only from standby RC), SPI set-up, debug prints
+#define LORA_TX_SETUP_US    8000
+
+// Radio TX timeout beyond the computed time on air; the frame is then aborted
+#define LORA_TX_TIMEOUT_MARGIN_MS   100
+
+// Sleep in __wfe() until the DIO interrupt while a frame is on air. The
+// FreeRTOS build turns this off: its time interop makes the wait a task delay
+#ifndef LORA_TX_WAIT_WFE
+#define LORA_TX_WAIT_WFE    1
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS PROTOTYPES ---------------------------------------------
@@ -34,12 +51,115 @@ void lora_tx_init(void);
 /**
  * @brief Send data over LoRa (blocking until TX complete)
  * 
+ * With hop_channels above 1 the frame goes out on the hop channel of its
+ * sequence number (channel_hop.h), otherwise on lora_freq_khz.
+ * 
  * @param data Pointer to data buffer to send
- * @param length Length of data in bytes (max PAYLOAD_LENGTH)
+ * @param length Length of data in bytes (max lora_max_payload, see config_store.h)
  * @return true if TX completed successfully, false on timeout/error
  */
 bool lora_send(const uint8_t* data, uint8_t length);
 
+/**
+ * @brief Send data over LoRa on another 2.4 GHz channel (blocking until TX complete)
+ * 
+ * Same as lora_send() with the live radio profile, except for the frequency.
+ * Used by the repeater to forward on its own channel.
+ * 
+ * @param freq_khz RF frequency in kHz
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max lora_max_payload)
+ * @return true if TX completed successfully, false on timeout/error
+ */
+bool lora_send_on(uint32_t freq_khz, const uint8_t* data, uint8_t length);
+
+/**
+ * @brief Send a critical frame (alert, lap) with dual-band diversity (blocking)
+ * 
+ * With div_mode DIV_OFF this is lora_send(). DIV_ALTERNATE sends every other
+ * frame as sub-GHz LoRa on div_freq_khz instead, falling back to lora_send()
+ * when the sub-GHz budget is spent. DIV_DUPLICATE sends each frame with
+ * lora_send() and then again on sub-GHz. Both copies carry the same bytes, so
+ * a receiver on both bands keeps the first copy of each sequence number.
+ * 
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max lora_max_payload)
+ * @return true if at least one copy was transmitted
+ */
+bool lora_send_critical(const uint8_t* data, uint8_t length);
+
+/**
+ * @brief Load the live LoRa profile (packet type, frequency, modulation, packet params)
+ * 
+ * lora_send() does this itself; lr1121_rx.c uses it before entering RX.
+ * The radio must be in standby.
+ * 
+ * @param freq_khz RF frequency in kHz
+ * @param length Payload length in bytes (the largest accepted frame for RX)
+ */
+void lora_apply_profile(uint32_t freq_khz, uint8_t length);
+
+/**
+ * @brief Set the RF frequency unless the radio is already on it (radio in standby)
+ * 
+ * @param freq_khz RF frequency in kHz
+ */
+void lora_set_freq(uint32_t freq_khz);
+
+/**
+ * @brief Whether the radio is in standby XOSC, with the TCXO already running
+ * 
+ * The radio falls back to standby XOSC after every frame, so the TCXO
+ * start-up wait is only needed after standby RC (boot, TX timeout, RX stop).
+ */
+bool lora_xosc_running(void);
+
+/**
+ * @brief Time on air of a LoRa frame with the active radio profile
+ * 
+ * Uses the configuration lora_send() would use now, not the compile-time
+ * defaults of get_time_on_air_in_ms().
+ * 
+ * @param length Payload length in bytes
+ * @return Time on air in milliseconds
+ */
+uint32_t lora_time_on_air_ms(uint8_t length);
+
+/**
+ * @brief Send data with LR-FHSS on the sub-GHz essentials channel (blocking)
+ * 
+ * Switches the radio to LR_FHSS_RF_FREQ_IN_HZ for one frame and restores the
+ * 2.4 GHz PA afterwards; lora_send() re-applies the rest of its settings.
+ * Frames that would exceed the sub-GHz hourly budget (duty_cycle.h), shared
+ * with the diversity copies, are not sent.
+ * 
+ * @param data Pointer to data buffer to send
+ * @param length Length of data in bytes (max LR_FHSS_MAX_PAYLOAD_LENGTH)
+ * @return true if TX completed successfully, false on error or deferral
+ */
+bool lr_fhss_send(const uint8_t* data, uint8_t length);
+
+/**
+ * Airtime accounting per modulation
+ */
+typedef struct {
+    uint32_t lora_packets;
+    uint32_t lora_airtime_ms;
+    uint32_t lr_fhss_packets;
+    uint32_t lr_fhss_airtime_ms;
+    uint32_t lr_fhss_deferred;      // Not sent: sub-GHz hourly budget spent
+    uint32_t div_packets;           // Sub-GHz LoRa copies of critical frames
+    uint32_t div_airtime_ms;
+    uint32_t div_deferred;          // Not sent: sub-GHz hourly budget spent
+} radio_airtime_t;
+
+/**
+ * @brief Get a copy of the airtime counters
+ * 
+ * @param airtime Structure to fill
+ */
+void lora_get_airtime(radio_airtime_t* airtime);
+
 /**
  * @brief Get the current TX packet count
  * 
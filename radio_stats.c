@@ -0,0 +1,98 @@
+/**
+ * @file      radio_stats.c
+ * @brief     LR1121 link diagnostics implementation
+ */
+
+#include "radio_stats.h"
+#include <string.h>
+#include "pico/time.h"
+#include "wavesahre_lora_1121.h"
+#include "telemetry_packet.h"
+
+static radio_stats_t g_stats = {0};
+
+static uint16_t sat16(uint32_t value) {
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+static int16_t sat16s(int32_t value) {
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+void radio_stats_record_tx(radio_link_t link, radio_tx_result_t result,
+                           uint32_t measured_ms, uint32_t computed_ms) {
+    if (link >= RADIO_NUM_LINKS || result >= RADIO_TX_NUM_RESULTS) {
+        return;
+    }
+
+    radio_link_stats_t* l = &g_stats.link[link];
+    l->result[result]++;
+    if (result != RADIO_TX_OK) {
+        return;
+    }
+
+    int32_t error_ms = (int32_t)measured_ms - (int32_t)computed_ms;
+    if (l->result[RADIO_TX_OK] == 1 || error_ms > l->toa_error_max_ms) {
+        l->toa_error_max_ms = error_ms;
+    }
+    l->toa_measured_ms = measured_ms;
+    l->toa_computed_ms = computed_ms;
+}
+
+void radio_stats_record_sys_errors(uint16_t errors) {
+    if (errors == 0) {
+        return;
+    }
+    g_stats.sys_errors |= errors;
+    g_stats.last_sys_errors = errors;
+    g_stats.sys_error_events++;
+}
+
+void radio_stats_get(radio_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    *stats = g_stats;
+
+    lora_hal_stats_t hal;
+    lora_hal_get_stats(&hal);
+    stats->spi_commands = hal.commands;
+    stats->busy_timeouts = hal.busy_timeouts;
+    stats->busy_wait_ms = (uint32_t)(hal.busy_wait_us / 1000);
+    stats->busy_wait_max_us = hal.busy_wait_max_us;
+}
+
+void radio_stats_build_packet(telemetry_diag_t* packet) {
+    radio_stats_t s;
+    radio_stats_get(&s);
+
+    const radio_link_stats_t* lora = &s.link[RADIO_LINK_LORA];
+    const radio_link_stats_t* fhss = &s.link[RADIO_LINK_LR_FHSS];
+
+    memset(packet, 0, sizeof(*packet));
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_DIAG);
+    packet->uptime_ms = to_ms_since_boot(get_absolute_time());
+
+    packet->lora_ok = sat16(lora->result[RADIO_TX_OK]);
+    packet->lora_timeout = sat16(lora->result[RADIO_TX_TIMEOUT]);
+    packet->lora_spi_error = sat16(lora->result[RADIO_TX_SPI_ERROR]);
+    packet->lora_toa_computed_ms = sat16(lora->toa_computed_ms);
+    packet->lora_toa_measured_ms = sat16(lora->toa_measured_ms);
+    packet->lora_toa_error_max_ms = sat16s(lora->toa_error_max_ms);
+
+    packet->fhss_ok = sat16(fhss->result[RADIO_TX_OK]);
+    packet->fhss_timeout = sat16(fhss->result[RADIO_TX_TIMEOUT]);
+    packet->fhss_spi_error = sat16(fhss->result[RADIO_TX_SPI_ERROR]);
+    packet->fhss_deferred = sat16(fhss->result[RADIO_TX_DEFERRED]);
+    packet->fhss_toa_computed_ms = sat16(fhss->toa_computed_ms);
+    packet->fhss_toa_measured_ms = sat16(fhss->toa_measured_ms);
+
+    packet->sys_errors = s.sys_errors;
+    packet->sys_error_events = sat16(s.sys_error_events);
+    packet->spi_commands = s.spi_commands;
+    packet->busy_timeouts = sat16(s.busy_timeouts);
+    packet->busy_wait_max_us = sat16(s.busy_wait_max_us);
+    packet->busy_wait_ms = s.busy_wait_ms;
+}
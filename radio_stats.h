@@ -0,0 +1,100 @@
+/**
+ * @file      radio_stats.h
+ * @brief     LR1121 link diagnostics (TX outcomes, time on air, chip errors)
+ *
+ * lr1121_tx.c records the outcome of every transmission together with its
+ * measured (set_tx -> TX_DONE) and computed time on air, and every non-zero
+ * lr11xx_system_get_errors() reading. The HAL SPI counters are folded in
+ * when a snapshot is taken. Core 1 sends the snapshot periodically as a
+ * telemetry_diag_t packet, so link problems can be read from the pits.
+ *
+ * All recording happens on the core that owns the radio.
+ */
+
+#ifndef RADIO_STATS_H
+#define RADIO_STATS_H
+
+#include <stdint.h>
+#include "telemetry_schema.h"
+
+#define RADIO_DIAG_PERIOD_MS    5000        // Diagnostics packet rate
+
+/**
+ * Modulation a transmission used
+ */
+typedef enum {
+    RADIO_LINK_LORA = 0,            // 2.4 GHz LoRa telemetry
+    RADIO_LINK_LR_FHSS,             // Sub-GHz LR-FHSS essentials
+    RADIO_LINK_LORA_SUB_GHZ,        // Sub-GHz LoRa diversity copies (not in telemetry_diag_t)
+    RADIO_NUM_LINKS
+} radio_link_t;
+
+/**
+ * Outcome of one send call
+ */
+typedef enum {
+    RADIO_TX_OK = 0,
+    RADIO_TX_TIMEOUT,               // No TX_DONE within the timeout
+    RADIO_TX_SPI_ERROR,             // A driver command failed (BUSY stuck, bad status)
+    RADIO_TX_BAD_LENGTH,            // Payload larger than the link allows
+    RADIO_TX_DEFERRED,              // Held back by the sub-GHz duty cycle
+    RADIO_TX_NUM_RESULTS
+} radio_tx_result_t;
+
+/**
+ * Per-link counters
+ */
+typedef struct {
+    uint32_t result[RADIO_TX_NUM_RESULTS];
+    uint32_t toa_computed_ms;       // Last computed time on air
+    uint32_t toa_measured_ms;       // Last measured set_tx -> TX_DONE time
+    int32_t  toa_error_max_ms;      // Worst (measured - computed) since boot
+} radio_link_stats_t;
+
+/**
+ * Snapshot of all radio counters
+ */
+typedef struct {
+    radio_link_stats_t link[RADIO_NUM_LINKS];
+    uint16_t sys_errors;            // OR of every lr11xx_system_get_errors() reading
+    uint16_t last_sys_errors;       // Most recent non-zero reading
+    uint32_t sys_error_events;      // Non-zero readings
+    uint32_t spi_commands;          // From the HAL
+    uint32_t busy_timeouts;
+    uint32_t busy_wait_ms;          // Total time blocked on BUSY
+    uint32_t busy_wait_max_us;
+} radio_stats_t;
+
+/**
+ * @brief Record the outcome of a transmission
+ *
+ * @param link Modulation used
+ * @param result Outcome
+ * @param measured_ms Measured set_tx -> TX_DONE time (RADIO_TX_OK only)
+ * @param computed_ms Computed time on air (RADIO_TX_OK only)
+ */
+void radio_stats_record_tx(radio_link_t link, radio_tx_result_t result,
+                           uint32_t measured_ms, uint32_t computed_ms);
+
+/**
+ * @brief Record a lr11xx_system_get_errors() reading (zero is ignored)
+ *
+ * @param errors lr11xx_system_errors_t bit mask
+ */
+void radio_stats_record_sys_errors(uint16_t errors);
+
+/**
+ * @brief Get a snapshot of the radio counters, including the HAL counters
+ *
+ * @param stats Structure to fill
+ */
+void radio_stats_get(radio_stats_t* stats);
+
+/**
+ * @brief Build the diagnostics packet from the current counters
+ *
+ * @param packet Packet to fill
+ */
+void radio_stats_build_packet(telemetry_diag_t* packet);
+
+#endif // RADIO_STATS_H
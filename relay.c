@@ -0,0 +1,111 @@
+/**
+ * @file      relay.c
+ * @brief     Store-and-forward core of the trackside repeater
+ */
+
+#include "relay.h"
+#include <string.h>
+#include "telemetry_auth.h"
+#include "telemetry_schema.h"
+
+_Static_assert(RELAY_QUEUE_DEPTH <= 255 && RELAY_DEDUP_DEPTH <= 255, "relay indices are uint8_t");
+
+void relay_init(relay_t* relay, uint32_t max_age_us) {
+    memset(relay, 0, sizeof(*relay));
+    relay->max_age_us = max_age_us;
+}
+
+bool relay_frame_key(const uint8_t* frame, uint8_t length, uint32_t* key) {
+    // Authenticated frame: the header is plaintext even when the payload is encrypted
+    if (length > TELEMETRY_AUTH_OVERHEAD && frame[0] == TELEMETRY_AUTH_VERSION &&
+        (frame[1] & ~TELEMETRY_AUTH_F_ENCRYPTED) == 0) {
+        uint32_t session = (uint32_t)frame[2] | (uint32_t)frame[3] << 8;
+        uint32_t counter = (uint32_t)frame[4] | (uint32_t)frame[5] << 8 |
+                           (uint32_t)frame[6] << 16 | (uint32_t)frame[7] << 24;
+        *key = session << 16 ^ counter;
+        return true;
+    }
+
+    // Plain telemetry packet: type/version, sequence number, timestamp
+    if (telemetry_peek_type(frame, length) != 0) {
+        *key = (uint32_t)frame[0] << 24 | (uint32_t)frame[1] << 16 |
+               (uint32_t)frame[2] | (uint32_t)frame[3] << 8;
+        return true;
+    }
+    return false;
+}
+
+// Remember key; true if it was already seen within the window
+static bool seen_recently(relay_t* relay, uint32_t key, uint64_t now_us) {
+    for (int i = 0; i < RELAY_DEDUP_DEPTH; i++) {
+        relay_seen_t* seen = &relay->seen[i];
+        if (seen->seen_us != 0 && seen->key == key && now_us - seen->seen_us < RELAY_DEDUP_WINDOW_US) {
+            return true;
+        }
+    }
+    relay->seen[relay->seen_next] = (relay_seen_t){ key, now_us ? now_us : 1 };
+    relay->seen_next = (uint8_t)((relay->seen_next + 1) % RELAY_DEDUP_DEPTH);
+    return false;
+}
+
+relay_rx_result_t relay_receive(relay_t* relay, const uint8_t* frame, uint8_t length, int8_t rssi_dbm,
+                                uint64_t now_us) {
+    relay->stats.received++;
+
+    uint32_t key;
+    if (length > RELAY_MAX_FRAME || !relay_frame_key(frame, length, &key)) {
+        relay->stats.invalid++;
+        return RELAY_RX_INVALID;
+    }
+    if (seen_recently(relay, key, now_us)) {
+        relay->stats.duplicates++;
+        return RELAY_RX_DUPLICATE;
+    }
+
+    relay_rx_result_t result = RELAY_RX_QUEUED;
+    if (relay->count == RELAY_QUEUE_DEPTH) {
+        // Newer data is worth more than old data that has waited longest
+        relay->head = (uint8_t)((relay->head + 1) % RELAY_QUEUE_DEPTH);
+        relay->count--;
+        relay->stats.overflows++;
+        result = RELAY_RX_OVERFLOW;
+    }
+
+    relay_frame_t* slot = &relay->queue[(relay->head + relay->count) % RELAY_QUEUE_DEPTH];
+    slot->rx_us = now_us;
+    slot->length = length;
+    slot->rssi_dbm = rssi_dbm;
+    memcpy(slot->data, frame, length);
+    relay->count++;
+    if (relay->count > relay->stats.queue_high) {
+        relay->stats.queue_high = relay->count;
+    }
+    return result;
+}
+
+const relay_frame_t* relay_next(relay_t* relay, uint64_t now_us) {
+    while (relay->count > 0) {
+        const relay_frame_t* frame = &relay->queue[relay->head];
+        if (now_us - frame->rx_us <= relay->max_age_us) {
+            return frame;
+        }
+        relay->head = (uint8_t)((relay->head + 1) % RELAY_QUEUE_DEPTH);
+        relay->count--;
+        relay->stats.expired++;
+    }
+    return NULL;
+}
+
+void relay_sent(relay_t* relay, uint64_t now_us) {
+    if (relay->count == 0) {
+        return;
+    }
+
+    uint32_t latency = (uint32_t)(now_us - relay->queue[relay->head].rx_us);
+    if (latency > relay->stats.max_latency_us) {
+        relay->stats.max_latency_us = latency;
+    }
+    relay->head = (uint8_t)((relay->head + 1) % RELAY_QUEUE_DEPTH);
+    relay->count--;
+    relay->stats.forwarded++;
+}
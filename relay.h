@@ -0,0 +1,128 @@
+/**
+ * @file      relay.h
+ * @brief     Store-and-forward core of the trackside repeater (FS26-Repeater)
+ *
+ * The repeater hears DAQ frames on the car channel and sends each one again,
+ * unchanged, so a MIC added by telemetry_auth.c still verifies at the base
+ * station. Frames are told apart by their sequence numbers: the session and
+ * counter of an authenticated frame, or the type, sequence number and
+ * timestamp of a plain telemetry header. A frame heard again within
+ * RELAY_DEDUP_WINDOW_US is dropped. The copy may come from the car, from
+ * another repeater or from this repeater's own earlier transmission, so
+ * repeaters that hear each other cannot loop.
+ *
+ * Frames wait in a bounded FIFO until the repeater may transmit: in its
+ * TDMA slot, or at once on a separate channel. A frame older than
+ * max_age_us is dropped instead of sent. The latency a repeater adds is
+ * therefore at most max_age_us plus one transmission.
+ *
+ * No Pico SDK dependency: tools/relay_sim.c runs it with simulated radios.
+ */
+
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RELAY_MAX_FRAME         64          // >= PAYLOAD_LENGTH (checked in FS26-Repeater.c)
+#define RELAY_QUEUE_DEPTH       16
+#define RELAY_DEDUP_DEPTH       64          // Keys remembered, > frames heard per window
+#define RELAY_DEDUP_WINDOW_US   2000000
+
+/**
+ * Outcome of relay_receive()
+ */
+typedef enum {
+    RELAY_RX_QUEUED = 0,
+    RELAY_RX_DUPLICATE,             // Key seen within RELAY_DEDUP_WINDOW_US
+    RELAY_RX_INVALID,               // Not a DAQ frame
+    RELAY_RX_OVERFLOW               // Queued; the oldest queued frame was dropped
+} relay_rx_result_t;
+
+/**
+ * One frame waiting to be forwarded
+ */
+typedef struct {
+    uint64_t rx_us;                 // Local time it was received
+    uint8_t  length;
+    int8_t   rssi_dbm;
+    uint8_t  data[RELAY_MAX_FRAME];
+} relay_frame_t;
+
+/**
+ * Forwarding counters
+ */
+typedef struct {
+    uint32_t received;              // Frames passed to relay_receive()
+    uint32_t forwarded;
+    uint32_t duplicates;
+    uint32_t invalid;
+    uint32_t overflows;             // Oldest frame dropped to queue a new one
+    uint32_t expired;               // Dropped after max_age_us in the queue
+    uint32_t max_latency_us;        // Worst receive -> relay_sent()
+    uint8_t  queue_high;            // Most frames queued at once
+} relay_stats_t;
+
+typedef struct {
+    uint32_t key;
+    uint64_t seen_us;
+} relay_seen_t;
+
+typedef struct {
+    relay_frame_t queue[RELAY_QUEUE_DEPTH];
+    uint8_t       head;             // Oldest frame
+    uint8_t       count;
+    relay_seen_t  seen[RELAY_DEDUP_DEPTH];
+    uint8_t       seen_next;        // Ring position of the next key
+    uint32_t      max_age_us;
+    relay_stats_t stats;
+} relay_t;
+
+/**
+ * @brief Empty the queue and the dedup ring
+ *
+ * @param relay Relay state
+ * @param max_age_us Longest a frame may wait before it is dropped
+ */
+void relay_init(relay_t* relay, uint32_t max_age_us);
+
+/**
+ * @brief Sequence key of a DAQ frame
+ *
+ * @param frame Frame as received
+ * @param length Frame length
+ * @param key Filled in
+ * @return false if the frame is neither a telemetry_auth frame nor a
+ *         telemetry packet of this schema version
+ */
+bool relay_frame_key(const uint8_t* frame, uint8_t length, uint32_t* key);
+
+/**
+ * @brief Queue a received frame unless it is a duplicate or not a DAQ frame
+ *
+ * @param relay Relay state
+ * @param frame Frame as received
+ * @param length Frame length (at most RELAY_MAX_FRAME)
+ * @param rssi_dbm Packet RSSI, kept for the statistics
+ * @param now_us Local time of reception
+ */
+relay_rx_result_t relay_receive(relay_t* relay, const uint8_t* frame, uint8_t length, int8_t rssi_dbm,
+                                uint64_t now_us);
+
+/**
+ * @brief Oldest frame to forward, after dropping the expired ones
+ *
+ * @return NULL if the queue is empty
+ */
+const relay_frame_t* relay_next(relay_t* relay, uint64_t now_us);
+
+/**
+ * @brief Remove the frame returned by relay_next() once it has been sent
+ *
+ * @param relay Relay state
+ * @param now_us Local time the transmission ended
+ */
+void relay_sent(relay_t* relay, uint64_t now_us);
+
+#endif // RELAY_H
@@ -0,0 +1,145 @@
+/**
+ * @file      sample_queue.c
+ * @brief     Lock-free SPSC sample queue implementation
+ */
+
+#include "sample_queue.h"
+#include "hot_path.h"
+#include <string.h>
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+#define SAMPLE_QUEUE_MASK (SAMPLE_QUEUE_CAPACITY - 1)
+
+_Static_assert((SAMPLE_QUEUE_CAPACITY & SAMPLE_QUEUE_MASK) == 0,
+               "SAMPLE_QUEUE_CAPACITY must be a power of two");
+
+const float sample_channel_scale[SAMPLE_CH_COUNT] = {
+    [SAMPLE_CH_RPM]                  = 1.0f,
+    [SAMPLE_CH_TPS]                  = 0.1f,
+    [SAMPLE_CH_ENGINE_TEMP]          = 0.1f,
+    [SAMPLE_CH_AIR_TEMP]             = 0.1f,
+    [SAMPLE_CH_BATTERY_VOLTAGE]      = 0.01f,
+    [SAMPLE_CH_MAP]                  = 0.1f,
+    [SAMPLE_CH_GPS_LATITUDE]         = 1e-7f,
+    [SAMPLE_CH_GPS_LONGITUDE]        = 1e-7f,
+    [SAMPLE_CH_GPS_ALTITUDE]         = 0.1f,
+    [SAMPLE_CH_GPS_SPEED]            = 0.1f,
+    [SAMPLE_CH_GPS_SATELLITES]       = 1.0f,
+    [SAMPLE_CH_WHEEL_SPEED_FR]       = 1.0f,
+    [SAMPLE_CH_WHEEL_SPEED_FL]       = 1.0f,
+    [SAMPLE_CH_WHEEL_SPEED_RR]       = 1.0f,
+    [SAMPLE_CH_WHEEL_SPEED_RL]       = 1.0f,
+    [SAMPLE_CH_TRACTION_CTRL_SLIP]   = 1.0f,
+    [SAMPLE_CH_TRACTION_CTRL_RETARD] = 1.0f,
+    [SAMPLE_CH_TRACTION_CTRL_CUT]    = 1.0f,
+    [SAMPLE_CH_HEADING]              = 1.0f,
+    [SAMPLE_CH_SHOCK_FR]             = 0.001f,
+    [SAMPLE_CH_SHOCK_FL]             = 0.001f,
+    [SAMPLE_CH_SHOCK_RR]             = 0.001f,
+    [SAMPLE_CH_SHOCK_RL]             = 0.001f,
+    [SAMPLE_CH_G_FORCE_ACCEL]        = 1.0f,
+    [SAMPLE_CH_G_FORCE_LATERAL]      = 1.0f,
+    [SAMPLE_CH_YAW_RATE_FRONTAL]     = 1.0f,
+    [SAMPLE_CH_YAW_RATE_LATERAL]     = 1.0f,
+};
+
+#if SAMPLE_QUEUE_ENABLED
+
+static sample_t g_buffer[SAMPLE_QUEUE_CAPACITY];
+
+// head is only written by the producer, tail only by the consumer.
+// Both are free-running; (head - tail) is the fill level.
+static volatile uint32_t g_head = 0;
+static volatile uint32_t g_tail = 0;
+
+// Producer-owned counters
+static uint16_t g_seq = 0;
+static volatile uint32_t g_pushed = 0;
+static volatile uint32_t g_dropped = 0;
+static volatile uint32_t g_high_water = 0;
+
+// Consumer-owned counter
+static volatile uint32_t g_popped = 0;
+
+void sample_queue_init(void) {
+    g_head = 0;
+    g_tail = 0;
+    g_seq = 0;
+    g_pushed = 0;
+    g_dropped = 0;
+    g_high_water = 0;
+    g_popped = 0;
+}
+
+bool HOT_PATH_FUNC(sample_queue_push)(uint8_t channel, int32_t value, uint32_t timestamp_us) {
+    uint32_t head = g_head;
+    uint16_t seq = g_seq++;
+
+    uint32_t fill = head - g_tail;
+    if (fill >= SAMPLE_QUEUE_CAPACITY) {
+        g_dropped++;
+        return false;
+    }
+
+    sample_t* slot = &g_buffer[head & SAMPLE_QUEUE_MASK];
+    slot->timestamp_us = timestamp_us;
+    slot->seq = seq;
+    slot->channel = channel;
+    slot->reserved = 0;
+    slot->value = value;
+
+    // Sample contents must be visible before the new head
+    __mem_fence_release();
+    g_head = head + 1;
+
+    g_pushed++;
+    if (fill + 1 > g_high_water) {
+        g_high_water = fill + 1;
+    }
+    return true;
+}
+
+void HOT_PATH_FUNC(sample_queue_publish)(void) {
+#if SAMPLE_QUEUE_USE_SIO_DOORBELL
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(SAMPLE_QUEUE_DOORBELL);
+    }
+#endif
+}
+
+uint32_t sample_queue_pop(sample_t* out, uint32_t max_samples) {
+    uint32_t tail = g_tail;
+    uint32_t head = g_head;
+
+    // Don't read sample contents ahead of the head we just observed
+    __mem_fence_acquire();
+
+    uint32_t count = head - tail;
+    if (count > max_samples) {
+        count = max_samples;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = g_buffer[(tail + i) & SAMPLE_QUEUE_MASK];
+    }
+
+    // Finish reading the slots before handing them back to the producer
+    __mem_fence_release();
+    g_tail = tail + count;
+
+    g_popped += count;
+    return count;
+}
+
+void sample_queue_get_stats(sample_queue_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->pushed = g_pushed;
+    stats->dropped = g_dropped;
+    stats->popped = g_popped;
+    stats->high_water = g_high_water;
+}
+
+#endif // SAMPLE_QUEUE_ENABLED
@@ -0,0 +1,156 @@
+/**
+ * @file      sample_queue.h
+ * @brief     Lossless core 0 -> core 1 sample stream (lock-free SPSC queue)
+ *
+ * Every decoded channel update on core 0 is pushed as a timestamped sample.
+ * Core 1 drains the queue, so downstream consumers see every update instead
+ * of only the latest snapshot. The RP2350 SIO FIFO carries a doorbell token
+ * so core 1 can sleep until data arrives.
+ *
+ * Exactly one producer (core 0) and one consumer (core 1) are supported.
+ * The FreeRTOS build has two preemptive producers (CAN and GPS tasks) and
+ * the repeater no consumer, so those targets compile the queue out.
+ */
+
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Queue depth in samples, must be a power of two
+#define SAMPLE_QUEUE_CAPACITY 512
+
+// 0: pushes and publishes compile to nothing (targets without a consumer)
+#ifndef SAMPLE_QUEUE_ENABLED
+#define SAMPLE_QUEUE_ENABLED 1
+#endif
+
+// The FreeRTOS SMP port owns the SIO FIFO, so a build there would turn this off
+#ifndef SAMPLE_QUEUE_USE_SIO_DOORBELL
+#define SAMPLE_QUEUE_USE_SIO_DOORBELL 1
+#endif
+
+// Token pushed through the SIO FIFO when new samples are published
+#define SAMPLE_QUEUE_DOORBELL 0x53514442  // "SQDB"
+
+/**
+ * Channels carried by the sample stream
+ * Values are raw fixed-point integers, see sample_channel_scale[]
+ */
+typedef enum {
+    SAMPLE_CH_RPM = 0,              // RPM (Raw × 1)
+    SAMPLE_CH_TPS,                  // % (Raw × 0.1)
+    SAMPLE_CH_ENGINE_TEMP,          // °C (Raw × 0.1)
+    SAMPLE_CH_AIR_TEMP,             // °C (Raw × 0.1)
+    SAMPLE_CH_BATTERY_VOLTAGE,      // V (Raw × 0.01)
+    SAMPLE_CH_MAP,                  // kPa (Raw × 0.1)
+    SAMPLE_CH_GPS_LATITUDE,         // deg (Raw × 1e-7)
+    SAMPLE_CH_GPS_LONGITUDE,        // deg (Raw × 1e-7)
+    SAMPLE_CH_GPS_ALTITUDE,         // m (Raw × 0.1)
+    SAMPLE_CH_GPS_SPEED,            // km/h (Raw × 0.1)
+    SAMPLE_CH_GPS_SATELLITES,       // count (Raw × 1)
+    // Chassis bus, in FT550 frame order (0x14080603 to 0x14080606)
+    SAMPLE_CH_WHEEL_SPEED_FR,       // km/h (Raw × 1, unsigned)
+    SAMPLE_CH_WHEEL_SPEED_FL,       // km/h (Raw × 1, unsigned)
+    SAMPLE_CH_WHEEL_SPEED_RR,       // km/h (Raw × 1, unsigned)
+    SAMPLE_CH_WHEEL_SPEED_RL,       // km/h (Raw × 1, unsigned)
+    SAMPLE_CH_TRACTION_CTRL_SLIP,   // Raw (No multiplier)
+    SAMPLE_CH_TRACTION_CTRL_RETARD, // Raw (No multiplier)
+    SAMPLE_CH_TRACTION_CTRL_CUT,    // Raw (No multiplier)
+    SAMPLE_CH_HEADING,              // Raw (No multiplier)
+    SAMPLE_CH_SHOCK_FR,             // Raw × 0.001
+    SAMPLE_CH_SHOCK_FL,             // Raw × 0.001
+    SAMPLE_CH_SHOCK_RR,             // Raw × 0.001
+    SAMPLE_CH_SHOCK_RL,             // Raw × 0.001
+    SAMPLE_CH_G_FORCE_ACCEL,        // g (No multiplier)
+    SAMPLE_CH_G_FORCE_LATERAL,      // g (No multiplier)
+    SAMPLE_CH_YAW_RATE_FRONTAL,     // Raw (No multiplier)
+    SAMPLE_CH_YAW_RATE_LATERAL,     // Raw (No multiplier)
+    SAMPLE_CH_COUNT
+} sample_channel_t;
+
+/**
+ * One channel update (12 bytes)
+ */
+typedef struct {
+    uint32_t timestamp_us;          // time_us_32() when the value was decoded
+    uint16_t seq;                   // Producer sequence, gaps = dropped samples
+    uint8_t  channel;               // sample_channel_t
+    uint8_t  reserved;
+    int32_t  value;                 // Raw fixed-point value
+} sample_t;
+
+/**
+ * Queue accounting
+ */
+typedef struct {
+    uint32_t pushed;                // Samples accepted by the queue
+    uint32_t dropped;               // Samples rejected because the queue was full
+    uint32_t popped;                // Samples handed to the consumer
+    uint32_t high_water;            // Deepest fill level seen
+} sample_queue_stats_t;
+
+// Multiplier converting a raw sample value into engineering units
+extern const float sample_channel_scale[SAMPLE_CH_COUNT];
+
+#if SAMPLE_QUEUE_ENABLED
+
+/**
+ * @brief Reset the queue. Call once before either core uses it.
+ */
+void sample_queue_init(void);
+
+/**
+ * @brief Push one sample (producer / core 0 only)
+ *
+ * Never blocks. When the queue is full the sample is dropped and counted;
+ * its sequence number is still consumed so the consumer sees the gap.
+ *
+ * @param channel Channel id (sample_channel_t)
+ * @param value Raw fixed-point value
+ * @param timestamp_us Decode time from time_us_32()
+ * @return true if queued, false if dropped
+ */
+bool sample_queue_push(uint8_t channel, int32_t value, uint32_t timestamp_us);
+
+/**
+ * @brief Signal the consumer that new samples are available (producer only)
+ *
+ * Call once after a batch of pushes. Rings the SIO FIFO doorbell without
+ * blocking; if the FIFO is full the consumer already has a doorbell pending.
+ */
+void sample_queue_publish(void);
+
+/**
+ * @brief Pop up to max_samples samples (consumer / core 1 only)
+ *
+ * @param out Destination array
+ * @param max_samples Capacity of out
+ * @return Number of samples copied
+ */
+uint32_t sample_queue_pop(sample_t* out, uint32_t max_samples);
+
+/**
+ * @brief Get a copy of the queue accounting counters
+ *
+ * @param stats Structure to fill
+ */
+void sample_queue_get_stats(sample_queue_stats_t* stats);
+
+#else
+
+static inline void sample_queue_init(void) {}
+
+static inline bool sample_queue_push(uint8_t channel, int32_t value, uint32_t timestamp_us) {
+    (void)channel;
+    (void)value;
+    (void)timestamp_us;
+    return false;
+}
+
+static inline void sample_queue_publish(void) {}
+
+#endif // SAMPLE_QUEUE_ENABLED
+
+#endif // SAMPLE_QUEUE_H
@@ -0,0 +1,188 @@
+/**
+ * @file      scheduler.c
+ * @brief     Deadline-driven cooperative scheduler implementation
+ */
+
+#include "scheduler.h"
+#include <string.h>
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "safe_print.h"
+
+void sched_init(scheduler_t* sched) {
+    memset(sched, 0, sizeof(*sched));
+}
+
+int sched_add_task(scheduler_t* sched, const sched_task_config_t* cfg) {
+    if (!sched || !cfg || !cfg->run || sched->num_tasks >= SCHED_MAX_TASKS) {
+        return -1;
+    }
+
+    int id = sched->num_tasks++;
+    sched_task_t* task = &sched->tasks[id];
+    memset(task, 0, sizeof(*task));
+    task->cfg = *cfg;
+    if (task->cfg.deadline_us == 0) {
+        task->cfg.deadline_us = task->cfg.period_us;
+    }
+    task->next_release_us = time_us_64() + task->cfg.period_us;
+
+    return id;
+}
+
+void sched_set_period(scheduler_t* sched, int task_id, uint32_t period_us) {
+    if (task_id < 0 || task_id >= sched->num_tasks || period_us == 0) {
+        return;
+    }
+
+    sched_task_t* task = &sched->tasks[task_id];
+    if (task->cfg.period_us != period_us) {
+        task->cfg.period_us = period_us;
+        task->next_release_us = time_us_64() + period_us;
+    }
+}
+
+void sched_set_next_release(scheduler_t* sched, int task_id, uint64_t release_us) {
+    if (task_id < 0 || task_id >= sched->num_tasks || sched->tasks[task_id].cfg.period_us == 0) {
+        return;
+    }
+
+    sched->tasks[task_id].next_release_us = release_us;
+}
+
+void sched_signal(scheduler_t* sched, int task_id) {
+    if (task_id < 0 || task_id >= sched->num_tasks) {
+        return;
+    }
+
+    sched_task_t* task = &sched->tasks[task_id];
+    if (!task->pending) {
+        task->release_us = time_us_64();
+        task->pending = true;
+    }
+    __sev();
+}
+
+// Move every task whose period has elapsed (or whose event source is ready)
+// into the pending state. Returns the earliest future periodic release.
+static uint64_t release_due_tasks(scheduler_t* sched, uint64_t now) {
+    uint64_t next_wake = UINT64_MAX;
+
+    for (int i = 0; i < sched->num_tasks; i++) {
+        sched_task_t* task = &sched->tasks[i];
+
+        if (task->cfg.period_us != 0 && now >= task->next_release_us) {
+            if (!task->pending) {
+                task->release_us = task->next_release_us;
+                task->pending = true;
+            }
+            task->next_release_us += task->cfg.period_us;
+
+            // Overran by more than a whole period: skip the lost releases
+            // instead of running the task back-to-back to catch up
+            if (task->next_release_us <= now) {
+                uint64_t skipped = (now - task->next_release_us) / task->cfg.period_us + 1;
+                task->stats.deadline_misses += (uint32_t)skipped;
+                task->next_release_us += skipped * task->cfg.period_us;
+            }
+        }
+
+        if (!task->pending && task->cfg.ready && task->cfg.ready()) {
+            task->release_us = now;
+            task->pending = true;
+        }
+
+        if (task->cfg.period_us != 0 && task->next_release_us < next_wake) {
+            next_wake = task->next_release_us;
+        }
+    }
+
+    return next_wake;
+}
+
+bool sched_run_once(scheduler_t* sched, uint64_t* next_wake_us) {
+    uint64_t now = time_us_64();
+    uint64_t next_wake = release_due_tasks(sched, now);
+    if (next_wake_us) {
+        *next_wake_us = next_wake;
+    }
+
+    // Highest priority pending task; ties go to the earliest absolute deadline
+    sched_task_t* best = NULL;
+    for (int i = 0; i < sched->num_tasks; i++) {
+        sched_task_t* task = &sched->tasks[i];
+        if (!task->pending) {
+            continue;
+        }
+        if (!best || task->cfg.priority < best->cfg.priority ||
+            (task->cfg.priority == best->cfg.priority &&
+             task->release_us + task->cfg.deadline_us < best->release_us + best->cfg.deadline_us)) {
+            best = task;
+        }
+    }
+
+    if (!best) {
+        return false;
+    }
+
+    uint64_t release = best->release_us;
+    best->pending = false;
+
+    uint64_t start = time_us_64();
+    best->cfg.run();
+    uint64_t finish = time_us_64();
+
+    sched_task_stats_t* stats = &best->stats;
+    uint32_t latency = (uint32_t)(start - release);
+    uint32_t exec = (uint32_t)(finish - start);
+    stats->runs++;
+    if (latency > stats->max_latency_us) stats->max_latency_us = latency;
+    if (exec > stats->max_exec_us) stats->max_exec_us = exec;
+    if (best->cfg.deadline_us != 0 && finish - release > best->cfg.deadline_us) {
+        stats->deadline_misses++;
+    }
+
+    return true;
+}
+
+void sched_run(scheduler_t* sched) {
+    while (true) {
+        uint64_t next_wake;
+        if (sched_run_once(sched, &next_wake)) {
+            continue;
+        }
+
+        // Nothing ready: sleep until the next periodic release or any
+        // interrupt/__sev(). Spurious wakeups just re-run the release scan.
+        sched->idle_count++;
+        if (next_wake == UINT64_MAX) {
+            __wfe();
+        } else {
+            best_effort_wfe_or_timeout(from_us_since_boot(next_wake));
+        }
+    }
+}
+
+const sched_task_stats_t* sched_get_stats(const scheduler_t* sched, int task_id) {
+    if (!sched || task_id < 0 || task_id >= sched->num_tasks) {
+        return NULL;
+    }
+    return &sched->tasks[task_id].stats;
+}
+
+void sched_report(scheduler_t* sched) {
+    safe_printf("[SCHED] idle:%lu", (unsigned long)sched->idle_count);
+    for (int i = 0; i < sched->num_tasks; i++) {
+        sched_task_t* task = &sched->tasks[i];
+        safe_printf(" | %s runs:%lu miss:%lu lat:%luus exec:%luus",
+                    task->cfg.name,
+                    (unsigned long)task->stats.runs,
+                    (unsigned long)task->stats.deadline_misses,
+                    (unsigned long)task->stats.max_latency_us,
+                    (unsigned long)task->stats.max_exec_us);
+        task->stats.max_latency_us = 0;
+        task->stats.max_exec_us = 0;
+    }
+    safe_printf("\n");
+    sched->idle_count = 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file      scheduler.h
+ * @brief     Deadline-driven cooperative scheduler for the DAQ cores
+ *
+ * Small run-to-completion scheduler that replaces the fixed-sleep super-loop.
+ * Each task has a period, a relative deadline and a priority, and can also be
+ * released by an event (ISR signal or polled ready check). When nothing is
+ * ready the core idles in __wfe() until the next release or interrupt.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*sched_task_fn_t)(void);
+typedef bool (*sched_ready_fn_t)(void);
+
+/**
+ * Static description of a task
+ */
+typedef struct {
+    const char*      name;
+    sched_task_fn_t  run;           // Run-to-completion body
+    sched_ready_fn_t ready;         // Optional polled event source (NULL = none)
+    uint32_t         period_us;     // Periodic release (0 = event-driven only)
+    uint32_t         deadline_us;   // Completion deadline relative to release
+    uint8_t          priority;      // 0 = most urgent
+} sched_task_config_t;
+
+/**
+ * Per-task runtime statistics
+ */
+typedef struct {
+    uint32_t runs;                  // Completed runs
+    uint32_t deadline_misses;       // Late completions + skipped periodic releases
+    uint32_t max_latency_us;        // Worst release -> start delay
+    uint32_t max_exec_us;           // Worst execution time
+} sched_task_stats_t;
+
+typedef struct {
+    sched_task_config_t cfg;
+    sched_task_stats_t  stats;
+    uint64_t            next_release_us;
+    uint64_t            release_us;
+    volatile bool       pending;
+} sched_task_t;
+
+typedef struct {
+    sched_task_t tasks[SCHED_MAX_TASKS];
+    uint8_t      num_tasks;
+    uint32_t     idle_count;        // Times the core entered __wfe()
+} scheduler_t;
+
+/**
+ * @brief Initialize an empty scheduler instance
+ *
+ * @param sched Scheduler to initialize
+ */
+void sched_init(scheduler_t* sched);
+
+/**
+ * @brief Register a task
+ *
+ * Periodic tasks are first released one period after registration.
+ *
+ * @param sched Scheduler instance
+ * @param cfg Task description (copied)
+ * @return Task id (>= 0), or -1 if the task table is full
+ */
+int sched_add_task(scheduler_t* sched, const sched_task_config_t* cfg);
+
+/**
+ * @brief Change a task's period (from the core that runs the scheduler)
+ *
+ * The next periodic release is one new period from now.
+ *
+ * @param sched Scheduler instance
+ * @param task_id Id returned by sched_add_task()
+ * @param period_us New period, must be non-zero for a periodic task
+ */
+void sched_set_period(scheduler_t* sched, int task_id, uint32_t period_us);
+
+/**
+ * @brief Move a periodic task's next release (from the core that runs the scheduler)
+ *
+ * Later releases follow one period apart from this one. Used to keep a
+ * task in phase with an external clock, such as a TDMA slot.
+ *
+ * @param sched Scheduler instance
+ * @param task_id Id returned by sched_add_task()
+ * @param release_us Absolute time_us_64() of the next release
+ */
+void sched_set_next_release(scheduler_t* sched, int task_id, uint64_t release_us);
+
+/**
+ * @brief Release a task from interrupt or task context
+ *
+ * Marks the task pending and issues __sev() so an idle core wakes up.
+ * Signals received while the task is already pending are merged.
+ *
+ * @param sched Scheduler instance
+ * @param task_id Id returned by sched_add_task()
+ */
+void sched_signal(scheduler_t* sched, int task_id);
+
+/**
+ * @brief Release due tasks and run the most urgent pending one
+ *
+ * @param sched Scheduler instance
+ * @param next_wake_us Filled with the earliest future periodic release time
+ * @return true if a task ran, false if the core may idle
+ */
+bool sched_run_once(scheduler_t* sched, uint64_t* next_wake_us);
+
+/**
+ * @brief Run the scheduler forever, idling with __wfe() when nothing is ready
+ *
+ * @param sched Scheduler instance
+ */
+void sched_run(scheduler_t* sched);
+
+/**
+ * @brief Get the runtime statistics of a task
+ *
+ * @param sched Scheduler instance
+ * @param task_id Task id
+ * @return Pointer to the statistics, or NULL for an invalid id
+ */
+const sched_task_stats_t* sched_get_stats(const scheduler_t* sched, int task_id);
+
+/**
+ * @brief Print one line of statistics per task and reset the worst-case maxima
+ *
+ * @param sched Scheduler instance
+ */
+void sched_report(scheduler_t* sched);
+
+#endif // SCHEDULER_H
@@ -11,6 +11,7 @@
  *
  ******************************************************************************/
 #include "gpio.h"
+#include "hot_path.h"
 
 /**
  * @brief Configure a GPIO pin as input or output
@@ -55,7 +56,7 @@ void DEV_GPIO_INT(int32_t Pin, gpio_irq_callback_t isr_handler)
  * @param Pin GPIO pin number
  * @param Value Logic level: 0 for low, 1 for high
  */
-void DEV_Digital_Write(uint16_t Pin, uint8_t Value)
+void HOT_PATH_FUNC(DEV_Digital_Write)(uint16_t Pin, uint8_t Value)
 {
     gpio_put(Pin, Value); // Set the GPIO pin level
 }
@@ -68,7 +69,7 @@ void DEV_Digital_Write(uint16_t Pin, uint8_t Value)
  * @param Pin GPIO pin number
  * @return uint8_t Logic level: 0 for low, 1 for high
  */
-uint8_t DEV_Digital_Read(uint16_t Pin)
+uint8_t HOT_PATH_FUNC(DEV_Digital_Read)(uint16_t Pin)
 {
     return gpio_get(Pin); // Get the GPIO pin level
 }
@@ -40,6 +40,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include "wavesahre_lora_1121.h"
+#include "hot_path.h"
 
 /*!
  * @brief lr11xx_hal.h API implementation
@@ -55,10 +56,19 @@
  */
 static lr11xx_hal_status_t lr11xx_hal_wait_on_unbusy(const void *context, uint32_t timeout_ms);
 
-lr11xx_hal_status_t lr11xx_hal_write(const void *context, const uint8_t *command,
+/* Only touched from the core that owns the radio */
+static lora_hal_stats_t hal_stats = {0};
+
+void lora_hal_get_stats(lora_hal_stats_t *stats)
+{
+    *stats = hal_stats;
+}
+
+lr11xx_hal_status_t HOT_PATH_FUNC(lr11xx_hal_write)(const void *context, const uint8_t *command,
                                      const uint16_t command_length, const uint8_t *data,
                                      const uint16_t data_length)
 {
+    hal_stats.commands++;
 #if defined(USE_LR11XX_CRC_OVER_SPI)
     uint8_t cmd_crc = lr11xx_hal_compute_crc(0xFF, command, command_length);
     if (data_length > 0)
@@ -87,10 +97,11 @@ lr11xx_hal_status_t lr11xx_hal_write(const void *context, const uint8_t *command
     return LR11XX_HAL_STATUS_ERROR;
 }
 
-lr11xx_hal_status_t lr11xx_hal_read(const void *context, const uint8_t *command,
+lr11xx_hal_status_t HOT_PATH_FUNC(lr11xx_hal_read)(const void *context, const uint8_t *command,
                                     const uint16_t command_length, uint8_t *data,
                                     const uint16_t data_length)
 {
+    hal_stats.commands++;
 #if defined(USE_LR11XX_CRC_OVER_SPI)
     const uint8_t cmd_crc = lr11xx_hal_compute_crc(0xFF, command, command_length);
 #endif
@@ -144,9 +155,10 @@ lr11xx_hal_status_t lr11xx_hal_read(const void *context, const uint8_t *command,
     return LR11XX_HAL_STATUS_ERROR;
 }
 
-lr11xx_hal_status_t lr11xx_hal_direct_read(const void *context, uint8_t *data,
+lr11xx_hal_status_t HOT_PATH_FUNC(lr11xx_hal_direct_read)(const void *context, uint8_t *data,
                                            const uint16_t data_length)
 {
+    hal_stats.commands++;
     if (lr11xx_hal_wait_on_unbusy(context, 10000) == LR11XX_HAL_STATUS_OK)
     {
         /* NSS low */
@@ -183,8 +195,9 @@ lr11xx_hal_status_t lr11xx_hal_wakeup(const void *context)
     return LR11XX_HAL_STATUS_OK;
 }
 
-static lr11xx_hal_status_t lr11xx_hal_wait_on_unbusy(const void *context, uint32_t timeout_ms)
+static lr11xx_hal_status_t HOT_PATH_FUNC(lr11xx_hal_wait_on_unbusy)(const void *context, uint32_t timeout_ms)
 {
+    lr11xx_hal_status_t status = LR11XX_HAL_STATUS_OK;
 #if 0
      while( DEV_Digital_Read( ( ( lr1121_t* ) context )->busy ) == 1 )
      {
@@ -192,17 +205,25 @@ static lr11xx_hal_status_t lr11xx_hal_wait_on_unbusy(const void *context, uint32
      }
 #else
     absolute_time_t  start = get_absolute_time() ;
-    absolute_time_t  current = 0;
+    absolute_time_t  current = start;
     while (DEV_Digital_Read(((lr1121_t *)context)->busy) == 1)
     {
 
         current = get_absolute_time();
         if ((int32_t)(absolute_time_diff_us(start, current) / 1000) > (int32_t)timeout_ms)
         {
-            return LR11XX_HAL_STATUS_ERROR;
+            hal_stats.busy_timeouts++;
+            status = LR11XX_HAL_STATUS_ERROR;
+            break;
         }
     }
-    
+
+    uint32_t waited_us = (uint32_t)absolute_time_diff_us(start, current);
+    hal_stats.busy_wait_us += waited_us;
+    if (waited_us > hal_stats.busy_wait_max_us)
+    {
+        hal_stats.busy_wait_max_us = waited_us;
+    }
 #endif
-    return LR11XX_HAL_STATUS_OK;
+    return status;
 }
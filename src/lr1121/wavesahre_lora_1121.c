@@ -1,4 +1,5 @@
 #include "wavesahre_lora_1121.h"
+#include "hot_path.h"
 
 
 void lora_init_io_context(const void *context)
@@ -15,7 +16,12 @@ void lora_init_io_context(const void *context)
 
 void lora_init_io(const void *context)
 {
-    DEV_GPIO_Mode(((lr1121_t *)context)->reset, GPIO_OUT);
+    // Set NRESET high before it becomes an output: gpio_init() clears the
+    // output latch, and a low glitch would reset a radio that kept power
+    // through an MCU reset (see lora_system_init's warm start)
+    gpio_init(((lr1121_t *)context)->reset);
+    gpio_put(((lr1121_t *)context)->reset, 1);
+    gpio_set_dir(((lr1121_t *)context)->reset, GPIO_OUT);
     DEV_GPIO_Mode(((lr1121_t *)context)->cs, GPIO_OUT);
     DEV_GPIO_Mode(((lr1121_t *)context)->led, GPIO_OUT);
     DEV_GPIO_Mode(((lr1121_t *)context)->busy, GPIO_IN);
@@ -37,12 +43,12 @@ void lora_spi_init(const void* context)
     DEV_SPI_Init();
 }
 
-void lora_spi_write_bytes(const void* context,const uint8_t *wirte,const uint16_t wirte_length)
+void HOT_PATH_FUNC(lora_spi_write_bytes)(const void* context,const uint8_t *wirte,const uint16_t wirte_length)
 {
     DEV_SPI_Write_Bytes(wirte, wirte_length);
 }
 
-void lora_spi_read_bytes(const void* context, uint8_t *read,const uint16_t read_length)
+void HOT_PATH_FUNC(lora_spi_read_bytes)(const void* context, uint8_t *read,const uint16_t read_length)
 {
     DEV_SPI_Read_Bytes(read, read_length);
 }
@@ -50,6 +50,17 @@ typedef struct lr1121_s
     // spi_device_handle_t spi;
 } lr1121_t;
 
+/**
+ * @brief SPI command accounting kept by lr11xx_hal.c
+ */
+typedef struct
+{
+    uint32_t commands;          // lr11xx_hal_write/read/direct_read calls
+    uint32_t busy_timeouts;     // Commands abandoned because BUSY stayed high
+    uint64_t busy_wait_us;      // Total time spent in lr11xx_hal_wait_on_unbusy
+    uint32_t busy_wait_max_us;  // Longest single wait
+} lora_hal_stats_t;
+
 /**
  * @brief Initializes the radio I/Os pins context
  *
@@ -69,6 +80,13 @@ void lora_init_irq(const void *context, gpio_irq_callback_t handler);
 void lora_spi_init(const void* context);
 void lora_spi_write_bytes(const void* context,const uint8_t *wirte,const uint16_t wirte_length);
 void lora_spi_read_bytes(const void* context, uint8_t *read,const uint16_t read_length);
+
+/**
+ * @brief Get a copy of the HAL SPI command counters
+ *
+ * @param [out] stats Structure to fill
+ */
+void lora_hal_get_stats(lora_hal_stats_t* stats);
 /**
  * @brief Flush the modem event queue
  *
@@ -27,22 +27,28 @@
 # THE SOFTWARE.
 ******************************************************************************/
 #include "DEV_Config.h"
+#include "hot_path.h"
 #include "gpio.h"
+#include "pico/mutex.h"
 
 #define SPI_PORT spi0
 #define I2C_PORT spi1
 
 uint slice_num;
 
+// Both MCP2515s share spi0; a driver call holds the bus for its whole
+// register sequence so transfers to the two controllers never interleave
+auto_init_mutex(spi_mutex);
+
 /**
  * SPI
 **/
-void DEV_SPI_WriteByte(uint8_t Value)
+void HOT_PATH_FUNC(DEV_SPI_WriteByte)(uint8_t Value)
 {
     spi_write_blocking(SPI_PORT, &Value, 1);
 }
 
-uint8_t DEV_SPI_ReadByte(void)
+uint8_t HOT_PATH_FUNC(DEV_SPI_ReadByte)(void)
 {
     uint8_t buf[1];
     // buf[0] = Value;
@@ -51,11 +57,21 @@ uint8_t DEV_SPI_ReadByte(void)
 }
 
 
-void DEV_SPI_Write_nByte(uint8_t pData[], uint32_t Len)
+void HOT_PATH_FUNC(DEV_SPI_Write_nByte)(uint8_t pData[], uint32_t Len)
 {
     spi_write_blocking(SPI_PORT, pData, Len);
 }
 
+void HOT_PATH_FUNC(DEV_SPI_Lock)(void)
+{
+    mutex_enter_blocking(&spi_mutex);
+}
+
+void HOT_PATH_FUNC(DEV_SPI_Unlock)(void)
+{
+    mutex_exit(&spi_mutex);
+}
+
 
 
 /**
@@ -98,7 +114,8 @@ void DEV_Delay_us(UDOUBLE xus)
 
 void DEV_GPIO_Init(void)
 {
-    DEV_GPIO_Mode(MCP2515_CS_PIN, 1);
+    DEV_GPIO_Mode(MCP2515_CS0_PIN, 1);
+    DEV_GPIO_Mode(MCP2515_CS1_PIN, 1);
     // DEV_GPIO_Mode(LCD_DC_PIN, 1);
     // DEV_GPIO_Mode(LCD_CS_PIN, 1);
     // DEV_GPIO_Mode(LCD_BL_PIN, 1);
@@ -107,7 +124,9 @@ void DEV_GPIO_Init(void)
     // DEV_GPIO_Mode(LCD_CS_PIN, 1);
     // DEV_GPIO_Mode(LCD_BL_PIN, 1);
 
-    DEV_Digital_Write(MCP2515_CS_PIN, 1);
+    // Deselect both controllers before the first transfer, even if only one is fitted
+    DEV_Digital_Write(MCP2515_CS0_PIN, 1);
+    DEV_Digital_Write(MCP2515_CS1_PIN, 1);
     // DEV_Digital_Write(LCD_DC_PIN, 0);
     // DEV_Digital_Write(LCD_BL_PIN, 1);
 }
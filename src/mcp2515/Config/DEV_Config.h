@@ -52,9 +52,12 @@
 #define SPI_CLK_PIN  6
 #define SPI_MOSI_PIN 7
 #define SPI_MISO_PIN 4
-#define MCP2515_CS0_PIN  5
-#define MCP2515_CS1_PIN  1
+#define MCP2515_CS0_PIN  5    // ECU bus controller
+#define MCP2515_CS1_PIN  17   // Chassis bus controller (GPIO 1 is the GPS UART RX)
 #define MCP2515_CS_PIN  MCP2515_CS0_PIN
+#define MCP2515_INT_PIN  20   // MCP2515 INT output (active low, open drain)
+#define MCP2515_INT0_PIN MCP2515_INT_PIN
+#define MCP2515_INT1_PIN 21   // Chassis bus controller INT
 /*------------------------------------------------------------------------------------------------------*/
 void DEV_Digital_Write(UWORD Pin, UBYTE Value);
 UBYTE DEV_Digital_Read(UWORD Pin);
@@ -67,6 +70,8 @@ UBYTE DEV_Digital_Read(UWORD Pin);
 void DEV_SPI_WriteByte(UBYTE Value);
 uint8_t DEV_SPI_ReadByte(void);
 void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len);
+void DEV_SPI_Lock(void);
+void DEV_SPI_Unlock(void);
 
 void DEV_Delay_ms(UDOUBLE xms);
 void DEV_Delay_us(UDOUBLE xus);
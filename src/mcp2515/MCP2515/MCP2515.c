@@ -10,43 +10,78 @@
  * -----------------------------------------------------------------------------
  ******************************************************************************/
 #include "MCP2515.h"
+#include "hot_path.h"
 #include "DEV_Config.h"
+#include "Debug.h"
 #include "pico/time.h"
 // #include "Log_debug.h"
 
-static void MCP2515_WriteByte(uint8_t Addr)
+const MCP2515_Dev MCP2515_DEV0 = { MCP2515_CS0_PIN, MCP2515_INT0_PIN };
+const MCP2515_Dev MCP2515_DEV1 = { MCP2515_CS1_PIN, MCP2515_INT1_PIN };
+
+// Per controller: RXB1 holds an older frame than RXB0 (MCP2515_Dev_Receive_Fast)
+static bool rxb1_older[2];
+
+static bool *MCP2515_Rxb1_Older(const MCP2515_Dev *dev)
+{
+    return &rxb1_older[dev == &MCP2515_DEV1];
+}
+
+// Register helpers; callers hold the SPI lock (DEV_SPI_Lock)
+static void HOT_PATH_FUNC(MCP2515_WriteByte)(const MCP2515_Dev *dev, uint8_t Addr)
 {
-    DEV_Digital_Write(MCP2515_CS_PIN, 0);
+    DEV_Digital_Write(dev->cs_pin, 0);
     DEV_SPI_WriteByte(Addr);
-    DEV_Digital_Write(MCP2515_CS_PIN, 1);
+    DEV_Digital_Write(dev->cs_pin, 1);
 }
 
-static void MCP2515_WriteBytes(uint8_t Addr, uint8_t Data)
+static void HOT_PATH_FUNC(MCP2515_WriteBytes)(const MCP2515_Dev *dev, uint8_t Addr, uint8_t Data)
 {
-    DEV_Digital_Write(MCP2515_CS_PIN, 0);
+    DEV_Digital_Write(dev->cs_pin, 0);
     DEV_SPI_WriteByte(CAN_WRITE);
     DEV_SPI_WriteByte(Addr);
     DEV_SPI_WriteByte(Data);
-    DEV_Digital_Write(MCP2515_CS_PIN, 1);
+    DEV_Digital_Write(dev->cs_pin, 1);
 }
 
-static uint8_t MCP2515_ReadByte(uint8_t Addr)
+static uint8_t HOT_PATH_FUNC(MCP2515_ReadByte)(const MCP2515_Dev *dev, uint8_t Addr)
 {
     uint8_t rdata;
-    DEV_Digital_Write(MCP2515_CS_PIN, 0);
+    DEV_Digital_Write(dev->cs_pin, 0);
     DEV_SPI_WriteByte(CAN_READ);
     DEV_SPI_WriteByte(Addr);
     rdata = DEV_SPI_ReadByte();
-    DEV_Digital_Write(MCP2515_CS_PIN, 1);
+    DEV_Digital_Write(dev->cs_pin, 1);
 
     return rdata;
 }
 
+static void HOT_PATH_FUNC(MCP2515_ReadBytes)(const MCP2515_Dev *dev, uint8_t Addr, uint8_t *Buf, uint8_t len)
+{
+    DEV_Digital_Write(dev->cs_pin, 0);
+    DEV_SPI_WriteByte(CAN_READ);
+    DEV_SPI_WriteByte(Addr);
+    for (uint8_t i = 0; i < len; i++) {
+        Buf[i] = DEV_SPI_ReadByte();
+    }
+    DEV_Digital_Write(dev->cs_pin, 1);
+}
+
+static void HOT_PATH_FUNC(MCP2515_BitModify)(const MCP2515_Dev *dev, uint8_t Addr, uint8_t Mask, uint8_t Data)
+{
+    DEV_Digital_Write(dev->cs_pin, 0);
+    DEV_SPI_WriteByte(CAN_BIT_MODIFY);
+    DEV_SPI_WriteByte(Addr);
+    DEV_SPI_WriteByte(Mask);
+    DEV_SPI_WriteByte(Data);
+    DEV_Digital_Write(dev->cs_pin, 1);
+}
+
 void MCP2515_Reset(void)
 {
-    DEV_Digital_Write(MCP2515_CS_PIN, 0);
-    DEV_SPI_WriteByte(CAN_RESET);
-    DEV_Digital_Write(MCP2515_CS_PIN, 1);
+    DEV_SPI_Lock();
+    MCP2515_WriteByte(&MCP2515_DEV0, CAN_RESET);
+    DEV_SPI_Unlock();
 }
 
 uint8_t CAN_RATE[10][3] = {
@@ -61,13 +96,10 @@ uint8_t CAN_RATE[10][3] = {
     {0x00, 0x92, 0x02}, 
     {0x00, 0x82, 0x02}};
 
-void MCP2515_Init(void)
+// Load the bit timing, RX setup and interrupts after a reset and request
+// an operating mode (REQOP_NORMAL / REQOP_LISTEN). Caller holds the SPI lock.
+static void MCP2515_Configure(const MCP2515_Dev *dev, enum RATEBPS rate, uint8_t reqop)
 {
-    printf("MCP2515 Init\r\n");
-    // LOG_INFO("Reset");
-    MCP2515_Reset();
-    DEV_Delay_ms(100);
-
     // #set baud rate 1000Kbps
     // #<7:6>SJW=00(1TQ)
     // #<5:0>BRP=0x03(TQ=[2*(BRP+1)]/Fsoc=2*4/8M=1us)
@@ -75,68 +107,185 @@ void MCP2515_Init(void)
     // # MCP2515_WriteBytes(CNF1, 7)
     // # MCP2515_WriteBytes(CNF2,0x80|PHSEG1_3TQ|PRSEG_1TQ)
     // # MCP2515_WriteBytes(CNF3,PHSEG2_3TQ)
-    MCP2515_WriteBytes(CNF1, CAN_RATE[KBPS1000][0]);
-    MCP2515_WriteBytes(CNF2, CAN_RATE[KBPS1000][1]);
-    MCP2515_WriteBytes(CNF3, CAN_RATE[KBPS1000][2]);
-    // MCP2515_WriteBytes
-    // MCP2515_WriteBytes
+    MCP2515_WriteBytes(dev, CNF1, CAN_RATE[rate][0]);
+    MCP2515_WriteBytes(dev, CNF2, CAN_RATE[rate][1]);
+    MCP2515_WriteBytes(dev, CNF3, CAN_RATE[rate][2]);
 
     // #set TXB0,TXB1
     // #<15:5> SID 11bit canid
     // #<BIT3> exide,1:extended 0:standard
-    MCP2515_WriteBytes(TXB0SIDH, 0xFF);
-    MCP2515_WriteBytes(TXB0SIDL, 0xE0);
-    MCP2515_WriteBytes(TXB0DLC, 0x40 | DLC_8);
-    // # MCP2515_WriteBytes(TXB1SIDH,0x50)
-    // # MCP2515_WriteBytes(TXB1SIDL,0x00)
-    // # MCP2515_WriteBytes(TXB1DLC,0x40 | DLC_8)    #Set DLC = 3 bytes and RTR bit*/
+    MCP2515_WriteBytes(dev, TXB0SIDH, 0xFF);
+    MCP2515_WriteBytes(dev, TXB0SIDL, 0xE0);
+    MCP2515_WriteBytes(dev, TXB0DLC, 0x40 | DLC_8);
 
     // #Set RX
-    MCP2515_WriteBytes(RXB0SIDH, 0x00);
-    MCP2515_WriteBytes(RXB0SIDL, 0x60);
-    MCP2515_WriteBytes(RXB0CTRL, 0x60);
-    MCP2515_WriteBytes(RXB0DLC, DLC_8);
+    MCP2515_WriteBytes(dev, RXB0SIDH, 0x00);
+    MCP2515_WriteBytes(dev, RXB0SIDL, 0x60);
+    // Any message; a frame that finds RXB0 full rolls over into RXB1
+    MCP2515_WriteBytes(dev, RXB0CTRL, 0x60 | BUKT_ROLLOVER);
+    MCP2515_WriteBytes(dev, RXB0DLC, DLC_8);
 
-    MCP2515_WriteBytes(RXF0SIDH, 0xFF);
-    MCP2515_WriteBytes(RXF0SIDL, 0xE0);
-    MCP2515_WriteBytes(RXM0SIDH, 0xFF);
-    MCP2515_WriteBytes(RXM0SIDL, 0xE0);
+    MCP2515_WriteBytes(dev, RXF0SIDH, 0xFF);
+    MCP2515_WriteBytes(dev, RXF0SIDL, 0xE0);
+    MCP2515_WriteBytes(dev, RXM0SIDH, 0xFF);
+    MCP2515_WriteBytes(dev, RXM0SIDL, 0xE0);
 
     // #can int
-    MCP2515_WriteBytes(CANINTF, 0x00);  // clean interrupt flag
-    MCP2515_WriteBytes(CANINTE, 0x01);  // Receive Buffer 0 Full Interrupt Enable Bit
+    MCP2515_WriteBytes(dev, CANINTF, 0x00);  // clean interrupt flag
+    *MCP2515_Rxb1_Older(dev) = false;
+    MCP2515_WriteBytes(dev, CANINTE, RX0IE | RX1IE);  // Receive Buffer 0/1 Full Interrupt Enable Bits (drive INT pin)
 
-    MCP2515_WriteBytes(CANCTRL, REQOP_NORMAL | CLKOUT_ENABLED);
+    MCP2515_WriteBytes(dev, CANCTRL, reqop | CLKOUT_ENABLED);
 
-    uint8_t dummy = MCP2515_ReadByte(CANSTAT);
-    if ((dummy&0xe0) != OPMODE_NORMAL) {
-        printf("OPMODE_NORMAL\r\n");
-        MCP2515_WriteBytes(CANCTRL, REQOP_NORMAL | CLKOUT_ENABLED);  // #set normal mode
+    uint8_t dummy = MCP2515_ReadByte(dev, CANSTAT);
+    if ((dummy&0xe0) != reqop) {
+        Debug("OPMODE 0x%02x\r\n", reqop);
+        MCP2515_WriteBytes(dev, CANCTRL, reqop | CLKOUT_ENABLED);  // #set requested mode
+    }
+}
+
+// Poll CANSTAT (50 us apart) until a reset controller reports configuration
+// mode. Caller holds the SPI lock; it is released between polls.
+static int8_t MCP2515_Await_Config(const MCP2515_Dev *dev, uint16_t max_polls)
+{
+    uint16_t polls = 0;
+    while ((MCP2515_ReadByte(dev, CANSTAT) & 0xE0) != OPMODE_CONFIG) {
+        if (++polls > max_polls) {
+            return -1;
+        }
+        DEV_SPI_Unlock();
+        DEV_Delay_us(50);
+        DEV_SPI_Lock();
+    }
+    return 0;
+}
+
+int8_t MCP2515_Dev_Init(const MCP2515_Dev *dev, enum RATEBPS rate)
+{
+    printf("MCP2515 Init (CS %d)\r\n", dev->cs_pin);
+    // LOG_INFO("Reset");
+    DEV_SPI_Lock();
+    MCP2515_WriteByte(dev, CAN_RESET);
+
+    // A controller comes out of reset in configuration mode; polling for it
+    // covers the oscillator start-up after power-on without a fixed 100 ms
+    // delay. Never reaching it means nothing is driving MISO for this chip select
+    if (MCP2515_Await_Config(dev, MCP2515_INIT_POLLS) != 0) {
+        DEV_SPI_Unlock();
+        printf("MCP2515 (CS %d) not responding\r\n", dev->cs_pin);
+        return -1;
     }
 
+    MCP2515_Configure(dev, rate, REQOP_NORMAL);
+    DEV_SPI_Unlock();
+
     printf("MCP2515 Init Complete\r\n");
+    return 0;
 }
 
-void MCP2515_Send(uint32_t Canid, uint8_t *Buf, uint8_t len)
+// SPI reset, then configure for reqop; 0 once the controller reports that mode
+static int8_t MCP2515_Restart(const MCP2515_Dev *dev, enum RATEBPS rate, uint8_t reqop)
+{
+    DEV_SPI_Lock();
+    MCP2515_WriteByte(dev, CAN_RESET);
+
+    // The oscillator is already running, so the reset completes in 128
+    // OSC1 cycles
+    if (MCP2515_Await_Config(dev, MCP2515_REINIT_POLLS) != 0) {
+        DEV_SPI_Unlock();
+        return -1;
+    }
+
+    MCP2515_Configure(dev, rate, reqop);
+    uint8_t opmode = MCP2515_ReadByte(dev, CANSTAT) & 0xE0;
+    DEV_SPI_Unlock();
+
+    return opmode == reqop ? 0 : -1;
+}
+
+int8_t MCP2515_Dev_Reinit(const MCP2515_Dev *dev, enum RATEBPS rate)
 {
+    return MCP2515_Restart(dev, rate, REQOP_NORMAL);
+}
+
+int8_t MCP2515_Dev_Listen(const MCP2515_Dev *dev, enum RATEBPS rate)
+{
+    return MCP2515_Restart(dev, rate, REQOP_LISTEN);
+}
+
+int8_t MCP2515_Dev_Take_Error(const MCP2515_Dev *dev)
+{
+    DEV_SPI_Lock();
+    int8_t error = (MCP2515_ReadByte(dev, CANINTF) & MERRF) ? 1 : 0;
+    if (error) {
+        MCP2515_BitModify(dev, CANINTF, MERRF, 0x00);
+    }
+    DEV_SPI_Unlock();
+
+    return error;
+}
+
+int8_t MCP2515_Dev_Read_Status(const MCP2515_Dev *dev, MCP2515_Status *status)
+{
+    uint8_t counters[2];
+
+    DEV_SPI_Lock();
+    MCP2515_ReadBytes(dev, TEC, counters, 2);       // TEC, REC
+    status->eflg = MCP2515_ReadByte(dev, EFLG);
+    status->canstat = MCP2515_ReadByte(dev, CANSTAT);
+    DEV_SPI_Unlock();
+
+    status->tec = counters[0];
+    status->rec = counters[1];
+
+    // MISO floats high with no controller answering
+    return status->canstat == 0xFF ? -1 : 0;
+}
+
+void MCP2515_Dev_Clear_Overflow(const MCP2515_Dev *dev)
+{
+    DEV_SPI_Lock();
+    MCP2515_BitModify(dev, EFLG, RX0OVR | RX1OVR, 0x00);
+    MCP2515_BitModify(dev, CANINTF, ERRIF | MERRF, 0x00);
+    DEV_SPI_Unlock();
+}
+
+void MCP2515_Init(void)
+{
+    MCP2515_Dev_Init(&MCP2515_DEV0, KBPS1000);
+}
+
+void HOT_PATH_FUNC(MCP2515_Dev_Send)(const MCP2515_Dev *dev, uint32_t Canid, uint8_t *Buf, uint8_t len)
+{
+    DEV_SPI_Lock();
+
     // uint8_t tempdata = MCP2515_ReadByte(CAN_RD_STATUS);
     uint8_t dly = 0;
-    while((MCP2515_ReadByte(TXB0CTRL)&0x08) && (dly<50)) { 
+    while((MCP2515_ReadByte(dev, TXB0CTRL)&0x08) && (dly<50)) { 
+        DEV_SPI_Unlock();
         DEV_Delay_ms(1);
+        DEV_SPI_Lock();
         dly++;
     }
 
-    MCP2515_WriteBytes(TXB0SIDH, (Canid >> 3) & 0XFF);
-    MCP2515_WriteBytes(TXB0SIDL, (Canid & 0x07) << 5);
+    MCP2515_WriteBytes(dev, TXB0SIDH, (Canid >> 3) & 0XFF);
+    MCP2515_WriteBytes(dev, TXB0SIDL, (Canid & 0x07) << 5);
 
-    MCP2515_WriteBytes(TXB0EID8, 0);
-    MCP2515_WriteBytes(TXB0EID0, 0);
-    MCP2515_WriteBytes(TXB0DLC, len);
+    MCP2515_WriteBytes(dev, TXB0EID8, 0);
+    MCP2515_WriteBytes(dev, TXB0EID0, 0);
+    MCP2515_WriteBytes(dev, TXB0DLC, len);
 
     for (uint8_t j = 0; j < len; j++) {
-        MCP2515_WriteBytes(TXB0D0 + j, Buf[j]);
+        MCP2515_WriteBytes(dev, TXB0D0 + j, Buf[j]);
     }
-    MCP2515_WriteBytes(TXB0CTRL, 0x08);
+    MCP2515_WriteBytes(dev, TXB0CTRL, 0x08);
+
+    DEV_SPI_Unlock();
+}
+
+void MCP2515_Send(uint32_t Canid, uint8_t *Buf, uint8_t len)
+{
+    MCP2515_Dev_Send(&MCP2515_DEV0, Canid, Buf, len);
 }
 
 /**
@@ -148,8 +297,11 @@ void MCP2515_Send(uint32_t Canid, uint8_t *Buf, uint8_t len)
  */
 int8_t MCP2515_Receive(uint32_t Canid, uint8_t *CAN_RX_Buf, uint32_t timeout_ms)
 {
-	MCP2515_WriteBytes(RXB0SIDH, (Canid>>3)&0XFF);
-	MCP2515_WriteBytes(RXB0SIDL, (Canid&0x07)<<5);
+	const MCP2515_Dev *dev = &MCP2515_DEV0;
+
+	DEV_SPI_Lock();
+	MCP2515_WriteBytes(dev, RXB0SIDH, (Canid>>3)&0XFF);
+	MCP2515_WriteBytes(dev, RXB0SIDL, (Canid&0x07)<<5);
 	
 	uint32_t start_time = to_ms_since_boot(get_absolute_time());
 	
@@ -159,50 +311,61 @@ int8_t MCP2515_Receive(uint32_t Canid, uint8_t *CAN_RX_Buf, uint32_t timeout_ms)
 			uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - start_time;
 			if(elapsed >= timeout_ms) {
 				printf("CAN RX timeout: no message after %lu ms\r\n", timeout_ms);
+				DEV_SPI_Unlock();
 				return 1;  // Timeout
 			}
 		}
 		
 		// Check for receive interrupt flag
-		if(MCP2515_ReadByte(CANINTF) & 0x01){
-			uint8_t len = MCP2515_ReadByte(RXB0DLC);
+		if(MCP2515_ReadByte(dev, CANINTF) & 0x01){
+			uint8_t len = MCP2515_ReadByte(dev, RXB0DLC);
 			// printf("len = %d\r\n", len);
 			for(uint8_t i=0; i<len; i++){
-				CAN_RX_Buf[i] = MCP2515_ReadByte(RXB0D0+i);
+				CAN_RX_Buf[i] = MCP2515_ReadByte(dev, RXB0D0+i);
 				// printf("rx buf =%d\r\n",CAN_RX_Buf[i]);
 			}
 			
-			MCP2515_WriteBytes(CANINTF, 0);
-			MCP2515_WriteBytes(CANINTE,0x01);//enable
-			MCP2515_WriteBytes(RXB0SIDH,0x00);//clean
-			MCP2515_WriteBytes(RXB0SIDL,0x60);
+			MCP2515_WriteBytes(dev, CANINTF, 0);
+			MCP2515_WriteBytes(dev, CANINTE,0x01);//enable
+			MCP2515_WriteBytes(dev, RXB0SIDH,0x00);//clean
+			MCP2515_WriteBytes(dev, RXB0SIDL,0x60);
+			DEV_SPI_Unlock();
 			return 0;  // Success
 		}
 		
-		// Yield to prevent watchdog timeout
+		// Yield to prevent watchdog timeout (and let the other controller use the bus)
+		DEV_SPI_Unlock();
 		sleep_ms(1);
+		DEV_SPI_Lock();
 	}
 }
 
-int8_t MCP2515_Receive_Fast(uint32_t *frame_id, uint8_t *CAN_RX_Buf)
+int8_t HOT_PATH_FUNC(MCP2515_Dev_Receive_Fast)(const MCP2515_Dev *dev, uint32_t *frame_id, uint8_t *CAN_RX_Buf)
 {
+    DEV_SPI_Lock();
+
     // 1. Read Interrupt Flag to see which buffer has data
-    uint8_t status = MCP2515_ReadByte(0x2C); // CANINTF is 0x2C
+    uint8_t status = MCP2515_ReadByte(dev, CANINTF);
     
+    // A frame only rolls over into RXB1 while RXB0 is full, so RXB0 holds
+    // the older frame until it is read. After that RXB0 refills behind the
+    // frame waiting in RXB1, which has to come out first.
+    bool *rxb1_first = MCP2515_Rxb1_Older(dev);
     uint8_t rx_base;
-    if (status & 0x01) {
-        rx_base = 0x61; // RXB0SIDH
-    } else if (status & 0x02) {
-        rx_base = 0x71; // RXB1SIDH
+    if ((status & RX1IF) && (*rxb1_first || !(status & RX0IF))) {
+        rx_base = RXB1SIDH;
+    } else if (status & RX0IF) {
+        rx_base = RXB0SIDH;
     } else {
+        DEV_SPI_Unlock();
         return -1; // No data waiting, exit instantly
     }
 
     // 2. Read ID Registers
-    uint8_t sidh = MCP2515_ReadByte(rx_base);
-    uint8_t sidl = MCP2515_ReadByte(rx_base + 1);
-    uint8_t eid8 = MCP2515_ReadByte(rx_base + 2);
-    uint8_t eid0 = MCP2515_ReadByte(rx_base + 3);
+    uint8_t sidh = MCP2515_ReadByte(dev, rx_base);
+    uint8_t sidl = MCP2515_ReadByte(dev, rx_base + 1);
+    uint8_t eid8 = MCP2515_ReadByte(dev, rx_base + 2);
+    uint8_t eid0 = MCP2515_ReadByte(dev, rx_base + 3);
 
     // 3. Reconstruct ID based on Standard (11-bit) vs Extended (29-bit)
     if (sidl & 0x08) { 
@@ -216,20 +379,31 @@ int8_t MCP2515_Receive_Fast(uint32_t *frame_id, uint8_t *CAN_RX_Buf)
     }
 
     // 4. Read DLC (Data Length Code)
-    uint8_t len = MCP2515_ReadByte(rx_base + 4) & 0x0F;
+    uint8_t len = MCP2515_ReadByte(dev, rx_base + 4) & 0x0F;
     if(len > 8) len = 8;
 
     // 5. Read Payload
     for(uint8_t i = 0; i < len; i++){
-        CAN_RX_Buf[i] = MCP2515_ReadByte(rx_base + 5 + i);
+        CAN_RX_Buf[i] = MCP2515_ReadByte(dev, rx_base + 5 + i);
     }
     
-    // 6. Clear the specific interrupt flag
-    if (rx_base == 0x61) {
-        MCP2515_WriteBytes(0x2C, status & ~0x01); // Clear RX0IF
+    // 6. Clear only this buffer's flag: writing back `status` would also
+    // clear an RX1IF, ERRIF or MERRF that was set during the reads
+    MCP2515_BitModify(dev, CANINTF, rx_base == RXB0SIDH ? RX0IF : RX1IF, 0x00);
+
+    // RXB1 may have filled during the reads; CANINTF after the clear is
+    // exact, since RXB1 cannot fill again until RXB0 has
+    if (rx_base == RXB0SIDH) {
+        *rxb1_first = (status & RX1IF) || (MCP2515_ReadByte(dev, CANINTF) & RX1IF);
     } else {
-        MCP2515_WriteBytes(0x2C, status & ~0x02); // Clear RX1IF
+        *rxb1_first = false;
     }
 
-    return 0; // Success
+    DEV_SPI_Unlock();
+    return (int8_t)len;
+}
+
+int8_t MCP2515_Receive_Fast(uint32_t *frame_id, uint8_t *CAN_RX_Buf)
+{
+    return MCP2515_Dev_Receive_Fast(&MCP2515_DEV0, frame_id, CAN_RX_Buf) < 0 ? -1 : 0;
 }
\ No newline at end of file
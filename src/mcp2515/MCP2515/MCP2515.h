@@ -189,6 +189,16 @@
 #define WAKIF         0x40
 #define MERRF         0x80
 
+// # ## EFLG */
+#define EWARN         0x01
+#define RXWAR         0x02
+#define TXWAR         0x04
+#define RXEP          0x08
+#define TXEP          0x10
+#define TXBO          0x20
+#define RX0OVR        0x40
+#define RX1OVR        0x80
+
 // # ## BFPCTRL */
 #define B1BFS         0x20
 #define B0BFS         0x10
@@ -404,6 +414,96 @@ function:
 ********************************************************************************/
 
 enum RATEBPS {KBPS5 = 0, KBPS10, KBPS20, KBPS50, KBPS100, KBPS125, KBPS250, KBPS500, KBPS800, KBPS1000 };
+
+/**
+ * One MCP2515 on the shared spi0 bus
+ */
+typedef struct {
+    uint8_t cs_pin;     // Chip select (active low)
+    uint8_t int_pin;    // INT output (active low)
+} MCP2515_Dev;
+
+/**
+ * Error state snapshot (MCP2515_Dev_Read_Status)
+ */
+typedef struct {
+    uint8_t tec;        // Transmit error counter
+    uint8_t rec;        // Receive error counter
+    uint8_t eflg;       // EFLG: warning/passive/bus-off and RX overflow bits
+    uint8_t canstat;    // CANSTAT: OPMOD in bits 7:5
+} MCP2515_Status;
+
+// CANSTAT polls (50 us apart) MCP2515_Dev_Reinit waits for the reset
+#define MCP2515_REINIT_POLLS  40
+// Same for MCP2515_Dev_Init, which may run while the oscillator is still starting
+#define MCP2515_INIT_POLLS    400
+
+// Controller behind the legacy single-device calls (CS0 / INT0)
+extern const MCP2515_Dev MCP2515_DEV0;
+// Second controller on the shared bus (CS1 / INT1)
+extern const MCP2515_Dev MCP2515_DEV1;
+
+/**
+ * @brief Reset and configure one controller for normal mode
+ * @param dev Controller to configure
+ * @param rate Bit rate
+ * @return 0 on success, -1 if the controller did not answer (not fitted)
+ */
+int8_t MCP2515_Dev_Init(const MCP2515_Dev *dev, enum RATEBPS rate);
+
+/**
+ * @brief Fast recovery: SPI reset and reload the configuration, no oscillator start-up wait
+ *
+ * Clears TEC/REC, EFLG and both RX buffers. Use on a controller that has
+ * already been through MCP2515_Dev_Init (oscillator running).
+ * @return 0 if the controller is back in normal mode, -1 otherwise
+ */
+int8_t MCP2515_Dev_Reinit(const MCP2515_Dev *dev, enum RATEBPS rate);
+
+/**
+ * @brief Fast restart in listen-only mode at a trial bit rate
+ *
+ * Same reset as MCP2515_Dev_Reinit. The controller never drives the bus
+ * (no ACK, no error frames), so a wrong rate cannot disturb other nodes;
+ * frames received with a bad CRC, stuffing or form set MERRF instead.
+ * @return 0 if the controller is in listen-only mode, -1 otherwise
+ */
+int8_t MCP2515_Dev_Listen(const MCP2515_Dev *dev, enum RATEBPS rate);
+
+/**
+ * @brief Test and clear the message error flag (CANINTF.MERRF)
+ * @return 1 if a bus error was seen since the last call, 0 otherwise
+ */
+int8_t MCP2515_Dev_Take_Error(const MCP2515_Dev *dev);
+
+/**
+ * @brief Read TEC, REC, EFLG and CANSTAT
+ * @return 0 on success, -1 if the controller does not answer (CANSTAT 0xFF)
+ */
+int8_t MCP2515_Dev_Read_Status(const MCP2515_Dev *dev, MCP2515_Status *status);
+
+/**
+ * @brief Clear the latched RX0OVR/RX1OVR flags (and ERRIF/MERRF)
+ */
+void MCP2515_Dev_Clear_Overflow(const MCP2515_Dev *dev);
+
+/**
+ * @brief Send a standard-ID frame from TXB0
+ */
+void MCP2515_Dev_Send(const MCP2515_Dev *dev, uint32_t Canid, uint8_t *Buf, uint8_t len);
+
+/**
+ * @brief Fast, non-blocking read of ANY available CAN message in either buffer
+ *
+ * Frames come out in arrival order: RXB1 (rollover) is read before RXB0
+ * when it holds the older frame.
+ * @param dev Controller to read
+ * @param frame_id Pointer to store the decoded 11/29-bit ID
+ * @param CAN_RX_Buf Buffer to store the up-to-8 byte payload
+ * @return Payload length (0-8) if a message was read, -1 if buffers are empty
+ */
+int8_t MCP2515_Dev_Receive_Fast(const MCP2515_Dev *dev, uint32_t *frame_id, uint8_t *CAN_RX_Buf);
+
 void MCP2515_Init(void);
 void MCP2515_Send(uint32_t Canid, uint8_t *Buf, uint8_t len);
 /**
@@ -0,0 +1,99 @@
+/**
+ * @file      tdma.c
+ * @brief     GPS-synchronised TDMA slot implementation
+ */
+
+#include "tdma.h"
+
+// Timer drift accumulated over the holdover time, added to every guard
+#define HOLDOVER_DRIFT_US   ((uint32_t)(TDMA_HOLDOVER_US / 1000000 * TDMA_DRIFT_PPM))
+
+// a - b on the time-of-day circle, in [-day/2, day/2)
+static int64_t day_diff(uint64_t a, uint64_t b) {
+    int64_t d = (int64_t)((a + TDMA_DAY_US - b) % TDMA_DAY_US);
+    return d >= (int64_t)(TDMA_DAY_US / 2) ? d - (int64_t)TDMA_DAY_US : d;
+}
+
+static uint64_t day_add(uint64_t a, int64_t delta) {
+    return (uint64_t)((int64_t)a + delta + (int64_t)TDMA_DAY_US) % TDMA_DAY_US;
+}
+
+// Position of now inside the frame, in UTC
+static uint32_t frame_phase(const tdma_plan_t* plan, const tdma_clock_t* clock, uint64_t now_us) {
+    uint64_t utc_us = (now_us % TDMA_DAY_US + clock->offset_us) % TDMA_DAY_US;
+    return (uint32_t)(utc_us % plan->frame_us);
+}
+
+bool tdma_plan_init(tdma_plan_t* plan, uint8_t node_id, uint8_t num_nodes, uint32_t frame_us,
+                    uint32_t sync_error_us, uint32_t max_packet_us) {
+    if (num_nodes == 0 || num_nodes > TDMA_MAX_NODES || node_id >= num_nodes ||
+        frame_us == 0 || TDMA_DAY_US % frame_us != 0) {
+        return false;
+    }
+
+    plan->node_id = node_id;
+    plan->num_nodes = num_nodes;
+    plan->frame_us = frame_us;
+    plan->slot_us = frame_us / num_nodes;
+    plan->guard_us = sync_error_us + HOLDOVER_DRIFT_US;
+    return (uint64_t)max_packet_us + 2u * plan->guard_us <= plan->slot_us;
+}
+
+void tdma_clock_update(tdma_clock_t* clock, uint32_t utc_ms_of_day, uint64_t local_us,
+                       tdma_sync_source_t source) {
+    uint64_t utc_us = (uint64_t)utc_ms_of_day * 1000u % TDMA_DAY_US;
+    uint64_t sample = (utc_us + TDMA_DAY_US - local_us % TDMA_DAY_US) % TDMA_DAY_US;
+
+    if (!clock->locked || source != clock->source) {
+        if (clock->locked) {
+            clock->relocks++;
+        }
+        clock->offset_us = sample;
+        clock->source = source;
+        clock->locked = true;
+        clock->outliers = 0;
+        clock->last_ref_us = local_us;
+        return;
+    }
+
+    int64_t err = day_diff(sample, clock->offset_us);
+    if (err > TDMA_RELOCK_US || err < -TDMA_RELOCK_US) {
+        // One bad sentence is ignored; a persistent step means the clock moved
+        if (++clock->outliers >= TDMA_RELOCK_SAMPLES) {
+            clock->locked = false;
+            tdma_clock_update(clock, utc_ms_of_day, local_us, source);
+        }
+        return;
+    }
+
+    // A reference that arrives early (err > 0) had less output latency:
+    // follow it quickly, and late ones slowly enough to track drift
+    clock->outliers = 0;
+    clock->offset_us = day_add(clock->offset_us, err > 0 ? err / 2 : err / 16);
+    clock->last_ref_us = local_us;
+}
+
+bool tdma_clock_synced(const tdma_clock_t* clock, uint64_t now_us) {
+    return clock->locked && (int64_t)(now_us - clock->last_ref_us) <= TDMA_HOLDOVER_US;
+}
+
+uint64_t tdma_next_window(const tdma_plan_t* plan, const tdma_clock_t* clock, uint64_t now_us) {
+    uint32_t open = plan->node_id * plan->slot_us + plan->guard_us;
+    uint32_t phase = frame_phase(plan, clock, now_us);
+    uint32_t wait = (open + plan->frame_us - phase) % plan->frame_us;
+    return now_us + (wait == 0 ? plan->frame_us : wait);
+}
+
+bool tdma_fits(const tdma_plan_t* plan, const tdma_clock_t* clock, uint64_t now_us, uint32_t tx_us) {
+    uint32_t open = plan->node_id * plan->slot_us + plan->guard_us;
+    uint32_t close = (plan->node_id + 1u) * plan->slot_us - plan->guard_us;
+    uint32_t phase = frame_phase(plan, clock, now_us);
+    return phase >= open && (uint64_t)phase + tx_us <= close;
+}
+
+bool tdma_node_configure(tdma_node_t* node, uint8_t node_id, uint8_t num_nodes, uint32_t frame_us,
+                         uint32_t sync_error_us, uint32_t max_packet_us) {
+    node->enabled = num_nodes > 1 &&
+                    tdma_plan_init(&node->plan, node_id, num_nodes, frame_us, sync_error_us, max_packet_us);
+    return node->enabled;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file      tdma.h
+ * @brief     GPS-synchronised TDMA slots for several DAQ nodes on one LoRa channel
+ *
+ * Every node transmits only inside its own slot of a repeating frame. The
+ * frame is the fast packet period, with one slot per node. All nodes derive
+ * the frame phase from GPS time, so slots line up without any traffic
+ * between the cars. Node n of N owns [n, n+1) x frame/N after each frame
+ * boundary. A frame boundary is every UTC time that is a multiple of the
+ * frame period.
+ *
+ * The node's clock is the local microsecond timer plus an offset to UTC
+ * time of day. The offset comes from GPS time references. These are the PPS
+ * edge when one is wired, otherwise the start of the RMC sentence. NMEA
+ * output can only be late, so the filter follows early references quickly
+ * and late ones slowly.
+ *
+ * Each slot keeps a guard time clear at both ends. The guard covers the
+ * sync error, plus the timer drift over the holdover time. A node only
+ * starts a packet if its time on air still ends before the guard, so nodes
+ * with bounded clock errors never overlap.
+ *
+ * No Pico SDK dependency: tools/tdma_sim.c runs the same code with
+ * virtual nodes on a host.
+ */
+
+#ifndef TDMA_H
+#define TDMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TDMA_MAX_NODES          8
+#define TDMA_DAY_US             86400000000ull
+
+// Clock uncertainty per time source (one node against true GPS time)
+#define TDMA_NMEA_SYNC_ERROR_US 15000       // RMC sentence start jitter
+#define TDMA_PPS_SYNC_ERROR_US  500         // PPS edge + interrupt latency
+
+#define TDMA_HOLDOVER_US        30000000    // Keep slotting this long without a reference
+#define TDMA_DRIFT_PPM          50          // Local timer against GPS during holdover
+#define TDMA_RELOCK_US          50000       // References this far off the clock...
+#define TDMA_RELOCK_SAMPLES     3           // ...this many times in a row re-lock it
+
+/**
+ * Time reference behind the clock
+ */
+typedef enum {
+    TDMA_SYNC_NONE = 0,
+    TDMA_SYNC_NMEA,                 // RMC sentence start
+    TDMA_SYNC_PPS                   // PPS edge
+} tdma_sync_source_t;
+
+/**
+ * Slot layout of one node
+ */
+typedef struct {
+    uint8_t  node_id;               // 0..num_nodes-1
+    uint8_t  num_nodes;
+    uint32_t frame_us;              // Must divide a day
+    uint32_t slot_us;               // frame_us / num_nodes
+    uint32_t guard_us;              // Kept clear at each end of the slot
+} tdma_plan_t;
+
+/**
+ * Local timer -> UTC time of day
+ */
+typedef struct {
+    uint64_t offset_us;             // UTC of day = (local + offset) mod day
+    uint64_t last_ref_us;           // Local time of the last reference used
+    tdma_sync_source_t source;
+    uint8_t  outliers;              // Consecutive references beyond TDMA_RELOCK_US
+    bool     locked;
+    uint32_t relocks;
+} tdma_clock_t;
+
+/**
+ * Plan and clock of one node
+ */
+typedef struct {
+    tdma_plan_t  plan;
+    tdma_clock_t clock;
+    bool         enabled;           // A valid plan with more than one node
+} tdma_node_t;
+
+/**
+ * @brief Lay out this node's slot
+ *
+ * @param plan Filled in
+ * @param node_id This node, below num_nodes
+ * @param num_nodes Nodes sharing the channel
+ * @param frame_us Frame period; must divide a day
+ * @param sync_error_us This node's clock uncertainty (TDMA_*_SYNC_ERROR_US)
+ * @param max_packet_us Longest transmission: time on air plus radio setup
+ * @return false if the layout is invalid or a packet and both guards do not
+ *         fit in one slot
+ */
+bool tdma_plan_init(tdma_plan_t* plan, uint8_t node_id, uint8_t num_nodes, uint32_t frame_us,
+                    uint32_t sync_error_us, uint32_t max_packet_us);
+
+/**
+ * @brief Feed one GPS time reference into the clock
+ *
+ * @param clock Clock
+ * @param utc_ms_of_day GPS time of the fix epoch
+ * @param local_us Local time of the same epoch (PPS edge or sentence start)
+ * @param source Kind of reference; a change of source re-locks the clock
+ */
+void tdma_clock_update(tdma_clock_t* clock, uint32_t utc_ms_of_day, uint64_t local_us,
+                       tdma_sync_source_t source);
+
+/**
+ * @brief Whether the clock can be used to slot transmissions
+ *
+ * @return true if locked and the last reference is within TDMA_HOLDOVER_US
+ */
+bool tdma_clock_synced(const tdma_clock_t* clock, uint64_t now_us);
+
+/**
+ * @brief Local time at which this node's next transmit window opens
+ *
+ * The window is the slot without its guards. Returns a time after now_us,
+ * within one frame. A node that is inside its window gets the next frame's
+ * window.
+ */
+uint64_t tdma_next_window(const tdma_plan_t* plan, const tdma_clock_t* clock, uint64_t now_us);
+
+/**
+ * @brief Whether a transmission of tx_us started now ends inside this node's window
+ */
+bool tdma_fits(const tdma_plan_t* plan, const tdma_clock_t* clock, uint64_t now_us, uint32_t tx_us);
+
+/**
+ * @brief Re-plan a node (call when the node ID, node count, frame or radio profile changes)
+ *
+ * @return node->enabled: true when num_nodes > 1 and the plan is valid
+ */
+bool tdma_node_configure(tdma_node_t* node, uint8_t node_id, uint8_t num_nodes, uint32_t frame_us,
+                         uint32_t sync_error_us, uint32_t max_packet_us);
+
+/**
+ * @brief Whether transmissions must wait for this node's slot
+ *
+ * false while TDMA is off or the clock is not synced; the node then sends
+ * as soon as packets are due, as without TDMA.
+ */
+static inline bool tdma_node_active(const tdma_node_t* node, uint64_t now_us) {
+    return node->enabled && tdma_clock_synced(&node->clock, now_us);
+}
+
+#endif // TDMA_H
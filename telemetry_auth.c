@@ -0,0 +1,325 @@
+/**
+ * @file      telemetry_auth.c
+ * @brief     Authenticated LoRa telemetry frames (LR1121 crypto offload)
+ */
+
+#include "telemetry_auth.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "aes_soft.h"
+#include "lr1121_tx.h"
+#include "lr11xx_crypto_engine.h"
+#include "telemetry_packet.h"
+#include "config_store.h"
+#include "safe_print.h"
+
+#if TELEMETRY_AUTH_MODE != TELEMETRY_AUTH_OFF
+_Static_assert(PAYLOAD_LENGTH >= TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD,
+               "PAYLOAD_LENGTH too small for authenticated telemetry");
+#endif
+
+_Static_assert(sizeof(telemetry_auth_header_t) == 8, "auth header must be 8 bytes");
+
+// General-purpose key slots in the LR1121 crypto engine
+#define KEY_ID_MAC  LR11XX_CRYPTO_KEYS_IDX_GP0
+#define KEY_ID_ENC  LR11XX_CRYPTO_KEYS_IDX_GP1
+
+#define COUNTER_BLOCKS_MAX  16  // Enough for a 255-byte frame
+
+static const uint8_t MAC_KEY[16] = TELEMETRY_AUTH_MAC_KEY;
+static const uint8_t ENC_KEY[16] = TELEMETRY_AUTH_ENC_KEY;
+
+static aes128_ctx_t g_mac_ctx;
+static aes128_ctx_t g_enc_ctx;
+static bool g_use_radio = false;
+static uint16_t g_session = 0;
+static bool g_session_valid = false;    // Sessions run out after 65535 boots
+static uint32_t g_counter = 0;
+
+// CTR counter block: 0x01 | session | counter | zeros | block index
+static uint16_t build_counter_blocks(uint16_t session, uint32_t counter, uint16_t length, uint8_t* blocks) {
+    uint16_t num_blocks = (length + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+    memset(blocks, 0, num_blocks * AES_BLOCK_SIZE);
+    for (uint16_t i = 0; i < num_blocks; i++) {
+        uint8_t* block = &blocks[i * AES_BLOCK_SIZE];
+        block[0] = 0x01;
+        block[1] = session & 0xFF;
+        block[2] = session >> 8;
+        block[3] = counter & 0xFF;
+        block[4] = (counter >> 8) & 0xFF;
+        block[5] = (counter >> 16) & 0xFF;
+        block[6] = (counter >> 24) & 0xFF;
+        block[15] = (uint8_t)i;
+    }
+    return num_blocks * AES_BLOCK_SIZE;
+}
+
+static bool compute_mic(bool use_radio, const uint8_t* data, uint16_t length, uint8_t* mic) {
+    if (use_radio) {
+        lr11xx_crypto_status_t status;
+        lr11xx_status_t rc = lr11xx_crypto_compute_aes_cmac(&lr1121, &status, KEY_ID_MAC, data, length, mic);
+        return rc == LR11XX_STATUS_OK && status == LR11XX_CRYPTO_STATUS_SUCCESS;
+    }
+
+    uint8_t full[AES_BLOCK_SIZE];
+    aes128_cmac(&g_mac_ctx, data, length, full);
+    memcpy(mic, full, TELEMETRY_AUTH_MIC_LENGTH);
+    return true;
+}
+
+static bool compute_keystream(bool use_radio, const uint8_t* blocks, uint16_t length, uint8_t* keystream) {
+    if (use_radio) {
+        lr11xx_crypto_status_t status;
+        lr11xx_status_t rc = lr11xx_crypto_aes_encrypt(&lr1121, &status, KEY_ID_ENC, blocks, length, keystream);
+        return rc == LR11XX_STATUS_OK && status == LR11XX_CRYPTO_STATUS_SUCCESS;
+    }
+
+    aes128_ecb_encrypt(&g_enc_ctx, blocks, length, keystream);
+    return true;
+}
+
+// RFC 4493 example 2 (16-byte message)
+static bool software_aes_self_test(void) {
+    static const uint8_t key[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    static const uint8_t msg[16] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+    static const uint8_t expected[16] = {
+        0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c };
+
+    aes128_ctx_t ctx;
+    uint8_t mac[16];
+    aes128_init(&ctx, key);
+    aes128_cmac(&ctx, msg, sizeof(msg), mac);
+    return memcmp(mac, expected, sizeof(mac)) == 0;
+}
+
+// The LR1121 must produce exactly what the software AES (and so the receiver) computes
+static bool radio_crypto_self_test(void) {
+    lr11xx_crypto_status_t status;
+    if (lr11xx_crypto_set_key(&lr1121, &status, KEY_ID_MAC, MAC_KEY) != LR11XX_STATUS_OK ||
+        status != LR11XX_CRYPTO_STATUS_SUCCESS) {
+        return false;
+    }
+    if (lr11xx_crypto_set_key(&lr1121, &status, KEY_ID_ENC, ENC_KEY) != LR11XX_STATUS_OK ||
+        status != LR11XX_CRYPTO_STATUS_SUCCESS) {
+        return false;
+    }
+
+    uint8_t msg[sizeof(telemetry_auth_header_t) + TELEMETRY_MAX_PACKET_SIZE];
+    for (uint16_t i = 0; i < sizeof(msg); i++) {
+        msg[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    uint8_t hw_mic[TELEMETRY_AUTH_MIC_LENGTH], sw_mic[TELEMETRY_AUTH_MIC_LENGTH];
+    if (!compute_mic(true, msg, sizeof(msg), hw_mic)) return false;
+    compute_mic(false, msg, sizeof(msg), sw_mic);
+    if (memcmp(hw_mic, sw_mic, sizeof(hw_mic)) != 0) return false;
+
+    uint8_t blocks[COUNTER_BLOCKS_MAX * AES_BLOCK_SIZE];
+    uint8_t hw_ks[sizeof(blocks)], sw_ks[sizeof(blocks)];
+    uint16_t ks_len = build_counter_blocks(0x1234, 0x89abcdef, TELEMETRY_MAX_PACKET_SIZE, blocks);
+    if (!compute_keystream(true, blocks, ks_len, hw_ks)) return false;
+    compute_keystream(false, blocks, ks_len, sw_ks);
+    return memcmp(hw_ks, sw_ks, ks_len) == 0;
+}
+
+bool telemetry_auth_init(void) {
+    aes128_init(&g_mac_ctx, MAC_KEY);
+    aes128_init(&g_enc_ctx, ENC_KEY);
+
+    if (!software_aes_self_test()) {
+        safe_printf("[AUTH] ERROR: software AES-CMAC self-test failed\n");
+    }
+
+    g_use_radio = radio_crypto_self_test();
+
+    // The boot count never repeats, so neither does a CTR counter block
+    uint32_t boot_count = config_get()->boot_count;
+    g_session = (uint16_t)boot_count;
+    g_session_valid = boot_count >= 1 && boot_count <= UINT16_MAX;
+    g_counter = 0;
+    if (!g_session_valid) {
+        safe_printf("[AUTH] ERROR: boot %lu has no session id left, not sending. Change the keys.\n",
+                    (unsigned long)boot_count);
+    }
+
+    // End-to-end check: wrap on this backend, open with the receiver's software path
+    uint8_t payload[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t frame[sizeof(payload) + TELEMETRY_AUTH_OVERHEAD];
+    uint8_t opened[sizeof(payload)];
+    telemetry_auth_rx_state_t rx = {0};
+    memset(payload, 0x5A, sizeof(payload));
+    int frame_len = telemetry_auth_wrap(payload, sizeof(payload), true, frame, sizeof(frame));
+    bool round_trip = frame_len > 0 &&
+        telemetry_auth_open(MAC_KEY, ENC_KEY, frame, (uint8_t)frame_len, opened, &rx) == (int)sizeof(payload) &&
+        memcmp(opened, payload, sizeof(payload)) == 0;
+
+    safe_printf("[AUTH] Mode %d, crypto on %s, session 0x%04x, round trip %s\n",
+                TELEMETRY_AUTH_MODE, g_use_radio ? "LR1121" : "core 1 (software)",
+                g_session, round_trip ? "OK" : "FAILED");
+    return g_use_radio;
+}
+
+int telemetry_auth_wrap(const uint8_t* payload, uint8_t length, bool encrypt,
+                        uint8_t* frame, uint8_t frame_max) {
+    uint16_t total = sizeof(telemetry_auth_header_t) + length + TELEMETRY_AUTH_MIC_LENGTH;
+    if (total > frame_max || !g_session_valid) {
+        return -1;
+    }
+
+    telemetry_auth_header_t header = {
+        .version = TELEMETRY_AUTH_VERSION,
+        .flags   = encrypt ? TELEMETRY_AUTH_F_ENCRYPTED : 0,
+        .session = g_session,
+        .counter = g_counter++,
+    };
+    memcpy(frame, &header, sizeof(header));
+    uint8_t* body = frame + sizeof(header);
+
+    if (encrypt) {
+        uint8_t blocks[COUNTER_BLOCKS_MAX * AES_BLOCK_SIZE];
+        uint8_t keystream[sizeof(blocks)];
+        uint16_t ks_len = build_counter_blocks(header.session, header.counter, length, blocks);
+        if (!compute_keystream(g_use_radio, blocks, ks_len, keystream)) {
+            safe_printf("[AUTH] LR1121 AES failed, falling back to software\n");
+            g_use_radio = false;
+            compute_keystream(false, blocks, ks_len, keystream);
+        }
+        for (uint8_t i = 0; i < length; i++) {
+            body[i] = payload[i] ^ keystream[i];
+        }
+    } else {
+        memcpy(body, payload, length);
+    }
+
+    uint16_t mic_len = sizeof(header) + length;
+    if (!compute_mic(g_use_radio, frame, mic_len, frame + mic_len)) {
+        safe_printf("[AUTH] LR1121 CMAC failed, falling back to software\n");
+        g_use_radio = false;
+        compute_mic(false, frame, mic_len, frame + mic_len);
+    }
+
+    return total;
+}
+
+int telemetry_auth_open(const uint8_t mac_key[16], const uint8_t enc_key[16],
+                        const uint8_t* frame, uint8_t length, uint8_t* payload,
+                        telemetry_auth_rx_state_t* rx) {
+    if (length < TELEMETRY_AUTH_OVERHEAD) {
+        return -1;
+    }
+
+    telemetry_auth_header_t header;
+    memcpy(&header, frame, sizeof(header));
+    if (header.version != TELEMETRY_AUTH_VERSION) {
+        return -1;
+    }
+
+    uint8_t payload_len = length - TELEMETRY_AUTH_OVERHEAD;
+    uint16_t mic_len = sizeof(header) + payload_len;
+
+    aes128_ctx_t ctx;
+    uint8_t mac[AES_BLOCK_SIZE];
+    aes128_init(&ctx, mac_key);
+    aes128_cmac(&ctx, frame, mic_len, mac);
+
+    uint8_t diff = 0;
+    for (int i = 0; i < TELEMETRY_AUTH_MIC_LENGTH; i++) {
+        diff |= mac[i] ^ frame[mic_len + i];
+    }
+    if (diff != 0) {
+        return -1;
+    }
+
+    // Sessions only move forward (transmitter reboot); a frame recorded in an
+    // older session, or an old counter in this one, is a replay
+    if (rx->synced && (header.session < rx->session ||
+                       (header.session == rx->session && header.counter <= rx->last_counter))) {
+        return -1;
+    }
+
+    const uint8_t* body = frame + sizeof(header);
+    if (header.flags & TELEMETRY_AUTH_F_ENCRYPTED) {
+        uint8_t blocks[COUNTER_BLOCKS_MAX * AES_BLOCK_SIZE];
+        uint16_t ks_len = build_counter_blocks(header.session, header.counter, payload_len, blocks);
+        aes128_init(&ctx, enc_key);
+        aes128_ecb_encrypt(&ctx, blocks, ks_len, blocks);
+        for (uint8_t i = 0; i < payload_len; i++) {
+            payload[i] = body[i] ^ blocks[i];
+        }
+    } else {
+        memcpy(payload, body, payload_len);
+    }
+
+    rx->synced = true;
+    rx->session = header.session;
+    rx->last_counter = header.counter;
+    return payload_len;
+}
+
+static bool send_frame(bool (*send)(const uint8_t*, uint8_t), uint8_t frame_max,
+                       const uint8_t* payload, uint8_t length) {
+#if TELEMETRY_AUTH_MODE == TELEMETRY_AUTH_OFF
+    (void)frame_max;
+    return send(payload, length);
+#else
+    uint8_t frame[255];
+    int frame_len = telemetry_auth_wrap(payload, length, TELEMETRY_AUTH_MODE == TELEMETRY_AUTH_ENCRYPT,
+                                        frame, frame_max);
+    if (frame_len < 0) {
+        return false;
+    }
+    return send(frame, (uint8_t)frame_len);
+#endif
+}
+
+bool telemetry_auth_send(const uint8_t* payload, uint8_t length) {
+    return send_frame(lora_send, PAYLOAD_LENGTH, payload, length);
+}
+
+bool telemetry_auth_send_lr_fhss(const uint8_t* payload, uint8_t length) {
+    return send_frame(lr_fhss_send, LR_FHSS_MAX_PAYLOAD_LENGTH, payload, length);
+}
+
+bool telemetry_auth_send_critical(const uint8_t* payload, uint8_t length) {
+    return send_frame(lora_send_critical, PAYLOAD_LENGTH, payload, length);
+}
+
+void telemetry_auth_benchmark(uint32_t iterations) {
+    uint8_t msg[sizeof(telemetry_auth_header_t) + TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t mic[TELEMETRY_AUTH_MIC_LENGTH];
+    uint8_t blocks[COUNTER_BLOCKS_MAX * AES_BLOCK_SIZE];
+    uint8_t keystream[sizeof(blocks)];
+    uint32_t mic_us[2] = {0}, ks_us[2] = {0};
+
+    if (iterations == 0) {
+        return;
+    }
+    memset(msg, 0xA5, sizeof(msg));
+    uint16_t ks_len = build_counter_blocks(g_session, 0, TELEMETRY_MAX_PACKET_SIZE, blocks);
+
+    // Index 0 = LR1121, 1 = software on this core
+    for (int backend = 0; backend < 2; backend++) {
+        bool use_radio = (backend == 0);
+        if (use_radio && !g_use_radio) {
+            continue;
+        }
+
+        uint64_t start = time_us_64();
+        for (uint32_t i = 0; i < iterations; i++) {
+            compute_mic(use_radio, msg, sizeof(msg), mic);
+        }
+        mic_us[backend] = (uint32_t)((time_us_64() - start) / iterations);
+
+        start = time_us_64();
+        for (uint32_t i = 0; i < iterations; i++) {
+            compute_keystream(use_radio, blocks, ks_len, keystream);
+        }
+        ks_us[backend] = (uint32_t)((time_us_64() - start) / iterations);
+    }
+
+    safe_printf("[AUTH] %u-byte MIC: LR1121 %lu us, software %lu us | %u-byte keystream: LR1121 %lu us, software %lu us\n",
+                (unsigned)sizeof(msg), (unsigned long)mic_us[0], (unsigned long)mic_us[1],
+                ks_len, (unsigned long)ks_us[0], (unsigned long)ks_us[1]);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file      telemetry_auth.h
+ * @brief     Authenticated (optionally encrypted) LoRa telemetry frames
+ * 
+ * Wraps every radio payload in a small header with a per-boot session id and
+ * a packet counter, optionally encrypts it (AES-128-CTR), and appends a
+ * truncated AES-CMAC. The session id is the boot count from the config
+ * store, so no session (and no AES-CTR counter block) is ever reused, and
+ * receivers reject any session older than the last one accepted. The AES work is offloaded to the LR1121 crypto engine;
+ * the software AES in aes_soft.c checks it at boot and takes over if the
+ * engine does not match.
+ * 
+ * Frame layout: header (8) | payload (n) | MIC (4)
+ * The MIC covers the header and the payload as transmitted (encrypt-then-MAC).
+ */
+
+#ifndef TELEMETRY_AUTH_H
+#define TELEMETRY_AUTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Build-time mode, set with -DFS26_TELEMETRY_AUTH_MODE
+#define TELEMETRY_AUTH_OFF      0
+#define TELEMETRY_AUTH_MIC      1   // Authenticated plaintext
+#define TELEMETRY_AUTH_ENCRYPT  2   // Authenticated ciphertext
+
+#ifndef TELEMETRY_AUTH_MODE
+#define TELEMETRY_AUTH_MODE TELEMETRY_AUTH_OFF
+#endif
+
+// Keys: set per car with -DTELEMETRY_AUTH_MAC_KEY={...} -DTELEMETRY_AUTH_ENC_KEY={...}.
+// The development keys below are public, so an authenticated build refuses
+// them unless asked for with -DTELEMETRY_AUTH_DEV_KEYS=1 (bench only).
+#if TELEMETRY_AUTH_MODE != TELEMETRY_AUTH_OFF && \
+    (!defined(TELEMETRY_AUTH_MAC_KEY) || !defined(TELEMETRY_AUTH_ENC_KEY))
+#if defined(TELEMETRY_AUTH_DEV_KEYS) && TELEMETRY_AUTH_DEV_KEYS
+#warning "telemetry_auth: public development keys, anyone can forge frames"
+#else
+#error "telemetry_auth: set TELEMETRY_AUTH_MAC_KEY and TELEMETRY_AUTH_ENC_KEY, or TELEMETRY_AUTH_DEV_KEYS=1 for the bench"
+#endif
+#endif
+
+#ifndef TELEMETRY_AUTH_MAC_KEY
+#define TELEMETRY_AUTH_MAC_KEY { 0x46, 0x53, 0x32, 0x36, 0x2d, 0x4d, 0x41, 0x43, \
+                                 0x2d, 0x44, 0x45, 0x56, 0x2d, 0x4b, 0x45, 0x59 }
+#endif
+#ifndef TELEMETRY_AUTH_ENC_KEY
+#define TELEMETRY_AUTH_ENC_KEY { 0x46, 0x53, 0x32, 0x36, 0x2d, 0x45, 0x4e, 0x43, \
+                                 0x2d, 0x44, 0x45, 0x56, 0x2d, 0x4b, 0x45, 0x59 }
+#endif
+
+#define TELEMETRY_AUTH_MIC_LENGTH   4
+#define TELEMETRY_AUTH_F_ENCRYPTED  0x01
+#define TELEMETRY_AUTH_VERSION      1
+
+/**
+ * Frame header (8 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t  version;               // TELEMETRY_AUTH_VERSION
+    uint8_t  flags;                 // TELEMETRY_AUTH_F_*
+    uint16_t session;               // Boot count (config_store.h), increases every boot
+    uint32_t counter;               // Increments per frame, never reused in a session
+} telemetry_auth_header_t;
+
+#define TELEMETRY_AUTH_OVERHEAD (sizeof(telemetry_auth_header_t) + TELEMETRY_AUTH_MIC_LENGTH)
+
+/**
+ * Receiver-side replay state
+ */
+typedef struct {
+    bool     synced;
+    uint16_t session;
+    uint32_t last_counter;
+} telemetry_auth_rx_state_t;
+
+/**
+ * @brief Load the keys into the LR1121 and self-test the crypto path (core 1)
+ * 
+ * Call after lora_tx_init(). Checks the software AES against RFC 4493 and
+ * the LR1121 results against the software AES. If the engine disagrees or
+ * errors, frames are protected in software instead.
+ * 
+ * @return true if the radio crypto engine is in use
+ */
+bool telemetry_auth_init(void);
+
+/**
+ * @brief Send a payload, wrapped according to TELEMETRY_AUTH_MODE
+ * 
+ * With TELEMETRY_AUTH_OFF this is lora_send().
+ * 
+ * @param payload Payload bytes
+ * @param length Payload length
+ * @return true if the frame was transmitted
+ */
+bool telemetry_auth_send(const uint8_t* payload, uint8_t length);
+
+/**
+ * @brief Send a payload on the LR-FHSS essentials link, wrapped the same way
+ * 
+ * @param payload Payload bytes
+ * @param length Payload length
+ * @return true if the frame was transmitted
+ */
+bool telemetry_auth_send_lr_fhss(const uint8_t* payload, uint8_t length);
+
+/**
+ * @brief Send a critical payload (alert, lap) with lora_send_critical()
+ * 
+ * Wrapped once, so a diversity copy carries the same counter and MIC.
+ * 
+ * @param payload Payload bytes
+ * @param length Payload length
+ * @return true if at least one copy was transmitted
+ */
+bool telemetry_auth_send_critical(const uint8_t* payload, uint8_t length);
+
+/**
+ * @brief Wrap a payload into an authenticated frame
+ * 
+ * @param payload Payload bytes
+ * @param length Payload length
+ * @param encrypt Encrypt the payload as well
+ * @param frame Output buffer
+ * @param frame_max Size of frame
+ * @return Frame length, or -1 on error
+ */
+int telemetry_auth_wrap(const uint8_t* payload, uint8_t length, bool encrypt,
+                        uint8_t* frame, uint8_t frame_max);
+
+/**
+ * @brief Verify (and decrypt) a received frame in software
+ * 
+ * Pure C on top of aes_soft.c, for receivers and host tools. Rejects frames
+ * with a bad MIC, a session older than the last accepted one, or a counter
+ * that is not newer than the last accepted one of the same session. Keep rx
+ * across receiver restarts where possible: a fresh rx accepts any session.
+ * 
+ * @param mac_key 16-byte MIC key
+ * @param enc_key 16-byte encryption key
+ * @param frame Received frame
+ * @param length Frame length
+ * @param payload Output, length - TELEMETRY_AUTH_OVERHEAD bytes
+ * @param rx Replay state, updated on success
+ * @return Payload length, or -1 if the frame was rejected
+ */
+int telemetry_auth_open(const uint8_t mac_key[16], const uint8_t enc_key[16],
+                        const uint8_t* frame, uint8_t length, uint8_t* payload,
+                        telemetry_auth_rx_state_t* rx);
+
+/**
+ * @brief Time the LR1121 crypto engine against the software AES on this core
+ * 
+ * Prints the average cost of a MIC and of a keystream for a telemetry-sized
+ * payload with each backend.
+ * 
+ * @param iterations Runs per measurement
+ */
+void telemetry_auth_benchmark(uint32_t iterations);
+
+#endif // TELEMETRY_AUTH_H
@@ -0,0 +1,153 @@
+/**
+ * @file      telemetry_packet.c
+ * @brief     Over-the-air telemetry packet builder implementation
+ */
+
+#include "telemetry_packet.h"
+#include "lr1121_tx.h"
+#include "can_handler.h"
+#include "pico/time.h"
+
+_Static_assert(PAYLOAD_LENGTH >= TELEMETRY_MAX_PACKET_SIZE, "PAYLOAD_LENGTH too small for the telemetry packets");
+_Static_assert(ALARM_NUM_RULES == 3, "telemetry_alarm carries one value per alarm rule");
+
+static uint16_t clamp_u16(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 65535.0f) return UINT16_MAX;
+    return (uint16_t)(value + 0.5f);
+}
+
+static uint16_t clamp_u16_int(int32_t value) {
+    if (value <= 0) return 0;
+    if (value >= UINT16_MAX) return UINT16_MAX;
+    return (uint16_t)value;
+}
+
+static int16_t clamp_i16_int(int32_t value) {
+    if (value <= INT16_MIN) return INT16_MIN;
+    if (value >= INT16_MAX) return INT16_MAX;
+    return (int16_t)value;
+}
+
+// Raw channel word divided by 10, rounded half away from zero
+// (x1000 channels -> the packet's x100)
+static int32_t raw_div10(int32_t raw) {
+    return raw < 0 ? (raw - 5) / 10 : (raw + 5) / 10;
+}
+
+void telemetry_fill_header(telemetry_header_t* header, telemetry_type_t type) {
+    static uint8_t seq = 0;
+
+    header->type_version = TELEMETRY_TYPE_VERSION(type);
+    header->seq = seq++;
+    header->timestamp_ms = (uint16_t)to_ms_since_boot(get_absolute_time());
+}
+
+uint8_t telemetry_encode(const telemetry_header_t* header, uint8_t* out) {
+    switch ((telemetry_type_t)(header->type_version & 0x0F)) {
+        case TELEMETRY_TYPE_FAST:
+            telemetry_fast_encode((const telemetry_fast_t*)header, out);
+            return sizeof(telemetry_fast_t);
+        case TELEMETRY_TYPE_THERMAL:
+            telemetry_thermal_encode((const telemetry_thermal_t*)header, out);
+            return sizeof(telemetry_thermal_t);
+        case TELEMETRY_TYPE_GPS:
+            telemetry_gps_encode((const telemetry_gps_t*)header, out);
+            return sizeof(telemetry_gps_t);
+        case TELEMETRY_TYPE_LAP:
+            telemetry_lap_encode((const telemetry_lap_t*)header, out);
+            return sizeof(telemetry_lap_t);
+        case TELEMETRY_TYPE_ALARM:
+            telemetry_alarm_encode((const telemetry_alarm_t*)header, out);
+            return sizeof(telemetry_alarm_t);
+        case TELEMETRY_TYPE_DIAG:
+            telemetry_diag_encode((const telemetry_diag_t*)header, out);
+            return sizeof(telemetry_diag_t);
+        case TELEMETRY_TYPE_CAN_HEALTH:
+            telemetry_can_health_encode((const telemetry_can_health_t*)header, out);
+            return sizeof(telemetry_can_health_t);
+        case TELEMETRY_TYPE_ESSENTIALS:
+            telemetry_essentials_encode((const telemetry_essentials_t*)header, out);
+            return sizeof(telemetry_essentials_t);
+        default:
+            return 0;
+    }
+}
+
+// The packet fields are the sensor snapshot's fixed point (x10, x100, e7),
+// so most are the raw channel word with no float round trip
+
+void telemetry_build_fast(telemetry_fast_t* packet, const ft550_sensor_data_t* can_data) {
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_FAST);
+    packet->rpm = (uint16_t)ft550_raw(can_data, FT550_CH_RPM);
+    packet->tps_x10 = clamp_u16_int(ft550_raw(can_data, FT550_CH_TPS));
+    packet->brake_pressure_x100 = clamp_u16_int(raw_div10(ft550_raw(can_data, FT550_CH_BRAKE_PRESSURE)));
+    packet->g_lateral_mg = clamp_i16_int(ft550_raw(can_data, FT550_CH_G_FORCE_LATERAL) * 1000);
+    packet->g_accel_mg = clamp_i16_int(ft550_raw(can_data, FT550_CH_G_FORCE_ACCEL) * 1000);
+    packet->wheel_speed_fr = (uint16_t)ft550_raw(can_data, FT550_CH_WHEEL_SPEED_FR);
+    packet->wheel_speed_fl = (uint16_t)ft550_raw(can_data, FT550_CH_WHEEL_SPEED_FL);
+    packet->wheel_speed_rr = (uint16_t)ft550_raw(can_data, FT550_CH_WHEEL_SPEED_RR);
+    packet->wheel_speed_rl = (uint16_t)ft550_raw(can_data, FT550_CH_WHEEL_SPEED_RL);
+    packet->gear = can_data->raw[FT550_CH_GEAR];
+}
+
+void telemetry_build_thermal(telemetry_thermal_t* packet, const ft550_sensor_data_t* can_data) {
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_THERMAL);
+    packet->engine_temp_x10 = can_data->raw[FT550_CH_ENGINE_TEMP];
+    packet->oil_temp_x10 = can_data->raw[FT550_CH_OIL_TEMP];
+    packet->air_temp_x10 = can_data->raw[FT550_CH_AIR_TEMP];
+    packet->oil_pressure_x100 = clamp_u16_int(raw_div10(ft550_raw(can_data, FT550_CH_OIL_PRESSURE)));
+    packet->fuel_pressure_x100 = clamp_u16_int(raw_div10(ft550_raw(can_data, FT550_CH_FUEL_PRESSURE)));
+    packet->battery_mv = clamp_u16_int(ft550_raw(can_data, FT550_CH_BATTERY_VOLTAGE) * 10);
+    packet->can_frame_count = (uint16_t)(can_get_frame_count() & 0xFFFF);
+    packet->tx_count = (uint16_t)lora_get_tx_count();
+}
+
+void telemetry_build_gps(telemetry_gps_t* packet, const gps_data_t* gps) {
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_GPS);
+    packet->latitude_e7 = gps->latitude_e7;
+    packet->longitude_e7 = gps->longitude_e7;
+    packet->speed_x10 = gps->speed_x10;
+    packet->course_x10 = gps->course_x10;
+    packet->altitude_m = (int16_t)raw_div10(gps->altitude_x10);
+    packet->satellites = gps->satellites;
+    packet->fix_valid = gps->fix_valid;
+}
+
+void telemetry_build_lap(telemetry_lap_t* packet, const lap_summary_t* lap) {
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_LAP);
+    packet->lap_time_ms = lap->lap_time_ms;
+    packet->best_lap_ms = lap->best_lap_ms;
+    packet->lap_number = lap->lap_number;
+    packet->max_rpm = lap->max_rpm;
+    packet->max_speed_x10 = clamp_u16(lap->max_speed_kph * 10.0f);
+    packet->reserved = 0;
+}
+
+void telemetry_build_alarm(telemetry_alarm_t* packet, const alarm_alert_t* alert) {
+    telemetry_fill_header(&packet->header, TELEMETRY_TYPE_ALARM);
+    packet->value_0 = alert->values[0];
+    packet->value_1 = alert->values[1];
+    packet->value_2 = alert->values[2];
+    packet->active_mask = alert->active_mask;
+    packet->changed_mask = alert->changed_mask;
+}
+
+void telemetry_build_essentials(telemetry_essentials_t* packet,
+                                const gps_data_t* gps,
+                                const ft550_sensor_data_t* can_data,
+                                uint16_t alarm_mask) {
+    // Own sequence: these go out on the LR-FHSS link and must not leave
+    // gaps in the LoRa sequence the receivers count losses by
+    static uint8_t seq = 0;
+
+    packet->header.type_version = TELEMETRY_TYPE_VERSION(TELEMETRY_TYPE_ESSENTIALS);
+    packet->header.seq = seq++;
+    packet->header.timestamp_ms = (uint16_t)to_ms_since_boot(get_absolute_time());
+    packet->latitude_e7 = gps->latitude_e7;
+    packet->longitude_e7 = gps->longitude_e7;
+    packet->rpm = (uint16_t)ft550_raw(can_data, FT550_CH_RPM);
+    packet->speed_kph = gps->speed_x10 >= 2550 ? 255 : (uint8_t)(gps->speed_x10 / 10);
+    packet->flags = gps->fix_valid ? 0x01 : 0x00;
+    packet->alarm_mask = alarm_mask;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file      telemetry_packet.h
+ * @brief     Over-the-air telemetry packet layout and builder
+ * 
+ * Packs the latest GPS and CAN snapshots into the typed LoRa packets
+ * broadcast by core 1. The packet layouts live in telemetry_schema.h.
+ */
+
+#ifndef TELEMETRY_PACKET_H
+#define TELEMETRY_PACKET_H
+
+#include <stdint.h>
+#include "ft550_decoder.h"
+#include "gps.h"
+#include "telemetry_schema.h"
+#include "lap_timer.h"
+#include "alarm_engine.h"
+
+#define ESSENTIALS_PERIOD_MS 15000  // LR-FHSS essentials rate (~1 s ToA, 10% duty cycle)
+
+// Per-type LoRa rates (lap and alarm packets are sent on event,
+// diagnostics every RADIO_DIAG_PERIOD_MS)
+#define TELEMETRY_FAST_PERIOD_MS    200
+#define TELEMETRY_GPS_PERIOD_MS     500
+#define TELEMETRY_THERMAL_PERIOD_MS 1000
+
+/**
+ * @brief Fill a packet header with its type, the next sequence number and the time
+ * 
+ * @param header Header to fill
+ * @param type Packet type
+ */
+void telemetry_fill_header(telemetry_header_t* header, telemetry_type_t type);
+
+/**
+ * @brief Encode any typed packet to its little-endian wire form
+ * 
+ * @param header Header of a telemetry_*_t packet (the packet type selects the encoder)
+ * @param out Destination, TELEMETRY_MAX_PACKET_SIZE bytes
+ * @return Encoded length, or 0 for an unknown type
+ */
+uint8_t telemetry_encode(const telemetry_header_t* header, uint8_t* out);
+
+/**
+ * @brief Build the fast dynamics packet (engine + chassis)
+ */
+void telemetry_build_fast(telemetry_fast_t* packet, const ft550_sensor_data_t* can_data);
+
+/**
+ * @brief Build the slow thermal packet (temperatures, pressures, battery, counters)
+ */
+void telemetry_build_thermal(telemetry_thermal_t* packet, const ft550_sensor_data_t* can_data);
+
+/**
+ * @brief Build the GPS packet
+ */
+void telemetry_build_gps(telemetry_gps_t* packet, const gps_data_t* gps);
+
+/**
+ * @brief Build the lap summary packet
+ */
+void telemetry_build_lap(telemetry_lap_t* packet, const lap_summary_t* lap);
+
+/**
+ * @brief Build the alarm packet from a taken alert
+ */
+void telemetry_build_alarm(telemetry_alarm_t* packet, const alarm_alert_t* alert);
+
+/**
+ * @brief Build the LR-FHSS essentials packet
+ * 
+ * @param packet Packet to fill
+ * @param gps Snapshot of the GPS data
+ * @param can_data Snapshot of the decoded ECU data
+ * @param alarm_mask Active alarm mask
+ */
+void telemetry_build_essentials(telemetry_essentials_t* packet,
+                                const gps_data_t* gps,
+                                const ft550_sensor_data_t* can_data,
+                                uint16_t alarm_mask);
+
+#endif // TELEMETRY_PACKET_H
@@ -0,0 +1,278 @@
+/**
+ * @file      telemetry_schema.h
+ * @brief     Over-the-air telemetry packet family, generated from field lists
+ *
+ * Every LoRa packet starts with a 4-byte telemetry_header_t: a type/version
+ * byte, a sequence number shared by all types (gaps = lost packets) and the
+ * low 16 bits of the board uptime in ms. Each packet type has its own field
+ * list and is sent at its own rate, so a channel can be added to one type
+ * without touching the others.
+ *
+ * For each TELEMETRY_<TYPE>_FIELDS list, TELEMETRY_DEFINE_PACKET expands the
+ * packed struct, its size, per-field natural-alignment checks and the
+ * little-endian <name>_encode() / <name>_decode() pair. Fields are ordered by
+ * size (4-byte, then 2-byte, then 1-byte) so the Cortex-M33 reads each one
+ * with a single load.
+ *
+ * This header only depends on the C standard library, so ground-station
+ * tools can include it unchanged. Bump TELEMETRY_SCHEMA_VERSION when any
+ * existing field list changes; new packet types do not need a bump.
+ */
+
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Type/version byte: high nibble = schema version, low nibble = packet type.
+// Version 1 never collides with the first byte of the packet sent by older
+// firmware (0x36, the "FS26" telemetry packet).
+#define TELEMETRY_SCHEMA_VERSION    1
+#define TELEMETRY_LEGACY_FIRST_BYTE 0x36        // Unversioned "FS26" combined packet
+
+typedef enum {
+    TELEMETRY_TYPE_FAST = 1,        // Engine + chassis dynamics
+    TELEMETRY_TYPE_THERMAL,         // Temperatures, pressures, battery
+    TELEMETRY_TYPE_GPS,             // Position, speed, heading
+    TELEMETRY_TYPE_LAP,             // Lap summary, sent once per lap
+    TELEMETRY_TYPE_ALARM,           // Alarm state change, sent on event
+    TELEMETRY_TYPE_DIAG,            // Radio link diagnostics
+    TELEMETRY_TYPE_CAN_HEALTH,      // CAN controller error state and recoveries
+    TELEMETRY_TYPE_ESSENTIALS,      // LR-FHSS essentials, own sequence number
+    TELEMETRY_NUM_TYPES
+} telemetry_type_t;
+
+#define TELEMETRY_TYPE_VERSION(type) ((uint8_t)((TELEMETRY_SCHEMA_VERSION << 4) | (type)))
+
+typedef struct __attribute__((packed)) {
+    uint8_t  type_version;          // TELEMETRY_TYPE_VERSION(type)
+    uint8_t  seq;                   // Shared across all types
+    uint16_t timestamp_ms;          // Low 16 bits of the uptime when built
+} telemetry_header_t;
+
+#define TELEMETRY_HEADER_SIZE 4
+
+//  X(type,     name)                             unit / meaning
+#define TELEMETRY_FAST_FIELDS(X) \
+    X(uint16_t, rpm)                   /* RPM                          */ \
+    X(uint16_t, tps_x10)               /* % × 10                       */ \
+    X(uint16_t, brake_pressure_x100)   /* Bar × 100                    */ \
+    X(int16_t,  g_lateral_mg)          /* milli-g                      */ \
+    X(int16_t,  g_accel_mg)            /* milli-g                      */ \
+    X(uint16_t, wheel_speed_fr)        /* km/h                         */ \
+    X(uint16_t, wheel_speed_fl)        /* km/h                         */ \
+    X(uint16_t, wheel_speed_rr)        /* km/h                         */ \
+    X(uint16_t, wheel_speed_rl)        /* km/h                         */ \
+    X(int16_t,  gear)                  /* ECU gear                     */
+
+#define TELEMETRY_THERMAL_FIELDS(X) \
+    X(int16_t,  engine_temp_x10)       /* °C × 10                      */ \
+    X(int16_t,  oil_temp_x10)          /* °C × 10                      */ \
+    X(int16_t,  air_temp_x10)          /* °C × 10                      */ \
+    X(uint16_t, oil_pressure_x100)     /* Bar × 100                    */ \
+    X(uint16_t, fuel_pressure_x100)    /* Bar × 100                    */ \
+    X(uint16_t, battery_mv)            /* mV                           */ \
+    X(uint16_t, can_frame_count)       /* CAN frames received          */ \
+    X(uint16_t, tx_count)              /* LoRa TX count                */
+
+#define TELEMETRY_GPS_FIELDS(X) \
+    X(int32_t,  latitude_e7)           /* deg × 1e7                    */ \
+    X(int32_t,  longitude_e7)          /* deg × 1e7                    */ \
+    X(uint16_t, speed_x10)             /* km/h × 10                    */ \
+    X(uint16_t, course_x10)            /* deg × 10                     */ \
+    X(int16_t,  altitude_m)            /* m                            */ \
+    X(uint8_t,  satellites)            /* count                        */ \
+    X(uint8_t,  fix_valid)             /* 0/1                          */
+
+#define TELEMETRY_LAP_FIELDS(X) \
+    X(uint32_t, lap_time_ms)           /* Completed lap                */ \
+    X(uint32_t, best_lap_ms)           /* Best lap this session        */ \
+    X(uint16_t, lap_number)            /* 1 = first completed lap      */ \
+    X(uint16_t, max_rpm)               /* RPM                          */ \
+    X(uint16_t, max_speed_x10)         /* km/h × 10                    */ \
+    X(uint16_t, reserved)              /* 0                            */
+
+#define TELEMETRY_ALARM_FIELDS(X) \
+    X(int32_t,  value_0)               /* Raw value at the last change, */ \
+    X(int32_t,  value_1)               /* one per alarm rule           */ \
+    X(int32_t,  value_2)               /*                              */ \
+    X(uint16_t, active_mask)           /* Rules currently raised       */ \
+    X(uint16_t, changed_mask)          /* Rules changed since last     */
+
+#define TELEMETRY_DIAG_FIELDS(X) \
+    X(uint32_t, uptime_ms)             /* Full uptime (reboot check)   */ \
+    X(uint16_t, lora_ok)               /*                              */ \
+    X(uint16_t, lora_timeout)          /*                              */ \
+    X(uint16_t, lora_spi_error)        /*                              */ \
+    X(uint16_t, lora_toa_computed_ms)  /*                              */ \
+    X(uint16_t, lora_toa_measured_ms)  /*                              */ \
+    X(int16_t,  lora_toa_error_max_ms) /*                              */ \
+    X(uint16_t, fhss_ok)               /*                              */ \
+    X(uint16_t, fhss_timeout)          /*                              */ \
+    X(uint16_t, fhss_spi_error)        /*                              */ \
+    X(uint16_t, fhss_deferred)         /*                              */ \
+    X(uint16_t, fhss_toa_computed_ms)  /*                              */ \
+    X(uint16_t, fhss_toa_measured_ms)  /*                              */ \
+    X(uint16_t, sys_errors)            /* lr11xx_system_errors_t bits  */ \
+    X(uint16_t, sys_error_events)      /*                              */ \
+    X(uint32_t, spi_commands)          /*                              */ \
+    X(uint16_t, busy_timeouts)         /*                              */ \
+    X(uint16_t, busy_wait_max_us)      /* Saturated at 65535           */ \
+    X(uint32_t, busy_wait_ms)          /* Total time blocked on BUSY   */
+
+#define TELEMETRY_CAN_HEALTH_FIELDS(X) \
+    X(uint32_t, downtime_ms)           /* Ingest lost to faults, total */ \
+    X(uint32_t, recovery_max_us)       /* Slowest re-init              */ \
+    X(uint16_t, ecu_overflows)         /* RX0OVR/RX1OVR samples        */ \
+    X(uint16_t, ecu_bus_off)           /* Entries into bus-off         */ \
+    X(uint16_t, ecu_passive)           /* Entries into error-passive   */ \
+    X(uint16_t, ecu_recoveries)        /* Successful re-inits          */ \
+    X(uint16_t, chassis_overflows)     /*                              */ \
+    X(uint16_t, chassis_bus_off)       /*                              */ \
+    X(uint16_t, chassis_passive)       /*                              */ \
+    X(uint16_t, chassis_recoveries)    /*                              */ \
+    X(uint8_t,  ecu_tec)               /* Last TEC                     */ \
+    X(uint8_t,  ecu_rec)               /* Last REC                     */ \
+    X(uint8_t,  ecu_eflg)              /* Last EFLG                    */ \
+    X(uint8_t,  ecu_state)             /* can_health_state_t           */ \
+    X(uint8_t,  chassis_tec)           /*                              */ \
+    X(uint8_t,  chassis_rec)           /*                              */ \
+    X(uint8_t,  chassis_eflg)          /*                              */ \
+    X(uint8_t,  chassis_state)         /*                              */
+
+#define TELEMETRY_ESSENTIALS_FIELDS(X) \
+    X(int32_t,  latitude_e7)           /* deg × 1e7                    */ \
+    X(int32_t,  longitude_e7)          /* deg × 1e7                    */ \
+    X(uint16_t, rpm)                   /* RPM                          */ \
+    X(uint16_t, alarm_mask)            /* alarm_get_active_mask()      */ \
+    X(uint8_t,  speed_kph)             /* km/h, saturated at 255       */ \
+    X(uint8_t,  flags)                 /* bit 0: GPS fix valid         */
+
+// --- Little-endian field codecs, selected by type name ---
+
+static inline void tlm_put_uint8_t(uint8_t* p, uint8_t v) {
+    p[0] = v;
+}
+
+static inline void tlm_put_uint16_t(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void tlm_put_int16_t(uint8_t* p, int16_t v) {
+    tlm_put_uint16_t(p, (uint16_t)v);
+}
+
+static inline void tlm_put_uint32_t(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void tlm_put_int32_t(uint8_t* p, int32_t v) {
+    tlm_put_uint32_t(p, (uint32_t)v);
+}
+
+static inline uint8_t tlm_get_uint8_t(const uint8_t* p) {
+    return p[0];
+}
+
+static inline uint16_t tlm_get_uint16_t(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int16_t tlm_get_int16_t(const uint8_t* p) {
+    return (int16_t)tlm_get_uint16_t(p);
+}
+
+static inline uint32_t tlm_get_uint32_t(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline int32_t tlm_get_int32_t(const uint8_t* p) {
+    return (int32_t)tlm_get_uint32_t(p);
+}
+
+// --- Packet generator ---
+
+#define TELEMETRY_FIELD_DECLARE(type, name) type name;
+#define TELEMETRY_FIELD_SIZE(type, name)    + sizeof(type)
+#define TELEMETRY_FIELD_ALIGNED(type, name) \
+    _Static_assert(offsetof(self_t, name) % sizeof(type) == 0, \
+                   "telemetry field " #name " is not naturally aligned");
+#define TELEMETRY_FIELD_ENCODE(type, name) \
+    tlm_put_##type(out + offsetof(self_t, name), packet->name);
+#define TELEMETRY_FIELD_DECODE(type, name) \
+    packet->name = tlm_get_##type(in + offsetof(self_t, name));
+
+/**
+ * Expands, for packet `name` of telemetry_type_t `type_id`:
+ *   name_t                 packed struct (header + fields)
+ *   name_encode(p, out)    writes sizeof(name_t) little-endian bytes
+ *   name_decode(in, n, p)  returns 0, or -1 on short input / wrong type-version
+ */
+#define TELEMETRY_DEFINE_PACKET(name, type_id, FIELDS) \
+    typedef struct __attribute__((packed)) { \
+        telemetry_header_t header; \
+        FIELDS(TELEMETRY_FIELD_DECLARE) \
+    } name##_t; \
+    _Static_assert(sizeof(name##_t) == TELEMETRY_HEADER_SIZE FIELDS(TELEMETRY_FIELD_SIZE), \
+                   #name " has padding"); \
+    static inline void name##_encode(const name##_t* packet, uint8_t* out) { \
+        typedef name##_t self_t; \
+        FIELDS(TELEMETRY_FIELD_ALIGNED) \
+        out[0] = packet->header.type_version; \
+        out[1] = packet->header.seq; \
+        tlm_put_uint16_t(out + 2, packet->header.timestamp_ms); \
+        FIELDS(TELEMETRY_FIELD_ENCODE) \
+    } \
+    static inline int name##_decode(const uint8_t* in, size_t length, name##_t* packet) { \
+        typedef name##_t self_t; \
+        if (length < sizeof(self_t) || in[0] != TELEMETRY_TYPE_VERSION(type_id)) { \
+            return -1; \
+        } \
+        packet->header.type_version = in[0]; \
+        packet->header.seq = in[1]; \
+        packet->header.timestamp_ms = tlm_get_uint16_t(in + 2); \
+        FIELDS(TELEMETRY_FIELD_DECODE) \
+        return 0; \
+    }
+
+TELEMETRY_DEFINE_PACKET(telemetry_fast,    TELEMETRY_TYPE_FAST,    TELEMETRY_FAST_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_thermal, TELEMETRY_TYPE_THERMAL, TELEMETRY_THERMAL_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_gps,     TELEMETRY_TYPE_GPS,     TELEMETRY_GPS_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_lap,     TELEMETRY_TYPE_LAP,     TELEMETRY_LAP_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_alarm,   TELEMETRY_TYPE_ALARM,   TELEMETRY_ALARM_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_diag,    TELEMETRY_TYPE_DIAG,    TELEMETRY_DIAG_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_can_health, TELEMETRY_TYPE_CAN_HEALTH, TELEMETRY_CAN_HEALTH_FIELDS)
+TELEMETRY_DEFINE_PACKET(telemetry_essentials, TELEMETRY_TYPE_ESSENTIALS, TELEMETRY_ESSENTIALS_FIELDS)
+
+// Wire sizes are fixed by the schema; a change here needs a version bump
+_Static_assert(sizeof(telemetry_fast_t) == 24, "telemetry_fast size changed");
+_Static_assert(sizeof(telemetry_thermal_t) == 20, "telemetry_thermal size changed");
+_Static_assert(sizeof(telemetry_gps_t) == 20, "telemetry_gps size changed");
+_Static_assert(sizeof(telemetry_lap_t) == 20, "telemetry_lap size changed");
+_Static_assert(sizeof(telemetry_alarm_t) == 20, "telemetry_alarm size changed");
+_Static_assert(sizeof(telemetry_diag_t) == 48, "telemetry_diag size changed");
+_Static_assert(sizeof(telemetry_can_health_t) == 36, "telemetry_can_health size changed");
+_Static_assert(sizeof(telemetry_essentials_t) == 18, "telemetry_essentials size changed");
+
+// Largest packet in the family (sizes the radio buffer)
+#define TELEMETRY_MAX_PACKET_SIZE sizeof(telemetry_diag_t)
+
+/**
+ * @brief Packet type of a received frame, or 0 if it is not a packet of this
+ *        schema version (e.g. a legacy "FS26" packet from older firmware)
+ */
+static inline telemetry_type_t telemetry_peek_type(const uint8_t* in, size_t length) {
+    if (length < TELEMETRY_HEADER_SIZE || (in[0] >> 4) != TELEMETRY_SCHEMA_VERSION) {
+        return (telemetry_type_t)0;
+    }
+    uint8_t type = in[0] & 0x0F;
+    return type < TELEMETRY_NUM_TYPES ? (telemetry_type_t)type : (telemetry_type_t)0;
+}
+
+#endif // TELEMETRY_SCHEMA_H
@@ -0,0 +1,268 @@
+/**
+ * @file      alarm_sim.c
+ * @brief     Host test of the alarm rule engine (alarm_engine.c)
+ *
+ * alarm_engine.c runs unchanged with a rule table of its own, so that
+ * every rule feature has a user:
+ *   - rule 0, fixed threshold above, with hysteresis and a debounce;
+ *   - rule 1, minimum battery voltage from an RPM map (charging system),
+ *     below, with hysteresis, no debounce;
+ *   - rule 2, fixed threshold above, no debounce, CAN frame only.
+ * The run fails if:
+ *   - rule 1 trips at any value other than below the map threshold for
+ *     the latest RPM, interpolated between breakpoints and clamped at both
+ *     ends, or does not follow an RPM change while raised;
+ *   - a raised rule clears inside its hysteresis band;
+ *   - rule 0 trips before its debounce has run out, or a dip back under
+ *     the threshold does not restart the debounce;
+ *   - alarm_publish() sends a CAN frame other than one per change, or
+ *     runs the alert callback for a rule without ALARM_F_LORA;
+ *   - alarm_take_alert() does not report the changed rules and values.
+ *
+ *     cc -O2 -I. -Itools/host -DALARM_RULES_EXTERNAL=1 -o alarm_sim tools/alarm_sim.c alarm_engine.c
+ *     ./alarm_sim
+ *
+ * Options:
+ *   -s step      RPM step of the map sweep (default 7)
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alarm_engine.h"
+#include "src/mcp2515/MCP2515/MCP2515.h"
+
+#if !ALARM_RULES_EXTERNAL
+#error "build alarm_sim with -DALARM_RULES_EXTERNAL=1"
+#endif
+
+uint64_t host_time_us;
+
+// Minimum battery voltage (raw 0.01 V) against RPM
+static const alarm_map_point_t BATTERY_MAP[] = {
+    { 800,  1150 },
+    { 2000, 1250 },
+    { 4000, 1350 },
+    { 9000, 1380 },
+};
+#define BATTERY_MAP_LEN (sizeof(BATTERY_MAP) / sizeof(BATTERY_MAP[0]))
+
+enum {
+    RULE_TEMP = 0,
+    RULE_CHARGE,
+    RULE_SHIFT,
+};
+
+_Static_assert(ALARM_NUM_RULES == 3, "alarm_sim defines three rules");
+
+const alarm_rule_t ALARM_RULES[ALARM_NUM_RULES] = {
+    [RULE_TEMP] = {
+        .name = "overtemp", .channel = SAMPLE_CH_ENGINE_TEMP, .compare = ALARM_ABOVE,
+        .flags = ALARM_F_LORA, .threshold = 1050, .hysteresis = 30,
+        .debounce_us = 500000,
+    },
+    [RULE_CHARGE] = {
+        .name = "charging", .channel = SAMPLE_CH_BATTERY_VOLTAGE, .compare = ALARM_BELOW,
+        .flags = ALARM_F_LORA, .hysteresis = 20, .debounce_us = 0,
+        .map_channel = SAMPLE_CH_RPM, .map = BATTERY_MAP, .map_len = BATTERY_MAP_LEN,
+    },
+    [RULE_SHIFT] = {
+        .name = "shift", .channel = SAMPLE_CH_RPM, .compare = ALARM_ABOVE,
+        .flags = 0, .threshold = 11500, .hysteresis = 300,
+        .debounce_us = 0,
+    },
+};
+
+typedef struct {
+    uint8_t rule_id;
+    bool    active;
+    int32_t value;
+    uint16_t mask;
+} sent_frame_t;
+
+static sent_frame_t g_frames[16];
+static int g_num_frames;
+static int g_alerts;
+static int g_failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (g_failures++ < 10) { \
+            printf("[ALARM] FAIL: " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+// --- Firmware stand-ins -------------------------------------------------------
+
+void MCP2515_Send(uint32_t Canid, uint8_t* Buf, uint8_t len) {
+    CHECK(Canid == ALARM_CAN_ID && len == 8, "frame 0x%lx, %u bytes", (unsigned long)Canid, len);
+    if (g_num_frames < (int)(sizeof(g_frames) / sizeof(g_frames[0]))) {
+        sent_frame_t* f = &g_frames[g_num_frames];
+        f->mask = (uint16_t)(Buf[0] | (Buf[1] << 8));
+        f->rule_id = Buf[2];
+        f->active = Buf[3];
+        f->value = (int32_t)((uint32_t)Buf[4] | ((uint32_t)Buf[5] << 8) | ((uint32_t)Buf[6] << 16) |
+                             ((uint32_t)Buf[7] << 24));
+    }
+    g_num_frames++;
+}
+
+static void alert_callback(void) {
+    g_alerts++;
+}
+
+// --- Checks -------------------------------------------------------------------
+
+static bool active(int rule) {
+    return (alarm_get_active_mask() >> rule) & 1;
+}
+
+// Independent of the engine: exact rational threshold, rounded down
+static int32_t expected_threshold(int32_t rpm) {
+    if (rpm <= BATTERY_MAP[0].x) {
+        return BATTERY_MAP[0].y;
+    }
+    for (size_t i = 1; i < BATTERY_MAP_LEN; i++) {
+        if (rpm <= BATTERY_MAP[i].x) {
+            double t = (double)(rpm - BATTERY_MAP[i - 1].x) / (BATTERY_MAP[i].x - BATTERY_MAP[i - 1].x);
+            return BATTERY_MAP[i - 1].y + (int32_t)(t * (BATTERY_MAP[i].y - BATTERY_MAP[i - 1].y) + 1e-9);
+        }
+    }
+    return BATTERY_MAP[BATTERY_MAP_LEN - 1].y;
+}
+
+static void reset(void) {
+    alarm_init();
+    alarm_set_alert_callback(alert_callback);
+    g_num_frames = 0;
+    g_alerts = 0;
+}
+
+// Trip point of the mapped rule at every RPM of the sweep, ends included
+static void map_sweep(int32_t step) {
+    int checked = 0;
+    for (int32_t rpm = -100; rpm <= 10000; rpm += step) {
+        int32_t threshold = expected_threshold(rpm);
+        reset();
+        alarm_on_sample(SAMPLE_CH_RPM, rpm, 0);
+        alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, threshold, 0);
+        CHECK(!active(RULE_CHARGE), "rpm %ld: tripped at the threshold %ld", (long)rpm, (long)threshold);
+        alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, threshold - 1, 0);
+        CHECK(active(RULE_CHARGE), "rpm %ld: not tripped at %ld, threshold %ld", (long)rpm,
+              (long)threshold - 1, (long)threshold);
+        checked++;
+    }
+    printf("[ALARM] map: %d RPM points, threshold %ld..%ld\n", checked, (long)BATTERY_MAP[0].y,
+           (long)BATTERY_MAP[BATTERY_MAP_LEN - 1].y);
+}
+
+// A raised mapped rule clears against the threshold of the current RPM
+static void map_follows_rpm(void) {
+    reset();
+    alarm_on_sample(SAMPLE_CH_RPM, 0, 0);
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1100, 0);
+    CHECK(active(RULE_CHARGE), "1100 at idle did not trip (threshold 1150)");
+
+    // Revving raises the threshold to 1350: 1360 is inside the band
+    alarm_on_sample(SAMPLE_CH_RPM, 4000, 10);
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1360, 20);
+    CHECK(active(RULE_CHARGE), "cleared at 1360 with threshold 1350 + 20");
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1370, 30);
+    CHECK(active(RULE_CHARGE), "cleared at 1370, the edge of the band");
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1371, 40);
+    CHECK(!active(RULE_CHARGE), "still raised at 1371");
+
+    // Dropping back to idle lowers the threshold: 1200 is fine there
+    alarm_on_sample(SAMPLE_CH_RPM, 800, 50);
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1200, 60);
+    CHECK(!active(RULE_CHARGE), "1200 at 800 RPM tripped (threshold 1150)");
+    alarm_on_sample(SAMPLE_CH_RPM, 4000, 70);
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1200, 80);
+    CHECK(active(RULE_CHARGE), "1200 at 4000 RPM did not trip (threshold 1350)");
+
+    // Other channels never move the map
+    alarm_on_sample(SAMPLE_CH_MAP, 0, 90);
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1371, 100);
+    CHECK(!active(RULE_CHARGE), "map moved by another channel");
+}
+
+static void debounce_and_hysteresis(void) {
+    reset();
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1051, 1000000);
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1060, 1499999);
+    CHECK(!active(RULE_TEMP), "tripped before the 500 ms debounce");
+
+    // A dip restarts the debounce
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1050, 1400000 + 100000);
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1060, 1600000);
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1060, 2000000);
+    CHECK(!active(RULE_TEMP), "debounce not restarted by a dip to the threshold");
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1060, 2100000);
+    CHECK(active(RULE_TEMP), "not tripped 500 ms after the dip");
+
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1020, 2200000);
+    CHECK(active(RULE_TEMP), "cleared at 1020, inside the band");
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1019, 2300000);
+    CHECK(!active(RULE_TEMP), "still raised at 1019");
+
+    // Debounce starts over for the next trip
+    alarm_on_sample(SAMPLE_CH_ENGINE_TEMP, 1060, 2400000);
+    CHECK(!active(RULE_TEMP), "tripped again without a debounce");
+}
+
+static void publish_and_alert(void) {
+    reset();
+    alarm_on_sample(SAMPLE_CH_RPM, 11600, 0);
+    CHECK(active(RULE_SHIFT), "shift light not raised at 11600");
+    alarm_publish(1000);
+    CHECK(g_num_frames == 1 && g_frames[0].rule_id == RULE_SHIFT && g_frames[0].active &&
+          g_frames[0].value == 11600, "shift change: %d frames", g_num_frames);
+    CHECK(g_alerts == 0, "alert for a CAN-only rule");
+    alarm_alert_t alert;
+    CHECK(!alarm_take_alert(&alert), "LoRa alert for a CAN-only rule");
+
+    alarm_publish(2000);
+    CHECK(g_num_frames == 1, "frame sent without a change");
+    alarm_publish(1000 + ALARM_FRAME_REFRESH_US);
+    CHECK(g_num_frames == 2 && g_frames[1].rule_id == 0xFF, "no refresh frame while raised");
+
+    // Idle with the battery flat: the mapped rule raises a LoRa alert
+    alarm_on_sample(SAMPLE_CH_RPM, 800, 600000);
+    CHECK(!active(RULE_SHIFT), "shift light still raised at 800");
+    alarm_on_sample(SAMPLE_CH_BATTERY_VOLTAGE, 1100, 600001);
+    alarm_publish(600002);
+    CHECK(g_num_frames == 4, "%d frames for two changes", g_num_frames - 2);
+    CHECK(g_alerts == 1, "%d alert callbacks for one LoRa rule change", g_alerts);
+    CHECK(alarm_take_alert(&alert) && alert.changed_mask == (1u << RULE_CHARGE) &&
+          alert.active_mask == (1u << RULE_CHARGE) && alert.values[RULE_CHARGE] == 1100,
+          "alert masks 0x%x/0x%x", alert.active_mask, alert.changed_mask);
+    CHECK(!alarm_take_alert(&alert), "alert taken twice");
+}
+
+int main(int argc, char** argv) {
+    int32_t step = 7;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        switch (opt) {
+            case 's': step = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s rpm step]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (step < 1) {
+        fprintf(stderr, "step >= 1\n");
+        return 2;
+    }
+
+    map_sweep(step);
+    map_follows_rpm();
+    debounce_and_hysteresis();
+    publish_and_alert();
+
+    printf("[ALARM] %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file      auth_sim.c
+ * @brief     Host test of telemetry_auth.c: seal on the car, open on the receiver
+ *
+ * The car side runs telemetry_auth.c unchanged. The LR1121 crypto engine
+ * is modelled with aes_soft.c, and config_store with a block whose boot
+ * count the sim sets before each "boot". Frames go through
+ * telemetry_auth_send() into a capture buffer and are opened with
+ * telemetry_auth_open(), as a receiver does.
+ *
+ * Each boot sends frames of every length up to TELEMETRY_MAX_PACKET_SIZE,
+ * with random payloads, and some are lost on the way. The run fails if:
+ *   - a frame does not open to its payload, or opens after a bit flip or
+ *     with the keys swapped;
+ *   - a frame opens twice, or after a newer frame of its session;
+ *   - a frame recorded in an earlier boot opens after a later boot's frame,
+ *     or two boots encrypt with the same keystream;
+ *   - a boot count outside 1..65535 lets anything be sent;
+ *   - a faulty crypto engine is used instead of falling back to software.
+ *
+ *     cc -O2 -I. -Itools/host -Isrc/gpio -Isrc/spi -Isrc/lr1121 -Isrc/lr1121/lr1121_printers \
+ *        -Isrc/lr1121/lr1121_modem -Isrc/lr1121/lr1121_common -Isrc/lr1121/lr11xx_driver \
+ *        -DTELEMETRY_AUTH_MODE=2 -DTELEMETRY_AUTH_DEV_KEYS=1 \
+ *        -o auth_sim tools/auth_sim.c telemetry_auth.c aes_soft.c
+ *     ./auth_sim -b 20
+ *
+ * Options:
+ *   -b boots     Boots to simulate (default 8)
+ *   -n frames    Frames per boot (default 500)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aes_soft.h"
+#include "config_store.h"
+#include "lr1121_tx.h"
+#include "lr11xx_crypto_engine.h"
+#include "telemetry_auth.h"
+#include "telemetry_packet.h"
+
+#if TELEMETRY_AUTH_MODE != TELEMETRY_AUTH_ENCRYPT
+#error "build auth_sim with -DTELEMETRY_AUTH_MODE=2"
+#endif
+
+#define MAX_FRAME   (TELEMETRY_MAX_PACKET_SIZE + TELEMETRY_AUTH_OVERHEAD)
+#define KEY_SLOTS   64
+
+uint64_t host_time_us;
+mutex_t printf_mutex;
+lr1121_t lr1121;
+
+static daq_config_t g_sim_config;
+const daq_config_t* volatile g_config_active = &g_sim_config;
+
+static const uint8_t MAC_KEY[16] = TELEMETRY_AUTH_MAC_KEY;
+static const uint8_t ENC_KEY[16] = TELEMETRY_AUTH_ENC_KEY;
+
+static int g_failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (g_failures++ < 10) { \
+            printf("[AUTH] FAIL: " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+// --- LR1121 crypto engine model ---------------------------------------------
+
+static uint8_t g_engine_keys[KEY_SLOTS][16];
+static bool g_engine_faulty;        // Wrong results with a success status
+static uint32_t g_engine_calls;
+
+lr11xx_status_t lr11xx_crypto_set_key(const void* context, lr11xx_crypto_status_t* status,
+                                      const uint8_t key_id, const lr11xx_crypto_key_t key) {
+    (void)context;
+    if (key_id >= KEY_SLOTS) {
+        *status = LR11XX_CRYPTO_STATUS_ERROR_INVALID_KEY_ID;
+        return LR11XX_STATUS_OK;
+    }
+    memcpy(g_engine_keys[key_id], key, 16);
+    *status = LR11XX_CRYPTO_STATUS_SUCCESS;
+    return LR11XX_STATUS_OK;
+}
+
+lr11xx_status_t lr11xx_crypto_compute_aes_cmac(const void* context, lr11xx_crypto_status_t* status,
+                                               const uint8_t key_id, const uint8_t* data,
+                                               const uint16_t length, lr11xx_crypto_mic_t mic) {
+    (void)context;
+    aes128_ctx_t ctx;
+    uint8_t full[AES_BLOCK_SIZE];
+    aes128_init(&ctx, g_engine_keys[key_id]);
+    aes128_cmac(&ctx, data, length, full);
+    memcpy(mic, full, LR11XX_CRYPTO_MIC_LENGTH);
+    if (g_engine_faulty) {
+        mic[0] ^= 0x01;
+    }
+    g_engine_calls++;
+    *status = LR11XX_CRYPTO_STATUS_SUCCESS;
+    return LR11XX_STATUS_OK;
+}
+
+lr11xx_status_t lr11xx_crypto_aes_encrypt(const void* context, lr11xx_crypto_status_t* status,
+                                          const uint8_t key_id, const uint8_t* data,
+                                          const uint16_t length, uint8_t* result) {
+    (void)context;
+    aes128_ctx_t ctx;
+    aes128_init(&ctx, g_engine_keys[key_id]);
+    aes128_ecb_encrypt(&ctx, data, length, result);
+    if (g_engine_faulty) {
+        result[length - 1] ^= 0x80;
+    }
+    g_engine_calls++;
+    *status = LR11XX_CRYPTO_STATUS_SUCCESS;
+    return LR11XX_STATUS_OK;
+}
+
+// --- Radio: every send lands in the capture buffer ----------------------------
+
+static uint8_t g_air[MAX_FRAME];
+static uint8_t g_air_length;
+static uint32_t g_air_frames;
+
+static bool capture(const uint8_t* data, uint8_t length) {
+    memcpy(g_air, data, length);
+    g_air_length = length;
+    g_air_frames++;
+    return true;
+}
+
+bool lora_send(const uint8_t* data, uint8_t length) {
+    return capture(data, length);
+}
+
+bool lora_send_critical(const uint8_t* data, uint8_t length) {
+    return capture(data, length);
+}
+
+bool lr_fhss_send(const uint8_t* data, uint8_t length) {
+    return capture(data, length);
+}
+
+// --- Checks -------------------------------------------------------------------
+
+typedef struct {
+    uint8_t frame[MAX_FRAME];
+    uint8_t length;
+} recorded_t;
+
+static uint32_t g_boots = 8;
+static uint32_t g_frames_per_boot = 500;
+static unsigned g_seed = 1;
+
+static bool boot(uint32_t boot_count) {
+    g_sim_config.boot_count = boot_count;
+    return telemetry_auth_init();
+}
+
+static int open_frame(const uint8_t* frame, uint8_t length, uint8_t* payload,
+                      telemetry_auth_rx_state_t* rx) {
+    return telemetry_auth_open(MAC_KEY, ENC_KEY, frame, length, payload, rx);
+}
+
+// Every single-bit change to the frame must be caught by the MIC
+static void check_bit_flips(const recorded_t* rec, const telemetry_auth_rx_state_t* rx) {
+    uint8_t frame[MAX_FRAME];
+    uint8_t payload[MAX_FRAME];
+    for (uint16_t bit = 0; bit < rec->length * 8u; bit++) {
+        telemetry_auth_rx_state_t copy = *rx;
+        memcpy(frame, rec->frame, rec->length);
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        CHECK(open_frame(frame, rec->length, payload, &copy) < 0,
+              "bit %u flipped in a %u-byte frame still opens", bit, rec->length);
+    }
+}
+
+// One boot: send, lose some, open the rest in order with the receiver's state
+static void run_boot(uint32_t boot_count, telemetry_auth_rx_state_t* rx, recorded_t* first,
+                     recorded_t* last, unsigned* seed) {
+    uint8_t payload[TELEMETRY_MAX_PACKET_SIZE];
+    uint8_t opened[MAX_FRAME];
+    recorded_t previous = { .length = 0 };
+
+    for (uint32_t i = 0; i < g_frames_per_boot; i++) {
+        uint8_t length = (uint8_t)(i % (TELEMETRY_MAX_PACKET_SIZE + 1));
+        for (uint8_t b = 0; b < length; b++) {
+            payload[b] = (uint8_t)rand_r(seed);
+        }
+
+        uint32_t before = g_air_frames;
+        bool sent = (i % 3 == 0) ? telemetry_auth_send_critical(payload, length)
+                  : (i % 3 == 1) ? telemetry_auth_send(payload, length)
+                                 : telemetry_auth_send_lr_fhss(payload, length);
+        bool fits = length + TELEMETRY_AUTH_OVERHEAD <= (i % 3 == 2 ? LR_FHSS_MAX_PAYLOAD_LENGTH : PAYLOAD_LENGTH);
+        CHECK(sent == fits, "boot %lu frame %lu: %u bytes sent %d", (unsigned long)boot_count,
+              (unsigned long)i, length, sent);
+        if (!sent || g_air_frames == before) {
+            continue;
+        }
+
+        recorded_t rec;
+        memcpy(rec.frame, g_air, g_air_length);
+        rec.length = g_air_length;
+        CHECK(rec.length == length + TELEMETRY_AUTH_OVERHEAD, "frame length %u for %u payload bytes",
+              rec.length, length);
+        if (i == 0) {
+            *first = rec;
+        }
+        *last = rec;
+
+        // Lost on the way: the receiver never sees it, later frames still open
+        if (rand_r(seed) % 8 == 0) {
+            continue;
+        }
+
+        if (i % 64 == 5) {
+            check_bit_flips(&rec, rx);
+        }
+
+        // Wrong key and wrong session expectations never open, nor touch rx
+        telemetry_auth_rx_state_t copy = *rx;
+        CHECK(telemetry_auth_open(ENC_KEY, MAC_KEY, rec.frame, rec.length, opened, &copy) < 0,
+              "frame opens with the keys swapped");
+        CHECK(memcmp(&copy, rx, sizeof(copy)) == 0, "rejected frame changed the rx state");
+
+        int n = open_frame(rec.frame, rec.length, opened, rx);
+        CHECK(n == length && memcmp(opened, payload, length) == 0,
+              "boot %lu frame %lu did not open (%d)", (unsigned long)boot_count, (unsigned long)i, n);
+
+        // In-session replays: the same frame again, then the one before it
+        copy = *rx;
+        CHECK(open_frame(rec.frame, rec.length, opened, &copy) < 0, "frame opens twice");
+        if (previous.length) {
+            CHECK(open_frame(previous.frame, previous.length, opened, &copy) < 0,
+                  "older frame of the session opens after a newer one");
+        }
+        previous = rec;
+    }
+}
+
+// Same payload, same counter, next boot: the ciphertext must change
+static void check_keystream_per_session(uint32_t boot_count) {
+    uint8_t payload[TELEMETRY_MAX_PACKET_SIZE] = { 0 };
+    uint8_t a[MAX_FRAME], b[MAX_FRAME];
+
+    boot(boot_count);
+    int la = telemetry_auth_wrap(payload, sizeof(payload), true, a, sizeof(a));
+    boot(boot_count + 1);
+    int lb = telemetry_auth_wrap(payload, sizeof(payload), true, b, sizeof(b));
+    CHECK(la > 0 && la == lb, "wrap failed (%d, %d)", la, lb);
+    CHECK(memcmp(a + sizeof(telemetry_auth_header_t), b + sizeof(telemetry_auth_header_t),
+                 sizeof(payload)) != 0, "boots %lu and %lu share a keystream",
+          (unsigned long)boot_count, (unsigned long)boot_count + 1);
+}
+
+static void check_session_limits(void) {
+    uint8_t payload[8] = { 0 };
+    uint8_t frame[MAX_FRAME];
+    static const uint32_t INVALID[] = { 0, 65536, 100000 };
+
+    for (size_t i = 0; i < sizeof(INVALID) / sizeof(INVALID[0]); i++) {
+        uint32_t before = g_air_frames;
+        boot(INVALID[i]);
+        CHECK(telemetry_auth_wrap(payload, sizeof(payload), true, frame, sizeof(frame)) < 0,
+              "boot count %lu wraps a frame", (unsigned long)INVALID[i]);
+        CHECK(!telemetry_auth_send(payload, sizeof(payload)) && g_air_frames == before,
+              "boot count %lu sends a frame", (unsigned long)INVALID[i]);
+    }
+
+    boot(UINT16_MAX);
+    CHECK(telemetry_auth_wrap(payload, sizeof(payload), true, frame, sizeof(frame)) > 0,
+          "the last session does not send");
+    CHECK(telemetry_auth_wrap(payload, sizeof(payload), true, frame,
+                              sizeof(payload) + TELEMETRY_AUTH_OVERHEAD - 1) < 0,
+          "a frame wraps into a buffer one byte short");
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "b:n:s:")) != -1) {
+        switch (opt) {
+            case 'b': g_boots = (uint32_t)atol(optarg); break;
+            case 'n': g_frames_per_boot = (uint32_t)atol(optarg); break;
+            case 's': g_seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-b boots] [-n frames] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (g_boots < 2) {
+        fprintf(stderr, "at least 2 boots\n");
+        return 2;
+    }
+    printf("[AUTH] %lu boots, %lu frames per boot\n", (unsigned long)g_boots,
+           (unsigned long)g_frames_per_boot);
+
+    unsigned seed = g_seed;
+    telemetry_auth_rx_state_t rx = { 0 };
+    recorded_t old_first = { .length = 0 }, old_last = { .length = 0 };
+    uint8_t opened[MAX_FRAME];
+
+    // Boot counts skip now and then: boots without a receiver in range
+    uint32_t boot_count = 1 + rand_r(&seed) % 100;
+    for (uint32_t b = 0; b < g_boots; b++) {
+        // Every other boot the engine is faulty and the software path takes over
+        g_engine_faulty = (b % 2) == 1;
+        bool radio = boot(boot_count);
+        CHECK(radio == !g_engine_faulty, "boot %lu: LR1121 engine %s", (unsigned long)boot_count,
+              radio ? "used although faulty" : "not used");
+
+        recorded_t first = { .length = 0 }, last = { .length = 0 };
+        uint32_t calls_init = g_engine_calls;
+        run_boot(boot_count, &rx, &first, &last, &seed);
+        CHECK(g_engine_faulty ? g_engine_calls == calls_init : g_engine_calls > calls_init,
+              "boot %lu: %lu engine calls after init", (unsigned long)boot_count,
+              (unsigned long)(g_engine_calls - calls_init));
+
+        // Cross-session replay: the last boot's frames, even ones with a
+        // counter above anything sent in this boot, stay rejected
+        if (old_first.length) {
+            telemetry_auth_rx_state_t copy = rx;
+            CHECK(open_frame(old_first.frame, old_first.length, opened, &copy) < 0,
+                  "first frame of the previous boot opens in boot %lu", (unsigned long)boot_count);
+            CHECK(open_frame(old_last.frame, old_last.length, opened, &copy) < 0,
+                  "last frame of the previous boot opens in boot %lu", (unsigned long)boot_count);
+
+            // A receiver that starts fresh takes whichever session it hears
+            // first; only a kept rx state protects across transmitter reboots
+            telemetry_auth_rx_state_t fresh = { 0 };
+            CHECK(open_frame(old_last.frame, old_last.length, opened, &fresh) >= 0,
+                  "a fresh receiver rejects a valid frame");
+        }
+        old_first = first;
+        old_last = last;
+
+        boot_count += 1 + (rand_r(&seed) % 4 == 0 ? rand_r(&seed) % 3 : 0);
+        if (boot_count > UINT16_MAX) {
+            break;
+        }
+    }
+
+    g_engine_faulty = false;
+    check_keystream_per_session(boot_count);
+    check_session_limits();
+
+    printf("[AUTH] %lu frames sent, %lu LR1121 engine calls\n", (unsigned long)g_air_frames,
+           (unsigned long)g_engine_calls);
+    printf("[AUTH] %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,269 @@
+/**
+ * @file      can_bitstream_sim.c
+ * @brief     Host test of the CAN bit-level codec (can_bitstream.c)
+ *
+ * Random standard, extended and remote frames are encoded onto one
+ * simulated wire with random idle gaps between them. The wire is sampled
+ * into 32-bit words at a random bit offset and fed to
+ * can_bitstream_push_word(), as can_pio.c does with the PIO's DMA buffer.
+ * The run fails if:
+ *   - the stuffed stream of a frame holds six equal bits before the CRC
+ *     delimiter;
+ *   - a frame does not decode to exactly what was sent, in order, or the
+ *     decoder counts an error on the clean wire.
+ *
+ * Then each of a set of frames is sent with one bit flipped between SOF
+ * and the CRC delimiter. An error frame follows, as the other nodes on the
+ * bus send one, and then the clean retransmission. The run fails if the
+ * corrupted copy decodes as a frame, or if the retransmission does not
+ * decode. The report counts each detection by error type.
+ *
+ *     cc -O2 -I. -o can_bitstream_sim tools/can_bitstream_sim.c can_bitstream.c
+ *     ./can_bitstream_sim -n 100000 -c 100000
+ *
+ * Options:
+ *   -n frames    Frames in the clean round trip (default 1500)
+ *   -c count     Single-bit corruptions (default 1000)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can_bitstream.h"
+
+#define ERROR_FLAG_BITS     6       // Dominant error flag
+#define ERROR_DELIM_BITS    8       // Recessive error delimiter
+#define INTERMISSION_BITS   3
+#define TRAILER_BITS        10      // CRC delimiter, ACK slot, ACK delimiter, EOF
+
+typedef struct {
+    uint8_t* bits;
+    size_t   count;
+    size_t   capacity;
+} wire_t;
+
+typedef struct {
+    can_frame_t frame;
+    size_t      end_bit;            // Wire bit that completed it
+} decoded_t;
+
+static unsigned g_seed = 1;
+static int g_failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (g_failures++ < 10) { \
+            printf("[BITS] FAIL: " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+static uint32_t random_u32(void) {
+    return ((uint32_t)rand_r(&g_seed) << 16) ^ (uint32_t)rand_r(&g_seed);
+}
+
+static void wire_put(wire_t* wire, uint8_t bit, size_t count) {
+    if (wire->count + count > wire->capacity) {
+        wire->capacity = (wire->capacity + count) * 2;
+        wire->bits = realloc(wire->bits, wire->capacity);
+        if (!wire->bits) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+    }
+    memset(&wire->bits[wire->count], bit, count);
+    wire->count += count;
+}
+
+static void random_frame(can_frame_t* frame) {
+    memset(frame, 0, sizeof(*frame));
+    frame->extended = rand_r(&g_seed) % 2;
+    frame->id = random_u32() & (frame->extended ? 0x1FFFFFFF : 0x7FF);
+    frame->rtr = rand_r(&g_seed) % 8 == 0;
+    frame->dlc = (uint8_t)(rand_r(&g_seed) % 9);
+    if (!frame->rtr) {
+        // Some frames all zeros or all ones, to get long stuffing runs
+        int fill = rand_r(&g_seed) % 4;
+        for (int i = 0; i < frame->dlc; i++) {
+            frame->data[i] = fill == 0 ? 0x00 : fill == 1 ? 0xFF : (uint8_t)rand_r(&g_seed);
+        }
+    }
+}
+
+// Encode onto the wire; returns the first bit of the frame
+static size_t put_frame(wire_t* wire, const can_frame_t* frame, int* length) {
+    uint8_t bits[CAN_BITSTREAM_MAX_BITS];
+    int n = can_bitstream_encode(frame, true, bits, sizeof(bits));
+    CHECK(n > 0, "frame 0x%lx did not encode", (unsigned long)frame->id);
+    if (n <= 0) {
+        *length = 0;
+        return wire->count;
+    }
+
+    // Stuffing: never six equal bits from SOF to the last CRC (or stuff) bit
+    int run = 1;
+    for (int i = 1; i < n - TRAILER_BITS; i++) {
+        run = bits[i] == bits[i - 1] ? run + 1 : 1;
+        CHECK(run <= 5, "frame 0x%lx: %d equal bits at %d", (unsigned long)frame->id, run, i);
+    }
+
+    size_t start = wire->count;
+    for (int i = 0; i < n; i++) {
+        wire_put(wire, bits[i], 1);
+    }
+    *length = n;
+    return start;
+}
+
+// Sample the wire into MSB-first words starting `offset` bits into a word
+// (leading recessive padding), and decode every word
+static size_t decode_wire(const wire_t* wire, can_bitstream_decoder_t* dec, int offset,
+                          decoded_t* out, size_t max_out) {
+    size_t found = 0;
+    size_t total = wire->count + (size_t)offset;
+    for (size_t w = 0; w * 32 < total; w++) {
+        uint32_t word = 0;
+        for (int b = 0; b < 32; b++) {
+            size_t pos = w * 32 + (size_t)b;
+            uint8_t bit = (pos < (size_t)offset || pos >= total) ? 1 : wire->bits[pos - (size_t)offset];
+            word = (word << 1) | bit;
+        }
+        can_frame_t frame;
+        int index = can_bitstream_push_word(dec, word, &frame);
+        if (index >= 0 && found < max_out) {
+            out[found].frame = frame;
+            out[found].end_bit = w * 32 + (size_t)index - (size_t)offset;
+            found++;
+        } else if (index >= 0) {
+            found++;
+        }
+    }
+    return found;
+}
+
+static bool same_frame(const can_frame_t* a, const can_frame_t* b) {
+    if (a->id != b->id || a->extended != b->extended || a->rtr != b->rtr || a->dlc != b->dlc) {
+        return false;
+    }
+    return a->rtr || memcmp(a->data, b->data, a->dlc) == 0;
+}
+
+static void round_trip(uint32_t count) {
+    wire_t wire = { 0 };
+    can_frame_t* sent = calloc(count, sizeof(*sent));
+    decoded_t* got = calloc(count + 1, sizeof(*got));
+    if (!sent || !got) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+
+    wire_put(&wire, 1, CAN_BITSTREAM_IDLE_BITS);
+    for (uint32_t i = 0; i < count; i++) {
+        int length;
+        random_frame(&sent[i]);
+        put_frame(&wire, &sent[i], &length);
+        // Intermission, sometimes a longer idle bus
+        wire_put(&wire, 1, INTERMISSION_BITS + (rand_r(&g_seed) % 4 == 0 ? rand_r(&g_seed) % 100 : 0));
+    }
+
+    can_bitstream_decoder_t dec;
+    can_bitstream_decoder_init(&dec);
+    size_t found = decode_wire(&wire, &dec, rand_r(&g_seed) % 32, got, count + 1);
+
+    CHECK(found == count, "%lu frames sent, %lu decoded", (unsigned long)count, (unsigned long)found);
+    for (uint32_t i = 0; i < count && i < found; i++) {
+        CHECK(same_frame(&sent[i], &got[i].frame), "frame %lu: sent 0x%lx dlc %u, decoded 0x%lx dlc %u",
+              (unsigned long)i, (unsigned long)sent[i].id, sent[i].dlc,
+              (unsigned long)got[i].frame.id, got[i].frame.dlc);
+    }
+    CHECK(dec.stats.frames == count && dec.stats.stuff_errors == 0 && dec.stats.crc_errors == 0 &&
+          dec.stats.form_errors == 0, "clean wire: %lu frames, %lu stuff, %lu CRC, %lu form errors",
+          (unsigned long)dec.stats.frames, (unsigned long)dec.stats.stuff_errors,
+          (unsigned long)dec.stats.crc_errors, (unsigned long)dec.stats.form_errors);
+
+    printf("[BITS] round trip: %lu frames, %lu bits on the wire, %lu decoded\n", (unsigned long)count,
+           (unsigned long)wire.count, (unsigned long)found);
+    free(wire.bits);
+    free(sent);
+    free(got);
+}
+
+static void corruptions(uint32_t count) {
+    can_bitstream_stats_t detected = { 0 };
+    uint32_t undetected = 0;
+
+    can_bitstream_decoder_t dec;
+    can_bitstream_decoder_init(&dec);
+    wire_t wire = { 0 };
+
+    for (uint32_t i = 0; i < count; i++) {
+        can_frame_t frame;
+        int length;
+        random_frame(&frame);
+
+        // Corrupted copy, then the error frame and the retransmission
+        wire.count = 0;
+        wire_put(&wire, 1, CAN_BITSTREAM_IDLE_BITS);
+        size_t start = put_frame(&wire, &frame, &length);
+        if (length == 0) {
+            continue;
+        }
+        int flip = rand_r(&g_seed) % (length - TRAILER_BITS + 1);   // SOF .. CRC delimiter
+        wire.bits[start + (size_t)flip] ^= 1;
+        size_t corrupt_end = wire.count;
+        wire_put(&wire, 0, ERROR_FLAG_BITS);
+        wire_put(&wire, 1, ERROR_DELIM_BITS + INTERMISSION_BITS);
+        put_frame(&wire, &frame, &length);
+        wire_put(&wire, 1, INTERMISSION_BITS);
+
+        can_bitstream_stats_t before = dec.stats;
+        decoded_t got[4];
+        size_t found = decode_wire(&wire, &dec, rand_r(&g_seed) % 32, got, 4);
+
+        size_t early = 0;
+        for (size_t k = 0; k < found && k < 4; k++) {
+            early += got[k].end_bit < corrupt_end;
+        }
+        if (early) {
+            undetected++;
+            CHECK(false, "frame 0x%lx dlc %u with bit %d of %d flipped decoded", (unsigned long)frame.id,
+                  frame.dlc, flip, length);
+        }
+        CHECK(found == early + 1 && found <= 4 && same_frame(&got[found - 1].frame, &frame),
+              "retransmission after bit %d flipped: %lu frames decoded", flip, (unsigned long)found);
+
+        detected.stuff_errors += dec.stats.stuff_errors - before.stuff_errors;
+        detected.crc_errors += dec.stats.crc_errors - before.crc_errors;
+        detected.form_errors += dec.stats.form_errors - before.form_errors;
+    }
+
+    printf("[BITS] %lu single-bit corruptions: %lu stuff, %lu CRC, %lu form errors, %lu undetected\n",
+           (unsigned long)count, (unsigned long)detected.stuff_errors, (unsigned long)detected.crc_errors,
+           (unsigned long)detected.form_errors, (unsigned long)undetected);
+    free(wire.bits);
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 1500;
+    uint32_t corrupt = 1000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:s:")) != -1) {
+        switch (opt) {
+            case 'n': frames = (uint32_t)atol(optarg); break;
+            case 'c': corrupt = (uint32_t)atol(optarg); break;
+            case 's': g_seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames] [-c corruptions] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    round_trip(frames);
+    corruptions(corrupt);
+
+    printf("[BITS] %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}
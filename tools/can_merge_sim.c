@@ -0,0 +1,598 @@
+/**
+ * @file      can_merge_sim.c
+ * @brief     Host test of the two-MCP2515 merge in can_handler.c
+ *
+ * can_handler.c and the MCP2515 driver run unchanged against two modelled
+ * controllers on a byte-timed SPI bus. Each model has the registers the
+ * driver touches: RXB0 with rollover into RXB1, CANINTF, EFLG and CANSTAT,
+ * an INT line that is low while an enabled flag is set, and an RX overflow
+ * when a frame finds no free buffer. Now and then a bus error sets MERRF.
+ * The ECU bus carries M84 bursts at 1 Mbit/s and the chassis bus carries
+ * FT550 frames at 500 kbit/s, on unrelated clocks. An INT falling edge
+ * calls the handler's ISR at the frame's arrival time. Frames that land
+ * during an SPI transfer are delivered at their arrival time. Core 0 runs
+ * can_ingest_task's drain loop whenever INT is low, except while another
+ * task is running.
+ *
+ * A frame's arrival stamp is its own INT edge. A frame that waited behind
+ * another one in the same controller is stamped when the frame in front
+ * was read. The run fails if:
+ *   - a frame is lost or duplicated beyond the counted RX overflows, or a
+ *     bus delivers its frames out of order;
+ *   - the driver clears an RX flag before reading that buffer, or clears
+ *     ERRIF or MERRF, which belong to the CAN health poll;
+ *   - can_process_frame() serves a bus whose oldest frame is stamped later
+ *     than the other bus's oldest frame;
+ *   - a decoder gets a timestamp other than the frame's arrival stamp;
+ *   - a frame with an exact INT edge stamp is overtaken by a frame from the
+ *     other bus that arrived after it.
+ * Frames that waited behind another can be overtaken. The run reports how
+ * many are, and by how much.
+ *
+ *     cc -O2 -I. -Itools/host -Isrc/mcp2515/Config -Isrc/mcp2515/MCP2515 -DCAN_PROFILER_ENABLED=1 \
+ *        -o can_merge_sim tools/can_merge_sim.c can_handler.c decode_kernel.c ft550_decoder.c \
+ *        src/mcp2515/MCP2515/MCP2515.c
+ *     ./can_merge_sim -b 500
+ *
+ * Options:
+ *   -t seconds   Simulated time (default 60)
+ *   -b us        Longest time another core 0 task runs (default 300)
+ *   -r ns        One SPI byte at 10 MHz, chip select and call overhead included (default 1000)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can_autobaud.h"
+#include "can_handler.h"
+#include "can_pio.h"
+#include "can_profiler.h"
+#include "alarm_engine.h"
+#include "sample_queue.h"
+#include "DEV_Config.h"
+#include "MCP2515.h"
+
+#if !CAN_PROFILER_ENABLED
+#error "build can_merge_sim with -DCAN_PROFILER_ENABLED=1"
+#endif
+
+#define RX_BUFFERS      2           // RXB0, RXB1
+#define MERR_ODDS       256         // One frame in this many follows a bus error
+
+uint64_t host_time_us;
+
+static int g_failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (g_failures++ < 10) { \
+            printf("[MERGE] FAIL: " __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+// --- Traffic and MCP2515 model ------------------------------------------------
+
+typedef struct {
+    uint32_t seq;                   // Per-bus frame number
+    uint32_t arrival_us;            // End of frame on the wire
+    uint32_t stamp_us;              // Arrival stamp the merge should use
+    bool     exact;                 // Stamped by its own INT edge
+} frame_t;
+
+typedef struct {
+    const MCP2515_Dev* dev;
+    uint32_t id;
+    // Traffic
+    uint32_t next_arrival_us;
+    uint32_t period_us;             // Start of one burst to the next
+    uint32_t gap_us;                // Frame to frame within a burst
+    uint32_t burst;                 // Frames per burst
+    uint32_t in_burst;
+    uint32_t sent;
+    // Controller
+    uint8_t  regs[128];
+    frame_t  rx[RX_BUFFERS];        // Frame in RXBn, valid while RXnIF is set
+    bool     consumed[RX_BUFFERS];  // Its last data byte has been read
+    uint32_t overflows;
+    uint32_t bus_errors;            // MERRF set
+    bool     restamp;               // A buffer was released in this can_process_frame()
+    // Receiver side
+    uint32_t delivered;
+    uint32_t next_seq;              // Oldest frame the bus may still deliver
+    uint32_t skipped;               // Frames never delivered
+} sim_bus_t;
+
+static sim_bus_t g_sim[CAN_NUM_BUSES] = {
+    [CAN_BUS_ECU]     = { &MCP2515_DEV0, 0x100,      0, 10000, 135, 12 },
+    [CAN_BUS_CHASSIS] = { &MCP2515_DEV1, 0x14080603, 0, 10007, 270, 4 },
+};
+
+static gpio_irq_callback_t g_int_callback;
+static unsigned g_seed = 1;
+static uint32_t g_byte_ns = 1000;
+static uint32_t g_spi_ns;           // Fraction of a microsecond carried over
+static bool g_traffic;              // Buses running (after can_init())
+
+// SPI transaction in progress
+static sim_bus_t* g_spi_bus;        // Chip selected, NULL = none
+static int g_spi_phase;             // Bytes so far
+static uint8_t g_spi_instr;
+static uint8_t g_spi_addr;
+static uint8_t g_spi_mask;
+
+static frame_t g_popped;            // Frame the driver read last
+static int g_popped_bus = -1;
+static frame_t g_served;            // Frame the last can_process_frame() decoded
+static int g_served_bus = -1;
+
+// Frames overtaken by a later frame from the other bus
+static uint32_t g_inversions;
+static uint32_t g_worst_inversion_us;
+
+static const uint8_t RX_FLAG[RX_BUFFERS] = { RX0IF, RX1IF };
+static const uint8_t RX_BASE[RX_BUFFERS] = { RXB0SIDH, RXB1SIDH };
+
+static uint32_t jitter(int max) {
+    return (uint32_t)(rand_r(&g_seed) % (2 * max + 1)) - (uint32_t)max;
+}
+
+static bool int_low(const sim_bus_t* bus) {
+    return (bus->regs[CANINTF] & bus->regs[CANINTE]) != 0;
+}
+
+static uint32_t frames_held(const sim_bus_t* bus) {
+    return !!(bus->regs[CANINTF] & RX0IF) + !!(bus->regs[CANINTF] & RX1IF);
+}
+
+// Oldest unread frame, NULL if both buffers are free
+static frame_t* oldest_frame(sim_bus_t* bus) {
+    frame_t* oldest = NULL;
+    for (int n = 0; n < RX_BUFFERS; n++) {
+        if ((bus->regs[CANINTF] & RX_FLAG[n]) &&
+            (!oldest || (int32_t)(bus->rx[n].arrival_us - oldest->arrival_us) < 0)) {
+            oldest = &bus->rx[n];
+        }
+    }
+    return oldest;
+}
+
+static uint32_t frame_id(const sim_bus_t* bus, const frame_t* frame) {
+    return bus->id + (bus->id == 0x100 ? 0 : frame->seq % 4);
+}
+
+// SIDH, SIDL, EID8, EID0, DLC and eight zero data bytes, then RXnIF
+static void load_frame(sim_bus_t* bus, int n, const frame_t* frame) {
+    uint8_t* r = &bus->regs[RX_BASE[n]];
+    uint32_t id = frame_id(bus, frame);
+    if (id > 0x7FF) {
+        uint32_t sid = id >> 18;
+        r[0] = (uint8_t)(sid >> 3);
+        r[1] = (uint8_t)(((sid & 0x07) << 5) | 0x08 | ((id >> 16) & 0x03));
+        r[2] = (uint8_t)(id >> 8);
+        r[3] = (uint8_t)id;
+    } else {
+        r[0] = (uint8_t)(id >> 3);
+        r[1] = (uint8_t)((id & 0x07) << 5);
+        r[2] = 0;
+        r[3] = 0;
+    }
+    r[4] = 8;
+    memset(&r[5], 0, 8);
+    bus->rx[n] = *frame;
+    bus->consumed[n] = false;
+    bus->regs[CANINTF] |= RX_FLAG[n];
+}
+
+// Every frame that has finished on either wire by now lands in its
+// controller, in arrival order: RXB0 if free, else RXB1 with rollover on
+static void deliver_arrivals(uint64_t now) {
+    while (g_traffic) {
+        sim_bus_t* next = NULL;
+        for (int b = 0; b < CAN_NUM_BUSES; b++) {
+            if (!next || (int32_t)(g_sim[b].next_arrival_us - next->next_arrival_us) < 0) {
+                next = &g_sim[b];
+            }
+        }
+        if ((int32_t)(next->next_arrival_us - (uint32_t)now) > 0) {
+            return;
+        }
+
+        bool was_low = int_low(next);
+        frame_t frame = { .seq = next->sent++, .arrival_us = next->next_arrival_us };
+        frame.stamp_us = frame.arrival_us;
+        frame.exact = !was_low;
+        if (rand_r(&g_seed) % MERR_ODDS == 0) {
+            next->regs[CANINTF] |= MERRF;
+            next->bus_errors++;
+        }
+
+        uint8_t flags = next->regs[CANINTF];
+        bool rollover = next->regs[RXB0CTRL] & BUKT;
+        if (!(flags & RX0IF)) {
+            load_frame(next, 0, &frame);
+        } else if (rollover && !(flags & RX1IF)) {
+            load_frame(next, 1, &frame);
+        } else {
+            next->overflows++;
+            next->regs[EFLG] |= rollover ? RX1OVR : RX0OVR;
+            next->regs[CANINTF] |= ERRIF;
+        }
+
+        if (!was_low && int_low(next) && g_int_callback) {
+            uint64_t saved = host_time_us;
+            host_time_us = frame.arrival_us;
+            g_int_callback(next->dev->int_pin, GPIO_IRQ_EDGE_FALL);
+            host_time_us = saved;
+        }
+
+        if (++next->in_burst < next->burst) {
+            next->next_arrival_us += next->gap_us + jitter(5);
+        } else {
+            next->in_burst = 0;
+            next->next_arrival_us += next->period_us - (next->burst - 1) * next->gap_us + jitter(50);
+        }
+    }
+}
+
+static void reset_controller(sim_bus_t* bus) {
+    memset(bus->regs, 0, sizeof(bus->regs));
+    bus->regs[CANSTAT] = OPMODE_CONFIG;
+    bus->regs[CANCTRL] = 0x87;
+}
+
+// Only the RX path writes CANINTF here: it may clear the flag of a buffer
+// it has read, nothing else
+static void write_canintf(sim_bus_t* bus, uint8_t value) {
+    int b = (int)(bus - g_sim);
+    uint8_t old = bus->regs[CANINTF];
+    for (int n = 0; n < RX_BUFFERS; n++) {
+        if ((old & RX_FLAG[n]) && !(value & RX_FLAG[n])) {
+            CHECK(bus->consumed[n], "bus %d: RX%dIF cleared before frame %lu was read", b, n,
+                  (unsigned long)bus->rx[n].seq);
+            bus->restamp = true;
+        }
+    }
+    CHECK(!(old & ~value & (ERRIF | MERRF)), "bus %d: RX path cleared CANINTF 0x%02x", b,
+          old & ~value & (ERRIF | MERRF));
+    CHECK(!(value & ~old), "bus %d: CANINTF write set 0x%02x", b, value & ~old);
+    bus->regs[CANINTF] = value;
+}
+
+static void write_reg(sim_bus_t* bus, uint8_t addr, uint8_t value) {
+    addr &= 0x7F;
+    if (addr == CANINTF) {
+        write_canintf(bus, value);
+    } else if (addr == CANCTRL) {
+        bus->regs[CANCTRL] = value;
+        bus->regs[CANSTAT] = (uint8_t)((bus->regs[CANSTAT] & ~0xE0) | (value & 0xE0));
+    } else if (addr != CANSTAT) {
+        bus->regs[addr] = value;
+    }
+}
+
+// The last data byte of a full buffer hands its frame to the driver
+static uint8_t read_reg(sim_bus_t* bus, uint8_t addr) {
+    addr &= 0x7F;
+    for (int n = 0; n < RX_BUFFERS; n++) {
+        if (addr == RX_BASE[n] + 12 && (bus->regs[CANINTF] & RX_FLAG[n]) && !bus->consumed[n]) {
+            bus->consumed[n] = true;
+            g_popped = bus->rx[n];
+            g_popped_bus = (int)(bus - g_sim);
+        }
+    }
+    return bus->regs[addr];
+}
+
+// One byte on the wire; frames that finish meanwhile land first
+static void spi_clock_byte(void) {
+    g_spi_ns += g_byte_ns;
+    host_time_us += g_spi_ns / 1000;
+    g_spi_ns %= 1000;
+    deliver_arrivals(host_time_us);
+}
+
+// --- Firmware stand-ins -------------------------------------------------------
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t callback) {
+    (void)gpio;
+    (void)event_mask;
+    (void)enabled;
+    g_int_callback = callback;
+}
+
+UBYTE DEV_Module_Init(void) {
+    return 0;
+}
+
+void DEV_GPIO_Mode(UWORD Pin, UWORD Mode) {
+    (void)Pin;
+    (void)Mode;
+}
+
+UBYTE DEV_Digital_Read(UWORD Pin) {
+    for (int b = 0; b < CAN_NUM_BUSES; b++) {
+        if (g_sim[b].dev->int_pin == Pin) {
+            return !int_low(&g_sim[b]);
+        }
+    }
+    return 1;
+}
+
+// Chip select. Once a read has released a buffer, the frame next in line
+// is stamped at the end of every transfer: the handler takes time_us_32()
+// right after the driver's last one
+void DEV_Digital_Write(UWORD Pin, UBYTE Value) {
+    for (int b = 0; b < CAN_NUM_BUSES; b++) {
+        sim_bus_t* bus = &g_sim[b];
+        if (bus->dev->cs_pin != Pin) {
+            continue;
+        }
+        if (Value == 0) {
+            g_spi_bus = bus;
+            g_spi_phase = 0;
+        } else if (g_spi_bus == bus) {
+            frame_t* next = oldest_frame(bus);
+            if (bus->restamp && next) {
+                next->stamp_us = (uint32_t)host_time_us;
+                next->exact = next->arrival_us == (uint32_t)host_time_us;
+            }
+            g_spi_bus = NULL;
+        }
+    }
+}
+
+void DEV_SPI_WriteByte(UBYTE Value) {
+    spi_clock_byte();
+    sim_bus_t* bus = g_spi_bus;
+    if (!bus) {
+        return;
+    }
+    int phase = g_spi_phase++;
+    if (phase == 0) {
+        g_spi_instr = Value;
+        if (Value == CAN_RESET) {
+            reset_controller(bus);
+        }
+        return;
+    }
+    switch (g_spi_instr) {
+        case CAN_READ:
+            if (phase == 1) g_spi_addr = Value;
+            break;
+        case CAN_WRITE:
+            if (phase == 1) {
+                g_spi_addr = Value;
+            } else {
+                write_reg(bus, g_spi_addr++, Value);
+            }
+            break;
+        case CAN_BIT_MODIFY:
+            if (phase == 1) {
+                g_spi_addr = Value;
+            } else if (phase == 2) {
+                g_spi_mask = Value;
+            } else if (phase == 3) {
+                uint8_t reg = bus->regs[g_spi_addr & 0x7F];
+                write_reg(bus, g_spi_addr, (uint8_t)((reg & ~g_spi_mask) | (Value & g_spi_mask)));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+uint8_t DEV_SPI_ReadByte(void) {
+    spi_clock_byte();
+    sim_bus_t* bus = g_spi_bus;
+    if (!bus || g_spi_instr != CAN_READ) {
+        return 0xFF;
+    }
+    g_spi_phase++;
+    return read_reg(bus, g_spi_addr++);
+}
+
+void DEV_SPI_Lock(void) {}
+
+void DEV_SPI_Unlock(void) {}
+
+void DEV_Delay_ms(UDOUBLE xms) {
+    host_time_us += xms * 1000u;
+}
+
+void DEV_Delay_us(UDOUBLE xus) {
+    host_time_us += xus;
+}
+
+enum RATEBPS can_autobaud_detect(const MCP2515_Dev* dev, can_bus_t bus) {
+    (void)dev;
+    (void)bus;
+    return KBPS1000;
+}
+
+bool can_pio_init(uint32_t rx_pin, uint32_t bitrate) {
+    (void)rx_pin;
+    (void)bitrate;
+    return false;
+}
+
+bool can_pio_rx_pending(void) {
+    return false;
+}
+
+uint32_t can_pio_next_timestamp(void) {
+    return 0;
+}
+
+int8_t can_pio_receive(uint32_t* frame_id, uint8_t* data, uint32_t* timestamp_us) {
+    (void)frame_id;
+    (void)data;
+    (void)timestamp_us;
+    return -1;
+}
+
+bool sample_queue_push(uint8_t channel, int32_t value, uint32_t timestamp_us) {
+    (void)channel;
+    (void)value;
+    (void)timestamp_us;
+    return true;
+}
+
+void sample_queue_publish(void) {}
+
+void alarm_on_sample(uint8_t channel, int32_t value, uint32_t now_us) {
+    (void)channel;
+    (void)value;
+    (void)now_us;
+}
+
+void can_profiler_record_block(uint32_t frames, uint32_t dropped, bool anchor_found) {
+    (void)frames;
+    (void)dropped;
+    (void)anchor_found;
+}
+
+// Every served frame passes through here, with the stamp the decoder got
+void can_profiler_record(can_bus_t bus, uint32_t frame_id, uint8_t len,
+                         uint32_t timestamp_us, bool decoded) {
+    (void)frame_id;
+    (void)len;
+    (void)decoded;
+    sim_bus_t* sim = &g_sim[bus];
+    CHECK(g_popped_bus == (int)bus, "bus %d recorded a frame read from bus %d", bus, g_popped_bus);
+    CHECK(g_popped.seq >= sim->next_seq, "bus %d delivered frame %lu after frame %lu", bus,
+          (unsigned long)g_popped.seq, (unsigned long)sim->next_seq - 1);
+    sim->skipped += g_popped.seq - sim->next_seq;
+    CHECK(timestamp_us == g_popped.stamp_us, "bus %d frame %lu: decoder got %lu, stamped %lu", bus,
+          (unsigned long)g_popped.seq, (unsigned long)timestamp_us, (unsigned long)g_popped.stamp_us);
+    sim->next_seq = g_popped.seq + 1;
+    sim->delivered++;
+    g_served = g_popped;
+    g_served_bus = g_popped_bus;
+    g_popped_bus = -1;
+}
+
+// --- Core 0 -------------------------------------------------------------------
+
+// Oldest unread frame of each controller when can_process_frame() picks a bus
+typedef struct {
+    bool    pending;
+    frame_t head;
+} head_t;
+
+static void snapshot_heads(head_t* heads) {
+    for (int b = 0; b < CAN_NUM_BUSES; b++) {
+        frame_t* oldest = oldest_frame(&g_sim[b]);
+        heads[b].pending = oldest != NULL;
+        if (oldest) {
+            heads[b].head = *oldest;
+        }
+    }
+}
+
+// The served frame must carry the oldest stamp. A frame on the other bus
+// that arrived earlier may only lose if its stamp is not its own INT edge
+static void check_served(const head_t* heads, int served_bus, const frame_t* served) {
+    for (int b = 0; b < CAN_NUM_BUSES; b++) {
+        if (b == served_bus || !heads[b].pending) {
+            continue;
+        }
+        const frame_t* other = &heads[b].head;
+        CHECK((int32_t)(served->stamp_us - other->stamp_us) <= 0,
+              "bus %d served at stamp %lu while bus %d waits from %lu", served_bus,
+              (unsigned long)served->stamp_us, b, (unsigned long)other->stamp_us);
+
+        int32_t overtaken_by = (int32_t)(served->arrival_us - other->arrival_us);
+        if (overtaken_by > 0) {
+            CHECK(!other->exact, "bus %d frame stamped at its INT edge %lu overtaken by bus %d frame at %lu",
+                  b, (unsigned long)other->arrival_us, served_bus, (unsigned long)served->arrival_us);
+            g_inversions++;
+            if ((uint32_t)overtaken_by > g_worst_inversion_us) {
+                g_worst_inversion_us = (uint32_t)overtaken_by;
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    uint32_t busy_max_us = 300;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:b:r:s:")) != -1) {
+        switch (opt) {
+            case 't': seconds = (uint32_t)atol(optarg); break;
+            case 'b': busy_max_us = (uint32_t)atol(optarg); break;
+            case 'r': g_byte_ns = (uint32_t)atol(optarg); break;
+            case 's': g_seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-t seconds] [-b busy us] [-r SPI byte ns] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (seconds > 4000) {
+        fprintf(stderr, "at most 4000 s (32-bit stamps)\n");
+        return 2;
+    }
+
+    host_time_us = 1000;
+    can_init();
+    g_sim[CAN_BUS_ECU].next_arrival_us = (uint32_t)host_time_us + rand_r(&g_seed) % 10000;
+    g_sim[CAN_BUS_CHASSIS].next_arrival_us = (uint32_t)host_time_us + rand_r(&g_seed) % 10000;
+    g_traffic = true;
+
+    uint64_t end_us = host_time_us + (uint64_t)seconds * 1000000u;
+    while (host_time_us < end_us) {
+        // Another core 0 task runs to completion first
+        if (rand_r(&g_seed) % 8 == 0) {
+            host_time_us += rand_r(&g_seed) % (busy_max_us + 1);
+        }
+        deliver_arrivals(host_time_us);
+
+        if (!can_rx_pending()) {
+            uint32_t next = g_sim[CAN_BUS_ECU].next_arrival_us;
+            if ((int32_t)(g_sim[CAN_BUS_CHASSIS].next_arrival_us - next) < 0) {
+                next = g_sim[CAN_BUS_CHASSIS].next_arrival_us;
+            }
+            host_time_us += (uint32_t)(next - (uint32_t)host_time_us);
+            deliver_arrivals(host_time_us);
+            continue;
+        }
+
+        // can_ingest_task: drain while INT is low on either controller
+        while (can_rx_pending()) {
+            head_t heads[CAN_NUM_BUSES];
+            snapshot_heads(heads);
+            for (int b = 0; b < CAN_NUM_BUSES; b++) {
+                g_sim[b].restamp = false;
+            }
+            if (!can_process_frame()) {
+                CHECK(false, "INT low but can_process_frame() served nothing");
+                break;
+            }
+            check_served(heads, g_served_bus, &g_served);
+            host_time_us += 5;  // Decode
+        }
+    }
+
+    bool accounted = true;
+    for (int b = 0; b < CAN_NUM_BUSES; b++) {
+        sim_bus_t* s = &g_sim[b];
+        uint32_t waiting = frames_held(s);
+        printf("[MERGE] bus %d: sent %lu, delivered %lu, RX overflow %lu, still in the controller %lu, "
+               "bus errors %lu\n", b, (unsigned long)s->sent, (unsigned long)s->delivered,
+               (unsigned long)s->overflows, (unsigned long)waiting, (unsigned long)s->bus_errors);
+        // Frames after the last one delivered are either still held or overflowed
+        uint32_t skipped = s->skipped + (s->sent - s->next_seq - waiting);
+        accounted &= s->delivered + s->overflows + waiting == s->sent && skipped == s->overflows &&
+                     s->delivered == can_get_bus_frame_count((can_bus_t)b);
+    }
+    CHECK(accounted, "frames lost or duplicated beyond the RX overflows");
+    printf("[MERGE] %lu frames overtaken after waiting behind another, by at most %lu us\n",
+           (unsigned long)g_inversions, (unsigned long)g_worst_inversion_us);
+    printf("[MERGE] %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file      hop_sim.c
+ * @brief     Host simulation of LoRa channel hopping (channel_hop.c) past Wi-Fi interference
+ *
+ * A car sends a fast frame every frame period and a GPS frame every 500 ms,
+ * each on the hop channel of its sequence number. Wi-Fi networks occupy
+ * 22 MHz around their centre and are busy part of the time, in bursts. A
+ * frame that overlaps a busy network is lost, and every frame also sees a
+ * small background loss. A receiver follows the hops with hop_rx_poll(), as
+ * FS26-Repeater.c does, starting from a guess of one frame per frame period.
+ *
+ * Halfway through, the receiver's suggested blacklist is applied to both
+ * ends, as an operator would with "cfg set hop_blacklist". The run fails if
+ * the suggestion misses a channel inside a busy network, blacklists a clean
+ * one, or delivery does not improve. With more busy channels than
+ * HOP_MIN_CHANNELS leaves room for, the receiver cannot follow and the run
+ * fails too.
+ *
+ *     cc -O2 -I. -o hop_sim tools/hop_sim.c channel_hop.c -lm
+ *     ./hop_sim -w 1,6
+ *
+ * Options:
+ *   -n channels  Hop channels (default 16)
+ *   -b kHz       First channel (default 2404000)
+ *   -k kHz       Channel spacing (default 5000)
+ *   -w list      Busy Wi-Fi channels, comma separated (default 1,6)
+ *   -d percent   Wi-Fi airtime (default 60)
+ *   -L percent   Background loss (default 5)
+ *   -A           Authenticated frames (32-bit counter) instead of plain ones (8-bit)
+ *   -t seconds   Simulated time (default 600)
+ *   -f ms        Frame, the fast packet period (default 200)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "channel_hop.h"
+#include "telemetry_auth.h"
+#include "telemetry_schema.h"
+
+#define TX_US               23000       // LORA_TX_SETUP_US + time on air at SF7, 800 kHz
+#define GPS_PERIOD_US       500000
+#define WIFI_HALF_WIDTH_KHZ 11000
+#define WIFI_BURST_US       20000       // Mean busy burst
+#define LORA_HALF_BW_KHZ    400
+#define MAX_WIFI            14
+
+typedef struct {
+    uint32_t sent;
+    uint32_t delivered;
+} phase_t;
+
+static double uniform(double max) {
+    return max * ((double)rand() / ((double)RAND_MAX + 1.0));
+}
+
+// Whether a LoRa channel overlaps Wi-Fi channel w (1..13)
+static bool in_wifi(uint32_t freq_khz, int wifi) {
+    int64_t centre = 2407000 + 5000 * wifi;
+    int64_t d = (int64_t)freq_khz - centre;
+    return d > -(WIFI_HALF_WIDTH_KHZ + LORA_HALF_BW_KHZ) && d < WIFI_HALF_WIDTH_KHZ + LORA_HALF_BW_KHZ;
+}
+
+static uint8_t build_frame(uint8_t* out, uint32_t counter, bool auth) {
+    memset(out, 0, 32);
+    if (auth) {
+        out[0] = TELEMETRY_AUTH_VERSION;
+        memcpy(out + 4, &counter, 4);
+    } else {
+        out[0] = TELEMETRY_TYPE_VERSION(TELEMETRY_TYPE_FAST);
+        out[1] = (uint8_t)counter;
+    }
+    return 32;
+}
+
+int main(int argc, char** argv) {
+    int num_channels = 16;
+    uint32_t base_khz = 2404000;
+    uint32_t spacing_khz = 5000;
+    bool wifi[MAX_WIFI] = { false };
+    double duty_pct = 60;
+    double loss_pct = 5;
+    bool auth = false;
+    double seconds = 600;
+    uint32_t frame_ms = 200;
+    unsigned seed = 1;
+    const char* wifi_list = "1,6";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:k:w:d:L:At:f:s:")) != -1) {
+        switch (opt) {
+            case 'n': num_channels = atoi(optarg); break;
+            case 'b': base_khz = (uint32_t)atol(optarg); break;
+            case 'k': spacing_khz = (uint32_t)atol(optarg); break;
+            case 'w': wifi_list = optarg; break;
+            case 'd': duty_pct = atof(optarg); break;
+            case 'L': loss_pct = atof(optarg); break;
+            case 'A': auth = true; break;
+            case 't': seconds = atof(optarg); break;
+            case 'f': frame_ms = (uint32_t)atoi(optarg); break;
+            case 's': seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n channels] [-b kHz] [-k kHz] [-w list] [-d %%] [-L %%] [-A] "
+                        "[-t s] [-f ms] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (num_channels < 2 || num_channels > HOP_MAX_CHANNELS || duty_pct < 0 || duty_pct >= 100) {
+        fprintf(stderr, "2..%d channels, Wi-Fi airtime 0..99 %%\n", HOP_MAX_CHANNELS);
+        return 2;
+    }
+    for (const char* p = wifi_list; *p; p++) {
+        int w = atoi(p);
+        if (w >= 1 && w < MAX_WIFI) wifi[w] = true;
+        while (*p && *p != ',') p++;
+        if (!*p) break;
+    }
+    srand(seed);
+
+    // Channels a busy network covers: what the blacklist should hold
+    uint16_t jammed = 0;
+    for (int i = 0; i < num_channels; i++) {
+        for (int w = 1; w < MAX_WIFI; w++) {
+            if (wifi[w] && in_wifi(base_khz + (uint32_t)i * spacing_khz, w)) jammed |= (uint16_t)(1u << i);
+        }
+    }
+
+    hop_plan_t plan;
+    if (!hop_plan_init(&plan, base_khz, (uint16_t)spacing_khz, (uint8_t)num_channels, 0, HOP_SEED)) {
+        fprintf(stderr, "no valid plan\n");
+        return 2;
+    }
+    uint64_t frame_us = frame_ms * 1000ull;
+    hop_rx_t rx;
+    hop_rx_init(&rx, &plan, (uint32_t)frame_us, 0);
+    printf("[HOP] %d channels from %u kHz, %u kHz apart, %s frames, Wi-Fi %s at %.0f %% airtime, "
+           "background loss %.0f %%\n", num_channels, base_khz, spacing_khz, auth ? "auth" : "plain",
+           wifi_list, duty_pct, loss_pct);
+
+    // Wi-Fi busy/idle bursts: exponential-ish lengths with the requested airtime
+    bool wifi_busy[MAX_WIFI] = { false };
+    double wifi_until[MAX_WIFI] = { 0 };
+    double idle_us = WIFI_BURST_US * (100.0 - duty_pct) / (duty_pct > 0 ? duty_pct : 1e-9);
+
+    phase_t phase[2] = { { 0, 0 } };
+    uint64_t end_us = (uint64_t)(seconds * 1e6);
+    uint64_t next_fast = 0, next_gps = 0;
+    uint32_t counter = 0;
+    uint16_t applied = 0;
+    int half = 0;
+
+    for (uint64_t now = 0; now < end_us;) {
+        // Halfway: apply the suggested blacklist on both ends
+        if (!half && now >= end_us / 2) {
+            half = 1;
+            applied = hop_suggest_blacklist(&rx.stats, &plan);
+            for (int i = 0; i < num_channels; i++) {
+                int loss = hop_loss_pct(&rx.stats, (uint8_t)i);
+                printf("[HOP] ch %2d %7u kHz%s loss %3d %%%s\n", i, hop_channel_khz(&plan, (uint8_t)i),
+                       jammed & (1u << i) ? " (Wi-Fi)" : "        ", loss,
+                       applied & (1u << i) ? "  blacklisted" : "");
+            }
+            hop_plan_init(&plan, base_khz, (uint16_t)spacing_khz, (uint8_t)num_channels, applied, HOP_SEED);
+            hop_rx_init(&rx, &plan, (uint32_t)frame_us, now);
+        }
+
+        // Next event: a frame from the car, or the receiver giving up on one
+        uint64_t t = next_fast < next_gps ? next_fast : next_gps;
+        if (rx.deadline_us < t) {
+            now = rx.deadline_us + 1;
+            hop_rx_poll(&rx, &plan, now);
+            continue;
+        }
+        now = t;
+        if (now == next_fast) next_fast += frame_us;
+        else next_gps += GPS_PERIOD_US;
+
+        uint8_t frame[32];
+        uint8_t length = build_frame(frame, counter, auth);
+        uint32_t c, mask;
+        hop_frame_counter(frame, length, &c, &mask);
+        uint8_t channel = hop_channel(&plan, c);
+        uint32_t freq_khz = hop_channel_khz(&plan, channel);
+        counter = (counter + 1) & mask;
+
+        // Lost to a busy network at any point on air, or to background loss
+        bool lost = uniform(100) < loss_pct;
+        for (int w = 1; w < MAX_WIFI; w++) {
+            if (!wifi[w]) continue;
+            while (wifi_until[w] < now + TX_US) {
+                bool was_busy = wifi_busy[w];
+                if (was_busy && wifi_until[w] > now) lost |= in_wifi(freq_khz, w);
+                wifi_busy[w] = !was_busy;
+                wifi_until[w] += (wifi_busy[w] ? WIFI_BURST_US : idle_us) * (0.2 + uniform(1.6));
+            }
+            lost |= wifi_busy[w] && in_wifi(freq_khz, w);
+        }
+
+        phase[half].sent++;
+        if (!lost && hop_rx_channel(&rx, &plan) == channel) {
+            phase[half].delivered++;
+            hop_rx_received(&rx, &plan, c, mask, now);
+        }
+        // The car's next frame: 23 ms later at the earliest
+        if (next_gps < now + TX_US) next_gps = now + TX_US;
+    }
+
+    double before = phase[0].sent ? 100.0 * phase[0].delivered / phase[0].sent : 0;
+    double after = phase[1].sent ? 100.0 * phase[1].delivered / phase[1].sent : 0;
+    printf("[HOP] blacklist 0x%04x (Wi-Fi channels 0x%04x) | delivered %.1f %% before, %.1f %% after\n",
+           applied, jammed, before, after);
+
+    // Every Wi-Fi channel caught, no clean one taken, and fewer frames lost
+    bool ok = applied == jammed && (jammed == 0 || after > before);
+    printf("[HOP] %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
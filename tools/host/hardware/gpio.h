@@ -0,0 +1,21 @@
+/**
+ * @file      gpio.h
+ * @brief     Host stand-in for the Pico SDK GPIO types (tools/ sims only)
+ *
+ * Declarations only, so driver headers parse. A sim that needs the INT
+ * callback defines gpio_set_irq_enabled_with_callback() itself.
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+#define GPIO_IRQ_EDGE_FALL  0x4u
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t callback);
+
+#endif // HOST_HARDWARE_GPIO_H
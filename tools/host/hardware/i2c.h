@@ -0,0 +1,9 @@
+/**
+ * @file      i2c.h
+ * @brief     Host stand-in for the Pico SDK I2C header (tools/ sims only)
+ */
+
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#endif // HOST_HARDWARE_I2C_H
@@ -0,0 +1,9 @@
+/**
+ * @file      irq.h
+ * @brief     Host stand-in for the Pico SDK IRQ header (tools/ sims only)
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#endif // HOST_HARDWARE_IRQ_H
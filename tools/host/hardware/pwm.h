@@ -0,0 +1,9 @@
+/**
+ * @file      pwm.h
+ * @brief     Host stand-in for the Pico SDK PWM header (tools/ sims only)
+ */
+
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#endif // HOST_HARDWARE_PWM_H
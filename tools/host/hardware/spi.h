@@ -0,0 +1,11 @@
+/**
+ * @file      spi.h
+ * @brief     Host stand-in for the Pico SDK SPI types (tools/ sims only)
+ */
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+typedef struct spi_inst spi_inst_t;
+
+#endif // HOST_HARDWARE_SPI_H
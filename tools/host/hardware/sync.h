@@ -0,0 +1,53 @@
+/**
+ * @file      sync.h
+ * @brief     Host stand-in for the Pico SDK barriers and events (tools/ sims only)
+ *
+ * Barriers map to C11 fences so code built for threads on the host keeps
+ * the ordering it has on the RP2350. Spin locks do nothing: the sims that
+ * use them run the code under test on one thread.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static inline void __mem_fence_acquire(void) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void __mem_fence_release(void) {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline int spin_lock_claim_unused(bool required) {
+    (void)required;
+    return 0;
+}
+
+static inline spin_lock_t* spin_lock_instance(unsigned int lock_num) {
+    static spin_lock_t locks[32];
+    return &locks[lock_num];
+}
+
+static inline uint32_t spin_lock_blocking(spin_lock_t* lock) {
+    (void)lock;
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t* lock, uint32_t saved_irq) {
+    (void)lock;
+    (void)saved_irq;
+}
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,11 @@
+/**
+ * @file      uart.h
+ * @brief     Host stand-in for the Pico SDK UART types (tools/ sims only)
+ */
+
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+typedef struct uart_inst uart_inst_t;
+
+#endif // HOST_HARDWARE_UART_H
@@ -0,0 +1,26 @@
+/**
+ * @file      multicore.h
+ * @brief     Host stand-in for the Pico SDK inter-core FIFO (tools/ sims only)
+ *
+ * The FIFO always has room and only counts the words pushed into it, in
+ * host_fifo_pushes, which the sim defines.
+ */
+
+#ifndef HOST_PICO_MULTICORE_H
+#define HOST_PICO_MULTICORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+extern volatile uint32_t host_fifo_pushes;
+
+static inline bool multicore_fifo_wready(void) {
+    return true;
+}
+
+static inline void multicore_fifo_push_blocking(uint32_t data) {
+    (void)data;
+    host_fifo_pushes++;
+}
+
+#endif // HOST_PICO_MULTICORE_H
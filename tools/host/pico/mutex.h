@@ -0,0 +1,27 @@
+/**
+ * @file      mutex.h
+ * @brief     Host stand-in for the Pico SDK mutex (tools/ sims only)
+ *
+ * The sims print from one thread, so the mutex does nothing.
+ */
+
+#ifndef HOST_PICO_MUTEX_H
+#define HOST_PICO_MUTEX_H
+
+typedef struct {
+    int unused;
+} mutex_t;
+
+static inline void mutex_init(mutex_t* mtx) {
+    (void)mtx;
+}
+
+static inline void mutex_enter_blocking(mutex_t* mtx) {
+    (void)mtx;
+}
+
+static inline void mutex_exit(mutex_t* mtx) {
+    (void)mtx;
+}
+
+#endif // HOST_PICO_MUTEX_H
@@ -0,0 +1,17 @@
+/**
+ * @file      stdlib.h
+ * @brief     Host stand-in for the Pico SDK umbrella header (tools/ sims only)
+ *
+ * The types, the clock and the GPIO declarations, as the SDK header
+ * pulls them in.
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#endif // HOST_PICO_STDLIB_H
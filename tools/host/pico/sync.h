@@ -0,0 +1,12 @@
+/**
+ * @file      sync.h
+ * @brief     Host stand-in for the Pico SDK sync primitives (tools/ sims only)
+ */
+
+#ifndef HOST_PICO_SYNC_H
+#define HOST_PICO_SYNC_H
+
+#include "hardware/sync.h"
+#include "pico/mutex.h"
+
+#endif // HOST_PICO_SYNC_H
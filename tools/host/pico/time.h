@@ -0,0 +1,52 @@
+/**
+ * @file      time.h
+ * @brief     Host stand-in for the Pico SDK timer API (tools/ sims only)
+ *
+ * Time is the sim's own clock, host_time_us, which the sim defines and
+ * moves forward. Build the sims with -Itools/host so firmware sources that
+ * include "pico/time.h" pick this up instead of the SDK.
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+extern uint64_t host_time_us;
+
+typedef uint64_t absolute_time_t;
+
+static inline uint64_t time_us_64(void) {
+    return host_time_us;
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_time_us;
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return host_time_us;
+}
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+// The sims never idle through these; they step the clock themselves
+static inline bool best_effort_wfe_or_timeout(absolute_time_t timeout) {
+    if (host_time_us < timeout) {
+        host_time_us = timeout;
+    }
+    return true;
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    host_time_us += (uint64_t)ms * 1000u;
+}
+
+#endif // HOST_PICO_TIME_H
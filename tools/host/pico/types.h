@@ -0,0 +1,14 @@
+/**
+ * @file      types.h
+ * @brief     Host stand-in for the Pico SDK base types (tools/ sims only)
+ */
+
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#endif // HOST_PICO_TYPES_H
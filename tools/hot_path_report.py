@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""List where the FS26-DAQ hot path symbols were placed (SRAM or XIP flash).
+
+Run as a post-build step (see CMakeLists.txt) or by hand:
+
+    tools/hot_path_report.py --objdump arm-none-eabi-objdump build/FS26-DAQ.elf
+
+Symbols marked HOT_PATH_FUNC / HOT_PATH_DATA (hot_path.h) should show up
+in SRAM. A symbol that is missing was inlined into its caller. Use --strict
+to fail the build when a hot symbol ended up in flash.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+# Keep in step with the HOT_PATH_FUNC / HOT_PATH_DATA markings
+HOT_SYMBOLS = [
+    # CAN ingest
+    "can_int_isr", "can_process_frame", "can_rx_pending",
+    "decode_ecu_frame", "decode_chassis_frame", "M84_OFFSETS",
+    "ft550_decode_frame",
+    "decode_kernel_frame", "decode_kernel_gather",
+    "decode_kernel_frame_c", "decode_kernel_gather_c", "DECODE_KERNEL_UNIT_SCALES",
+    "can_pio_rx_pending", "can_pio_next_timestamp", "can_pio_receive",
+    "decode_new_words", "queue_frame",
+    "can_bitstream_push_word", "can_bitstream_push_bit",
+    # MCP2515 driver and shared spi0 / GPIO helpers
+    "MCP2515_Dev_Receive_Fast", "MCP2515_Dev_Send",
+    "MCP2515_ReadByte", "MCP2515_ReadBytes", "MCP2515_WriteByte", "MCP2515_WriteBytes",
+    "MCP2515_BitModify",
+    "DEV_SPI_WriteByte", "DEV_SPI_ReadByte", "DEV_SPI_Write_nByte",
+    "DEV_SPI_Lock", "DEV_SPI_Unlock", "DEV_Digital_Write", "DEV_Digital_Read",
+    # Core 0 -> core 1 samples and alarms
+    "sample_queue_push", "sample_queue_publish", "alarm_on_sample", "map_threshold",
+    "set_rule_state",
+    # GPS
+    "gps_uart_irq_handler", "gps_process", "process_gps_data",
+    "verify_nmea_checksum", "parse_gpgga", "parse_gprmc", "nmea_token", "nmea_to_decimal",
+    "apply_filtering_and_print",
+    # LR1121 TX
+    "lr11xx_hal_write", "lr11xx_hal_read", "lr11xx_hal_direct_read",
+    "lr11xx_hal_wait_on_unbusy", "lora_spi_write_bytes", "lora_spi_read_bytes",
+]
+
+FLASH = (0x10000000, 0x12000000)
+SRAM = (0x20000000, 0x20082000)
+
+SYMBOL_RE = re.compile(r"^([0-9a-fA-F]+)\s.{7}\s(\S+)\s+([0-9a-fA-F]+)\s+(\S+)$")
+
+
+def placement(addr):
+    if FLASH[0] <= addr < FLASH[1]:
+        return "flash"
+    if SRAM[0] <= addr < SRAM[1]:
+        return "SRAM"
+    return "other"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    parser.add_argument("-o", "--output", help="write the report here as well as stdout")
+    parser.add_argument("--strict", action="store_true", help="exit 1 if a hot symbol is in flash")
+    args = parser.parse_args()
+
+    table = subprocess.run([args.objdump, "-t", args.elf], check=True,
+                           capture_output=True, text=True).stdout
+
+    symbols = {}
+    for line in table.splitlines():
+        m = SYMBOL_RE.match(line.strip())
+        if m:
+            addr, section, size, name = m.groups()
+            # Keep the first definition; statics with the same name are rare here
+            symbols.setdefault(name, (int(addr, 16), section, int(size, 16)))
+
+    lines = [f"{'symbol':<28} {'address':>10} {'size':>6}  {'section':<12} placement"]
+    in_flash = 0
+    ram_bytes = 0
+    for name in HOT_SYMBOLS:
+        if name not in symbols:
+            lines.append(f"{name:<28} {'-':>10} {'-':>6}  {'-':<12} inlined/absent")
+            continue
+        addr, section, size = symbols[name]
+        where = placement(addr)
+        if where == "flash":
+            in_flash += 1
+        elif where == "SRAM":
+            ram_bytes += size
+        lines.append(f"{name:<28} {addr:#010x} {size:>6}  {section:<12} {where}")
+    lines.append(f"{len(HOT_SYMBOLS)} hot symbols, {in_flash} in flash, {ram_bytes} bytes in SRAM")
+
+    report = "\n".join(lines) + "\n"
+    sys.stdout.write(report)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(report)
+
+    return 1 if args.strict and in_flash else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
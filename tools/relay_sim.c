@@ -0,0 +1,413 @@
+/**
+ * @file      relay_sim.c
+ * @brief     Host simulation of trackside repeaters running relay.c with lossy radios
+ *
+ * One car drives laps and sends DAQ frames: a fast frame every frame period
+ * and a GPS frame every 500 ms. The base station cannot hear the car in a
+ * blind sector of the lap. Each repeater hears the car over part of the lap
+ * and always reaches the base. Every link also loses frames in bursts
+ * (Gilbert model: a good state that delivers and a bad state that loses).
+ *
+ * By default the repeaters forward on the car channel in their own TDMA
+ * slots (node 0 is the car). They hear each other, so a frame one repeater
+ * forwards reaches the other as a duplicate, or is carried one hop further.
+ * With -c they forward at once on a relay channel, and the base listens on
+ * both channels. A repeater is half duplex and misses what the car sends
+ * while it transmits. Overlapping frames on one channel are all lost.
+ *
+ * The run fails if a repeater forwards the same frame twice, a repeater adds
+ * more than max age plus one transmission of latency, or a repeater forwards
+ * more frames than the unique frames it heard.
+ *
+ *     cc -O2 -I. -o relay_sim tools/relay_sim.c relay.c tdma.c -lm
+ *     ./relay_sim -r 2 -t 600
+ *
+ * Options:
+ *   -r repeaters Repeaters, 0..2 (default 1)
+ *   -c           Forward on a separate relay channel instead of a TDMA slot
+ *   -A           Authenticated frames (telemetry_auth.h header) instead of plain ones
+ *   -t seconds   Simulated time (default 600)
+ *   -f ms        Frame, the fast packet period (default 200)
+ *   -a ms        Time on air of one frame (default 15: SF7, 800 kHz)
+ *   -m ms        relay_max_age_ms (default 500)
+ *   -l seconds   Lap time (default 60)
+ *   -L percent   Average burst loss on every link (default 10)
+ *   -b frames    Mean loss burst length (default 4)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "relay.h"
+#include "tdma.h"
+#include "telemetry_auth.h"
+#include "telemetry_schema.h"
+
+#define STEP_US             250
+#define TX_SETUP_US         8000        // LORA_TX_SETUP_US: lora_send() call to the frame on air
+#define GPS_PERIOD_US       500000
+#define FRAME_LENGTH        32
+#define START_UTC_MS        (10u * 3600000u)
+#define MAX_REPEATERS       2
+#define MAX_NODES           (1 + MAX_REPEATERS)
+#define BASE                MAX_NODES   // Receiver index of the base station
+#define MAX_FRAMES          200000
+#define MAX_AIR             64          // Transmissions remembered for overlap checks
+#define CAR_QUEUE           8
+
+enum { CH_CAR = 0, CH_RELAY };
+
+// Part of the lap each receiver hears the car in: [from, to) as a fraction of the lap
+static const double BASE_BLIND[2] = { 0.30, 0.60 };
+static const double REPEATER_SECTOR[MAX_REPEATERS][2] = { { 0.20, 0.70 }, { 0.45, 0.90 } };
+
+typedef struct {
+    int      sender;                // 0 = car, 1.. = repeaters
+    int      channel;
+    uint64_t setup_us;              // Sender busy from here
+    uint64_t start_us;              // On air
+    uint64_t end_us;
+    uint32_t frame_id;
+    uint8_t  length;
+    uint8_t  data[RELAY_MAX_FRAME];
+} air_t;
+
+typedef struct {
+    bool   bad;
+    double p_good_bad;
+    double p_bad_good;
+} link_t;
+
+typedef struct {
+    relay_t  relay;
+    tdma_node_t tdma;
+    bool     sending;
+    air_t    tx;                    // Frame on air while sending
+    uint64_t rx_us;                 // relay receive time of the frame on air
+    uint32_t heard_unique;          // Distinct frames queued
+    uint32_t half_duplex_misses;    // Car frames lost while this repeater transmitted
+    uint32_t max_added_us;
+} repeater_t;
+
+typedef struct {
+    uint32_t id;
+    uint8_t  type;
+} car_frame_t;
+
+static air_t g_air[MAX_AIR];
+static int g_air_next;
+static link_t g_links[MAX_NODES][MAX_NODES + 1];   // [sender][receiver]
+static uint8_t g_forwarded[MAX_REPEATERS][MAX_FRAMES];
+static uint64_t g_sent_us[MAX_FRAMES];             // Car transmission end
+static uint64_t g_base_us[MAX_FRAMES];             // First delivery to the base, 0 if none
+static bool g_direct[MAX_FRAMES];
+
+static double uniform(double max) {
+    return max * ((double)rand() / ((double)RAND_MAX + 1.0));
+}
+
+static bool in_sector(double pos, const double sector[2]) {
+    return pos >= sector[0] && pos < sector[1];
+}
+
+// One frame over a link: advance the burst state, true if delivered
+static bool link_delivers(link_t* link) {
+    link->bad = link->bad ? uniform(1) >= link->p_bad_good : uniform(1) < link->p_good_bad;
+    return !link->bad;
+}
+
+// Build a DAQ frame carrying the simulation's frame id in its payload
+static uint8_t build_frame(uint8_t* out, uint32_t id, uint8_t type, uint64_t now_us, bool auth) {
+    memset(out, 0, FRAME_LENGTH);
+    size_t body;
+    if (auth) {
+        out[0] = TELEMETRY_AUTH_VERSION;
+        out[2] = 0x34, out[3] = 0x12;               // Session
+        memcpy(out + 4, &id, 4);                    // Counter: one per frame
+        body = sizeof(telemetry_auth_header_t);
+    } else {
+        out[0] = TELEMETRY_TYPE_VERSION(type);
+        out[1] = (uint8_t)id;
+        uint16_t ms = (uint16_t)(now_us / 1000);
+        memcpy(out + 2, &ms, 2);
+        body = TELEMETRY_HEADER_SIZE;
+    }
+    memcpy(out + body, &id, 4);
+    return FRAME_LENGTH;
+}
+
+static uint32_t frame_id_of(const uint8_t* data, bool auth) {
+    uint32_t id;
+    memcpy(&id, data + (auth ? sizeof(telemetry_auth_header_t) : TELEMETRY_HEADER_SIZE), 4);
+    return id;
+}
+
+static void start_tx(air_t* tx, int sender, int channel, uint64_t now_us, uint32_t air_us,
+                     const uint8_t* data, uint8_t length, uint32_t id) {
+    tx->sender = sender;
+    tx->channel = channel;
+    tx->setup_us = now_us;
+    tx->start_us = now_us + TX_SETUP_US;
+    tx->end_us = tx->start_us + air_us;
+    tx->frame_id = id;
+    tx->length = length;
+    memcpy(tx->data, data, length);
+    g_air[g_air_next] = *tx;
+    g_air_next = (g_air_next + 1) % MAX_AIR;
+}
+
+// Whether tx is lost at receiver rx (BASE or a repeater) to overlap on the channel or half duplex
+static bool overlapped(const air_t* tx, int rx, bool* half_duplex) {
+    *half_duplex = false;
+    for (int i = 0; i < MAX_AIR; i++) {
+        const air_t* other = &g_air[i];
+        if (other->end_us == 0 || (other->sender == tx->sender && other->start_us == tx->start_us)) {
+            continue;
+        }
+        if (other->sender == rx && other->setup_us < tx->end_us && other->end_us > tx->start_us) {
+            *half_duplex = true;
+            return true;
+        }
+        if (other->channel == tx->channel && other->start_us < tx->end_us && other->end_us > tx->start_us) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    int num_repeaters = 1;
+    bool relay_channel = false;
+    bool auth = false;
+    double seconds = 600;
+    uint32_t frame_ms = 200;
+    uint32_t air_ms = 15;
+    uint32_t max_age_ms = 500;
+    double lap_s = 60;
+    double loss_pct = 10;
+    double burst = 4;
+    unsigned seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:cAt:f:a:m:l:L:b:s:")) != -1) {
+        switch (opt) {
+            case 'r': num_repeaters = atoi(optarg); break;
+            case 'c': relay_channel = true; break;
+            case 'A': auth = true; break;
+            case 't': seconds = atof(optarg); break;
+            case 'f': frame_ms = (uint32_t)atoi(optarg); break;
+            case 'a': air_ms = (uint32_t)atoi(optarg); break;
+            case 'm': max_age_ms = (uint32_t)atoi(optarg); break;
+            case 'l': lap_s = atof(optarg); break;
+            case 'L': loss_pct = atof(optarg); break;
+            case 'b': burst = atof(optarg); break;
+            case 's': seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r repeaters] [-c] [-A] [-t s] [-f ms] [-a ms] [-m ms] [-l s] "
+                        "[-L %%] [-b frames] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (num_repeaters < 0 || num_repeaters > MAX_REPEATERS || loss_pct < 0 || loss_pct >= 100 || burst < 1) {
+        fprintf(stderr, "0..%d repeaters, loss 0..99 %%, burst >= 1\n", MAX_REPEATERS);
+        return 2;
+    }
+    srand(seed);
+
+    uint32_t frame_us = frame_ms * 1000u;
+    uint32_t air_us = air_ms * 1000u;
+    uint32_t packet_us = TX_SETUP_US + air_us;
+    uint32_t max_age_us = max_age_ms * 1000u;
+
+    // Gilbert model with the requested average loss and burst length
+    double p_bad = loss_pct / 100.0;
+    for (int s = 0; s < MAX_NODES; s++) {
+        for (int r = 0; r <= MAX_NODES; r++) {
+            g_links[s][r].p_bad_good = 1.0 / burst;
+            g_links[s][r].p_good_bad = p_bad / (1.0 - p_bad) / burst;
+        }
+    }
+
+    // Slot mode: the car is node 0, repeater i is node i + 1. Ideal clocks:
+    // tdma_sim.c covers sync errors.
+    int num_nodes = relay_channel ? 1 : 1 + num_repeaters;
+    tdma_node_t car_tdma;
+    memset(&car_tdma, 0, sizeof(car_tdma));
+    repeater_t repeaters[MAX_REPEATERS];
+    memset(repeaters, 0, sizeof(repeaters));
+    bool planned = tdma_node_configure(&car_tdma, 0, (uint8_t)num_nodes, frame_us, TDMA_PPS_SYNC_ERROR_US,
+                                       packet_us);
+    for (int i = 0; i < num_repeaters; i++) {
+        relay_init(&repeaters[i].relay, max_age_us);
+        if (!relay_channel) {
+            planned &= tdma_node_configure(&repeaters[i].tdma, (uint8_t)(i + 1), (uint8_t)num_nodes, frame_us,
+                                           TDMA_PPS_SYNC_ERROR_US, packet_us);
+        }
+    }
+    if (num_nodes > 1 && !planned) {
+        fprintf(stderr, "no valid TDMA plan for %d nodes (slot %u us, packet %u us)\n", num_nodes,
+                car_tdma.plan.slot_us, packet_us);
+        return 2;
+    }
+    printf("[RELAY] %d repeater(s), %s, %s frames, frame %u ms, packet %u us, max age %u ms, "
+           "loss %.0f %% in bursts of %.1f\n",
+           num_repeaters, relay_channel ? "relay channel" : num_nodes > 1 ? "TDMA slots" : "no TDMA",
+           auth ? "authenticated" : "plain", frame_ms, packet_us, max_age_ms, loss_pct, burst);
+
+    car_frame_t car_queue[CAR_QUEUE];
+    int car_queued = 0;
+    bool car_sending = false;
+    air_t car_tx;
+    uint32_t num_frames = 0, car_dropped = 0;
+    uint64_t next_fast = 0, next_gps = 0;
+    int failures = 0;
+
+    uint64_t end_us = (uint64_t)(seconds * 1e6);
+    for (uint64_t now = STEP_US; now < end_us; now += STEP_US) {
+        // GPS time once a second, exact
+        if (now % 1000000 < STEP_US) {
+            uint32_t utc_ms = START_UTC_MS + (uint32_t)(now / 1000);
+            tdma_clock_update(&car_tdma.clock, utc_ms, now, TDMA_SYNC_PPS);
+            for (int i = 0; i < num_repeaters; i++) {
+                tdma_clock_update(&repeaters[i].tdma.clock, utc_ms, now, TDMA_SYNC_PPS);
+            }
+        }
+
+        // Car: new frames, oldest dropped when the queue is full
+        for (int gps = 0; gps < 2; gps++) {
+            uint64_t* next = gps ? &next_gps : &next_fast;
+            if (now < *next || num_frames >= MAX_FRAMES) continue;
+            *next += gps ? GPS_PERIOD_US : frame_us;
+            if (car_queued == CAR_QUEUE) {
+                memmove(car_queue, car_queue + 1, sizeof(car_queue[0]) * (CAR_QUEUE - 1));
+                car_queued--;
+                car_dropped++;
+            }
+            car_queue[car_queued++] = (car_frame_t){ num_frames++,
+                                                     gps ? TELEMETRY_TYPE_GPS : TELEMETRY_TYPE_FAST };
+        }
+
+        // Transmissions that end now are received
+        for (int i = 0; i < MAX_AIR; i++) {
+            air_t* tx = &g_air[i];
+            if (tx->end_us == 0 || tx->end_us > now || tx->end_us <= now - STEP_US) continue;
+            double pos = fmod((double)tx->start_us / 1e6, lap_s) / lap_s;
+            bool half_duplex;
+
+            // Base station: on both channels
+            if (!overlapped(tx, BASE, &half_duplex) &&
+                (tx->sender != 0 || !in_sector(pos, BASE_BLIND)) && link_delivers(&g_links[tx->sender][BASE])) {
+                if (g_base_us[tx->frame_id] == 0) {
+                    g_base_us[tx->frame_id] = tx->end_us;
+                }
+                g_direct[tx->frame_id] |= tx->sender == 0;
+            }
+
+            // Repeaters listen on the car channel
+            for (int r = 0; r < num_repeaters; r++) {
+                repeater_t* rep = &repeaters[r];
+                if (tx->channel != CH_CAR || tx->sender == r + 1) continue;
+                if (tx->sender == 0 && !in_sector(pos, REPEATER_SECTOR[r])) continue;
+                if (overlapped(tx, r + 1, &half_duplex)) {
+                    rep->half_duplex_misses += half_duplex && tx->sender == 0;
+                    continue;
+                }
+                if (!link_delivers(&g_links[tx->sender][r + 1])) continue;
+                if (relay_receive(&rep->relay, tx->data, tx->length, -80, tx->end_us) != RELAY_RX_DUPLICATE) {
+                    rep->heard_unique++;
+                }
+            }
+        }
+
+        // Transmissions that ended
+        if (car_sending && car_tx.end_us <= now) {
+            car_sending = false;
+            g_sent_us[car_tx.frame_id] = car_tx.end_us;
+        }
+        for (int r = 0; r < num_repeaters; r++) {
+            repeater_t* rep = &repeaters[r];
+            if (!rep->sending || rep->tx.end_us > now) continue;
+            rep->sending = false;
+            relay_sent(&rep->relay, rep->tx.end_us);
+            uint32_t added = (uint32_t)(rep->tx.end_us - rep->rx_us);
+            if (added > rep->max_added_us) rep->max_added_us = added;
+            if (added > max_age_us + packet_us) {
+                printf("[FAIL] repeater %d added %u us to frame %u\n", r, added, rep->tx.frame_id);
+                failures++;
+            }
+            if (++g_forwarded[r][rep->tx.frame_id] > 1) {
+                printf("[FAIL] repeater %d forwarded frame %u twice\n", r, rep->tx.frame_id);
+                failures++;
+            }
+        }
+
+        // Car: send in its slot, or at once without TDMA
+        if (!car_sending && car_queued > 0 &&
+            (num_nodes == 1 || tdma_fits(&car_tdma.plan, &car_tdma.clock, now, packet_us))) {
+            uint8_t frame[FRAME_LENGTH];
+            uint8_t length = build_frame(frame, car_queue[0].id, car_queue[0].type, now, auth);
+            start_tx(&car_tx, 0, CH_CAR, now, air_us, frame, length, car_queue[0].id);
+            memmove(car_queue, car_queue + 1, sizeof(car_queue[0]) * (CAR_QUEUE - 1));
+            car_queued--;
+            car_sending = true;
+        }
+
+        // Repeaters: FS26-Repeater.c's fwd task
+        for (int r = 0; r < num_repeaters; r++) {
+            repeater_t* rep = &repeaters[r];
+            if (rep->sending) continue;
+            const relay_frame_t* frame = relay_next(&rep->relay, now);
+            if (frame == NULL ||
+                (!relay_channel && !tdma_fits(&rep->tdma.plan, &rep->tdma.clock, now, packet_us))) {
+                continue;
+            }
+            rep->rx_us = frame->rx_us;
+            start_tx(&rep->tx, r + 1, relay_channel ? CH_RELAY : CH_CAR, now, air_us, frame->data,
+                     frame->length, frame_id_of(frame->data, auth));
+            rep->sending = true;
+        }
+    }
+
+    // Coverage at the base: frames the car finished sending
+    uint32_t sent = 0, direct = 0, delivered = 0;
+    uint64_t relayed_latency_sum = 0, relayed_latency_max = 0;
+    uint32_t relayed = 0;
+    for (uint32_t id = 0; id < num_frames; id++) {
+        if (g_sent_us[id] == 0) continue;
+        sent++;
+        direct += g_direct[id];
+        delivered += g_base_us[id] != 0;
+        if (g_base_us[id] != 0 && !g_direct[id]) {
+            uint64_t latency = g_base_us[id] - g_sent_us[id];
+            relayed_latency_sum += latency;
+            if (latency > relayed_latency_max) relayed_latency_max = latency;
+            relayed++;
+        }
+    }
+
+    for (int r = 0; r < num_repeaters; r++) {
+        const repeater_t* rep = &repeaters[r];
+        const relay_stats_t* s = &rep->relay.stats;
+        printf("[RELAY] repeater %d | heard %u unique %u dup %u | fwd %u expired %u overflow %u | "
+               "half-duplex misses %u | max added %u ms, queue high %u\n",
+               r, s->received, rep->heard_unique, s->duplicates, s->forwarded, s->expired, s->overflows,
+               rep->half_duplex_misses, rep->max_added_us / 1000, s->queue_high);
+        if (s->forwarded > rep->heard_unique) {
+            printf("[FAIL] repeater %d forwarded %u of %u unique frames\n", r, s->forwarded, rep->heard_unique);
+            failures++;
+        }
+        if (s->invalid != 0) {
+            printf("[FAIL] repeater %d rejected %u DAQ frames\n", r, s->invalid);
+            failures++;
+        }
+    }
+    printf("[RELAY] car sent %u (dropped %u) | base: direct %.1f %%, with repeaters %.1f %% | "
+           "relayed latency mean %.0f ms, max %.0f ms\n",
+           sent, car_dropped, sent ? 100.0 * direct / sent : 0.0, sent ? 100.0 * delivered / sent : 0.0,
+           relayed ? relayed_latency_sum / 1000.0 / relayed : 0.0, relayed_latency_max / 1000.0);
+    printf("[RELAY] %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
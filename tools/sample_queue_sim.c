@@ -0,0 +1,327 @@
+/**
+ * @file      sample_queue_sim.c
+ * @brief     Host stress test of sample_queue.c with the CAN and GPS producers
+ *
+ * A consumer thread drains the queue the way core 1 does, while producers
+ * push the CAN channels (RPM to MAP and the chassis channels) and the GPS
+ * channels. Every value
+ * carries a per-channel counter. The consumer therefore checks that each
+ * channel arrives in order and that every gap in the sequence numbers
+ * matches a sample the queue reported as dropped.
+ *
+ * First run, the bare-metal model: the CAN and GPS ingest tasks share one
+ * producer thread and take turns at task granularity, as the core 0
+ * scheduler runs them to completion. This run must be lossless apart from
+ * counted drops. The run fails on any out-of-order sample, uncounted loss
+ * or accounting mismatch.
+ *
+ * Second run, the FreeRTOS model: can_rx_task (priority 6) preempts
+ * gps_rx_task (priority 5) at any instruction, including in the middle of
+ * a push. The GPS producer is a thread, and a 100 us interval timer signal
+ * stands in for can_rx_task and pushes the CAN channels. This run is
+ * reported, not checked. The samples it loses and reorders are why the
+ * FreeRTOS and repeater targets build with SAMPLE_QUEUE_ENABLED=0.
+ *
+ *     cc -O2 -I. -Itools/host -pthread -o sample_queue_sim tools/sample_queue_sim.c sample_queue.c
+ *     ./sample_queue_sim -n 2000000
+ *
+ * Options:
+ *   -n samples   Samples per producer (default 1000000)
+ *   -b batch     Consumer batch, as core 1's pop buffer (default 64)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "sample_queue.h"
+
+uint64_t host_time_us;
+volatile uint32_t host_fifo_pushes;
+
+#define CAN_CHANNELS    (SAMPLE_CH_MAP - SAMPLE_CH_RPM + 1)
+#define GPS_CHANNELS    (SAMPLE_CH_GPS_SATELLITES - SAMPLE_CH_GPS_LATITUDE + 1)
+#define CHASSIS_FRAMES  4           // FT550 frames on the chassis bus, four channels each
+#define MAX_BATCH       512
+
+typedef struct {
+    uint32_t samples;               // Samples seen
+    uint32_t seq_gaps;              // Sequence numbers skipped
+    uint32_t channel_gaps;          // Per-channel counter values skipped
+    uint32_t out_of_order;          // Sequence or channel counter went backwards
+    uint32_t bad_channel;           // Channel id outside the stream
+} check_t;
+
+typedef struct {
+    pthread_t threads[1];
+    int       count;
+} producers_t;
+
+static volatile int g_producers_done;
+static unsigned g_seed = 1;
+static uint32_t g_per_producer = 1000000;
+static uint32_t g_batch = 64;
+static volatile uint32_t g_timestamp;   // Shared clock, stamps stay non-decreasing per thread
+
+// Value = channel counter; the consumer expects each channel to count up by one
+static uint32_t g_next_value[SAMPLE_CH_COUNT];
+
+static void push_channel(uint8_t channel) {
+    uint32_t value = g_next_value[channel]++;
+    sample_queue_push(channel, (int32_t)value, __atomic_add_fetch(&g_timestamp, 1, __ATOMIC_RELAXED));
+}
+
+// One CAN ingest run: M84 blocks of six channels, and sometimes a chassis
+// frame of four
+static uint32_t can_ingest(unsigned* seed) {
+    int frames = 1 + rand_r(seed) % 4;
+    for (int f = 0; f < frames; f++) {
+        for (int c = 0; c < CAN_CHANNELS; c++) {
+            push_channel((uint8_t)(SAMPLE_CH_RPM + c));
+        }
+    }
+    uint32_t pushed = (uint32_t)frames * CAN_CHANNELS;
+    if (rand_r(seed) % 2) {
+        int first = SAMPLE_CH_WHEEL_SPEED_FR + 4 * (rand_r(seed) % CHASSIS_FRAMES);
+        for (int c = 0; c < 4; c++) {
+            push_channel((uint8_t)(first + c));
+        }
+        pushed += 4;
+    }
+    return pushed;
+}
+
+// One GPS ingest run: a fix, then its speed
+static uint32_t gps_ingest(void) {
+    for (int c = 0; c < GPS_CHANNELS; c++) {
+        push_channel((uint8_t)(SAMPLE_CH_GPS_LATITUDE + c));
+    }
+    return GPS_CHANNELS;
+}
+
+// Time between ingest runs; core 1 drains faster than the buses fill, but
+// not always in time. Yields too, so the consumer gets to run on a host
+// with a single CPU.
+static void idle(unsigned* seed) {
+    for (volatile int i = rand_r(seed) % 400; i > 0; i--) {
+    }
+    if (rand_r(seed) % 4 == 0) {
+        sched_yield();
+    }
+}
+
+// Bare-metal core 0: both tasks on one thread, run to completion in turn
+static void* cooperative_producer(void* arg) {
+    (void)arg;
+    unsigned seed = g_seed;
+    uint32_t can_pushed = 0, gps_pushed = 0;
+    while (can_pushed < g_per_producer || gps_pushed < g_per_producer) {
+        if (can_pushed < g_per_producer && (gps_pushed >= g_per_producer || rand_r(&seed) % 4)) {
+            can_pushed += can_ingest(&seed);
+        } else {
+            gps_pushed += gps_ingest();
+        }
+        sample_queue_publish();
+        idle(&seed);
+    }
+    return NULL;
+}
+
+// FreeRTOS: can_rx_task runs whenever the timer fires, mid-push or not
+static volatile uint32_t g_can_pushed;
+static unsigned g_can_seed;
+
+static void can_rx_signal(int sig) {
+    (void)sig;
+    if (g_can_pushed < g_per_producer) {
+        g_can_pushed += can_ingest(&g_can_seed);
+    }
+}
+
+static void* gps_rx_thread(void* arg) {
+    (void)arg;
+    sigset_t alarm;
+    sigemptyset(&alarm);
+    sigaddset(&alarm, SIGALRM);
+    pthread_sigmask(SIG_UNBLOCK, &alarm, NULL);
+
+    unsigned seed = g_seed + 2;
+    uint32_t pushed = 0;
+    while (pushed < g_per_producer || g_can_pushed < g_per_producer) {
+        if (pushed < g_per_producer) {
+            pushed += gps_ingest();
+        }
+        idle(&seed);
+    }
+
+    pthread_sigmask(SIG_BLOCK, &alarm, NULL);
+    return NULL;
+}
+
+// Core 1: drain in batches, sometimes late (a long LoRa send) so the
+// queue fills and drops
+static void consume(check_t* check) {
+    static sample_t batch[MAX_BATCH];
+    uint32_t expected_value[SAMPLE_CH_COUNT] = { 0 };
+    uint16_t expected_seq = 0;
+    unsigned seed = g_seed + 1;
+    uint32_t pops_after_done = 0;
+    while (true) {
+        int done = __atomic_load_n(&g_producers_done, __ATOMIC_ACQUIRE);
+        uint32_t count = sample_queue_pop(batch, g_batch);
+        // A torn head can leave the queue looking non-empty forever
+        if (done && pops_after_done++ > SAMPLE_QUEUE_CAPACITY / g_batch + 1) {
+            break;
+        }
+        if (count == 0) {
+            if (done) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        if (rand_r(&seed) % 4096 == 0) {
+            for (int i = 0; i < 20; i++) {
+                sched_yield();
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const sample_t* s = &batch[i];
+            check->samples++;
+
+            uint16_t gap = (uint16_t)(s->seq - expected_seq);
+            if (gap >= 0x8000) {
+                check->out_of_order++;
+            } else {
+                check->seq_gaps += gap;
+                expected_seq = (uint16_t)(s->seq + 1);
+            }
+
+            if (s->channel >= SAMPLE_CH_COUNT) {
+                check->bad_channel++;
+                continue;
+            }
+            uint32_t value = (uint32_t)s->value;
+            if (value < expected_value[s->channel]) {
+                check->out_of_order++;
+            } else {
+                check->channel_gaps += value - expected_value[s->channel];
+                expected_value[s->channel] = value + 1;
+            }
+        }
+    }
+}
+
+// Marks the end once every producer is done, so the consumer can drain what is left
+static void* join_producers(void* arg) {
+    producers_t* producers = arg;
+    for (int i = 0; i < producers->count; i++) {
+        pthread_join(producers->threads[i], NULL);
+    }
+    __atomic_store_n(&g_producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void run(bool preemptive, check_t* check, sample_queue_stats_t* stats) {
+    memset(check, 0, sizeof(*check));
+    memset(g_next_value, 0, sizeof(g_next_value));
+    g_producers_done = 0;
+    sample_queue_init();
+
+    // Only the GPS producer takes the timer signal
+    sigset_t alarm;
+    sigemptyset(&alarm);
+    sigaddset(&alarm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alarm, NULL);
+
+    producers_t producers = { .count = 0 };
+    struct itimerval timer = { { 0, 100 }, { 0, 100 } };
+    if (preemptive) {
+        g_can_pushed = 0;
+        g_can_seed = g_seed;
+        signal(SIGALRM, can_rx_signal);
+        setitimer(ITIMER_REAL, &timer, NULL);
+        pthread_create(&producers.threads[producers.count++], NULL, gps_rx_thread, NULL);
+    } else {
+        pthread_create(&producers.threads[producers.count++], NULL, cooperative_producer, NULL);
+    }
+    pthread_t joiner;
+    pthread_create(&joiner, NULL, join_producers, &producers);
+    consume(check);
+    pthread_join(joiner, NULL);
+
+    if (preemptive) {
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_REAL, &timer, NULL);
+    }
+
+    sample_queue_get_stats(stats);
+}
+
+static uint32_t attempts(void) {
+    uint32_t total = 0;
+    for (int c = 0; c < SAMPLE_CH_COUNT; c++) {
+        total += g_next_value[c];
+    }
+    return total;
+}
+
+static void print_run(const char* name, const check_t* check, const sample_queue_stats_t* stats) {
+    printf("[SQ] %s: pushed %lu dropped %lu popped %lu high water %lu | seen %lu, seq gaps %lu, "
+           "channel gaps %lu, out of order %lu, bad channel %lu\n", name,
+           (unsigned long)stats->pushed, (unsigned long)stats->dropped, (unsigned long)stats->popped,
+           (unsigned long)stats->high_water, (unsigned long)check->samples, (unsigned long)check->seq_gaps,
+           (unsigned long)check->channel_gaps, (unsigned long)check->out_of_order,
+           (unsigned long)check->bad_channel);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:s:")) != -1) {
+        switch (opt) {
+            case 'n': g_per_producer = (uint32_t)atol(optarg); break;
+            case 'b': g_batch = (uint32_t)atoi(optarg); break;
+            case 's': g_seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-b batch] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (g_batch < 1 || g_batch > MAX_BATCH) {
+        fprintf(stderr, "batch 1..%d\n", MAX_BATCH);
+        return 2;
+    }
+    printf("[SQ] %lu samples per producer, capacity %d, consumer batch %lu\n",
+           (unsigned long)g_per_producer, SAMPLE_QUEUE_CAPACITY, (unsigned long)g_batch);
+
+    check_t check;
+    sample_queue_stats_t stats;
+    run(false, &check, &stats);
+    print_run("cooperative", &check, &stats);
+
+    // Every attempt is either delivered or counted as dropped, and the only
+    // gaps the consumer sees are the dropped samples
+    uint32_t tried = attempts();
+    bool ok = check.out_of_order == 0 && check.bad_channel == 0 &&
+              stats.pushed + stats.dropped == tried && stats.popped == stats.pushed &&
+              check.samples == stats.popped && check.seq_gaps == stats.dropped &&
+              check.channel_gaps == stats.dropped && host_fifo_pushes > 0;
+
+    run(true, &check, &stats);
+    print_run("preemptive ", &check, &stats);
+    tried = attempts();
+    long unaccounted = (long)tried - (long)check.samples - (long)stats.dropped;
+    bool raced = unaccounted != 0 || check.out_of_order || check.bad_channel ||
+                 check.seq_gaps != stats.dropped || check.channel_gaps != stats.dropped;
+    printf("[SQ] preemptive producers: %ld samples unaccounted for, %lu out of order, %s\n",
+           unaccounted, (unsigned long)check.out_of_order,
+           raced ? "race seen (the queue is single-producer)" : "no race hit this run");
+
+    printf("[SQ] %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file      tdma_sim.c
+ * @brief     Host simulation of several DAQ nodes sharing one channel with tdma.c
+ *
+ * Each virtual node has its own timer offset and drift. It receives GPS time
+ * references with NMEA output latency and jitter, or from PPS with -p. It
+ * runs the same slot loop as the firmware's fast task: the fast packet, then
+ * the GPS, thermal and diagnostics packets when they are due and fit. Every
+ * transmission is logged in true time. The run fails if two nodes are on
+ * air at the same time while both are synced.
+ *
+ *     cc -O2 -I. -o tdma_sim tools/tdma_sim.c tdma.c -lm
+ *     ./tdma_sim -n 3 -t 600
+ *
+ * Options:
+ *   -n nodes     Nodes on the channel (default 3)
+ *   -t seconds   Simulated time (default 600)
+ *   -f ms        Frame, the fast packet period (default 200)
+ *   -a ms        Time on air of the longest packet (default 15: SF7, 800 kHz, diagnostics frame)
+ *   -j ms        NMEA output latency jitter (default 10)
+ *   -p           PPS references instead of NMEA
+ *   -o seconds   GPS outage on node 0 halfway through (default 0)
+ *   -s seed      Random seed (default 1)
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tdma.h"
+
+#define GPS_EPOCH_US        200000      // 5 Hz fixes
+#define NMEA_LATENCY_US     80000       // Sentence start after the epoch (before jitter)
+#define TX_SETUP_US         8000        // LORA_TX_SETUP_US: lora_send() call to the frame on air
+#define SEND_MIN_US         10000       // lora_send() returns no earlier than this after set_tx
+#define START_UTC_MS        (23u * 3600000u + 59u * 60000u)    // Crosses midnight after 60 s
+#define MAX_TX              2000000
+
+enum { PKT_FAST, PKT_GPS, PKT_THERMAL, PKT_DIAG, PKT_HEALTH, PKT_COUNT };
+static const uint32_t PKT_PERIOD_US[PKT_COUNT] = { 0, 500000, 1000000, 5000000, 5000000 };
+
+typedef struct {
+    double   start_us;              // True time
+    double   end_us;
+    int      node;
+    bool     slotted;               // Sent while the node's TDMA clock was synced
+} tx_t;
+
+typedef struct {
+    tdma_node_t tdma;
+    double   ppm;                   // Timer drift against true time
+    double   boot_us;               // Local timer at true time 0
+    double   next_wake_us;          // True time of the next slot task run
+    double   last_due_us[PKT_COUNT];
+    bool     waiting[PKT_COUNT];    // Due but deferred from an earlier slot
+    double   ref_seen_us;           // True time the pending GPS reference is read, 0 if none
+    uint32_t ref_utc_ms;
+    uint64_t ref_local_us;
+    uint32_t sent;
+    uint32_t unslotted;
+    uint32_t deferred;              // Due packets that had to wait for a later slot
+    double   max_error_us;          // |estimated UTC - true UTC| while synced
+} sim_node_t;
+
+static tx_t g_tx[MAX_TX];
+static int g_num_tx;
+
+static double uniform(double max) {
+    return max * ((double)rand() / ((double)RAND_MAX + 1.0));
+}
+
+// Rounded up, so a wait of 1 us on the local timer still moves true time forward
+static uint64_t to_local(const sim_node_t* node, double true_us) {
+    return (uint64_t)ceil(node->boot_us + true_us * (1.0 + node->ppm * 1e-6));
+}
+
+static double to_true(const sim_node_t* node, uint64_t local_us) {
+    return ((double)local_us - node->boot_us) / (1.0 + node->ppm * 1e-6);
+}
+
+static void log_tx(int node, double start_us, double air_us, bool slotted) {
+    if (g_num_tx < MAX_TX) {
+        g_tx[g_num_tx++] = (tx_t){ start_us, start_us + air_us, node, slotted };
+    }
+}
+
+static int by_start(const void* a, const void* b) {
+    double d = ((const tx_t*)a)->start_us - ((const tx_t*)b)->start_us;
+    return (d > 0) - (d < 0);
+}
+
+// The firmware's fast task: one slot's worth of packets, then sleep until the next window
+static void run_slot(sim_node_t* node, int id, double now_true, uint32_t frame_us, uint32_t air_us) {
+    uint64_t local = to_local(node, now_true);
+    bool active = tdma_node_active(&node->tdma, local);
+
+    if (active) {
+        double utc_true = fmod((double)START_UTC_MS * 1000.0 + now_true, (double)TDMA_DAY_US);
+        double utc_est = (double)((local % TDMA_DAY_US + node->tdma.clock.offset_us) % TDMA_DAY_US);
+        double err = fabs(utc_est - utc_true);
+        if (err > TDMA_DAY_US / 2) err = TDMA_DAY_US - err;
+        if (err > node->max_error_us) node->max_error_us = err;
+    }
+
+    // Packets deferred from an earlier slot go first, so a window that
+    // only fits one packet does not starve them behind the fast packet
+    int order[2 * PKT_COUNT], count = 0;
+    for (int pkt = 1; pkt < PKT_COUNT; pkt++) {
+        if (node->waiting[pkt]) order[count++] = pkt;
+    }
+    for (int pkt = 0; pkt < PKT_COUNT; pkt++) {
+        if (!node->waiting[pkt]) order[count++] = pkt;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int pkt = order[i];
+        bool due = pkt == PKT_FAST || now_true - node->last_due_us[pkt] >= PKT_PERIOD_US[pkt];
+        if (!due) {
+            continue;
+        }
+        local = to_local(node, now_true);
+        if (active && !tdma_fits(&node->tdma.plan, &node->tdma.clock, local, TX_SETUP_US + air_us)) {
+            node->deferred += !node->waiting[pkt];
+            node->waiting[pkt] = pkt != PKT_FAST;
+            continue;
+        }
+        log_tx(id, now_true + TX_SETUP_US, air_us, active);
+        node->sent++;
+        node->unslotted += !active;
+        node->last_due_us[pkt] = now_true;
+        node->waiting[pkt] = false;
+        now_true += TX_SETUP_US + (air_us > SEND_MIN_US ? air_us : SEND_MIN_US);
+    }
+
+    local = to_local(node, now_true);
+    if (active) {
+        node->next_wake_us = to_true(node, tdma_next_window(&node->tdma.plan, &node->tdma.clock, local));
+    } else {
+        node->next_wake_us = now_true + frame_us;
+    }
+}
+
+int main(int argc, char** argv) {
+    int num_nodes = 3;
+    double seconds = 600;
+    uint32_t frame_ms = 200;
+    uint32_t air_ms = 15;
+    double jitter_ms = 10;
+    bool pps = false;
+    double outage_s = 0;
+    unsigned seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:f:a:j:po:s:")) != -1) {
+        switch (opt) {
+            case 'n': num_nodes = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'f': frame_ms = (uint32_t)atoi(optarg); break;
+            case 'a': air_ms = (uint32_t)atoi(optarg); break;
+            case 'j': jitter_ms = atof(optarg); break;
+            case 'p': pps = true; break;
+            case 'o': outage_s = atof(optarg); break;
+            case 's': seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n nodes] [-t s] [-f ms] [-a ms] [-j ms] [-p] [-o s] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (num_nodes < 1 || num_nodes > TDMA_MAX_NODES) {
+        fprintf(stderr, "1..%d nodes\n", TDMA_MAX_NODES);
+        return 2;
+    }
+    srand(seed);
+
+    uint32_t frame_us = frame_ms * 1000u;
+    uint32_t air_us = air_ms * 1000u;
+    uint32_t sync_error_us = pps ? TDMA_PPS_SYNC_ERROR_US : TDMA_NMEA_SYNC_ERROR_US;
+
+    sim_node_t nodes[TDMA_MAX_NODES];
+    memset(nodes, 0, sizeof(nodes));
+    for (int i = 0; i < num_nodes; i++) {
+        sim_node_t* node = &nodes[i];
+        node->ppm = uniform(2.0 * TDMA_DRIFT_PPM) - TDMA_DRIFT_PPM;
+        node->boot_us = uniform(5e6);
+        node->next_wake_us = uniform(frame_us);
+        if (!tdma_node_configure(&node->tdma, (uint8_t)i, (uint8_t)num_nodes, frame_us, sync_error_us,
+                                 TX_SETUP_US + air_us)) {
+            fprintf(stderr, "node %d: no valid plan (slot %u us, guard %u us, packet %u us)\n", i,
+                    node->tdma.plan.slot_us, node->tdma.plan.guard_us, TX_SETUP_US + air_us);
+            if (num_nodes > 1) return 2;
+        }
+    }
+    printf("[TDMA] %d nodes, frame %u ms, slot %u us, guard %u us, packet %u us on air, %s references\n",
+           num_nodes, frame_ms, nodes[0].tdma.plan.slot_us, nodes[0].tdma.plan.guard_us, air_us,
+           pps ? "PPS" : "NMEA");
+
+    double end_us = seconds * 1e6;
+    double outage_start = end_us / 2, outage_end = outage_start + outage_s * 1e6;
+    double next_epoch = GPS_EPOCH_US;
+    while (true) {
+        // Next event: a GPS epoch, a node reading its reference, or a slot task run
+        double t = next_epoch;
+        int next_node = -1;
+        bool is_ref = false;
+        for (int i = 0; i < num_nodes; i++) {
+            if (nodes[i].next_wake_us < t) {
+                t = nodes[i].next_wake_us, next_node = i, is_ref = false;
+            }
+            if (nodes[i].ref_seen_us > 0 && nodes[i].ref_seen_us < t) {
+                t = nodes[i].ref_seen_us, next_node = i, is_ref = true;
+            }
+        }
+        if (t >= end_us) {
+            break;
+        }
+
+        if (next_node < 0) {
+            uint32_t utc_ms = (uint32_t)(((uint64_t)START_UTC_MS + (uint64_t)(t / 1000)) % (TDMA_DAY_US / 1000));
+            for (int i = 0; i < num_nodes; i++) {
+                if (i == 0 && t >= outage_start && t < outage_end) continue;
+                double seen = pps ? t + uniform(20) : t + NMEA_LATENCY_US + uniform(jitter_ms * 1000);
+                double latency = pps ? 0 : NMEA_LATENCY_US;     // Nominal, as the firmware assumes
+                nodes[i].ref_seen_us = seen;
+                nodes[i].ref_utc_ms = utc_ms;
+                nodes[i].ref_local_us = to_local(&nodes[i], seen) - (uint64_t)latency;
+            }
+            next_epoch += GPS_EPOCH_US;
+        } else if (is_ref) {
+            sim_node_t* node = &nodes[next_node];
+            tdma_clock_update(&node->tdma.clock, node->ref_utc_ms, node->ref_local_us,
+                              pps ? TDMA_SYNC_PPS : TDMA_SYNC_NMEA);
+            node->ref_seen_us = 0;
+        } else {
+            run_slot(&nodes[next_node], next_node, t, frame_us, air_us);
+        }
+    }
+
+    // Collisions: overlapping transmissions from different nodes
+    qsort(g_tx, (size_t)g_num_tx, sizeof(tx_t), by_start);
+    int collisions = 0, slotted_collisions = 0;
+    double min_gap = 1e12;
+    for (int i = 1; i < g_num_tx; i++) {
+        for (int j = i - 1; j >= 0 && j >= i - 2 * TDMA_MAX_NODES; j--) {
+            if (g_tx[j].node == g_tx[i].node) continue;
+            double gap = g_tx[i].start_us - g_tx[j].end_us;
+            if (gap < 0) {
+                collisions++;
+                slotted_collisions += g_tx[i].slotted && g_tx[j].slotted;
+            } else if (g_tx[i].slotted && g_tx[j].slotted && gap < min_gap) {
+                min_gap = gap;
+            }
+        }
+    }
+
+    for (int i = 0; i < num_nodes; i++) {
+        printf("[TDMA] node %d drift %+5.1f ppm | sent %u (unslotted %u) deferred %u | relocks %u | max clock error %.0f us\n",
+               i, nodes[i].ppm, nodes[i].sent, nodes[i].unslotted, nodes[i].deferred,
+               nodes[i].tdma.clock.relocks, nodes[i].max_error_us);
+    }
+    printf("[TDMA] %d transmissions, %d collisions (%d between synced nodes), min gap between nodes %.0f us\n",
+           g_num_tx, collisions, slotted_collisions, min_gap < 1e12 ? min_gap : 0.0);
+    return slotted_collisions == 0 ? 0 : 1;
+}